@@ -0,0 +1,43 @@
+#include <robot_dart/batch_simu.hpp>
+#include <robot_dart/control/pd_control.hpp>
+#include <robot_dart/robots/talos.hpp>
+
+static constexpr int NUM_WORLDS = 32;
+
+int main()
+{
+    // the template robot: every world gets a clone of it (controllers included)
+    auto robot = std::make_shared<robot_dart::robots::TalosLight>();
+    robot->set_actuator_types("velocity");
+    // PD controller on all the joints but the floating base
+    Eigen::VectorXd ctrl = Eigen::VectorXd::Zero(robot->dof_names(true, true, true).size() - 6);
+    robot->add_controller(std::make_shared<robot_dart::control::PDControl>(ctrl));
+
+    robot_dart::BatchSimu batch(NUM_WORLDS, 0.001);
+    batch.set_collision_detector("fcl");
+    batch.add_checkerboard_floor();
+    batch.add_robot(robot);
+    batch.set_control_freq(100);
+
+    // world-specific setup: different PD targets for each world
+    batch.for_each([](robot_dart::RobotDARTSimu& simu, size_t i) {
+        auto ctrl = std::static_pointer_cast<robot_dart::control::PDControl>(simu.robot(1)->controller(0));
+        Eigen::VectorXd target = ctrl->parameters();
+        target[0] = 0.02 * i;
+        ctrl->set_parameters(target);
+    });
+
+    // run all the worlds for 3 seconds and get back the final height of each robot
+    std::function<double(robot_dart::RobotDARTSimu&, size_t)> eval = [](robot_dart::RobotDARTSimu& simu, size_t) {
+        return simu.robot(1)->base_pose().translation()[2];
+    };
+    auto heights = batch.run<double>(3., eval);
+
+    for (size_t i = 0; i < heights.size(); i++)
+        std::cout << "world " << i << ": " << heights[i] << std::endl;
+
+    std::cout << batch.num_worlds() << " worlds on " << batch.num_threads() << " threads: "
+              << batch.last_steps_per_second() << " steps/s" << std::endl;
+
+    return 0;
+}
@@ -1,9 +1,12 @@
+#include <chrono>
+
 #include <robot_dart/control/pd_control.hpp>
 #include <robot_dart/robot_dart_simu.hpp>
 #include <robot_dart/robots/iiwa.hpp>
 
 #include <robot_dart/gui/magnum/graphics.hpp>
 #include <robot_dart/gui/magnum/sensor/camera.hpp>
+#include <robot_dart/gui/magnum/sensor/camera_atlas.hpp>
 
 class MyApp : public robot_dart::gui::magnum::GlfwApplication {
 public:
@@ -50,15 +53,18 @@ int main()
 
     // record images from main camera/graphics
     graphics->camera().record(true);
-    // we can also record a video directly to a file --- requires the executable of ffmpeg
+    // we can also record a video directly to a file --- requires the libav* libraries or the executable of ffmpeg
+    // (the frames are encoded in a background thread)
     graphics->record_video("video-main.mp4", simu.graphics_freq());
 
     // Add camera
     auto camera = std::make_shared<robot_dart::sensor::Camera>(graphics->magnum_app(), 256, 256);
     camera->camera().set_far_plane(5.f);
     camera->camera().record(true, true); // cameras are recording color images by default, enable depth images as well for this example
-    // cameras can also record video
-    camera->record_video("video-camera.mp4");
+    // cameras can also record video; here an uncompressed Y4M stream (no encoder needed),
+    // and frames are dropped instead of slowing down the simulation if the disk cannot keep up
+    camera->camera().set_video_policy(robot_dart::gui::VideoPolicy::DropOldest, 16);
+    camera->record_video("video-camera.y4m");
     // camera->look_at({-0.5, -3., 0.75}, {0.5, 0., 0.2});
     Eigen::Isometry3d tf;
     // tf.setIdentity();
@@ -111,16 +117,78 @@ int main()
         }
     }
 
+    // benchmark of the readback of the images: in the asynchronous modes, the CPU does not wait for the GPU
+    // (the transfer of a frame overlaps with the rendering of the next one)
+    {
+        using robot_dart::gui::magnum::gs::ReadbackMode;
+        std::vector<std::pair<std::string, ReadbackMode>> modes = {{"sync", ReadbackMode::Sync}, {"latest", ReadbackMode::Latest}, {"latest-but-one", ReadbackMode::LatestButOne}};
+
+        simu.scheduler().set_sync(false);
+        double duration = 2.;
+        double num_frames = duration * (simu.graphics_freq() + camera->frequency());
+        for (auto& mode : modes) {
+            graphics->camera().set_readback_mode(mode.second);
+            camera->camera().set_readback_mode(mode.second);
+
+            auto start = std::chrono::steady_clock::now();
+            simu.run(duration);
+            double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "readback " << mode.first << ": " << num_frames / time << " frames per second" << std::endl;
+        }
+        graphics->camera().set_readback_mode(ReadbackMode::Sync);
+        camera->camera().set_readback_mode(ReadbackMode::Sync);
+    }
+
+    // benchmark of many small cameras: one framebuffer each vs. one atlas
+    // (the atlas traverses the scene, renders the shadows and reads back the images once per frame)
+    {
+        size_t num_cameras = 8;
+        double duration = 2.;
+        auto look = [](const std::shared_ptr<robot_dart::sensor::Camera>& cam, size_t i) {
+            double angle = 2. * M_PI * i / 8.;
+            cam->look_at({2. * std::cos(angle), 2. * std::sin(angle), 1.}, {0., 0., 0.25});
+        };
+
+        std::vector<std::shared_ptr<robot_dart::sensor::Camera>> cameras;
+        for (size_t i = 0; i < num_cameras; i++) {
+            cameras.push_back(std::make_shared<robot_dart::sensor::Camera>(graphics->magnum_app(), 128, 128));
+            look(cameras.back(), i);
+            simu.add_sensor(cameras.back());
+        }
+        auto start = std::chrono::steady_clock::now();
+        simu.run(duration);
+        double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << num_cameras << " cameras: " << time / duration << "s per simulated second" << std::endl;
+        for (auto& cam : cameras)
+            simu.remove_sensor(cam);
+
+        auto atlas = std::make_shared<robot_dart::sensor::CameraAtlas>(graphics->magnum_app());
+        for (size_t i = 0; i < num_cameras; i++)
+            look(atlas->add_camera(128, 128), i);
+        simu.add_sensor(atlas);
+        start = std::chrono::steady_clock::now();
+        simu.run(duration);
+        time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << num_cameras << " cameras in an atlas: " << time / duration << "s per simulated second" << std::endl;
+
+        // each camera gives a view of its region of the atlas
+        robot_dart::gui::save_png_image("camera-atlas-0.png", atlas->cameras()[0]->image_view().copy());
+        simu.remove_sensor(atlas);
+    }
+
     simu.set_graphics_freq(20);
     simu.world()->setTime(0.);
     simu.scheduler().reset(simu.timestep(), true);
+    // per-frame point clouds: the rays are computed once and the points are written in the same buffer (from the raw depth buffer)
+    robot_dart::gui::PointCloudGenerator point_cloud_generator;
+    point_cloud_generator.set_intrinsics(camera->camera_intrinsic_matrix(), camera->camera().width(), camera->camera().height());
+    Eigen::Matrix3Xf points;
     while (true) {
         if (simu.step())
             break;
         if (simu.schedule(simu.graphics_freq())) {
-            auto depth_image = camera->depth_array();
-            std::vector<Eigen::Vector3d> point_cloud = robot_dart::gui::point_cloud_from_depth_array(depth_image, camera->camera_intrinsic_matrix(), camera->camera_extrinsic_matrix(), camera->camera().far_plane());
-            std::cout << simu.scheduler().current_time() << ": " << point_cloud.size() << std::endl;
+            size_t num_points = point_cloud_generator.compute(camera->depth_view(), camera->camera_extrinsic_matrix(), points);
+            std::cout << simu.scheduler().current_time() << ": " << num_points << std::endl;
         }
     }
 
@@ -0,0 +1,114 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <unordered_map>
+
+#include <robot_dart/robot_dart_simu.hpp>
+#include <robot_dart/utils_headers_dart_collision.hpp>
+#include <robot_dart/utils_headers_dart_dynamics.hpp>
+
+// Compares the collision detection with the bitmask filter of RobotDARTSimu (dense masks, tested before the body nodes)
+// to the previous filter (hash map of masks, tested after the body nodes) in a cluttered scene where the masks are set
+static constexpr size_t NUM_ITERATIONS = 200;
+
+// the previous BitmaskContactFilter
+class LegacyBitmaskContactFilter : public dart::collision::BodyNodeCollisionFilter {
+public:
+    struct Masks {
+        uint32_t collision_mask = 0xffffffff;
+        uint32_t category_mask = 0xffffffff;
+    };
+
+    bool ignoresCollision(const dart::collision::CollisionObject* object1, const dart::collision::CollisionObject* object2) const override
+    {
+        auto shape_node1 = object1->getShapeFrame()->asShapeNode();
+        auto shape_node2 = object2->getShapeFrame()->asShapeNode();
+
+        if (dart::collision::BodyNodeCollisionFilter::ignoresCollision(object1, object2))
+            return true;
+
+        auto shape1_iter = _bitmask_map.find(shape_node1);
+        auto shape2_iter = _bitmask_map.find(shape_node2);
+        if (shape1_iter != _bitmask_map.end() && shape2_iter != _bitmask_map.end()) {
+            if ((shape1_iter->second.collision_mask & shape2_iter->second.category_mask) == 0 && (shape2_iter->second.collision_mask & shape1_iter->second.category_mask) == 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    void add_to_map(const dart::dynamics::ShapeNode* shape, uint32_t col_mask, uint32_t cat_mask) { _bitmask_map[shape] = {col_mask, cat_mask}; }
+
+private:
+    std::unordered_map<const dart::dynamics::ShapeNode*, Masks> _bitmask_map;
+};
+
+// time of one collision detection (broadphase, filter and narrowphase) and number of contacts
+std::pair<double, size_t> collide(robot_dart::RobotDARTSimu& simu, const std::shared_ptr<dart::collision::CollisionFilter>& filter)
+{
+    auto solver = simu.world()->getConstraintSolver();
+    dart::collision::CollisionOption option = solver->getCollisionOption();
+    option.collisionFilter = filter;
+    dart::collision::CollisionResult result;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < NUM_ITERATIONS; i++) {
+        result.clear();
+        solver->getCollisionGroup()->collide(option, &result);
+    }
+    double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return {time / NUM_ITERATIONS, result.getNumContacts()};
+}
+
+void benchmark(size_t num_boxes, size_t num_categories)
+{
+    robot_dart::RobotDARTSimu simu(0.001);
+    simu.add_floor();
+
+    // overlapping boxes in a grid: most of them are candidate pairs for the broadphase
+    size_t side = static_cast<size_t>(std::ceil(std::cbrt(static_cast<double>(num_boxes))));
+    for (size_t i = 0; i < num_boxes; i++) {
+        Eigen::Vector6d pose = Eigen::Vector6d::Zero();
+        pose.tail(3) << 0.08 * (i % side), 0.08 * ((i / side) % side), 0.05 + 0.08 * (i / (side * side));
+        simu.add_robot(robot_dart::Robot::create_box({0.1, 0.1, 0.1}, pose, "free", 1., dart::Color::Red(1.), "box_" + std::to_string(i)));
+    }
+
+    // each box only collides with the floor and the boxes of its category
+    auto legacy_filter = std::make_shared<LegacyBitmaskContactFilter>();
+    for (size_t i = 1; i < simu.num_robots(); i++) {
+        uint32_t category = 1u << (1 + i % num_categories);
+        simu.set_collision_masks(i, category, category | 1u);
+        auto skel = simu.robot(i)->skeleton();
+        for (size_t s = 0; s < skel->getNumShapeNodes(); s++)
+            legacy_filter->add_to_map(skel->getShapeNode(s), category | 1u, category);
+    }
+    simu.set_collision_masks(0, 1u, 0xffffffff);
+    auto floor = simu.robot(0)->skeleton();
+    for (size_t s = 0; s < floor->getNumShapeNodes(); s++)
+        legacy_filter->add_to_map(floor->getShapeNode(s), 0xffffffff, 1u);
+
+    auto legacy = collide(simu, legacy_filter);
+    auto current = collide(simu, simu.world()->getConstraintSolver()->getCollisionOption().collisionFilter);
+
+    std::cout << num_boxes << " boxes, " << num_categories << " categories:" << std::endl;
+    std::cout << "  previous filter: " << legacy.first * 1e3 << "ms/detection (" << legacy.second << " contacts)" << std::endl;
+    std::cout << "  current filter:  " << current.first * 1e3 << "ms/detection (" << current.second << " contacts)"
+              << " (x" << legacy.first / current.first << ")" << std::endl;
+
+    // the world steps with the current filter
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < NUM_ITERATIONS; i++)
+        simu.step_world();
+    double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "  world step: " << time / NUM_ITERATIONS * 1e3 << "ms" << std::endl;
+}
+
+int main()
+{
+    for (size_t num_boxes : {100, 300, 600})
+        for (size_t num_categories : {2, 8})
+            benchmark(num_boxes, num_categories);
+
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <robot_dart/robot_dart_simu.hpp>
+#include <robot_dart/robots/iiwa.hpp>
+
+#include <robot_dart/gui/magnum/windowless_graphics.hpp>
+
+// renders `num_threads` simulations in parallel with `num_contexts` GL contexts and returns the total frames per second
+double frames_per_second(const std::shared_ptr<robot_dart::Robot>& global_robot, size_t num_contexts, size_t num_threads)
+{
+    robot_dart::gui::magnum::GlobalData::instance()->set_max_contexts(num_contexts);
+
+    double duration = 2.; // simulated seconds per thread
+    size_t graphics_freq = 40;
+
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < num_threads; i++) {
+        workers.push_back(std::thread([&] {
+            // the threads wait for a free context (for at most one minute)
+            get_gl_context_with_timeout(gl_context, 60000);
+
+            auto robot = global_robot->clone();
+            robot_dart::RobotDARTSimu simu(0.001);
+            simu.set_graphics_freq(graphics_freq);
+
+            robot_dart::gui::magnum::GraphicsConfiguration configuration = robot_dart::gui::magnum::WindowlessGraphics::default_configuration();
+            configuration.width = 320;
+            configuration.height = 240;
+            auto graphics = std::make_shared<robot_dart::gui::magnum::WindowlessGraphics>(configuration);
+            simu.set_graphics(graphics);
+            graphics->look_at({0., 3.5, 2.}, {0., 0., 0.25});
+
+            simu.add_robot(robot);
+            simu.run(duration);
+
+            release_gl_context(gl_context);
+        }));
+    }
+    for (auto& worker : workers)
+        worker.join();
+    double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return num_threads * duration * graphics_freq / time;
+}
+
+int main(int argc, char** argv)
+{
+    // ./headless_benchmark [auto|hardware|software]
+    std::string backend = (argc > 1) ? argv[1] : "auto";
+    if (backend == "hardware")
+        robot_dart::gui::magnum::GlobalData::instance()->set_backend(robot_dart::gui::magnum::GLBackend::Hardware);
+    else if (backend == "software")
+        robot_dart::gui::magnum::GlobalData::instance()->set_backend(robot_dart::gui::magnum::GLBackend::Software);
+
+    bool software = robot_dart::gui::magnum::GlobalData::instance()->backend() == robot_dart::gui::magnum::GLBackend::Software;
+    std::cout << "Backend: " << (software ? "software" : "hardware") << std::endl;
+
+    auto global_robot = std::make_shared<robot_dart::robots::Iiwa>();
+
+    size_t cores = std::max<size_t>(1, std::thread::hardware_concurrency());
+    for (size_t num_contexts = 1; num_contexts <= cores; num_contexts *= 2) {
+        for (size_t num_threads : {num_contexts, 2 * num_contexts}) {
+            double fps = frames_per_second(global_robot, num_contexts, num_threads);
+            std::cout << num_contexts << " contexts, " << num_threads << " threads: " << fps << " frames per second" << std::endl;
+        }
+    }
+
+    global_robot.reset();
+    return 0;
+}
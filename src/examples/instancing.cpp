@@ -0,0 +1,53 @@
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include <robot_dart/robot_dart_simu.hpp>
+#include <robot_dart/robots/iiwa.hpp>
+
+#include <robot_dart/gui/magnum/windowless_graphics.hpp>
+
+// renders a population of clones and returns the (wall-clock) time per frame
+double time_per_frame(const std::shared_ptr<robot_dart::Robot>& robot, size_t num_robots, bool instancing)
+{
+    robot_dart::RobotDARTSimu simu(0.001);
+    simu.set_graphics_freq(50);
+
+    // the clones share their meshes and materials: they are drawn with one instanced draw call per mesh
+    robot_dart::gui::magnum::GraphicsConfiguration configuration = robot_dart::gui::magnum::WindowlessGraphics::default_configuration();
+    configuration.instancing = instancing;
+    auto graphics = std::make_shared<robot_dart::gui::magnum::WindowlessGraphics>(configuration);
+    simu.set_graphics(graphics);
+    graphics->look_at({12., 12., 8.}, {0., 0., 0.});
+
+    size_t side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(num_robots))));
+    for (size_t i = 0; i < num_robots; i++) {
+        auto clone = robot->clone();
+        Eigen::Vector6d pose;
+        pose << 0., 0., 0., (i % side) * 1.5, (i / side) * 1.5, 0.;
+        clone->set_base_pose(pose);
+        simu.add_robot(clone);
+    }
+
+    // the first frames load the meshes
+    simu.run(0.1);
+
+    double duration = 2.;
+    auto start = std::chrono::steady_clock::now();
+    simu.run(duration);
+    double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return time / (duration * simu.graphics_freq());
+}
+
+int main()
+{
+    auto robot = std::make_shared<robot_dart::robots::Iiwa>();
+
+    for (size_t num_robots : {1, 10, 100}) {
+        double with = time_per_frame(robot, num_robots, true);
+        double without = time_per_frame(robot, num_robots, false);
+        std::cout << num_robots << " robots: " << with * 1000. << "ms per frame with instancing, " << without * 1000. << "ms without" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include <chrono>
+#include <unordered_map>
+
+#include <robot_dart/control/pd_control.hpp>
+#include <robot_dart/robots/icub.hpp>
+#include <robot_dart/robots/talos.hpp>
+#include <robot_dart/utils_headers_dart_dynamics.hpp>
+
+// Compares PDControl::calculate() (with angular errors) to the previous implementation,
+// which resolved the joint of every DoF with hash maps and string compares at each call
+static constexpr size_t NUM_ITERATIONS = 20000;
+
+double angle_dist(double target, double current)
+{
+    double theta = target - current;
+    while (theta < -M_PI)
+        theta += 2 * M_PI;
+    while (theta > M_PI)
+        theta -= 2 * M_PI;
+    return theta;
+}
+
+// the previous PDControl::calculate() for a full-control PD controller
+Eigen::VectorXd legacy_calculate(const std::shared_ptr<robot_dart::Robot>& robot, const Eigen::VectorXd& ctrl, const Eigen::VectorXd& Kp, const Eigen::VectorXd& Kd)
+{
+    size_t control_dof = robot->num_dofs();
+    Eigen::VectorXd dq = robot->velocities();
+    Eigen::VectorXd error = Eigen::VectorXd::Zero(control_dof);
+
+    std::unordered_map<size_t, Eigen::VectorXd> joint_vals, joint_desired, errors;
+    for (size_t i = 0; i < control_dof; ++i) {
+        auto dof = robot->dof(i);
+        size_t joint_index = dof->getJoint()->getJointIndexInSkeleton();
+        if (joint_vals.find(joint_index) == joint_vals.end()) {
+            joint_vals[joint_index] = dof->getJoint()->getPositions();
+            joint_desired[joint_index] = dof->getJoint()->getPositions();
+        }
+        joint_desired[joint_index][dof->getIndexInJoint()] = ctrl[i];
+    }
+
+    for (size_t i = 0; i < control_dof; ++i) {
+        auto dof = robot->dof(i);
+        size_t joint_index = dof->getJoint()->getJointIndexInSkeleton();
+        size_t dof_index_in_joint = dof->getIndexInJoint();
+
+        Eigen::VectorXd val;
+        if (errors.find(joint_index) == errors.end()) {
+            val = Eigen::VectorXd(dof->getJoint()->getNumDofs());
+
+            std::string joint_type = dof->getJoint()->getType();
+            if (joint_type == dart::dynamics::RevoluteJoint::getStaticType())
+                val[dof_index_in_joint] = angle_dist(ctrl[i], joint_vals[joint_index][dof_index_in_joint]);
+            else if (joint_type == dart::dynamics::BallJoint::getStaticType()) {
+                Eigen::Matrix3d R_desired = dart::math::expMapRot(joint_desired[joint_index]);
+                Eigen::Matrix3d R_current = dart::math::expMapRot(joint_vals[joint_index]);
+                val = dart::math::logMap(R_desired * R_current.transpose());
+            }
+            else if (joint_type == dart::dynamics::EulerJoint::getStaticType()) {
+                for (size_t d = 0; d < dof->getJoint()->getNumDofs(); d++)
+                    val[d] = angle_dist(joint_desired[joint_index][d], joint_vals[joint_index][d]);
+            }
+            else if (joint_type == dart::dynamics::FreeJoint::getStaticType()) {
+                Eigen::Isometry3d tf_desired = dart::dynamics::FreeJoint::convertToTransform(joint_desired[joint_index]);
+                Eigen::Isometry3d tf_current = dart::dynamics::FreeJoint::convertToTransform(joint_vals[joint_index]);
+
+                val.tail(3) = tf_desired.translation() - tf_current.translation();
+                val.head(3) = dart::math::logMap(tf_desired.linear().matrix() * tf_current.linear().matrix().transpose());
+            }
+            else
+                val[dof_index_in_joint] = ctrl[i] - joint_vals[joint_index][dof_index_in_joint];
+
+            errors[joint_index] = val;
+        }
+        else
+            val = errors[joint_index];
+        error(i) = val[dof_index_in_joint];
+    }
+
+    return Kp.array() * error.array() - Kd.array() * dq.array();
+}
+
+void benchmark(const std::string& name, const std::shared_ptr<robot_dart::Robot>& robot)
+{
+    robot->set_positions(Eigen::VectorXd::Random(robot->num_dofs()));
+    robot->set_velocities(Eigen::VectorXd::Random(robot->num_dofs()));
+
+    Eigen::VectorXd ctrl = Eigen::VectorXd::Random(robot->num_dofs());
+    auto controller = std::make_shared<robot_dart::control::PDControl>(ctrl, true);
+    robot->add_controller(controller);
+    controller->set_pd(Eigen::VectorXd::Random(robot->num_dofs()).cwiseAbs(), Eigen::VectorXd::Random(robot->num_dofs()).cwiseAbs());
+    Eigen::VectorXd Kp = controller->pd().first;
+    Eigen::VectorXd Kd = controller->pd().second;
+
+    Eigen::VectorXd commands = Eigen::VectorXd::Zero(robot->num_dofs());
+    Eigen::VectorXd legacy_commands = legacy_calculate(robot, ctrl, Kp, Kd);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < NUM_ITERATIONS; i++)
+        legacy_commands = legacy_calculate(robot, ctrl, Kp, Kd);
+    double legacy_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < NUM_ITERATIONS; i++)
+        controller->calculate_into(0., commands);
+    double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << name << " (" << robot->num_dofs() << " DoFs):" << std::endl;
+    std::cout << "  previous calculate(): " << legacy_time / NUM_ITERATIONS * 1e6 << "us/call" << std::endl;
+    std::cout << "  calculate_into():     " << time / NUM_ITERATIONS * 1e6 << "us/call"
+              << " (x" << legacy_time / time << ")" << std::endl;
+    std::cout << "  max difference: " << (commands - legacy_commands).cwiseAbs().maxCoeff() << std::endl;
+}
+
+int main()
+{
+    benchmark("iCub", std::make_shared<robot_dart::robots::ICub>());
+    benchmark("Talos", std::make_shared<robot_dart::robots::Talos>());
+
+    return 0;
+}
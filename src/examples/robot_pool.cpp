@@ -1,3 +1,4 @@
+#include <functional>
 #include <thread>
 
 #include <robot_dart/robot_dart_simu.hpp>
@@ -48,41 +49,46 @@ inline void simulate_robot(const std::shared_ptr<robot_dart::Robot>& robot)
     }
 }
 
-namespace pool {
-    inline std::shared_ptr<robot_dart::Robot> robot_creator()
-    {
-        return std::make_shared<robot_dart::robots::Talos>();
-    }
-
-    robot_dart::RobotPool robot_pool(robot_creator, NUM_THREADS);
-} // namespace pool
-
-inline void eval_robot(int i)
+inline std::shared_ptr<robot_dart::Robot> robot_creator()
 {
-    auto robot = pool::robot_pool.get_robot();
-    std::cout << "Robot " << i << " got [" << robot->skeleton() << "]" << std::endl;
+    return std::make_shared<robot_dart::robots::Talos>();
+}
 
-    /// --- some robot_dart code ---
-    simulate_robot(robot);
-    // --- do something with the result
+inline void eval_robot(robot_dart::RobotPool& robot_pool, int i)
+{
+    {
+        // the handle gives the robot back to the pool when it goes out of scope
+        // (use get_robot() and free_robot() if you want to do it manually)
+        auto robot = robot_pool.get_robot_handle();
+        std::cout << "Robot " << i << " got [" << robot->skeleton() << "]" << std::endl;
 
-    std::cout << "End of simulation " << i << std::endl;
+        /// --- some robot_dart code ---
+        simulate_robot(robot.robot());
+        // --- do something with the result
 
-    // CRITICAL : free your robot !
-    pool::robot_pool.free_robot(robot);
+        std::cout << "End of simulation " << i << std::endl;
+    }
 
     std::cout << "Robot " << i << " freed!" << std::endl;
 }
 
 int main()
 {
+    // half of the robots are built at startup (4 at a time), the rest when they are needed
+    robot_dart::RobotPool robot_pool(robot_creator, NUM_THREADS / 2, true, 4, NUM_THREADS);
+
     // for the example, we run NUM_THREADS threads of eval_robot()
     std::vector<std::thread> threads(NUM_THREADS * 2); // *2 to see some reuse
     for (size_t i = 0; i < threads.size(); ++i)
-        threads[i] = std::thread(eval_robot, i);
+        threads[i] = std::thread(eval_robot, std::ref(robot_pool), i);
 
     // wait for the threads to finish
     for (size_t i = 0; i < threads.size(); ++i)
         threads[i].join();
+
+    auto build_times = robot_pool.build_times();
+    std::cout << "Pool size: " << build_times.size() << std::endl;
+    for (size_t i = 0; i < build_times.size(); ++i)
+        std::cout << "Robot " << i << " was built in " << build_times[i] << "s" << std::endl;
     return 0;
 }
@@ -0,0 +1,50 @@
+#include <chrono>
+#include <thread>
+
+#include <robot_dart/robot_pool.hpp>
+
+// Measures the throughput of RobotPool::get_robot()/free_robot() when many threads
+// compete for a small pool (no simulation is done, only the pool is exercised)
+static constexpr size_t NUM_ITERATIONS = 20000;
+
+inline std::shared_ptr<robot_dart::Robot> robot_creator()
+{
+    return robot_dart::Robot::create_box(Eigen::Vector3d(0.1, 0.1, 0.1));
+}
+
+double benchmark(size_t num_threads, size_t pool_size)
+{
+    robot_dart::RobotPool pool(robot_creator, pool_size, false);
+
+    auto worker = [&pool]() {
+        for (size_t i = 0; i < NUM_ITERATIONS; i++) {
+            auto robot = pool.get_robot_handle();
+            robot->set_positions(robot->positions()); // a tiny bit of work
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; t++)
+        threads.emplace_back(worker);
+    for (auto& t : threads)
+        t.join();
+    auto end = std::chrono::steady_clock::now();
+
+    double duration = std::chrono::duration<double>(end - start).count();
+    return (num_threads * NUM_ITERATIONS) / duration;
+}
+
+int main()
+{
+    size_t max_threads = std::max(2u, std::thread::hardware_concurrency());
+
+    std::cout << "threads\tpool size\tget+free per second" << std::endl;
+    for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        for (size_t pool_size : {1, 4, 16, 64}) {
+            std::cout << num_threads << "\t" << pool_size << "\t\t" << benchmark(num_threads, pool_size) << std::endl;
+        }
+    }
+
+    return 0;
+}
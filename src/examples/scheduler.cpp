@@ -5,6 +5,8 @@
 int main()
 {
     robot_dart::Scheduler scheduler(1e-3, true);
+    // tasks are registered once; their period does not need to be a multiple of dt
+    size_t task_300 = scheduler.add_task(300);
 
     while (scheduler.next_time() < 5) {
         if (scheduler(1000)) {
@@ -19,6 +21,10 @@ int main()
             std::cout << 20 << std::endl;
         }
 
+        if (scheduler.due(task_300)) {
+            std::cout << 300 << std::endl;
+        }
+
         scheduler.step();
     }
     return 0;
@@ -0,0 +1,52 @@
+#include <chrono>
+#include <iostream>
+
+#include <robot_dart/robot_dart_simu.hpp>
+#include <robot_dart/robots/talos.hpp>
+
+// Compares the refresh of the force/torque and torque sensors of Talos, one sensor at a time
+// (26 sensors, as they were registered before) and with the sensor banks (one pass per bank)
+static constexpr size_t NUM_ITERATIONS = 20000;
+
+int main()
+{
+    auto robot = std::make_shared<robot_dart::robots::Talos>();
+    robot_dart::RobotDARTSimu simu(0.001);
+    simu.add_robot(robot);
+    for (size_t i = 0; i < 100; i++)
+        simu.step_world();
+
+    // the sensors as separate scheduler tasks
+    std::vector<std::shared_ptr<robot_dart::sensor::Sensor>> sensors;
+    for (auto& s : {"leg_left_6_joint", "leg_right_6_joint", "wrist_left_ft_joint", "wrist_right_ft_joint"})
+        sensors.push_back(std::make_shared<robot_dart::sensor::ForceTorque>(robot, s));
+    for (auto& t : robot->torques())
+        sensors.push_back(std::make_shared<robot_dart::sensor::Torque>(robot, t.first));
+    for (auto& s : sensors)
+        s->init();
+
+    // the banks of the robot
+    std::vector<std::shared_ptr<robot_dart::sensor::Sensor>> banks;
+    for (auto& s : simu.sensors())
+        if (s->type() == "ft_bank" || s->type() == "t_bank")
+            banks.push_back(s);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < NUM_ITERATIONS; i++)
+        for (auto& s : sensors)
+            s->refresh(0.);
+    double sensors_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < NUM_ITERATIONS; i++)
+        for (auto& b : banks)
+            b->refresh(0.);
+    double banks_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Talos (" << sensors.size() << " sensors, " << banks.size() << " banks):" << std::endl;
+    std::cout << "  individual sensors: " << sensors_time / NUM_ITERATIONS * 1e6 << "us/refresh" << std::endl;
+    std::cout << "  sensor banks:       " << banks_time / NUM_ITERATIONS * 1e6 << "us/refresh"
+              << " (x" << sensors_time / banks_time << ")" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,52 @@
+#include <chrono>
+#include <iostream>
+
+#include <robot_dart/robot_dart_simu.hpp>
+#include <robot_dart/robots/talos.hpp>
+
+// Records all the sensors of Talos (IMU, force/torque and torque banks) and reads the recording back;
+// the duration of the simulation is compared with and without the recorder
+double run(bool record, const std::string& filename)
+{
+    auto robot = std::make_shared<robot_dart::robots::Talos>();
+    robot_dart::RobotDARTSimu simu(0.001);
+    simu.add_floor();
+    simu.add_robot(robot);
+
+    std::shared_ptr<robot_dart::sensor::Recorder> recorder;
+    if (record) {
+        recorder = std::make_shared<robot_dart::sensor::Recorder>(filename);
+        recorder->add_sensors(simu.sensors(robot));
+        recorder->start();
+        simu.set_recorder(recorder);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    simu.run(5.);
+    if (recorder)
+        recorder->stop();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main()
+{
+    std::string filename = "talos_sensors.rdrec";
+    double time = run(false, filename);
+    double record_time = run(true, filename);
+    std::cout << "5s of simulation: " << time << "s (" << record_time << "s with the recorder)" << std::endl;
+
+    robot_dart::sensor::RecordingReader reader(filename);
+    for (size_t i = 0; i < reader.num_streams(); i++) {
+        auto& stream = reader.stream(i);
+        std::cout << stream.name << " (" << stream.type << "): " << reader.num_records(i) << " records of " << stream.num_values << " values at " << stream.frequency << "Hz" << std::endl;
+    }
+
+    // the values of the chunks are used in place
+    int torques = reader.stream_index("t_bank_2");
+    if (torques >= 0 && reader.num_chunks(torques) > 0) {
+        auto values = reader.chunk_values(torques, reader.num_chunks(torques) - 1);
+        std::cout << "last torques: " << values.bottomRows(1) << std::endl;
+    }
+
+    return 0;
+}
@@ -62,4 +62,9 @@ simu.run(5.)
 img = camera.image()
 rd.gui.save_png_image('camera.png', img)
 
+# the view gives the pixels to numpy without any copy (height x width x 3)
+view = camera.image_view()
+pixels = np.asarray(view)
+print(pixels.shape)
+
 print(robot.positions())
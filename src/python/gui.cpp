@@ -7,12 +7,21 @@
 #ifdef GRAPHIC
 #include <robot_dart/gui/magnum/graphics.hpp>
 #include <robot_dart/gui/magnum/sensor/camera.hpp>
+#include <robot_dart/gui/magnum/sensor/camera_atlas.hpp>
 #include <robot_dart/gui/magnum/windowless_graphics.hpp>
 #endif
 
 namespace robot_dart {
     namespace python {
 #ifdef GRAPHIC
+        namespace {
+            // frees the GL context when leaving the scope (also when the Python code throws)
+            struct GLContextRelease {
+                Magnum::Platform::WindowlessGLContext* context;
+                ~GLContextRelease() { release_gl_context(context); }
+            };
+        } // namespace
+
         void py_gui(py::module& m)
         {
             auto sm = m.def_submodule("gui");
@@ -57,7 +66,7 @@ namespace robot_dart {
                 .def("record", &Camera::record,
                     py::arg("recording"),
                     py::arg("recording_depth") = false)
-                .def("record_video", &Camera::record_video)
+                .def("record_video", static_cast<void (Camera::*)(const std::string&, int)>(&Camera::record_video))
                 .def("recording", &Camera::recording)
                 .def("recording_depth", &Camera::recording_depth);
 
@@ -72,6 +81,27 @@ namespace robot_dart {
                 .def_readwrite("channels", &gui::Image::channels)
                 .def_readwrite("data", &gui::Image::data);
 
+            // numpy.asarray(view) does not copy the pixels (the view keeps the camera buffer alive)
+            py::class_<gui::ImageView>(sm, "ImageView", py::buffer_protocol())
+                .def_buffer([](const gui::ImageView& view) -> py::buffer_info {
+                    return py::buffer_info(
+                        const_cast<uint8_t*>(view.data),
+                        sizeof(uint8_t),
+                        py::format_descriptor<uint8_t>::format(),
+                        3,
+                        {static_cast<py::ssize_t>(view.height), static_cast<py::ssize_t>(view.width), static_cast<py::ssize_t>(view.channels)},
+                        {static_cast<py::ssize_t>(view.row_stride), static_cast<py::ssize_t>(view.channels), static_cast<py::ssize_t>(1)},
+                        true);
+                })
+
+                .def_readonly("width", &gui::ImageView::width)
+                .def_readonly("height", &gui::ImageView::height)
+                .def_readonly("channels", &gui::ImageView::channels)
+                .def_readonly("row_stride", &gui::ImageView::row_stride)
+                .def("empty", &gui::ImageView::empty)
+                .def("bottom_up", &gui::ImageView::bottom_up)
+                .def("copy", &gui::ImageView::copy);
+
             py::class_<gui::GrayscaleImage>(sm, "GrayscaleImage")
                 .def(py::init<size_t, size_t>(),
                     py::arg("width") = 0,
@@ -90,8 +120,31 @@ namespace robot_dart {
                 .def_readwrite("height", &gui::DepthImage::height)
                 .def_readwrite("data", &gui::DepthImage::data);
 
+            // numpy.asarray(view) does not copy the depth buffer
+            py::class_<gui::DepthView>(sm, "DepthView", py::buffer_protocol())
+                .def_buffer([](const gui::DepthView& view) -> py::buffer_info {
+                    return py::buffer_info(
+                        const_cast<float*>(view.data),
+                        sizeof(float),
+                        py::format_descriptor<float>::format(),
+                        2,
+                        {static_cast<py::ssize_t>(view.height), static_cast<py::ssize_t>(view.width)},
+                        {static_cast<py::ssize_t>(view.row_stride), static_cast<py::ssize_t>(view.pixel_stride * sizeof(float))},
+                        true);
+                })
+
+                .def_readonly("width", &gui::DepthView::width)
+                .def_readonly("height", &gui::DepthView::height)
+                .def_readonly("row_stride", &gui::DepthView::row_stride)
+                .def_readonly("pixel_stride", &gui::DepthView::pixel_stride)
+                .def_readonly("near_plane", &gui::DepthView::near_plane)
+                .def_readonly("far_plane", &gui::DepthView::far_plane)
+                .def_readonly("linear", &gui::DepthView::linear)
+                .def("empty", &gui::DepthView::empty)
+                .def("bottom_up", &gui::DepthView::bottom_up);
+
             py::class_<GraphicsConfiguration>(sm, "GraphicsConfiguration")
-                .def(py::init<size_t, size_t, const std::string&, bool, bool, size_t, size_t, double, bool, bool, bool, const Eigen::Vector4d&>(),
+                .def(py::init<size_t, size_t, const std::string&, bool, bool, size_t, size_t, double, bool, bool, bool, const Eigen::Vector4d&, bool, size_t, const std::vector<size_t>&, bool>(),
                     py::arg("width") = 640,
                     py::arg("height") = 480,
                     py::arg("title") = "DART",
@@ -103,7 +156,11 @@ namespace robot_dart {
                     py::arg("draw_main_camera") = true,
                     py::arg("draw_debug") = true,
                     py::arg("draw_text") = true,
-                    py::arg("bg_color") = Eigen::Vector4d(0.0, 0.0, 0.0, 1.0))
+                    py::arg("bg_color") = Eigen::Vector4d(0.0, 0.0, 0.0, 1.0),
+                    py::arg("instancing") = true,
+                    py::arg("shadow_update_period") = 1,
+                    py::arg("light_shadow_update_periods") = std::vector<size_t>(),
+                    py::arg("cache_static_shadows") = true)
 
                 .def_readwrite("width", &GraphicsConfiguration::width)
                 .def_readwrite("height", &GraphicsConfiguration::height)
@@ -120,7 +177,13 @@ namespace robot_dart {
                 .def_readwrite("draw_debug", &GraphicsConfiguration::draw_debug)
                 .def_readwrite("draw_text", &GraphicsConfiguration::draw_text)
 
-                .def_readwrite("bg_color", &GraphicsConfiguration::bg_color);
+                .def_readwrite("bg_color", &GraphicsConfiguration::bg_color)
+
+                .def_readwrite("instancing", &GraphicsConfiguration::instancing)
+
+                .def_readwrite("shadow_update_period", &GraphicsConfiguration::shadow_update_period)
+                .def_readwrite("light_shadow_update_periods", &GraphicsConfiguration::light_shadow_update_periods)
+                .def_readwrite("cache_static_shadows", &GraphicsConfiguration::cache_static_shadows);
 
             py::class_<gui::Base, std::shared_ptr<gui::Base>>(sm, "Base");
             py::class_<BaseWindowedGraphics, gui::Base, std::shared_ptr<BaseWindowedGraphics>>(sm, "BaseWindowedGraphics");
@@ -167,9 +230,11 @@ namespace robot_dart {
 
                 // Magnum::Image2D* magnum_image()
                 .def("image", &Graphics::image)
+                .def("image_view", &Graphics::image_view)
                 .def("depth_image", &Graphics::depth_image)
                 .def("raw_depth_image", &Graphics::raw_depth_image)
                 .def("depth_array", &Graphics::depth_array)
+                .def("depth_view", &Graphics::depth_view)
 
                 .def("camera", static_cast<Camera& (Graphics::*)()>(&Graphics::camera), py::return_value_policy::reference)
                 .def("camera_intrinsic_matrix", &Graphics::camera_intrinsic_matrix)
@@ -215,9 +280,11 @@ namespace robot_dart {
 
                 // Magnum::Image2D* magnum_image()
                 .def("image", &WindowlessGraphics::image)
+                .def("image_view", &WindowlessGraphics::image_view)
                 .def("depth_image", &WindowlessGraphics::depth_image)
                 .def("raw_depth_image", &WindowlessGraphics::raw_depth_image)
                 .def("depth_array", &WindowlessGraphics::depth_array)
+                .def("depth_view", &WindowlessGraphics::depth_view)
 
                 .def("camera", static_cast<Camera& (WindowlessGraphics::*)()>(&WindowlessGraphics::camera), py::return_value_policy::reference)
                 .def("camera_intrinsic_matrix", &WindowlessGraphics::camera_intrinsic_matrix)
@@ -229,12 +296,24 @@ namespace robot_dart {
 
             sm.def(
                 "run_with_gl_context", +[](const std::function<void()>& func, size_t wait_ms) {
+                    /* Wait for the GL context without the GIL (the Python threads that hold the contexts need it) */
+                    py::gil_scoped_release release;
                     get_gl_context_with_sleep(my_context, wait_ms);
+                    GLContextRelease context_release{my_context};
                     /* Acquire GIL before calling Python code */
                     py::gil_scoped_acquire acquire;
                     func();
+                });
+
+            sm.def(
+                "run_with_gl_context_timeout", +[](const std::function<void()>& func, size_t timeout_ms) {
+                    /* Wait for the GL context without the GIL (the Python threads that hold the contexts need it) */
                     py::gil_scoped_release release;
-                    release_gl_context(my_context);
+                    get_gl_context_with_timeout(my_context, timeout_ms);
+                    GLContextRelease context_release{my_context};
+                    /* Acquire GIL before calling Python code */
+                    py::gil_scoped_acquire acquire;
+                    func();
                 });
 
             sm.def(
@@ -242,6 +321,31 @@ namespace robot_dart {
                     gui::magnum::GlobalData::instance()->set_max_contexts(num_contexts);
                 });
 
+            sm.def(
+                "max_contexts", +[]() {
+                    return gui::magnum::GlobalData::instance()->max_contexts();
+                });
+
+            py::enum_<gui::magnum::GLBackend>(sm, "GLBackend")
+                .value("Auto", gui::magnum::GLBackend::Auto)
+                .value("Hardware", gui::magnum::GLBackend::Hardware)
+                .value("Software", gui::magnum::GLBackend::Software);
+
+            sm.def(
+                "set_gl_backend", +[](gui::magnum::GLBackend backend) {
+                    gui::magnum::GlobalData::instance()->set_backend(backend);
+                });
+
+            sm.def(
+                "gl_backend", +[]() {
+                    return gui::magnum::GlobalData::instance()->backend();
+                });
+
+            py::enum_<gui::magnum::gs::DepthMode>(sm, "DepthMode")
+                .value("Raw", gui::magnum::gs::DepthMode::Raw)
+                .value("Linear", gui::magnum::gs::DepthMode::Linear)
+                .value("LinearXYZ", gui::magnum::gs::DepthMode::LinearXYZ);
+
             // Camera sensor class
             py::class_<gui::magnum::sensor::Camera, robot_dart::sensor::Sensor, std::shared_ptr<gui::magnum::sensor::Camera>>(sensormodule, "Camera")
                 .def(py::init<gui::magnum::BaseApplication*, size_t, size_t, size_t, bool>(),
@@ -285,9 +389,38 @@ namespace robot_dart {
                 // Magnum::Image2D* magnum_depth_image()
 
                 .def("image", &gui::magnum::sensor::Camera::image)
+                .def("image_view", &gui::magnum::sensor::Camera::image_view)
                 .def("depth_image", &gui::magnum::sensor::Camera::depth_image)
                 .def("raw_depth_image", &gui::magnum::sensor::Camera::raw_depth_image)
-                .def("depth_array", &gui::magnum::sensor::Camera::depth_array);
+                .def("depth_array", &gui::magnum::sensor::Camera::depth_array)
+                .def("depth_view", &gui::magnum::sensor::Camera::depth_view)
+
+                .def("set_depth_mode", &gui::magnum::sensor::Camera::set_depth_mode)
+                .def("depth_mode", &gui::magnum::sensor::Camera::depth_mode);
+
+            // Camera atlas sensor class
+            py::class_<gui::magnum::sensor::CameraAtlas, robot_dart::sensor::Sensor, std::shared_ptr<gui::magnum::sensor::CameraAtlas>>(sensormodule, "CameraAtlas")
+                .def(py::init<gui::magnum::BaseApplication*, size_t, bool>(),
+                    py::arg("app"),
+                    py::arg("freq") = 30,
+                    py::arg("draw_ghost") = false)
+
+                .def("init", &gui::magnum::sensor::CameraAtlas::init)
+
+                .def("calculate", &gui::magnum::sensor::CameraAtlas::calculate)
+
+                .def("type", &gui::magnum::sensor::CameraAtlas::type)
+
+                .def("add_camera", &gui::magnum::sensor::CameraAtlas::add_camera,
+                    py::arg("width"),
+                    py::arg("height"),
+                    py::arg("freq") = 0)
+                .def("remove_camera", &gui::magnum::sensor::CameraAtlas::remove_camera)
+                .def("cameras", &gui::magnum::sensor::CameraAtlas::cameras)
+
+                .def("drawing_debug", &gui::magnum::sensor::CameraAtlas::drawing_debug)
+                .def("draw_debug", &gui::magnum::sensor::CameraAtlas::draw_debug,
+                    py::arg("draw") = true);
 
             // Helper functions
             sm.def("save_png_image", static_cast<void (*)(const std::string&, const gui::Image&)>(&gui::save_png_image));
@@ -299,6 +432,38 @@ namespace robot_dart {
                 py::arg("tf"),
                 py::arg("far_plane") = 1000.);
 
+            // the points are returned as a 3xN array (copied from the buffer of the generator)
+            py::class_<gui::PointCloudGenerator>(sm, "PointCloudGenerator")
+                .def(py::init<size_t>(),
+                    py::arg("num_threads") = 1)
+
+                .def("set_intrinsics", &gui::PointCloudGenerator::set_intrinsics,
+                    py::arg("intrinsic_matrix"),
+                    py::arg("width"),
+                    py::arg("height"),
+                    py::arg("stride") = 1)
+                .def("set_num_threads", &gui::PointCloudGenerator::set_num_threads)
+                .def("num_threads", &gui::PointCloudGenerator::num_threads)
+                .def("max_points", &gui::PointCloudGenerator::max_points)
+
+                .def(
+                    "compute", +[](gui::PointCloudGenerator& self, const gui::DepthView& depth, const Eigen::Matrix4d& tf) {
+                        Eigen::Matrix3Xf points;
+                        size_t n = self.compute(depth, tf, points);
+                        return Eigen::Matrix3Xf(points.leftCols(n));
+                    },
+                    py::arg("depth"),
+                    py::arg("tf"))
+                .def(
+                    "compute", +[](gui::PointCloudGenerator& self, const gui::DepthImage& depth, const Eigen::Matrix4d& tf, double far_plane) {
+                        Eigen::Matrix3Xf points;
+                        size_t n = self.compute(depth, tf, far_plane, points);
+                        return Eigen::Matrix3Xf(points.leftCols(n));
+                    },
+                    py::arg("depth"),
+                    py::arg("tf"),
+                    py::arg("far_plane") = 1000.);
+
             // Material class
             using Material = gui::magnum::gs::Material;
             py::class_<Material>(sm, "Material")
@@ -49,6 +49,14 @@ namespace robot_dart {
                 }
             };
 
+            // DofSelection class
+            py::class_<DofSelection>(m, "DofSelection")
+                .def_static("none", &DofSelection::none)
+                .def("names", &DofSelection::names)
+                .def("indices", &DofSelection::indices)
+                .def("size", &DofSelection::size)
+                .def("all", &DofSelection::all);
+
             // Robot class
             py::class_<Robot, PyRobot, std::shared_ptr<Robot>>(m, "Robot")
                 .def(py::init<const std::string&, const std::vector<std::pair<std::string, std::string>>&, const std::string&, bool, bool>(),
@@ -253,79 +261,144 @@ namespace robot_dart {
                 .def("com_velocity", &Robot::com_velocity)
                 .def("com_acceleration", &Robot::com_acceleration)
 
-                .def("positions", &Robot::positions,
+                .def("positions", static_cast<Eigen::VectorXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::positions),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("set_positions", &Robot::set_positions,
+                .def("positions", static_cast<Eigen::VectorXd (Robot::*)(const DofSelection&) const>(&Robot::positions),
+                    py::arg("dofs"))
+                .def("set_positions", static_cast<void (Robot::*)(const Eigen::VectorXd&, const std::vector<std::string>&)>(&Robot::set_positions),
                     py::arg("positions"),
                     py::arg("dof_names") = std::vector<std::string>())
+                .def("set_positions", static_cast<void (Robot::*)(const Eigen::VectorXd&, const DofSelection&)>(&Robot::set_positions),
+                    py::arg("positions"),
+                    py::arg("dofs"))
 
-                .def("position_lower_limits", &Robot::position_lower_limits,
+                .def("position_lower_limits", static_cast<Eigen::VectorXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::position_lower_limits),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("set_position_lower_limits", &Robot::set_position_lower_limits,
+                .def("position_lower_limits", static_cast<Eigen::VectorXd (Robot::*)(const DofSelection&) const>(&Robot::position_lower_limits),
+                    py::arg("dofs"))
+                .def("set_position_lower_limits", static_cast<void (Robot::*)(const Eigen::VectorXd&, const std::vector<std::string>&)>(&Robot::set_position_lower_limits),
                     py::arg("positions"),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("position_upper_limits", &Robot::position_upper_limits,
+                .def("set_position_lower_limits", static_cast<void (Robot::*)(const Eigen::VectorXd&, const DofSelection&)>(&Robot::set_position_lower_limits),
+                    py::arg("positions"),
+                    py::arg("dofs"))
+                .def("position_upper_limits", static_cast<Eigen::VectorXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::position_upper_limits),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("set_position_upper_limits", &Robot::set_position_upper_limits,
+                .def("position_upper_limits", static_cast<Eigen::VectorXd (Robot::*)(const DofSelection&) const>(&Robot::position_upper_limits),
+                    py::arg("dofs"))
+                .def("set_position_upper_limits", static_cast<void (Robot::*)(const Eigen::VectorXd&, const std::vector<std::string>&)>(&Robot::set_position_upper_limits),
                     py::arg("positions"),
                     py::arg("dof_names") = std::vector<std::string>())
+                .def("set_position_upper_limits", static_cast<void (Robot::*)(const Eigen::VectorXd&, const DofSelection&)>(&Robot::set_position_upper_limits),
+                    py::arg("positions"),
+                    py::arg("dofs"))
 
-                .def("velocities", &Robot::velocities,
+                .def("velocities", static_cast<Eigen::VectorXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::velocities),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("set_velocities", &Robot::set_velocities,
+                .def("velocities", static_cast<Eigen::VectorXd (Robot::*)(const DofSelection&) const>(&Robot::velocities),
+                    py::arg("dofs"))
+                .def("set_velocities", static_cast<void (Robot::*)(const Eigen::VectorXd&, const std::vector<std::string>&)>(&Robot::set_velocities),
                     py::arg("velocities"),
                     py::arg("dof_names") = std::vector<std::string>())
+                .def("set_velocities", static_cast<void (Robot::*)(const Eigen::VectorXd&, const DofSelection&)>(&Robot::set_velocities),
+                    py::arg("velocities"),
+                    py::arg("dofs"))
 
-                .def("velocity_lower_limits", &Robot::velocity_lower_limits,
+                .def("velocity_lower_limits", static_cast<Eigen::VectorXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::velocity_lower_limits),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("set_velocity_lower_limits", &Robot::set_velocity_lower_limits,
+                .def("velocity_lower_limits", static_cast<Eigen::VectorXd (Robot::*)(const DofSelection&) const>(&Robot::velocity_lower_limits),
+                    py::arg("dofs"))
+                .def("set_velocity_lower_limits", static_cast<void (Robot::*)(const Eigen::VectorXd&, const std::vector<std::string>&)>(&Robot::set_velocity_lower_limits),
                     py::arg("velocities"),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("velocity_upper_limits", &Robot::velocity_upper_limits,
+                .def("set_velocity_lower_limits", static_cast<void (Robot::*)(const Eigen::VectorXd&, const DofSelection&)>(&Robot::set_velocity_lower_limits),
+                    py::arg("velocities"),
+                    py::arg("dofs"))
+                .def("velocity_upper_limits", static_cast<Eigen::VectorXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::velocity_upper_limits),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("set_velocity_upper_limits", &Robot::set_velocity_upper_limits,
+                .def("velocity_upper_limits", static_cast<Eigen::VectorXd (Robot::*)(const DofSelection&) const>(&Robot::velocity_upper_limits),
+                    py::arg("dofs"))
+                .def("set_velocity_upper_limits", static_cast<void (Robot::*)(const Eigen::VectorXd&, const std::vector<std::string>&)>(&Robot::set_velocity_upper_limits),
                     py::arg("velocities"),
                     py::arg("dof_names") = std::vector<std::string>())
+                .def("set_velocity_upper_limits", static_cast<void (Robot::*)(const Eigen::VectorXd&, const DofSelection&)>(&Robot::set_velocity_upper_limits),
+                    py::arg("velocities"),
+                    py::arg("dofs"))
 
-                .def("accelerations", &Robot::accelerations,
+                .def("accelerations", static_cast<Eigen::VectorXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::accelerations),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("set_accelerations", &Robot::set_accelerations,
+                .def("accelerations", static_cast<Eigen::VectorXd (Robot::*)(const DofSelection&) const>(&Robot::accelerations),
+                    py::arg("dofs"))
+                .def("set_accelerations", static_cast<void (Robot::*)(const Eigen::VectorXd&, const std::vector<std::string>&)>(&Robot::set_accelerations),
                     py::arg("accelerations"),
                     py::arg("dof_names") = std::vector<std::string>())
+                .def("set_accelerations", static_cast<void (Robot::*)(const Eigen::VectorXd&, const DofSelection&)>(&Robot::set_accelerations),
+                    py::arg("accelerations"),
+                    py::arg("dofs"))
 
-                .def("acceleration_lower_limits", &Robot::acceleration_lower_limits,
+                .def("acceleration_lower_limits", static_cast<Eigen::VectorXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::acceleration_lower_limits),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("set_acceleration_lower_limits", &Robot::set_acceleration_lower_limits,
+                .def("acceleration_lower_limits", static_cast<Eigen::VectorXd (Robot::*)(const DofSelection&) const>(&Robot::acceleration_lower_limits),
+                    py::arg("dofs"))
+                .def("set_acceleration_lower_limits", static_cast<void (Robot::*)(const Eigen::VectorXd&, const std::vector<std::string>&)>(&Robot::set_acceleration_lower_limits),
                     py::arg("accelerations"),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("acceleration_upper_limits", &Robot::acceleration_upper_limits,
+                .def("set_acceleration_lower_limits", static_cast<void (Robot::*)(const Eigen::VectorXd&, const DofSelection&)>(&Robot::set_acceleration_lower_limits),
+                    py::arg("accelerations"),
+                    py::arg("dofs"))
+                .def("acceleration_upper_limits", static_cast<Eigen::VectorXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::acceleration_upper_limits),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("set_acceleration_upper_limits", &Robot::set_acceleration_upper_limits,
+                .def("acceleration_upper_limits", static_cast<Eigen::VectorXd (Robot::*)(const DofSelection&) const>(&Robot::acceleration_upper_limits),
+                    py::arg("dofs"))
+                .def("set_acceleration_upper_limits", static_cast<void (Robot::*)(const Eigen::VectorXd&, const std::vector<std::string>&)>(&Robot::set_acceleration_upper_limits),
                     py::arg("accelerations"),
                     py::arg("dof_names") = std::vector<std::string>())
+                .def("set_acceleration_upper_limits", static_cast<void (Robot::*)(const Eigen::VectorXd&, const DofSelection&)>(&Robot::set_acceleration_upper_limits),
+                    py::arg("accelerations"),
+                    py::arg("dofs"))
 
-                .def("forces", &Robot::forces,
+                .def("forces", static_cast<Eigen::VectorXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::forces),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("set_forces", &Robot::set_forces,
+                .def("forces", static_cast<Eigen::VectorXd (Robot::*)(const DofSelection&) const>(&Robot::forces),
+                    py::arg("dofs"))
+                .def("set_forces", static_cast<void (Robot::*)(const Eigen::VectorXd&, const std::vector<std::string>&)>(&Robot::set_forces),
                     py::arg("forces"),
                     py::arg("dof_names") = std::vector<std::string>())
+                .def("set_forces", static_cast<void (Robot::*)(const Eigen::VectorXd&, const DofSelection&)>(&Robot::set_forces),
+                    py::arg("forces"),
+                    py::arg("dofs"))
 
-                .def("force_lower_limits", &Robot::force_lower_limits,
+                .def("force_lower_limits", static_cast<Eigen::VectorXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::force_lower_limits),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("set_force_lower_limits", &Robot::set_force_lower_limits,
+                .def("force_lower_limits", static_cast<Eigen::VectorXd (Robot::*)(const DofSelection&) const>(&Robot::force_lower_limits),
+                    py::arg("dofs"))
+                .def("set_force_lower_limits", static_cast<void (Robot::*)(const Eigen::VectorXd&, const std::vector<std::string>&)>(&Robot::set_force_lower_limits),
                     py::arg("forces"),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("force_upper_limits", &Robot::force_upper_limits,
+                .def("set_force_lower_limits", static_cast<void (Robot::*)(const Eigen::VectorXd&, const DofSelection&)>(&Robot::set_force_lower_limits),
+                    py::arg("forces"),
+                    py::arg("dofs"))
+                .def("force_upper_limits", static_cast<Eigen::VectorXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::force_upper_limits),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("set_force_upper_limits", &Robot::set_force_upper_limits,
+                .def("force_upper_limits", static_cast<Eigen::VectorXd (Robot::*)(const DofSelection&) const>(&Robot::force_upper_limits),
+                    py::arg("dofs"))
+                .def("set_force_upper_limits", static_cast<void (Robot::*)(const Eigen::VectorXd&, const std::vector<std::string>&)>(&Robot::set_force_upper_limits),
                     py::arg("forces"),
                     py::arg("dof_names") = std::vector<std::string>())
+                .def("set_force_upper_limits", static_cast<void (Robot::*)(const Eigen::VectorXd&, const DofSelection&)>(&Robot::set_force_upper_limits),
+                    py::arg("forces"),
+                    py::arg("dofs"))
 
-                .def("commands", &Robot::commands,
+                .def("commands", static_cast<Eigen::VectorXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::commands),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("set_commands", &Robot::set_commands,
+                .def("commands", static_cast<Eigen::VectorXd (Robot::*)(const DofSelection&) const>(&Robot::commands),
+                    py::arg("dofs"))
+                .def("set_commands", static_cast<void (Robot::*)(const Eigen::VectorXd&, const std::vector<std::string>&)>(&Robot::set_commands),
                     py::arg("commands"),
                     py::arg("dof_names") = std::vector<std::string>())
+                .def("set_commands", static_cast<void (Robot::*)(const Eigen::VectorXd&, const DofSelection&)>(&Robot::set_commands),
+                    py::arg("commands"),
+                    py::arg("dofs"))
 
                 .def("force_torque", &Robot::force_torque)
 
@@ -398,37 +471,67 @@ namespace robot_dart {
                 .def("add_body_mass", static_cast<void (Robot::*)(const std::string& body_name, double mass)>(&Robot::add_body_mass))
                 .def("add_body_mass", static_cast<void (Robot::*)(size_t body_index, double mass)>(&Robot::add_body_mass))
 
-                .def("jacobian", &Robot::jacobian,
+                .def("jacobian", static_cast<Eigen::MatrixXd (Robot::*)(const std::string&, const std::vector<std::string>&) const>(&Robot::jacobian),
                     py::arg("body_name"),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("jacobian_deriv", &Robot::jacobian_deriv,
+                .def("jacobian", static_cast<Eigen::MatrixXd (Robot::*)(const std::string&, const DofSelection&) const>(&Robot::jacobian),
+                    py::arg("body_name"),
+                    py::arg("dofs"))
+                .def("jacobian_deriv", static_cast<Eigen::MatrixXd (Robot::*)(const std::string&, const std::vector<std::string>&) const>(&Robot::jacobian_deriv),
                     py::arg("body_name"),
                     py::arg("dof_names") = std::vector<std::string>())
+                .def("jacobian_deriv", static_cast<Eigen::MatrixXd (Robot::*)(const std::string&, const DofSelection&) const>(&Robot::jacobian_deriv),
+                    py::arg("body_name"),
+                    py::arg("dofs"))
 
-                .def("com_jacobian", &Robot::com_jacobian,
+                .def("com_jacobian", static_cast<Eigen::MatrixXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::com_jacobian),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("com_jacobian_deriv", &Robot::com_jacobian_deriv,
+                .def("com_jacobian", static_cast<Eigen::MatrixXd (Robot::*)(const DofSelection&) const>(&Robot::com_jacobian),
+                    py::arg("dofs"))
+                .def("com_jacobian_deriv", static_cast<Eigen::MatrixXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::com_jacobian_deriv),
                     py::arg("dof_names") = std::vector<std::string>())
+                .def("com_jacobian_deriv", static_cast<Eigen::MatrixXd (Robot::*)(const DofSelection&) const>(&Robot::com_jacobian_deriv),
+                    py::arg("dofs"))
 
-                .def("mass_matrix", &Robot::mass_matrix,
+                .def("mass_matrix", static_cast<Eigen::MatrixXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::mass_matrix),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("aug_mass_matrix", &Robot::aug_mass_matrix,
+                .def("mass_matrix", static_cast<Eigen::MatrixXd (Robot::*)(const DofSelection&) const>(&Robot::mass_matrix),
+                    py::arg("dofs"))
+                .def("aug_mass_matrix", static_cast<Eigen::MatrixXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::aug_mass_matrix),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("inv_mass_matrix", &Robot::inv_mass_matrix,
+                .def("aug_mass_matrix", static_cast<Eigen::MatrixXd (Robot::*)(const DofSelection&) const>(&Robot::aug_mass_matrix),
+                    py::arg("dofs"))
+                .def("inv_mass_matrix", static_cast<Eigen::MatrixXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::inv_mass_matrix),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("inv_aug_mass_matrix", &Robot::inv_aug_mass_matrix,
+                .def("inv_mass_matrix", static_cast<Eigen::MatrixXd (Robot::*)(const DofSelection&) const>(&Robot::inv_mass_matrix),
+                    py::arg("dofs"))
+                .def("inv_aug_mass_matrix", static_cast<Eigen::MatrixXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::inv_aug_mass_matrix),
                     py::arg("dof_names") = std::vector<std::string>())
+                .def("inv_aug_mass_matrix", static_cast<Eigen::MatrixXd (Robot::*)(const DofSelection&) const>(&Robot::inv_aug_mass_matrix),
+                    py::arg("dofs"))
 
-                .def("coriolis_forces", &Robot::coriolis_forces,
+                .def("coriolis_forces", static_cast<Eigen::VectorXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::coriolis_forces),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("gravity_forces", &Robot::gravity_forces,
+                .def("coriolis_forces", static_cast<Eigen::VectorXd (Robot::*)(const DofSelection&) const>(&Robot::coriolis_forces),
+                    py::arg("dofs"))
+                .def("gravity_forces", static_cast<Eigen::VectorXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::gravity_forces),
                     py::arg("dof_names") = std::vector<std::string>())
-                .def("coriolis_gravity_forces", &Robot::coriolis_gravity_forces,
+                .def("gravity_forces", static_cast<Eigen::VectorXd (Robot::*)(const DofSelection&) const>(&Robot::gravity_forces),
+                    py::arg("dofs"))
+                .def("coriolis_gravity_forces", static_cast<Eigen::VectorXd (Robot::*)(const std::vector<std::string>&) const>(&Robot::coriolis_gravity_forces),
                     py::arg("dof_names") = std::vector<std::string>())
+                .def("coriolis_gravity_forces", static_cast<Eigen::VectorXd (Robot::*)(const DofSelection&) const>(&Robot::coriolis_gravity_forces),
+                    py::arg("dofs"))
 
-                .def("vec_dof", &Robot::vec_dof,
+                .def("vec_dof", static_cast<Eigen::VectorXd (Robot::*)(const Eigen::VectorXd&, const std::vector<std::string>&) const>(&Robot::vec_dof),
                     py::arg("vec"),
                     py::arg("dof_names"))
+                .def("vec_dof", static_cast<Eigen::VectorXd (Robot::*)(const Eigen::VectorXd&, const DofSelection&) const>(&Robot::vec_dof),
+                    py::arg("vec"),
+                    py::arg("dofs"))
+
+                .def("dof_selection", &Robot::dof_selection,
+                    py::arg("dof_names") = std::vector<std::string>())
 
                 .def("update_joint_dof_maps", &Robot::update_joint_dof_maps)
                 .def("dof_map", &Robot::dof_map)
@@ -558,7 +661,9 @@ namespace robot_dart {
                 .def("ft_wrist_left", &Talos::ft_foot_left, py::return_value_policy::reference)
                 .def("ft_wrist_right", &Talos::ft_foot_right, py::return_value_policy::reference)
 
-                .def("torques", &Talos::torques);
+                .def("torques", &Talos::torques)
+                .def("ft_bank", &Talos::ft_bank, py::return_value_policy::reference)
+                .def("torque_bank", &Talos::torque_bank, py::return_value_policy::reference);
 
             py::class_<TalosLight, Talos, std::shared_ptr<TalosLight>>(m, "TalosLight")
                 .def(py::init<size_t, const std::string&, const std::vector<std::pair<std::string, std::string>>&>(),
@@ -5,7 +5,9 @@
 #include <robot_dart/robot_dart_simu.hpp>
 #include <robot_dart/sensor/force_torque.hpp>
 #include <robot_dart/sensor/imu.hpp>
+#include <robot_dart/sensor/recorder.hpp>
 #include <robot_dart/sensor/sensor.hpp>
+#include <robot_dart/sensor/torque.hpp>
 
 namespace robot_dart {
     namespace python {
@@ -96,6 +98,12 @@ namespace robot_dart {
                 using Sensor::_joint_attached;
             };
 
+            py::class_<sensor::Snapshot>(sensormodule, "Snapshot")
+                .def(py::init<>())
+                .def_readwrite("time", &sensor::Snapshot::time)
+                .def_readwrite("sequence", &sensor::Snapshot::sequence)
+                .def_readwrite("values", &sensor::Snapshot::values);
+
             py::class_<Sensor, PySensor, std::shared_ptr<Sensor>>(sensormodule, "Sensor")
                 .def(py::init<size_t>(),
                     py::arg("freq") = 40)
@@ -135,6 +143,12 @@ namespace robot_dart {
                     py::arg("t"))
                 .def("type", &Sensor::type)
 
+                .def("attached_to_robot", &Sensor::attached_to_robot,
+                    py::arg("robot"))
+
+                .def("snapshot_size", &Sensor::snapshot_size)
+                .def("snapshot", static_cast<sensor::Snapshot (Sensor::*)() const>(&Sensor::snapshot))
+
                 .def("attach_to_body", static_cast<void (Sensor::*)(dart::dynamics::BodyNode*, const Eigen::Isometry3d& tf)>(&Sensor::attach_to_body),
                     py::arg("body"),
                     py::arg("tf") = Eigen::Isometry3d::Identity())
@@ -188,6 +202,83 @@ namespace robot_dart {
                     py::arg("body"),
                     py::arg("tf") = Eigen::Isometry3d::Identity());
 
+            py::class_<sensor::ForceTorqueBank, Sensor, std::shared_ptr<sensor::ForceTorqueBank>>(sensormodule, "ForceTorqueBank")
+                .def(py::init<size_t>(),
+                    py::arg("frequency") = 1000)
+
+                .def("add_joint", static_cast<size_t (sensor::ForceTorqueBank::*)(dart::dynamics::Joint*, const std::string&)>(&sensor::ForceTorqueBank::add_joint),
+                    py::arg("joint"),
+                    py::arg("direction") = "child_to_parent")
+                .def("add_joint", static_cast<size_t (sensor::ForceTorqueBank::*)(const std::shared_ptr<Robot>&, const std::string&, const std::string&)>(&sensor::ForceTorqueBank::add_joint),
+                    py::arg("robot"),
+                    py::arg("joint_name"),
+                    py::arg("direction") = "child_to_parent")
+                .def("add_sensor", &sensor::ForceTorqueBank::add_sensor,
+                    py::arg("sensor"))
+
+                .def("init", &sensor::ForceTorqueBank::init)
+                .def("calculate", &sensor::ForceTorqueBank::calculate,
+                    py::arg("t"))
+                .def("type", &sensor::ForceTorqueBank::type)
+
+                .def("num_joints", &sensor::ForceTorqueBank::num_joints)
+                .def("joint", &sensor::ForceTorqueBank::joint, py::return_value_policy::reference,
+                    py::arg("index"))
+                .def("wrenches", &sensor::ForceTorqueBank::wrenches)
+                .def("wrench", &sensor::ForceTorqueBank::wrench,
+                    py::arg("index"))
+                .def("force", &sensor::ForceTorqueBank::force,
+                    py::arg("index"))
+                .def("torque", &sensor::ForceTorqueBank::torque,
+                    py::arg("index"));
+
+            // Torque Sensor Class
+            py::class_<sensor::Torque, Sensor, std::shared_ptr<sensor::Torque>>(sensormodule, "Torque")
+                .def(py::init<dart::dynamics::Joint*, size_t>(),
+                    py::arg("joint"),
+                    py::arg("frequency") = 1000)
+                .def(py::init<const std::shared_ptr<Robot>&, const std::string&, size_t>(),
+                    py::arg("robot"),
+                    py::arg("joint_name"),
+                    py::arg("frequency") = 1000)
+
+                .def("init", &sensor::Torque::init)
+                .def("calculate", &sensor::Torque::calculate,
+                    py::arg("t"))
+                .def("type", &sensor::Torque::type)
+
+                .def("torques", &sensor::Torque::torques);
+
+            py::class_<sensor::TorqueBank, Sensor, std::shared_ptr<sensor::TorqueBank>>(sensormodule, "TorqueBank")
+                .def(py::init<size_t>(),
+                    py::arg("frequency") = 1000)
+                .def(py::init<const std::vector<dart::dynamics::Joint*>&, size_t>(),
+                    py::arg("joints"),
+                    py::arg("frequency") = 1000)
+
+                .def("add_joint", static_cast<size_t (sensor::TorqueBank::*)(dart::dynamics::Joint*)>(&sensor::TorqueBank::add_joint),
+                    py::arg("joint"))
+                .def("add_joint", static_cast<size_t (sensor::TorqueBank::*)(const std::shared_ptr<Robot>&, const std::string&)>(&sensor::TorqueBank::add_joint),
+                    py::arg("robot"),
+                    py::arg("joint_name"))
+                .def("add_sensor", &sensor::TorqueBank::add_sensor,
+                    py::arg("sensor"))
+
+                .def("init", &sensor::TorqueBank::init)
+                .def("calculate", &sensor::TorqueBank::calculate,
+                    py::arg("t"))
+                .def("type", &sensor::TorqueBank::type)
+
+                .def("num_joints", &sensor::TorqueBank::num_joints)
+                .def("joint", &sensor::TorqueBank::joint, py::return_value_policy::reference,
+                    py::arg("index"))
+                .def("offset", &sensor::TorqueBank::offset,
+                    py::arg("index"))
+                .def("torques", static_cast<const Eigen::VectorXd& (sensor::TorqueBank::*)() const>(&sensor::TorqueBank::torques))
+                .def(
+                    "torques", [](const sensor::TorqueBank& bank, size_t index) -> Eigen::VectorXd { return bank.torques(index); },
+                    py::arg("index"));
+
             // IMU Sensor Class
             py::class_<sensor::IMUConfig>(sensormodule, "IMUConfig")
                 .def(py::init<const Eigen::Vector3d&, const Eigen::Vector3d&, dart::dynamics::BodyNode*, size_t>(),
@@ -235,6 +326,73 @@ namespace robot_dart {
                 .def("attach_to_joint", static_cast<void (sensor::IMU::*)(dart::dynamics::Joint*, const Eigen::Isometry3d& tf)>(&sensor::ForceTorque::attach_to_joint),
                     py::arg("joint"),
                     py::arg("tf") = Eigen::Isometry3d::Identity());
+
+            // Recording
+            py::class_<sensor::Recorder, std::shared_ptr<sensor::Recorder>>(sensormodule, "Recorder")
+                .def(py::init<const std::string&, size_t>(),
+                    py::arg("filename"),
+                    py::arg("chunk_size") = 1000)
+
+                .def("add_sensor", &sensor::Recorder::add_sensor,
+                    py::arg("sensor"),
+                    py::arg("name") = "",
+                    py::arg("blobs") = false)
+                .def("add_sensors", &sensor::Recorder::add_sensors,
+                    py::arg("sensors"))
+
+                .def("start", &sensor::Recorder::start)
+                .def("stop", &sensor::Recorder::stop)
+                .def("recording", &sensor::Recorder::recording)
+
+                .def("filename", &sensor::Recorder::filename)
+                .def("num_streams", &sensor::Recorder::num_streams);
+
+            py::class_<sensor::RecordingReader::StreamInfo>(sensormodule, "RecordingStreamInfo")
+                .def_readonly("name", &sensor::RecordingReader::StreamInfo::name)
+                .def_readonly("type", &sensor::RecordingReader::StreamInfo::type)
+                .def_readonly("num_values", &sensor::RecordingReader::StreamInfo::num_values)
+                .def_readonly("frequency", &sensor::RecordingReader::StreamInfo::frequency)
+                .def_readonly("has_blobs", &sensor::RecordingReader::StreamInfo::has_blobs);
+
+            // the chunks and the blobs are numpy arrays that use the mapped file (they keep the reader alive)
+            py::class_<sensor::RecordingReader, std::shared_ptr<sensor::RecordingReader>>(sensormodule, "RecordingReader")
+                .def(py::init<const std::string&>(),
+                    py::arg("filename"))
+
+                .def("num_streams", &sensor::RecordingReader::num_streams)
+                .def("stream", &sensor::RecordingReader::stream, py::return_value_policy::reference_internal,
+                    py::arg("index"))
+                .def("stream_index", &sensor::RecordingReader::stream_index,
+                    py::arg("name"))
+
+                .def("num_records", &sensor::RecordingReader::num_records,
+                    py::arg("stream"))
+                .def("num_chunks", &sensor::RecordingReader::num_chunks,
+                    py::arg("stream"))
+                .def("chunk_times", &sensor::RecordingReader::chunk_times, py::return_value_policy::reference_internal,
+                    py::arg("stream"),
+                    py::arg("index"))
+                .def("chunk_values", &sensor::RecordingReader::chunk_values, py::return_value_policy::reference_internal,
+                    py::arg("stream"),
+                    py::arg("index"))
+
+                .def("times", &sensor::RecordingReader::times,
+                    py::arg("stream"))
+                .def("values", &sensor::RecordingReader::values,
+                    py::arg("stream"))
+
+                .def("num_blobs", &sensor::RecordingReader::num_blobs,
+                    py::arg("stream"))
+                .def(
+                    "blob", [](py::object self, size_t stream, size_t index) {
+                        auto blob = self.cast<const sensor::RecordingReader&>().blob(stream, index);
+                        py::array_t<uint8_t> data({blob.size}, {sizeof(uint8_t)}, blob.data, self);
+                    // the file is mapped read-only
+                    data.attr("flags").attr("writeable") = false;
+                        return py::make_tuple(blob.time, data);
+                    },
+                    py::arg("stream"),
+                    py::arg("index"));
         }
     } // namespace python
 } // namespace robot_dart
\ No newline at end of file
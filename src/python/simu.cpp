@@ -61,8 +61,15 @@ namespace robot_dart {
                 .def("add_sensor", static_cast<void (RobotDARTSimu::*)(const std::shared_ptr<sensor::Sensor>&)>(&RobotDARTSimu::add_sensor),
                     py::keep_alive<2, 1>(),
                     py::arg("sensor"))
-                .def("sensors", &RobotDARTSimu::sensors)
+                .def("sensors", static_cast<std::vector<std::shared_ptr<sensor::Sensor>> (RobotDARTSimu::*)() const>(&RobotDARTSimu::sensors))
+                .def("sensors", static_cast<std::vector<std::shared_ptr<sensor::Sensor>> (RobotDARTSimu::*)(const std::shared_ptr<Robot>&) const>(&RobotDARTSimu::sensors),
+                    py::arg("robot"))
                 .def("sensor", &RobotDARTSimu::sensor)
+                .def("set_recorder", &RobotDARTSimu::set_recorder,
+                    py::arg("recorder"))
+                .def("recorder", &RobotDARTSimu::recorder)
+                .def("sensor_snapshots", static_cast<std::vector<sensor::Snapshot> (RobotDARTSimu::*)(const std::shared_ptr<Robot>&) const>(&RobotDARTSimu::sensor_snapshots),
+                    py::arg("robot"))
 
                 .def("remove_sensor", static_cast<void (RobotDARTSimu::*)(const std::shared_ptr<sensor::Sensor>&)>(&RobotDARTSimu::remove_sensor))
                 .def("remove_sensor", static_cast<void (RobotDARTSimu::*)(size_t)>(&RobotDARTSimu::remove_sensor))
@@ -147,7 +154,21 @@ namespace robot_dart {
                 .def("remove_collision_masks", static_cast<void (RobotDARTSimu::*)(size_t, const std::string&)>(&RobotDARTSimu::remove_collision_masks))
                 .def("remove_collision_masks", static_cast<void (RobotDARTSimu::*)(size_t, size_t)>(&RobotDARTSimu::remove_collision_masks))
 
-                .def("remove_all_collision_masks", &RobotDARTSimu::remove_all_collision_masks);
+                .def("remove_all_collision_masks", &RobotDARTSimu::remove_all_collision_masks)
+
+                .def("set_static_pruning", &RobotDARTSimu::set_static_pruning,
+                    py::arg("enable") = true)
+                .def("static_pruning", &RobotDARTSimu::static_pruning)
+
+                .def("enable_sleeping", &RobotDARTSimu::enable_sleeping,
+                    py::arg("enable") = true,
+                    py::arg("velocity_threshold") = 1e-3,
+                    py::arg("steps") = 60)
+                .def("sleeping_enabled", &RobotDARTSimu::sleeping_enabled)
+                .def("sleeping", &RobotDARTSimu::sleeping)
+                .def("num_sleeping_robots", &RobotDARTSimu::num_sleeping_robots)
+                .def("wake_up", &RobotDARTSimu::wake_up)
+                .def("wake_up_all", &RobotDARTSimu::wake_up_all);
         }
     } // namespace python
 } // namespace robot_dart
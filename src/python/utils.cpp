@@ -18,6 +18,19 @@ namespace robot_dart {
                 .def("schedule", &Scheduler::schedule,
                     py::arg("frequency"))
 
+                .def("add_task", &Scheduler::add_task,
+                    py::arg("frequency"))
+                .def("remove_task", &Scheduler::remove_task,
+                    py::arg("id"))
+                .def("set_task_frequency", &Scheduler::set_task_frequency,
+                    py::arg("id"),
+                    py::arg("frequency"))
+                .def("task_frequency", &Scheduler::task_frequency,
+                    py::arg("id"))
+                .def("due_tasks", &Scheduler::due_tasks)
+                .def("due", &Scheduler::due,
+                    py::arg("id"))
+
                 .def("step", &Scheduler::step)
 
                 .def("reset", &Scheduler::reset,
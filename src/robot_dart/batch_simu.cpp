@@ -0,0 +1,269 @@
+#include <robot_dart/batch_simu.hpp>
+#include <robot_dart/control/batch_pd_control.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace robot_dart {
+    BatchSimu::BatchSimu(size_t num_worlds, double timestep, size_t num_threads) : _thread_pool(num_threads)
+    {
+        ROBOT_DART_EXCEPTION_ASSERT(num_worlds > 0, "BatchSimu: we need at least one world!");
+        for (size_t i = 0; i < num_worlds; i++)
+            _simus.push_back(std::make_shared<RobotDARTSimu>(timestep));
+        _robots.resize(num_worlds);
+        _pd_controllers.resize(num_worlds);
+    }
+
+    BatchSimu::~BatchSimu()
+    {
+        clear();
+    }
+
+    BatchSimu::simu_t BatchSimu::simu(size_t index) const
+    {
+        ROBOT_DART_ASSERT(index < _simus.size(), "World index out of bounds", nullptr);
+        return _simus[index];
+    }
+
+    BatchSimu::robot_t BatchSimu::robot(size_t world_index, size_t robot_index) const
+    {
+        ROBOT_DART_ASSERT(world_index < _robots.size(), "World index out of bounds", nullptr);
+        ROBOT_DART_ASSERT(robot_index < _robots[world_index].size(), "Robot index out of bounds", nullptr);
+        return _robots[world_index][robot_index];
+    }
+
+    void BatchSimu::add_robot(const robot_t& robot)
+    {
+        ROBOT_DART_EXCEPTION_ASSERT(robot, "BatchSimu: robot pointer is null!");
+        // cloning locks the template skeleton only while copying it, so this can be done in parallel
+        std::vector<robot_t> clones(_simus.size());
+        _thread_pool.parallel_for(_simus.size(), [&](size_t i) {
+            clones[i] = robot->clone();
+            _simus[i]->add_robot(clones[i]);
+        });
+
+        for (size_t i = 0; i < _simus.size(); i++)
+            _robots[i].push_back(clones[i]);
+    }
+
+    void BatchSimu::add_robot(RobotPool& pool, const std::string& name)
+    {
+        for (size_t i = 0; i < _simus.size(); i++) {
+            auto robot = pool.get_robot(name);
+            _pool_robots.push_back({&pool, robot});
+            _simus[i]->add_robot(robot);
+            _robots[i].push_back(robot);
+        }
+    }
+
+    void BatchSimu::add_floor(double floor_width, double floor_height, const Eigen::Isometry3d& tf, const std::string& floor_name)
+    {
+        for (size_t i = 0; i < _simus.size(); i++)
+            _robots[i].push_back(_simus[i]->add_floor(floor_width, floor_height, tf, floor_name));
+    }
+
+    void BatchSimu::add_checkerboard_floor(double floor_width, double floor_height, double size, const Eigen::Isometry3d& tf, const std::string& floor_name, const Eigen::Vector4d& first_color, const Eigen::Vector4d& second_color)
+    {
+        for (size_t i = 0; i < _simus.size(); i++)
+            _robots[i].push_back(_simus[i]->add_checkerboard_floor(floor_width, floor_height, size, tf, floor_name, first_color, second_color));
+    }
+
+    void BatchSimu::set_control_freq(int frequency)
+    {
+        for (auto& simu : _simus)
+            simu->set_control_freq(frequency);
+    }
+
+    void BatchSimu::set_collision_detector(const std::string& collision_detector)
+    {
+        for (auto& simu : _simus)
+            simu->set_collision_detector(collision_detector);
+    }
+
+    void BatchSimu::for_each(const world_func_t& func, bool parallel)
+    {
+        if (parallel)
+            _thread_pool.parallel_for(_simus.size(), [&](size_t i) { func(*_simus[i], i); });
+        else {
+            for (size_t i = 0; i < _simus.size(); i++)
+                func(*_simus[i], i);
+        }
+    }
+
+    std::vector<bool> BatchSimu::step(bool reset_commands)
+    {
+        // std::vector<bool> cannot be written concurrently
+        std::vector<char> done(_simus.size(), 0);
+        std::atomic<size_t> steps(0);
+
+        auto start = std::chrono::steady_clock::now();
+        // the commands of the PD batches are computed from the state of all the worlds before the step;
+        // otherwise the first controller of a batch would read the other worlds while they are stepped
+        _find_pd_batches();
+        for (auto batch : _pd_batches)
+            batch->update();
+
+        _thread_pool.parallel_for(_simus.size(), [&](size_t i) {
+            auto& simu = _simus[i];
+            if (simu->halted_sim()) {
+                done[i] = 1;
+                return;
+            }
+            done[i] = simu->step(reset_commands);
+            steps.fetch_add(1, std::memory_order_relaxed);
+        });
+        auto end = std::chrono::steady_clock::now();
+
+        _last_steps = steps.load();
+        _last_duration = std::chrono::duration<double>(end - start).count();
+        _total_steps += _last_steps;
+        _total_duration += _last_duration;
+
+        return std::vector<bool>(done.begin(), done.end());
+    }
+
+    void BatchSimu::run(double max_duration, bool reset_commands)
+    {
+        _run(max_duration, reset_commands);
+    }
+
+    void BatchSimu::clear()
+    {
+        for (auto& simu : _simus) {
+            simu->clear_sensors();
+            simu->clear_robots();
+        }
+        for (auto& robots : _robots)
+            robots.clear();
+        for (auto& pd : _pd_controllers)
+            pd = PDControllers();
+
+        _free_pool_robots();
+    }
+
+    void BatchSimu::_run(double max_duration, bool reset_commands, const std::function<void(size_t)>& post)
+    {
+        // like RobotDARTSimu::run(), the halted worlds are run again
+        for (auto& simu : _simus)
+            simu->stop_sim(false);
+
+        // the robots of a PD batch can be in several worlds: a batch cannot read them while they are stepped
+        _find_pd_batches();
+        if (!_pd_batches.empty()) {
+            _run_lock_step(max_duration, reset_commands, post);
+            return;
+        }
+
+        std::atomic<size_t> steps(0);
+
+        auto start = std::chrono::steady_clock::now();
+        // one task per world: work-stealing balances worlds that halt early or are more expensive
+        _thread_pool.parallel_for(_simus.size(), [&](size_t i) {
+            auto& simu = _simus[i];
+            double old_time = simu->world()->getTime();
+            simu->run(max_duration, reset_commands);
+            size_t n = static_cast<size_t>(std::round((simu->world()->getTime() - old_time) / simu->timestep()));
+            steps.fetch_add(n, std::memory_order_relaxed);
+
+            if (post)
+                post(i);
+        });
+        auto end = std::chrono::steady_clock::now();
+
+        _last_steps = steps.load();
+        _last_duration = std::chrono::duration<double>(end - start).count();
+        _total_steps += _last_steps;
+        _total_duration += _last_duration;
+    }
+
+    void BatchSimu::_run_lock_step(double max_duration, bool reset_commands, const std::function<void(size_t)>& post)
+    {
+        // same stopping conditions as RobotDARTSimu::run(), world by world
+        std::vector<double> start_times(_simus.size());
+        std::vector<char> running(_simus.size(), 1);
+        for (size_t i = 0; i < _simus.size(); i++)
+            start_times[i] = _simus[i]->world()->getTime();
+        std::atomic<size_t> steps(0);
+
+        auto start = std::chrono::steady_clock::now();
+        while (true) {
+            bool any = false;
+            for (size_t i = 0; i < _simus.size(); i++) {
+                auto& simu = _simus[i];
+                if (running[i] && (simu->world()->getTime() - start_times[i] - max_duration) >= -simu->timestep() / 2.)
+                    running[i] = 0;
+                any = any || running[i];
+            }
+            if (!any)
+                break;
+
+            // as in step(): the commands of the batches are computed before the worlds are stepped
+            _find_pd_batches();
+            for (auto batch : _pd_batches)
+                batch->update();
+
+            _thread_pool.parallel_for(_simus.size(), [&](size_t i) {
+                if (!running[i])
+                    return;
+                if (_simus[i]->step(reset_commands))
+                    running[i] = 0;
+                steps.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+
+        if (post)
+            _thread_pool.parallel_for(_simus.size(), post);
+        auto end = std::chrono::steady_clock::now();
+
+        _last_steps = steps.load();
+        _last_duration = std::chrono::duration<double>(end - start).count();
+        _total_steps += _last_steps;
+        _total_duration += _last_duration;
+    }
+
+    void BatchSimu::_find_pd_batches()
+    {
+        _pd_batches.clear();
+        for (size_t w = 0; w < _simus.size(); w++) {
+            if (_simus[w]->halted_sim())
+                continue;
+
+            // the controllers are searched again only if a robot or a controller was added or removed
+            const auto& robots = _simus[w]->robots();
+            const auto& known = _pd_controllers[w].robots;
+            bool changed = (known.size() != robots.size());
+            for (size_t r = 0; r < robots.size() && !changed; r++)
+                changed = (known[r].first != robots[r] || known[r].second != robots[r]->controllers_version());
+            if (changed)
+                _find_pd_controllers(w);
+
+            for (auto controller : _pd_controllers[w].controllers) {
+                if (controller->active() && std::find(_pd_batches.begin(), _pd_batches.end(), controller->batch().get()) == _pd_batches.end())
+                    _pd_batches.push_back(controller->batch().get());
+            }
+        }
+    }
+
+    void BatchSimu::_find_pd_controllers(size_t world_index)
+    {
+        auto& pd = _pd_controllers[world_index];
+        pd.robots.clear();
+        pd.controllers.clear();
+        for (auto& robot : _simus[world_index]->robots()) {
+            pd.robots.push_back({robot, robot->controllers_version()});
+            for (size_t i = 0; i < robot->num_controllers(); i++) {
+                auto controller = dynamic_cast<control::BatchPDControl*>(robot->controller(i).get());
+                if (controller)
+                    pd.controllers.push_back(controller);
+            }
+        }
+    }
+
+    void BatchSimu::_free_pool_robots()
+    {
+        for (auto& p : _pool_robots)
+            p.first->free_robot(p.second);
+        _pool_robots.clear();
+    }
+} // namespace robot_dart
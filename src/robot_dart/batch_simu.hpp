@@ -0,0 +1,125 @@
+#ifndef ROBOT_DART_BATCH_SIMU_HPP
+#define ROBOT_DART_BATCH_SIMU_HPP
+
+#include <robot_dart/robot_dart_simu.hpp>
+#include <robot_dart/robot_pool.hpp>
+#include <robot_dart/thread_pool.hpp>
+
+#include <functional>
+
+namespace robot_dart {
+    namespace control {
+        class BatchPDControl;
+        class PDBatch;
+    } // namespace control
+
+    /// N independent RobotDARTSimu worlds built from the same template and stepped
+    /// together over a work-stealing thread pool.
+    /// Robots added with add_robot() are cloned (Robot::clone(), controllers included)
+    /// or taken from a RobotPool for every world; world-specific things
+    /// (sensors, extra controllers, initial states) are set with for_each().
+    class BatchSimu {
+    public:
+        using simu_t = std::shared_ptr<RobotDARTSimu>;
+        using robot_t = std::shared_ptr<Robot>;
+        using world_func_t = std::function<void(RobotDARTSimu&, size_t)>;
+
+        /// num_threads = 0 uses all the hardware threads
+        BatchSimu(size_t num_worlds, double timestep = 0.015, size_t num_threads = 0);
+        ~BatchSimu();
+
+        BatchSimu(const BatchSimu&) = delete;
+        void operator=(const BatchSimu&) = delete;
+
+        size_t num_worlds() const { return _simus.size(); }
+        size_t num_threads() const { return _thread_pool.num_threads(); }
+
+        simu_t simu(size_t index) const;
+        const std::vector<simu_t>& simus() const { return _simus; }
+
+        /// robot `robot_index` (in order of addition) of world `world_index`
+        robot_t robot(size_t world_index, size_t robot_index) const;
+
+        /// adds a clone of `robot` to every world; the template robot itself is not added anywhere
+        void add_robot(const robot_t& robot);
+        /// adds a robot from `pool` to every world; robots are given back to the pool
+        /// when the BatchSimu is cleared or destroyed (the pool needs to outlive it)
+        /// The pool needs at least num_worlds() free robots, otherwise this blocks.
+        void add_robot(RobotPool& pool, const std::string& name = "robot");
+
+        void add_floor(double floor_width = 10.0, double floor_height = 0.1, const Eigen::Isometry3d& tf = Eigen::Isometry3d::Identity(), const std::string& floor_name = "floor");
+        void add_checkerboard_floor(double floor_width = 10.0, double floor_height = 0.1, double size = 1., const Eigen::Isometry3d& tf = Eigen::Isometry3d::Identity(), const std::string& floor_name = "checkerboard_floor", const Eigen::Vector4d& first_color = dart::Color::White(1.), const Eigen::Vector4d& second_color = dart::Color::Gray(1.));
+
+        void set_control_freq(int frequency);
+        void set_collision_detector(const std::string& collision_detector);
+
+        /// calls func(simu, world_index) for every world (in parallel if requested)
+        void for_each(const world_func_t& func, bool parallel = false);
+
+        /// one step of every world that is not halted; returns the per-world result of RobotDARTSimu::step()
+        /// The PD batches (control::PDBatch) of the robots are updated before the worlds are stepped in parallel.
+        std::vector<bool> step(bool reset_commands = false);
+        /// runs every world for max_duration seconds (or until it halts);
+        /// the worlds with PD batches (control::PDBatch) are stepped together, like with step()
+        void run(double max_duration = 5.0, bool reset_commands = false);
+
+        /// runs every world for max_duration seconds and then evaluates each one (in the worker thread)
+        template <typename Result>
+        std::vector<Result> run(double max_duration, const std::function<Result(RobotDARTSimu&, size_t)>& evaluate, bool reset_commands = false)
+        {
+            // we go through a wrapper to avoid writing concurrently to a std::vector<bool>
+            struct Slot {
+                Result value;
+            };
+            std::vector<Slot> slots(_simus.size());
+            _run(max_duration, reset_commands, [&](size_t i) { slots[i].value = evaluate(*_simus[i], i); });
+
+            std::vector<Result> results;
+            results.reserve(slots.size());
+            for (auto& slot : slots)
+                results.push_back(std::move(slot.value));
+            return results;
+        }
+
+        /// removes all robots (giving back the pool robots) and sensors from every world
+        void clear();
+
+        /// world steps (summed over all worlds) of the last step()/run() call
+        size_t last_steps() const { return _last_steps; }
+        /// wall-clock seconds of the last step()/run() call
+        double last_duration() const { return _last_duration; }
+        /// aggregate world steps per wall-clock second of the last step()/run() call
+        double last_steps_per_second() const { return (_last_duration > 0.) ? _last_steps / _last_duration : 0.; }
+
+        /// aggregate world steps per wall-clock second since construction
+        double steps_per_second() const { return (_total_duration > 0.) ? _total_steps / _total_duration : 0.; }
+        size_t total_steps() const { return _total_steps; }
+
+    protected:
+        ThreadPool _thread_pool;
+        std::vector<simu_t> _simus;
+        std::vector<std::vector<robot_t>> _robots;
+        // robots borrowed from pools: (pool, robot)
+        std::vector<std::pair<RobotPool*, robot_t>> _pool_robots;
+
+        size_t _last_steps = 0, _total_steps = 0;
+        double _last_duration = 0., _total_duration = 0.;
+
+        // BatchPDControl controllers of each world, found again only when its robots or their controllers change
+        struct PDControllers {
+            std::vector<std::pair<robot_t, size_t>> robots; // (robot, Robot::controllers_version())
+            std::vector<control::BatchPDControl*> controllers;
+        };
+        std::vector<PDControllers> _pd_controllers;
+        // PD batches of the active controllers of the worlds that are not halted (updated at every step)
+        std::vector<control::PDBatch*> _pd_batches;
+
+        void _run(double max_duration, bool reset_commands, const std::function<void(size_t)>& post = nullptr);
+        void _run_lock_step(double max_duration, bool reset_commands, const std::function<void(size_t)>& post);
+        void _free_pool_robots();
+        void _find_pd_batches();
+        void _find_pd_controllers(size_t world_index);
+    };
+} // namespace robot_dart
+
+#endif
@@ -0,0 +1,234 @@
+#include "batch_pd_control.hpp"
+#include "robot_dart/robot.hpp"
+#include "robot_dart/utils.hpp"
+#include "robot_dart/utils_headers_dart_dynamics.hpp"
+
+namespace robot_dart {
+    namespace control {
+        PDBatch::PDBatch(const Eigen::VectorXd& target, bool full_control, bool use_angular_errors) : _control_dof(target.size()), _default_target(target), _full_control(full_control), _use_angular_errors(use_angular_errors), _wrapped(Eigen::VectorXd::Zero(target.size())) {}
+        PDBatch::PDBatch(const Eigen::VectorXd& target, const std::vector<std::string>& controllable_dofs, bool use_angular_errors) : _control_dof(target.size()), _default_target(target), _full_control(false), _use_angular_errors(use_angular_errors), _controllable_dofs(controllable_dofs), _wrapped(Eigen::VectorXd::Zero(target.size()))
+        {
+            ROBOT_DART_EXCEPTION_ASSERT(controllable_dofs.size() == _control_dof, "PDBatch: The target size is not the same as the controllable DOFs!");
+        }
+
+        size_t PDBatch::num_robots() const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _controllers.size();
+        }
+
+        void PDBatch::set_pd(double Kp, double Kd)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _default_Kp = Kp;
+            _default_Kd = Kd;
+            _Kp.setConstant(Kp);
+            _Kd.setConstant(Kd);
+        }
+
+        void PDBatch::set_pd(size_t index, const Eigen::VectorXd& Kp, const Eigen::VectorXd& Kd)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ROBOT_DART_ASSERT(index < _controllers.size(), "PDBatch: Robot index out of bounds", );
+            ROBOT_DART_ASSERT(static_cast<size_t>(Kp.size()) == _control_dof, "PDBatch: The Kp size is not the same as the DOFs!", );
+            ROBOT_DART_ASSERT(static_cast<size_t>(Kd.size()) == _control_dof, "PDBatch: The Kd size is not the same as the DOFs!", );
+            _Kp.col(index) = Kp;
+            _Kd.col(index) = Kd;
+        }
+
+        std::pair<Eigen::VectorXd, Eigen::VectorXd> PDBatch::pd(size_t index) const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ROBOT_DART_ASSERT(index < _controllers.size(), "PDBatch: Robot index out of bounds", std::make_pair(Eigen::VectorXd(), Eigen::VectorXd()));
+            return std::make_pair(_Kp.col(index), _Kd.col(index));
+        }
+
+        void PDBatch::set_target(size_t index, const Eigen::VectorXd& target)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ROBOT_DART_ASSERT(index < _controllers.size(), "PDBatch: Robot index out of bounds", );
+            ROBOT_DART_ASSERT(static_cast<size_t>(target.size()) == _control_dof, "PDBatch: The target size is not the same as the DOFs!", );
+            _targets.col(index) = target;
+        }
+
+        Eigen::VectorXd PDBatch::target(size_t index) const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ROBOT_DART_ASSERT(index < _controllers.size(), "PDBatch: Robot index out of bounds", Eigen::VectorXd());
+            return _targets.col(index);
+        }
+
+        void PDBatch::update()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _external_updates = true;
+            _update();
+        }
+
+        Eigen::MatrixXd PDBatch::commands() const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _commands;
+        }
+
+        size_t PDBatch::_add(BatchPDControl* controller, long copy_from)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            size_t index = 0;
+            while (index < _controllers.size() && _controllers[index])
+                index++;
+
+            if (index == _controllers.size()) {
+                // new column (this is not done at every step)
+                size_t n = index + 1;
+                _controllers.push_back(nullptr);
+                _Kp.conservativeResize(_control_dof, n);
+                _Kd.conservativeResize(_control_dof, n);
+                _targets.conservativeResize(_control_dof, n);
+                _positions.conservativeResize(_control_dof, n);
+                _velocities.conservativeResize(_control_dof, n);
+                _commands.conservativeResize(_control_dof, n);
+            }
+
+            _controllers[index] = controller;
+            if (copy_from >= 0) {
+                _Kp.col(index) = _Kp.col(copy_from);
+                _Kd.col(index) = _Kd.col(copy_from);
+                _targets.col(index) = _targets.col(copy_from);
+            }
+            else {
+                _Kp.col(index).setConstant(_default_Kp);
+                _Kd.col(index).setConstant(_default_Kd);
+                _targets.col(index) = _default_target;
+            }
+            _positions.col(index) = _targets.col(index);
+            _velocities.col(index).setZero();
+            _commands.col(index).setZero();
+
+            return index;
+        }
+
+        void PDBatch::_remove(size_t index)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _controllers[index] = nullptr;
+        }
+
+        void PDBatch::_configure(size_t index)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            // all the robots are the same: the type of the joints is read from the last one
+            auto controller = _controllers[index];
+            _angular_errors.build(controller->robot()->skeleton(), controller->dof_selection().indices());
+            _wrapped = _angular_errors.wrapped_dofs(_control_dof);
+        }
+
+        void PDBatch::_update()
+        {
+            // gather the state of the robots (one column each)
+            for (size_t i = 0; i < _controllers.size(); i++) {
+                auto controller = _controllers[i];
+                if (!controller || !controller->active())
+                    continue;
+                auto robot = controller->_robot.lock();
+                if (!robot)
+                    continue;
+                // the DoFs changed since configure() (e.g., fix_to_world() without reinit_controllers()): the indices are found again
+                if (!controller->_dof_selection.valid(robot->skeleton().get()))
+                    controller->_dof_selection = robot->dof_selection(controller->_controllable_dofs);
+                if (!_angular_errors.valid(robot->skeleton().get())) {
+                    _angular_errors.build(robot->skeleton(), controller->_dof_selection.indices());
+                    _wrapped = _angular_errors.wrapped_dofs(_control_dof);
+                }
+                robot->positions(_positions.col(i), controller->dof_selection());
+                robot->velocities(_velocities.col(i), controller->dof_selection());
+            }
+
+            // the errors are computed in place in the commands
+            _commands = _targets - _positions;
+            if (_use_angular_errors) {
+                _commands.array() -= (2. * M_PI * ((_commands.array() + M_PI) / (2. * M_PI)).floor()).colwise() * _wrapped.array();
+
+                if (_angular_errors.has_joints()) {
+                    for (size_t i = 0; i < _controllers.size(); i++) {
+                        auto controller = _controllers[i];
+                        if (!controller || !controller->active())
+                            continue;
+                        auto robot = controller->_robot.lock();
+                        if (robot)
+                            _angular_errors.compute_joints(robot->skeleton(), _targets.col(i), _commands.col(i));
+                    }
+                }
+            }
+
+            /// Compute the simplest PD controller output:
+            /// P gain * (target position - current position) + D gain * (0 - current velocity)
+            _commands = _Kp.cwiseProduct(_commands) - _Kd.cwiseProduct(_velocities);
+
+            _generation++;
+        }
+
+        BatchPDControl::BatchPDControl(const std::shared_ptr<PDBatch>& batch) : RobotControl(batch->_default_target, batch->_full_control), _batch(batch)
+        {
+            if (!batch->_controllable_dofs.empty()) {
+                _controllable_dofs = batch->_controllable_dofs;
+                _check_free = false;
+            }
+            _index = _batch->_add(this, -1);
+            _batch_ctrl = _ctrl;
+        }
+
+        BatchPDControl::BatchPDControl(const BatchPDControl& other) : RobotControl(other), _batch(other._batch), _generation(0), _batch_ctrl(other._batch_ctrl)
+        {
+            _index = _batch->_add(this, other._index);
+        }
+
+        BatchPDControl::~BatchPDControl()
+        {
+            _batch->_remove(_index);
+        }
+
+        void BatchPDControl::configure()
+        {
+            if (static_cast<size_t>(_ctrl.size()) == _batch->control_dof() && static_cast<size_t>(_control_dof) == _batch->control_dof()) {
+                // the target of the column (given by set_target() or copied from the cloned robot) is kept
+                // unless new parameters were given with set_parameters()
+                if (_ctrl != _batch_ctrl) {
+                    _batch->set_target(_index, _ctrl);
+                    _batch_ctrl = _ctrl;
+                }
+                _batch->_configure(_index);
+                _active = true;
+            }
+        }
+
+        Eigen::VectorXd BatchPDControl::calculate(double t)
+        {
+            Eigen::VectorXd commands = Eigen::VectorXd::Zero(_control_dof);
+            calculate_into(t, commands);
+            return commands;
+        }
+
+        void BatchPDControl::calculate_into(double, Eigen::Ref<Eigen::VectorXd> commands)
+        {
+            ROBOT_DART_ASSERT(static_cast<size_t>(commands.size()) == _batch->control_dof(), "BatchPDControl: Commands size is not the same as DOFs of the robot", );
+
+            std::lock_guard<std::mutex> lock(_batch->_mutex);
+            // we already used these commands: the robots have moved since
+            if (_generation == _batch->_generation) {
+                // the other robots might be stepped right now (e.g., in the other worlds of a BatchSimu): they cannot be read here
+                ROBOT_DART_ASSERT(!_batch->_external_updates, "BatchPDControl: the batch was not updated since the last commands (see PDBatch::update())", );
+                _batch->_update();
+            }
+            _generation = _batch->_generation;
+
+            commands = _batch->_commands.col(_index);
+        }
+
+        std::shared_ptr<RobotControl> BatchPDControl::clone() const
+        {
+            // the clone is a new robot of the same batch
+            return std::make_shared<BatchPDControl>(*this);
+        }
+    } // namespace control
+} // namespace robot_dart
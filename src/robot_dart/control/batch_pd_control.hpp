@@ -0,0 +1,110 @@
+#ifndef ROBOT_DART_CONTROL_BATCH_PD_CONTROL
+#define ROBOT_DART_CONTROL_BATCH_PD_CONTROL
+
+#include <mutex>
+
+#include <robot_dart/control/pd_control.hpp>
+#include <robot_dart/robot.hpp>
+
+namespace robot_dart {
+    namespace control {
+        class BatchPDControl;
+
+        /// Gains, targets and states of many identical robots, stored as (controllable DoFs x robots) matrices
+        /// so that the PD commands of all the robots are computed with a few vectorized operations.
+        /// Each robot gets a BatchPDControl that reads its column of commands.
+        class PDBatch {
+        public:
+            PDBatch(const Eigen::VectorXd& target, bool full_control = false, bool use_angular_errors = true);
+            PDBatch(const Eigen::VectorXd& target, const std::vector<std::string>& controllable_dofs, bool use_angular_errors = true);
+
+            PDBatch(const PDBatch&) = delete;
+            void operator=(const PDBatch&) = delete;
+
+            /// number of columns (robots that were removed leave a column that is reused by the next one)
+            size_t num_robots() const;
+            size_t control_dof() const { return _control_dof; }
+
+            /// sets the gains of all the robots (and of the ones added later)
+            void set_pd(double Kp, double Kd);
+            void set_pd(size_t index, const Eigen::VectorXd& Kp, const Eigen::VectorXd& Kd);
+            std::pair<Eigen::VectorXd, Eigen::VectorXd> pd(size_t index) const;
+
+            void set_target(size_t index, const Eigen::VectorXd& target);
+            Eigen::VectorXd target(size_t index) const;
+
+            bool using_angular_errors() const { return _use_angular_errors; }
+
+            /// reads the state of all the robots and computes all the commands;
+            /// this is done automatically by the first controller that needs new commands,
+            /// unless update() was called once (e.g., by BatchSimu::step()): it then needs to be called before each control step
+            void update();
+            Eigen::MatrixXd commands() const;
+
+        protected:
+            friend class BatchPDControl;
+
+            size_t _control_dof;
+            Eigen::VectorXd _default_target;
+            double _default_Kp = 10., _default_Kd = 0.1;
+            bool _full_control, _use_angular_errors;
+            std::vector<std::string> _controllable_dofs;
+
+            // one column per robot
+            Eigen::MatrixXd _Kp, _Kd, _targets;
+            Eigen::MatrixXd _positions, _velocities, _commands;
+            // same errors as PDControl: the wrapped DoFs (revolute and euler joints) are done for all the robots at once,
+            // the DoFs of ball and free joints robot by robot
+            AngularErrors _angular_errors;
+            Eigen::VectorXd _wrapped;
+
+            std::vector<BatchPDControl*> _controllers;
+            // incremented every time that the commands are computed
+            size_t _generation = 0;
+            // true once update() was called: the controllers do not update the batch themselves
+            // (the robots might be in worlds that are stepped in parallel)
+            bool _external_updates = false;
+            mutable std::mutex _mutex;
+
+            size_t _add(BatchPDControl* controller, long copy_from);
+            void _remove(size_t index);
+            void _configure(size_t index);
+            void _update();
+        };
+
+        /// Controller of one robot of a PDBatch: when Robot::update() asks for commands that were already given,
+        /// the commands of all the robots of the batch are computed again. This is correct when the robots
+        /// are updated one after the other in a single RobotDARTSimu. BatchSimu::step() steps its worlds in parallel:
+        /// it updates the batches of its robots before stepping them, so that no batch reads a world during its step
+        /// (the controllers then only check that the batch was updated since their last commands).
+        class BatchPDControl : public RobotControl {
+        public:
+            BatchPDControl(const std::shared_ptr<PDBatch>& batch);
+            BatchPDControl(const BatchPDControl& other);
+            ~BatchPDControl();
+
+            void operator=(const BatchPDControl&) = delete;
+
+            void configure() override;
+            Eigen::VectorXd calculate(double) override;
+            void calculate_into(double, Eigen::Ref<Eigen::VectorXd> commands) override;
+
+            std::shared_ptr<RobotControl> clone() const override;
+
+            const std::shared_ptr<PDBatch>& batch() const { return _batch; }
+            /// column of the robot in the batch
+            size_t index() const { return _index; }
+
+        protected:
+            friend class PDBatch;
+
+            std::shared_ptr<PDBatch> _batch;
+            size_t _index;
+            size_t _generation = 0;
+            // the parameters that were last given to the batch as target (set_parameters() changes the target)
+            Eigen::VectorXd _batch_ctrl;
+        };
+    } // namespace control
+} // namespace robot_dart
+
+#endif
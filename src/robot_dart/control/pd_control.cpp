@@ -3,9 +3,12 @@
 #include "robot_dart/utils.hpp"
 #include "robot_dart/utils_headers_dart_dynamics.hpp"
 
+#include <algorithm>
+#include <typeinfo>
+
 namespace robot_dart {
     namespace control {
-        PDControl::PDControl() : RobotControl() {}
+        PDControl::PDControl() : RobotControl(), _use_angular_errors(true) {}
         PDControl::PDControl(const Eigen::VectorXd& ctrl, bool full_control, bool use_angular_errors) : RobotControl(ctrl, full_control), _use_angular_errors(use_angular_errors) {}
         PDControl::PDControl(const Eigen::VectorXd& ctrl, const std::vector<std::string>& controllable_dofs, bool use_angular_errors) : RobotControl(ctrl, controllable_dofs), _use_angular_errors(use_angular_errors) {}
 
@@ -16,85 +19,53 @@ namespace robot_dart {
 
             if (_Kp.size() == 0)
                 set_pd(10., 0.1);
+
+            _errors = Eigen::VectorXd::Zero(_control_dof);
+            _velocities = Eigen::VectorXd::Zero(_control_dof);
+            _angular_errors.build(_robot.lock()->skeleton(), _dof_selection.indices());
         }
 
         Eigen::VectorXd PDControl::calculate(double)
         {
-            ROBOT_DART_ASSERT(_control_dof == _ctrl.size(), "PDControl: Controller parameters size is not the same as DOFs of the robot", Eigen::VectorXd::Zero(_control_dof));
+            Eigen::VectorXd commands = Eigen::VectorXd::Zero(_control_dof);
+            _calculate(commands);
+            return commands;
+        }
+
+        void PDControl::calculate_into(double t, Eigen::Ref<Eigen::VectorXd> commands)
+        {
+            // calculate() might be overridden by a subclass: it stays the reference
+            if (typeid(*this) != typeid(PDControl)) {
+                RobotControl::calculate_into(t, commands);
+                return;
+            }
+            _calculate(commands);
+        }
+
+        void PDControl::_calculate(Eigen::Ref<Eigen::VectorXd> commands)
+        {
+            ROBOT_DART_ASSERT(_control_dof == _ctrl.size(), "PDControl: Controller parameters size is not the same as DOFs of the robot", );
+            ROBOT_DART_ASSERT(_control_dof == commands.size(), "PDControl: Commands size is not the same as DOFs of the robot", );
             auto robot = _robot.lock();
 
-            Eigen::VectorXd dq = robot->velocities(_controllable_dofs);
+            robot->velocities(_velocities, _dof_selection);
 
-            Eigen::VectorXd error;
             if (!_use_angular_errors) {
-                Eigen::VectorXd q = robot->positions(_controllable_dofs);
-                error = _ctrl - q;
+                robot->positions(_errors, _dof_selection);
+                _errors = _ctrl - _errors;
             }
             else {
-                error = Eigen::VectorXd::Zero(_control_dof);
-
-                std::unordered_map<size_t, Eigen::VectorXd> joint_vals, joint_desired, errors;
-
-                for (int i = 0; i < _control_dof; ++i) {
-                    auto dof = robot->dof(_controllable_dofs[i]);
-                    size_t joint_index = dof->getJoint()->getJointIndexInSkeleton();
-                    if (joint_vals.find(joint_index) == joint_vals.end()) {
-                        joint_vals[joint_index] = dof->getJoint()->getPositions();
-                        joint_desired[joint_index] = dof->getJoint()->getPositions();
-                    }
-
-                    joint_desired[joint_index][dof->getIndexInJoint()] = _ctrl[i];
-                }
-
-                for (int i = 0; i < _control_dof; ++i) {
-                    auto dof = robot->dof(_controllable_dofs[i]);
-                    size_t joint_index = dof->getJoint()->getJointIndexInSkeleton();
-                    size_t dof_index_in_joint = dof->getIndexInJoint();
-
-                    Eigen::VectorXd val;
-                    if (errors.find(joint_index) == errors.end()) {
-                        val = Eigen::VectorXd(dof->getJoint()->getNumDofs());
-
-                        std::string joint_type = robot->dof(_controllable_dofs[i])->getJoint()->getType();
-                        if (joint_type == dart::dynamics::RevoluteJoint::getStaticType()) {
-                            val[dof_index_in_joint] = _angle_dist(_ctrl[i], joint_vals[joint_index][dof_index_in_joint]);
-                        }
-                        else if (joint_type == dart::dynamics::BallJoint::getStaticType()) {
-                            Eigen::Matrix3d R_desired = dart::math::expMapRot(joint_desired[joint_index]);
-                            Eigen::Matrix3d R_current = dart::math::expMapRot(joint_vals[joint_index]);
-                            val = dart::math::logMap(R_desired * R_current.transpose());
-                        }
-                        else if (joint_type == dart::dynamics::EulerJoint::getStaticType()) {
-                            // TO-DO: Check if this is 100% correct
-                            for (size_t d = 0; d < dof->getJoint()->getNumDofs(); d++)
-                                val[d] = _angle_dist(joint_desired[joint_index][d], joint_vals[joint_index][d]);
-                        }
-                        else if (joint_type == dart::dynamics::FreeJoint::getStaticType()) {
-                            auto free_joint = static_cast<dart::dynamics::FreeJoint*>(dof->getJoint());
-
-                            Eigen::Isometry3d tf_desired = free_joint->convertToTransform(joint_desired[joint_index]);
-                            Eigen::Isometry3d tf_current = free_joint->convertToTransform(joint_vals[joint_index]);
-
-                            val.tail(3) = tf_desired.translation() - tf_current.translation();
-                            val.head(3) = dart::math::logMap(tf_desired.linear().matrix() * tf_current.linear().matrix().transpose());
-                        }
-                        else {
-                            val[dof_index_in_joint] = _ctrl[i] - joint_vals[joint_index][dof_index_in_joint];
-                        }
-
-                        errors[joint_index] = val;
-                    }
-                    else
-                        val = errors[joint_index];
-                    error(i) = val[dof_index_in_joint];
+                // the DoFs changed since configure() (e.g., fix_to_world() without reinit_controllers()): the indices are found again
+                if (!_angular_errors.valid(robot->skeleton().get())) {
+                    _dof_selection = robot->dof_selection(_controllable_dofs);
+                    _angular_errors.build(robot->skeleton(), _dof_selection.indices());
                 }
+                _angular_errors.compute(robot->skeleton(), _ctrl, _errors);
             }
 
             /// Compute the simplest PD controller output:
             /// P gain * (target position - current position) + D gain * (0 - current velocity)
-            Eigen::VectorXd commands = _Kp.array() * error.array() - _Kd.array() * dq.array();
-
-            return commands;
+            commands = _Kp.cwiseProduct(_errors) - _Kd.cwiseProduct(_velocities);
         }
 
         void PDControl::set_pd(double Kp, double Kd)
@@ -125,7 +96,107 @@ namespace robot_dart {
             return std::make_shared<PDControl>(*this);
         }
 
-        double PDControl::_angle_dist(double target, double current)
+        void AngularErrors::build(const dart::dynamics::SkeletonPtr& skeleton, const std::vector<size_t>& indices)
+        {
+            _angular_dofs.clear();
+            _linear_dofs.clear();
+            _ball_joints.clear();
+            _free_joints.clear();
+            _joint_entries.clear();
+            _num_skeleton_dofs = skeleton->getNumDofs();
+
+            // controlled DoFs of the ball/free joints, by first DoF of the joint
+            std::vector<std::pair<size_t, DofEntry>> ball_dofs, free_dofs;
+            for (size_t i = 0; i < indices.size(); i++) {
+                auto dof = skeleton->getDof(indices[i]);
+                auto joint = dof->getJoint();
+                std::string joint_type = joint->getType();
+                size_t first_dof_index = joint->getDof(0)->getIndexInSkeleton();
+
+                if (joint_type == dart::dynamics::RevoluteJoint::getStaticType() || joint_type == dart::dynamics::EulerJoint::getStaticType())
+                    _angular_dofs.push_back({i, indices[i]});
+                else if (joint_type == dart::dynamics::BallJoint::getStaticType())
+                    ball_dofs.push_back({first_dof_index, {i, dof->getIndexInJoint()}});
+                else if (joint_type == dart::dynamics::FreeJoint::getStaticType())
+                    free_dofs.push_back({first_dof_index, {i, dof->getIndexInJoint()}});
+                else
+                    _linear_dofs.push_back({i, indices[i]});
+            }
+
+            auto group = [this](std::vector<std::pair<size_t, DofEntry>>& dofs, std::vector<JointEntry>& joints) {
+                std::stable_sort(dofs.begin(), dofs.end(), [](const std::pair<size_t, DofEntry>& a, const std::pair<size_t, DofEntry>& b) { return a.first < b.first; });
+                for (size_t i = 0; i < dofs.size(); i++) {
+                    if (joints.empty() || joints.back().first_dof_index != dofs[i].first)
+                        joints.push_back({dofs[i].first, _joint_entries.size(), _joint_entries.size()});
+                    _joint_entries.push_back(dofs[i].second);
+                    joints.back().end = _joint_entries.size();
+                }
+            };
+            group(ball_dofs, _ball_joints);
+            group(free_dofs, _free_joints);
+        }
+
+        bool AngularErrors::valid(const dart::dynamics::Skeleton* skeleton) const
+        {
+            return skeleton && _num_skeleton_dofs == skeleton->getNumDofs();
+        }
+
+        void AngularErrors::compute(const dart::dynamics::SkeletonPtr& skeleton, const Eigen::Ref<const Eigen::VectorXd>& targets, Eigen::Ref<Eigen::VectorXd> errors) const
+        {
+            for (auto& d : _angular_dofs)
+                errors(d.control_index) = angle_dist(targets(d.control_index), skeleton->getPosition(d.dof_index));
+
+            for (auto& d : _linear_dofs)
+                errors(d.control_index) = targets(d.control_index) - skeleton->getPosition(d.dof_index);
+
+            compute_joints(skeleton, targets, errors);
+        }
+
+        void AngularErrors::compute_joints(const dart::dynamics::SkeletonPtr& skeleton, const Eigen::Ref<const Eigen::VectorXd>& targets, Eigen::Ref<Eigen::VectorXd> errors) const
+        {
+            for (auto& joint : _ball_joints) {
+                Eigen::Vector3d current;
+                for (size_t k = 0; k < 3; k++)
+                    current(k) = skeleton->getPosition(joint.first_dof_index + k);
+                Eigen::Vector3d desired = current;
+                for (size_t e = joint.begin; e < joint.end; e++)
+                    desired(_joint_entries[e].dof_index) = targets(_joint_entries[e].control_index);
+
+                Eigen::Matrix3d R_desired = dart::math::expMapRot(desired);
+                Eigen::Matrix3d R_current = dart::math::expMapRot(current);
+                Eigen::Vector3d error = dart::math::logMap(R_desired * R_current.transpose());
+                for (size_t e = joint.begin; e < joint.end; e++)
+                    errors(_joint_entries[e].control_index) = error(_joint_entries[e].dof_index);
+            }
+
+            for (auto& joint : _free_joints) {
+                Eigen::Vector6d current;
+                for (size_t k = 0; k < 6; k++)
+                    current(k) = skeleton->getPosition(joint.first_dof_index + k);
+                Eigen::Vector6d desired = current;
+                for (size_t e = joint.begin; e < joint.end; e++)
+                    desired(_joint_entries[e].dof_index) = targets(_joint_entries[e].control_index);
+
+                Eigen::Isometry3d tf_desired = dart::dynamics::FreeJoint::convertToTransform(desired);
+                Eigen::Isometry3d tf_current = dart::dynamics::FreeJoint::convertToTransform(current);
+
+                Eigen::Vector6d error;
+                error.tail<3>() = tf_desired.translation() - tf_current.translation();
+                error.head<3>() = dart::math::logMap(tf_desired.linear().matrix() * tf_current.linear().matrix().transpose());
+                for (size_t e = joint.begin; e < joint.end; e++)
+                    errors(_joint_entries[e].control_index) = error(_joint_entries[e].dof_index);
+            }
+        }
+
+        Eigen::VectorXd AngularErrors::wrapped_dofs(size_t size) const
+        {
+            Eigen::VectorXd wrapped = Eigen::VectorXd::Zero(size);
+            for (auto& d : _angular_dofs)
+                wrapped(d.control_index) = 1.;
+            return wrapped;
+        }
+
+        double AngularErrors::angle_dist(double target, double current)
         {
             double theta = target - current;
             while (theta < -M_PI)
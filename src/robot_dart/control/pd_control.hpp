@@ -8,6 +8,48 @@
 
 namespace robot_dart {
     namespace control {
+        /// Errors between the targets and the current positions of controllable DoFs that take the type of their joint into account:
+        /// the errors of revolute and euler DoFs are wrapped in [-pi, pi] and the ones of ball and free joints
+        /// come from the rotation between the target and the current orientations. The plan is built once per robot model.
+        class AngularErrors {
+        public:
+            /// indices: indices in the skeleton of the controllable DoFs
+            void build(const dart::dynamics::SkeletonPtr& skeleton, const std::vector<size_t>& indices);
+            /// false if the DoFs of the skeleton changed since build() (e.g., fix_to_world()): the plan needs to be built again
+            bool valid(const dart::dynamics::Skeleton* skeleton) const;
+
+            /// errors of all the DoFs
+            void compute(const dart::dynamics::SkeletonPtr& skeleton, const Eigen::Ref<const Eigen::VectorXd>& targets, Eigen::Ref<Eigen::VectorXd> errors) const;
+            /// errors of the DoFs of the ball and free joints only (the other ones are not changed)
+            void compute_joints(const dart::dynamics::SkeletonPtr& skeleton, const Eigen::Ref<const Eigen::VectorXd>& targets, Eigen::Ref<Eigen::VectorXd> errors) const;
+
+            /// 1 for the DoFs whose error is wrapped (revolute and euler joints), 0 otherwise
+            Eigen::VectorXd wrapped_dofs(size_t size) const;
+            bool has_joints() const { return !_ball_joints.empty() || !_free_joints.empty(); }
+
+            static double angle_dist(double target, double current);
+
+        protected:
+            // one controllable DoF: index in the controller and index in the skeleton
+            struct DofEntry {
+                size_t control_index;
+                size_t dof_index;
+            };
+            // a ball or free joint: the error depends on all the DoFs of the joint;
+            // entries [begin, end) of _joint_entries are the controlled ones (dof_index is then the index in the joint)
+            struct JointEntry {
+                size_t first_dof_index;
+                size_t begin, end;
+            };
+
+            // grouped by kind of joint
+            std::vector<DofEntry> _angular_dofs; // revolute and euler joints
+            std::vector<DofEntry> _linear_dofs; // other joints
+            std::vector<JointEntry> _ball_joints, _free_joints;
+            std::vector<DofEntry> _joint_entries;
+            // DoFs of the skeleton when the plan was built (the plan of a PDBatch is shared by identical skeletons)
+            size_t _num_skeleton_dofs = 0;
+        };
 
         class PDControl : public RobotControl {
         public:
@@ -17,6 +59,8 @@ namespace robot_dart {
 
             void configure() override;
             Eigen::VectorXd calculate(double) override;
+            /// the subclasses that only override calculate() go through calculate() (and allocate)
+            void calculate_into(double, Eigen::Ref<Eigen::VectorXd> commands) override;
 
             void set_pd(double p, double d);
             void set_pd(const Eigen::VectorXd& p, const Eigen::VectorXd& d);
@@ -33,7 +77,15 @@ namespace robot_dart {
             Eigen::VectorXd _Kd;
             bool _use_angular_errors;
 
-            static double _angle_dist(double target, double current);
+            // kept for the subclasses (see AngularErrors::angle_dist())
+            static double _angle_dist(double target, double current) { return AngularErrors::angle_dist(target, current); }
+
+            // built in configure()
+            AngularErrors _angular_errors;
+            Eigen::VectorXd _errors, _velocities;
+
+            // computation of calculate() and calculate_into() (not virtual)
+            void _calculate(Eigen::Ref<Eigen::VectorXd> commands);
         };
     } // namespace control
 } // namespace robot_dart
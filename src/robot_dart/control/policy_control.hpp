@@ -4,6 +4,8 @@
 #include <robot_dart/control/robot_control.hpp>
 #include <robot_dart/robot.hpp>
 
+#include <typeinfo>
+
 namespace robot_dart {
     namespace control {
 
@@ -42,15 +44,23 @@ namespace robot_dart {
             Eigen::VectorXd calculate(double t) override
             {
                 ROBOT_DART_ASSERT(_control_dof == _policy.output_size(), "PolicyControl: Policy output size is not the same as DOFs of the robot", Eigen::VectorXd::Zero(_control_dof));
-                if (_first || _full_dt || (t - _prev_time - _dt) >= _threshold) {
-                    _prev_commands = _policy.query(_robot.lock(), t);
+                _query(t);
 
-                    _first = false;
-                    _prev_time = t;
-                    _i++;
+                return _prev_commands;
+            }
+
+            /// the subclasses that only override calculate() go through calculate() (and allocate)
+            void calculate_into(double t, Eigen::Ref<Eigen::VectorXd> commands) override
+            {
+                // calculate() might be overridden by a subclass: it stays the reference
+                if (typeid(*this) != typeid(PolicyControl<Policy>)) {
+                    RobotControl::calculate_into(t, commands);
+                    return;
                 }
+                ROBOT_DART_ASSERT(_control_dof == _policy.output_size() && commands.size() == _control_dof, "PolicyControl: Policy output size is not the same as DOFs of the robot", );
+                _query(t);
 
-                return _prev_commands;
+                commands = _prev_commands;
             }
 
             std::shared_ptr<RobotControl> clone() const override
@@ -64,6 +74,18 @@ namespace robot_dart {
             double _dt, _prev_time, _threshold;
             Eigen::VectorXd _prev_commands;
             bool _first, _full_dt;
+
+            void _query(double t)
+            {
+                // the policy is only queried at its own rate
+                if (_first || _full_dt || (t - _prev_time - _dt) >= _threshold) {
+                    _prev_commands = _policy.query(_robot.lock(), t);
+
+                    _first = false;
+                    _prev_time = t;
+                    _i++;
+                }
+            }
         };
     } // namespace control
 } // namespace robot_dart
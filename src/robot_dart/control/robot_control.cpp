@@ -37,10 +37,19 @@ namespace robot_dart {
             }
 
             _control_dof = _controllable_dofs.size();
+            // the names are looked up once here and not at every step
+            _dof_selection = robot->dof_selection(_controllable_dofs);
 
             configure();
         }
 
+        void RobotControl::calculate_into(double t, Eigen::Ref<Eigen::VectorXd> commands)
+        {
+            Eigen::VectorXd result = calculate(t);
+            ROBOT_DART_ASSERT(result.size() == commands.size(), "RobotControl: size of the commands is not the same as the controllable DOFs", );
+            commands = result;
+        }
+
         void RobotControl::set_robot(const std::shared_ptr<Robot>& robot)
         {
             _robot = robot;
@@ -66,6 +75,8 @@ namespace robot_dart {
 
         const std::vector<std::string>& RobotControl::controllable_dofs() const { return _controllable_dofs; }
 
+        const DofSelection& RobotControl::dof_selection() const { return _dof_selection; }
+
         double RobotControl::weight() const
         {
             return _weight;
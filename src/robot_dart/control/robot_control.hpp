@@ -1,6 +1,7 @@
 #ifndef ROBOT_DART_CONTROL_ROBOT_CONTROL
 #define ROBOT_DART_CONTROL_ROBOT_CONTROL
 
+#include <robot_dart/robot.hpp>
 #include <robot_dart/utils.hpp>
 
 #include <memory>
@@ -30,6 +31,8 @@ namespace robot_dart {
             bool active() const;
 
             const std::vector<std::string>& controllable_dofs() const;
+            /// precomputed indices of the controllable DoFs (updated by init())
+            const DofSelection& dof_selection() const;
 
             double weight() const;
             void set_weight(double weight);
@@ -37,6 +40,9 @@ namespace robot_dart {
             virtual void configure() = 0;
             // TO-DO: Maybe make this const?
             virtual Eigen::VectorXd calculate(double t) = 0;
+            /// writes the commands of the controllable DoFs in `commands` (called by Robot::update());
+            /// the default implementation copies the result of calculate(), controllers can override it to avoid allocations
+            virtual void calculate_into(double t, Eigen::Ref<Eigen::VectorXd> commands);
             virtual std::shared_ptr<RobotControl> clone() const = 0;
 
         protected:
@@ -46,6 +52,7 @@ namespace robot_dart {
             bool _active, _check_free = false;
             int _dof, _control_dof;
             std::vector<std::string> _controllable_dofs;
+            DofSelection _dof_selection = DofSelection::none();
         };
     } // namespace control
 } // namespace robot_dart
@@ -2,6 +2,8 @@
 #include "robot_dart/robot.hpp"
 #include "robot_dart/utils.hpp"
 
+#include <typeinfo>
+
 namespace robot_dart {
     namespace control {
         SimpleControl::SimpleControl() : RobotControl() {}
@@ -20,6 +22,17 @@ namespace robot_dart {
             return _ctrl;
         }
 
+        void SimpleControl::calculate_into(double t, Eigen::Ref<Eigen::VectorXd> commands)
+        {
+            // calculate() might be overridden by a subclass: it stays the reference
+            if (typeid(*this) != typeid(SimpleControl)) {
+                RobotControl::calculate_into(t, commands);
+                return;
+            }
+            ROBOT_DART_ASSERT(_control_dof == _ctrl.size() && commands.size() == _ctrl.size(), "SimpleControl: Controller parameters size is not the same as DOFs of the robot", );
+            commands = _ctrl;
+        }
+
         std::shared_ptr<RobotControl> SimpleControl::clone() const
         {
             return std::make_shared<SimpleControl>(*this);
@@ -14,6 +14,8 @@ namespace robot_dart {
 
             void configure() override;
             Eigen::VectorXd calculate(double) override;
+            /// the subclasses that only override calculate() go through calculate() (and allocate)
+            void calculate_into(double, Eigen::Ref<Eigen::VectorXd> commands) override;
             std::shared_ptr<RobotControl> clone() const override;
         };
     } // namespace control
@@ -26,9 +26,11 @@ namespace robot_dart {
             virtual void set_fps(int) {}
 
             virtual Image image() { return Image(); }
+            virtual ImageView image_view() { return ImageView(); }
             virtual GrayscaleImage depth_image() { return GrayscaleImage(); }
             virtual GrayscaleImage raw_depth_image() { return GrayscaleImage(); }
             virtual DepthImage depth_array() { return DepthImage(); }
+            virtual DepthView depth_view() { return DepthView(); }
 
             virtual size_t width() const { return 0; }
             virtual size_t height() const { return 0; }
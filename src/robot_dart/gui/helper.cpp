@@ -1,10 +1,39 @@
 #include "helper.hpp"
 
+#include <algorithm>
+#include <cstring>
+
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
 
 namespace robot_dart {
     namespace gui {
+        Image ImageView::copy() const
+        {
+            Image image;
+            image.width = width;
+            image.height = height;
+            image.channels = channels;
+            image.data.resize(width * height * channels);
+
+            size_t row_size = width * channels;
+            for (size_t h = 0; h < height; h++)
+                std::copy(row(h), row(h) + row_size, image.data.begin() + h * row_size);
+
+            return image;
+        }
+
+        ImageView ImageView::region(size_t x, size_t y, size_t region_width, size_t region_height) const
+        {
+            ROBOT_DART_ASSERT(x + region_width <= width && y + region_height <= height, "ImageView: The region is out of the image", ImageView());
+
+            ImageView view = *this;
+            view.data = row(y) + x * channels;
+            view.width = region_width;
+            view.height = region_height;
+            return view;
+        }
+
         void save_png_image(const std::string& filename, const Image& rgb)
         {
             auto ends_with = [](const std::string& value, const std::string& ending) {
@@ -84,6 +113,8 @@ namespace robot_dart {
 
             size_t height = depth_image.height;
             size_t width = depth_image.width;
+            point_cloud.reserve(width * height);
+            Eigen::Matrix4d tf_inv = tf.inverse();
             for (size_t h = 0; h < height; h++) {
                 for (size_t w = 0; w < width; w++) {
                     int id = w + h * width;
@@ -92,7 +123,7 @@ namespace robot_dart {
                     Eigen::Vector4d pp;
                     pp.head(3) = point_3d(intrinsic_matrix, w, h, depth_image.data[id]);
                     pp.tail(1) << 1.;
-                    pp = tf.inverse() * pp;
+                    pp = tf_inv * pp;
 
                     point_cloud.push_back(pp.head(3));
                 }
@@ -100,5 +131,157 @@ namespace robot_dart {
 
             return point_cloud;
         }
+
+        void PointCloudGenerator::set_num_threads(size_t num_threads)
+        {
+            num_threads = std::max<size_t>(1, num_threads);
+            if (num_threads == _num_threads && (num_threads == 1 || _thread_pool))
+                return;
+            _num_threads = num_threads;
+            _thread_pool.reset((num_threads > 1) ? new ThreadPool(num_threads) : nullptr);
+        }
+
+        void PointCloudGenerator::set_intrinsics(const Eigen::Matrix3d& intrinsic_matrix, size_t width, size_t height, size_t stride)
+        {
+            stride = std::max<size_t>(1, stride);
+            if (intrinsic_matrix == _intrinsic_matrix && width == _width && height == _height && stride == _stride)
+                return;
+            _intrinsic_matrix = intrinsic_matrix;
+            _width = width;
+            _height = height;
+            _stride = stride;
+            _cols = (width + stride - 1) / stride;
+            _rows = (height + stride - 1) / stride;
+
+            // same camera model as point_cloud_from_depth_array()
+            double fx = intrinsic_matrix(0, 0);
+            double fy = intrinsic_matrix(1, 1);
+            double cx = intrinsic_matrix(0, 2);
+            double cy = intrinsic_matrix(1, 2);
+            double gamma = intrinsic_matrix(0, 1);
+
+            _rays_x.resize(_cols);
+            for (size_t c = 0; c < _cols; c++)
+                _rays_x(c) = static_cast<float>((static_cast<double>(c * stride) - cx) / fx);
+            _rays_y.resize(_rows);
+            for (size_t r = 0; r < _rows; r++)
+                _rays_y(r) = static_cast<float>((cy - static_cast<double>(r * stride)) / fy);
+            _skew = static_cast<float>(gamma / fx);
+        }
+
+        size_t PointCloudGenerator::compute(const DepthView& depth, const Eigen::Matrix4d& tf, Eigen::Matrix3Xf& points)
+        {
+            ROBOT_DART_ASSERT(!depth.empty() && depth.width == _width && depth.height == _height, "PointCloudGenerator: The depth buffer does not match the intrinsics", 0);
+
+            float n = static_cast<float>(depth.near_plane), f = static_cast<float>(depth.far_plane);
+            size_t stride = _stride, cols = _cols, pixel_stride = depth.pixel_stride;
+            bool linear = depth.linear;
+            auto depth_row = [&depth, n, f, stride, cols, pixel_stride, linear](size_t r, Eigen::ArrayXf& out) {
+                // contiguous rows are vectorized (not the strided ones)
+                if (stride == 1 && pixel_stride == 1) {
+                    Eigen::Map<const Eigen::ArrayXf> raw(depth.row(r), cols);
+                    if (linear)
+                        out = raw;
+                    else
+                        out = (n * f) / (f - raw * (f - n));
+                    return;
+                }
+                Eigen::Map<const Eigen::ArrayXf, 0, Eigen::InnerStride<>> raw(depth.row(r * stride), cols, Eigen::InnerStride<>(stride * pixel_stride));
+                if (linear)
+                    out = raw;
+                else
+                    out = (n * f) / (f - raw * (f - n));
+            };
+
+            return _compute(depth_row, 0.99f * f, tf, points);
+        }
+
+        size_t PointCloudGenerator::compute(const DepthImage& depth, const Eigen::Matrix4d& tf, double far_plane, Eigen::Matrix3Xf& points)
+        {
+            ROBOT_DART_ASSERT(depth.width == _width && depth.height == _height && depth.data.size() == _width * _height, "PointCloudGenerator: The depth image does not match the intrinsics", 0);
+
+            size_t stride = _stride, cols = _cols, width = _width;
+            auto depth_row = [&depth, stride, cols, width](size_t r, Eigen::ArrayXf& out) {
+                if (stride == 1)
+                    out = Eigen::Map<const Eigen::ArrayXd>(depth.data.data() + r * width, cols).cast<float>();
+                else
+                    out = Eigen::Map<const Eigen::ArrayXd, 0, Eigen::InnerStride<>>(depth.data.data() + r * stride * width, cols, Eigen::InnerStride<>(stride)).cast<float>();
+            };
+
+            return _compute(depth_row, static_cast<float>(0.99 * far_plane), tf, points);
+        }
+
+        template <typename DepthRow>
+        size_t PointCloudGenerator::_compute(DepthRow depth_row, float max_depth, const Eigen::Matrix4d& tf, Eigen::Matrix3Xf& points)
+        {
+            size_t max_points = _rows * _cols;
+            if (static_cast<size_t>(points.cols()) != max_points)
+                points.resize(3, max_points);
+            if (max_points == 0)
+                return 0;
+
+            // camera to world, once per point cloud
+            Eigen::Matrix4f tf_inv = tf.inverse().cast<float>();
+            Eigen::Matrix3f R = tf_inv.topLeftCorner<3, 3>();
+            Eigen::Vector3f t = tf_inv.topRightCorner<3, 1>();
+
+            size_t num_threads = std::min(_num_threads, _rows);
+            if (_depths.size() < num_threads) {
+                _depths.resize(num_threads);
+                _row_points.resize(num_threads);
+                _counts.resize(num_threads);
+            }
+            for (size_t k = 0; k < num_threads; k++) {
+                _depths[k].resize(_cols);
+                _row_points[k].resize(_cols, 3);
+            }
+
+            // each thread fills its band of rows from the first column of the band
+            auto band = [&](size_t k) {
+                size_t first_row = k * _rows / num_threads, last_row = (k + 1) * _rows / num_threads;
+                Eigen::ArrayXf& d = _depths[k];
+                Eigen::Array<float, Eigen::Dynamic, 3>& world = _row_points[k];
+                float* out = points.data() + 3 * first_row * _cols;
+                size_t count = 0;
+
+                for (size_t r = first_row; r < last_row; r++) {
+                    depth_row(r, d);
+
+                    // world point = d * R * (x, y, -1) + t, with x = _rays_x + _skew * y
+                    float y = _rays_y(r);
+                    Eigen::Vector3f a = R.col(0) * (_skew * y) + R.col(1) * y - R.col(2);
+                    for (int i = 0; i < 3; i++)
+                        world.col(i) = d * (R(i, 0) * _rays_x + a(i)) + t(i);
+
+                    for (size_t c = 0; c < _cols; c++) {
+                        if (!(d(c) < max_depth)) // close to far plane
+                            continue;
+                        out[0] = world(c, 0);
+                        out[1] = world(c, 1);
+                        out[2] = world(c, 2);
+                        out += 3;
+                        count++;
+                    }
+                }
+                _counts[k] = count;
+            };
+
+            if (num_threads > 1) {
+                // the function only holds a reference to the band: it does not allocate
+                _thread_pool->parallel_for(num_threads, [&band](size_t k) { band(k); });
+            }
+            else
+                band(0);
+
+            // the bands are moved next to each other
+            size_t total = _counts[0];
+            for (size_t k = 1; k < num_threads; k++) {
+                size_t first_row = k * _rows / num_threads;
+                std::memmove(points.data() + 3 * total, points.data() + 3 * first_row * _cols, 3 * _counts[k] * sizeof(float));
+                total += _counts[k];
+            }
+
+            return total;
+        }
     } // namespace gui
 } // namespace robot_dart
\ No newline at end of file
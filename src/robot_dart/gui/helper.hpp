@@ -1,9 +1,13 @@
 #ifndef ROBOT_DART_GUI_HELPER_HPP
 #define ROBOT_DART_GUI_HELPER_HPP
 
+#include <algorithm>
+#include <cstddef>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include <robot_dart/thread_pool.hpp>
 #include <robot_dart/utils.hpp>
 
 namespace robot_dart {
@@ -14,6 +18,28 @@ namespace robot_dart {
             std::vector<uint8_t> data;
         };
 
+        /// Image that is not copied from the readback buffer of a camera:
+        /// `data` points to the top-left pixel and the rows are `row_stride` bytes apart;
+        /// the stride is negative when the rows are stored from bottom to top (OpenGL images).
+        /// The view keeps the buffer alive, even after the camera has read new images.
+        struct ImageView {
+            const uint8_t* data = nullptr;
+            size_t width = 0, height = 0;
+            size_t channels = 3;
+            std::ptrdiff_t row_stride = 0;
+            std::shared_ptr<const void> owner;
+
+            bool empty() const { return data == nullptr; }
+            bool bottom_up() const { return row_stride < 0; }
+            const uint8_t* row(size_t y) const { return data + static_cast<std::ptrdiff_t>(y) * row_stride; }
+
+            /// view of a rectangle of this view (x, y from the top-left corner), sharing the same buffer
+            ImageView region(size_t x, size_t y, size_t region_width, size_t region_height) const;
+
+            /// owning (top-down, contiguous) copy of the image
+            Image copy() const;
+        };
+
         struct GrayscaleImage {
             size_t width = 0, height = 0;
             std::vector<uint8_t> data;
@@ -24,12 +50,75 @@ namespace robot_dart {
             std::vector<double> data;
         };
 
+        /// Depth buffer of a camera that is not copied (same layout as ImageView, one float per pixel, `row_stride` in bytes).
+        /// The values are the raw depth buffer values in [0, 1] unless `linear` is true (distance along the axis of the camera).
+        struct DepthView {
+            const float* data = nullptr;
+            size_t width = 0, height = 0;
+            std::ptrdiff_t row_stride = 0;
+            // number of floats between two pixels (4 for the depth in the w component of the camera frame positions)
+            size_t pixel_stride = 1;
+            double near_plane = 0., far_plane = 0.;
+            bool linear = false;
+            std::shared_ptr<const void> owner;
+
+            bool empty() const { return data == nullptr; }
+            bool bottom_up() const { return row_stride < 0; }
+            const float* row(size_t y) const { return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(data) + static_cast<std::ptrdiff_t>(y) * row_stride); }
+        };
+
         void save_png_image(const std::string& filename, const Image& rgb);
         void save_png_image(const std::string& filename, const GrayscaleImage& gray);
 
         GrayscaleImage convert_rgb_to_grayscale(const Image& rgb);
 
         std::vector<Eigen::Vector3d> point_cloud_from_depth_array(const DepthImage& depth_image, const Eigen::Matrix3d& intrinsic_matrix, const Eigen::Matrix4d& tf, double far_plane = 1000.);
+
+        /// Point clouds from depth buffers, without allocating once the buffers are sized.
+        /// The rays of the pixels are computed once for the intrinsic matrix (and the image size/stride),
+        /// the depth is linearized and the points are transformed row by row (vectorized by Eigen).
+        /// Same conventions as point_cloud_from_depth_array(): `tf` is the extrinsic matrix of the camera
+        /// and the pixels close to the far plane are skipped.
+        class PointCloudGenerator {
+        public:
+            PointCloudGenerator(size_t num_threads = 1) { set_num_threads(num_threads); }
+
+            /// one pixel out of `stride` in each direction (the rays are only recomputed when something changes)
+            void set_intrinsics(const Eigen::Matrix3d& intrinsic_matrix, size_t width, size_t height, size_t stride = 1);
+
+            /// the rows are split between the threads (of a thread pool created here, not for each point cloud)
+            void set_num_threads(size_t num_threads);
+            size_t num_threads() const { return _num_threads; }
+
+            size_t width() const { return _width; }
+            size_t height() const { return _height; }
+            size_t stride() const { return _stride; }
+            /// maximum number of points (one per sampled pixel)
+            size_t max_points() const { return _rows * _cols; }
+
+            /// fills the first n columns of `points` (world frame) and returns n;
+            /// `points` is resized to max_points() columns if needed (it is not resized again)
+            size_t compute(const DepthView& depth, const Eigen::Matrix4d& tf, Eigen::Matrix3Xf& points);
+            size_t compute(const DepthImage& depth, const Eigen::Matrix4d& tf, double far_plane, Eigen::Matrix3Xf& points);
+
+        protected:
+            size_t _num_threads = 1;
+            std::unique_ptr<ThreadPool> _thread_pool; // only with more than one thread
+            Eigen::Matrix3d _intrinsic_matrix = Eigen::Matrix3d::Zero();
+            size_t _width = 0, _height = 0, _stride = 1;
+            size_t _rows = 0, _cols = 0;
+
+            // rays of the sampled pixels (camera frame, z = -1): x = _rays_x(u) + _skew * _rays_y(v), y = _rays_y(v)
+            Eigen::ArrayXf _rays_x, _rays_y;
+            float _skew = 0.f;
+            // per thread: linear depth and world points (one column per coordinate) of one row
+            std::vector<Eigen::ArrayXf> _depths;
+            std::vector<Eigen::Array<float, Eigen::Dynamic, 3>> _row_points;
+            std::vector<size_t> _counts;
+
+            template <typename DepthRow>
+            size_t _compute(DepthRow depth_row, float max_depth, const Eigen::Matrix4d& tf, Eigen::Matrix3Xf& points);
+        };
     } // namespace gui
 } // namespace robot_dart
 
@@ -1,6 +1,13 @@
 #include "base_application.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
 #include <robot_dart/gui/magnum/gs/helper.hpp>
+#include <robot_dart/gui_data.hpp>
 #include <robot_dart/robot_dart_simu.hpp>
 #include <robot_dart/utils.hpp>
 #include <robot_dart/utils_headers_dart_dynamics.hpp>
@@ -10,6 +17,8 @@
 
 #include <Magnum/GL/CubeMapTexture.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
+#include <Magnum/GL/Extensions.h>
+#include <Magnum/GL/OpenGL.h>
 #include <Magnum/GL/Renderer.h>
 #include <Magnum/GL/Texture.h>
 #include <Magnum/GL/TextureFormat.h>
@@ -22,10 +31,43 @@
 #include <Magnum/Trade/MeshData.h>
 #include <Magnum/Trade/PhongMaterialData.h>
 
+#ifdef ROBOT_DART_MAGNUM_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
 namespace robot_dart {
     namespace gui {
         namespace magnum {
             // GlobalData
+            namespace {
+#ifdef ROBOT_DART_MAGNUM_EGL
+                /* Index of the EGL device of Mesa's software renderer (-1 if there is none) and number of devices */
+                int software_egl_device(int& num_devices)
+                {
+                    num_devices = 0;
+                    auto query_devices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+                    auto query_device_string = reinterpret_cast<PFNEGLQUERYDEVICESTRINGEXTPROC>(eglGetProcAddress("eglQueryDeviceStringEXT"));
+                    if (!query_devices || !query_device_string)
+                        return -1;
+
+                    EGLint count = 0;
+                    if (!query_devices(0, nullptr, &count) || count <= 0)
+                        return -1;
+                    std::vector<EGLDeviceEXT> devices(count);
+                    query_devices(count, devices.data(), &count);
+                    num_devices = count;
+
+                    for (EGLint i = 0; i < count; i++) {
+                        const char* extensions = query_device_string(devices[i], EGL_EXTENSIONS);
+                        if (extensions && std::strstr(extensions, "EGL_MESA_device_software"))
+                            return i;
+                    }
+                    return -1;
+                }
+#endif
+            } // namespace
+
             Magnum::Platform::WindowlessGLContext* GlobalData::gl_context()
             {
 #ifdef MAGNUM_MAC_OSX
@@ -35,7 +77,7 @@ namespace robot_dart {
                 if (_gl_contexts.size() == 0)
                     _create_contexts();
 
-                for (size_t i = 0; i < _max_contexts; i++) {
+                for (size_t i = 0; i < _gl_contexts.size(); i++) {
                     if (!_used[i]) {
                         _used[i] = true;
                         return &_gl_contexts[i];
@@ -45,19 +87,46 @@ namespace robot_dart {
                 return nullptr;
             }
 
+            Magnum::Platform::WindowlessGLContext* GlobalData::wait_gl_context(size_t timeout_ms)
+            {
+#ifdef MAGNUM_MAC_OSX
+                ROBOT_DART_EXCEPTION_ASSERT(false, "Windowless GLContext unsupported in Mac!");
+#endif
+                std::unique_lock<std::mutex> lock(_context_mutex);
+                if (_gl_contexts.size() == 0)
+                    _create_contexts();
+
+                /* free_gl_context() wakes up one of the waiting threads */
+                size_t index = 0;
+                auto available = [&]() {
+                    for (index = 0; index < _gl_contexts.size(); index++)
+                        if (!_used[index])
+                            return true;
+                    return false;
+                };
+                if (!_context_freed.wait_for(lock, std::chrono::milliseconds(timeout_ms), available))
+                    return nullptr;
+
+                _used[index] = true;
+                return &_gl_contexts[index];
+            }
+
             void GlobalData::free_gl_context(Magnum::Platform::WindowlessGLContext* context)
             {
 #ifdef MAGNUM_MAC_OSX
                 ROBOT_DART_EXCEPTION_ASSERT(false, "Windowless GLContext unsupported in Mac!");
 #endif
-                std::lock_guard<std::mutex> lg(_context_mutex);
-                for (size_t i = 0; i < _gl_contexts.size(); i++) {
-                    if (&_gl_contexts[i] == context) {
-                        while (!_gl_contexts[i].release()) {} // release the context
-                        _used[i] = false;
-                        break;
+                {
+                    std::lock_guard<std::mutex> lg(_context_mutex);
+                    for (size_t i = 0; i < _gl_contexts.size(); i++) {
+                        if (&_gl_contexts[i] == context) {
+                            while (!_gl_contexts[i].release()) {} // release the context
+                            _used[i] = false;
+                            break;
+                        }
                     }
                 }
+                _context_freed.notify_one();
             }
 
             void GlobalData::set_max_contexts(size_t N)
@@ -65,19 +134,121 @@ namespace robot_dart {
 #ifdef MAGNUM_MAC_OSX
                 ROBOT_DART_EXCEPTION_ASSERT(false, "Windowless GLContext unsupported in Mac!");
 #endif
+                {
+                    std::lock_guard<std::mutex> lg(_context_mutex);
+                    _max_contexts = N;
+                    _create_contexts();
+                }
+                _context_freed.notify_all();
+            }
+
+            size_t GlobalData::max_contexts()
+            {
                 std::lock_guard<std::mutex> lg(_context_mutex);
-                _max_contexts = N;
-                _create_contexts();
+                _resolve_backend();
+                return _num_contexts();
+            }
+
+            void GlobalData::set_backend(GLBackend backend)
+            {
+                std::lock_guard<std::mutex> lg(_context_mutex);
+                ROBOT_DART_WARNING(_gl_contexts.size() > 0, "The GL backend should be set before creating the contexts! The existing contexts are recreated, but the driver might ignore the change.");
+                _backend = backend;
+                _backend_resolved = false;
+                if (_gl_contexts.size() > 0)
+                    _create_contexts();
+            }
+
+            GLBackend GlobalData::backend()
+            {
+                std::lock_guard<std::mutex> lg(_context_mutex);
+                _resolve_backend();
+                return _backend;
+            }
+
+            Magnum::Platform::WindowlessGLContext::Configuration GlobalData::context_configuration()
+            {
+                std::lock_guard<std::mutex> lg(_context_mutex);
+                return _context_configuration();
+            }
+
+            Magnum::Platform::WindowlessGLContext::Configuration GlobalData::_context_configuration()
+            {
+                _resolve_backend();
+
+                Magnum::Platform::WindowlessGLContext::Configuration configuration;
+#ifdef ROBOT_DART_MAGNUM_EGL
+                if (_device >= 0)
+                    configuration.setDevice(static_cast<Magnum::UnsignedInt>(_device));
+#endif
+                return configuration;
+            }
+
+            void GlobalData::_resolve_backend()
+            {
+                if (_backend_resolved)
+                    return;
+                _backend_resolved = true;
+
+                if (_backend == GLBackend::Auto) {
+                    const char* env = std::getenv("ROBOT_DART_GL_BACKEND");
+                    std::string requested = env ? env : "";
+                    if (requested == "software")
+                        _backend = GLBackend::Software;
+                    else if (requested == "hardware")
+                        _backend = GLBackend::Hardware;
+                }
+
+                _device = -1;
+#ifdef ROBOT_DART_MAGNUM_EGL
+                int num_devices = 0;
+                int software_device = software_egl_device(num_devices);
+                /* Without GPU, the only device is the software one */
+                if (_backend == GLBackend::Auto)
+                    _backend = (software_device >= 0 && num_devices == 1) ? GLBackend::Software : GLBackend::Hardware;
+                if (_backend == GLBackend::Software) {
+                    ROBOT_DART_WARNING(software_device < 0, "No software EGL device (Mesa's llvmpipe) found! Using the default device..");
+                    _device = software_device;
+                }
+#else
+                if (_backend == GLBackend::Auto)
+                    _backend = GLBackend::Hardware;
+#ifndef MAGNUM_MAC_OSX
+                ROBOT_DART_WARNING(!std::getenv("DISPLAY"), "No X server (DISPLAY is not set)! Compile with --magnum-egl for headless rendering.");
+#endif
+#endif
+
+                if (_backend == GLBackend::Software) {
+                    /* Mesa reads its options when the driver is loaded (the variables of the user are kept) */
+                    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+                    setenv("GALLIUM_DRIVER", "llvmpipe", 0);
+                    /* The contexts render in parallel: the cores are shared between the rasterizer threads of the contexts */
+                    size_t threads = std::max<size_t>(1, std::thread::hardware_concurrency() / _num_contexts());
+                    setenv("LP_NUM_THREADS", std::to_string(threads).c_str(), 0);
+                }
+            }
+
+            size_t GlobalData::_num_contexts() const
+            {
+                if (_max_contexts > 0)
+                    return _max_contexts;
+                /* One context per core with the software renderer */
+                if (_backend == GLBackend::Software)
+                    return std::max<size_t>(1, std::thread::hardware_concurrency());
+                return 4;
             }
 
             void GlobalData::_create_contexts()
             {
+                Magnum::Platform::WindowlessGLContext::Configuration configuration = _context_configuration();
+
+                size_t num_contexts = _num_contexts();
                 _used.clear();
                 _gl_contexts.clear();
-                _gl_contexts.reserve(_max_contexts);
-                for (size_t i = 0; i < _max_contexts; i++) {
+                _gl_contexts.reserve(num_contexts);
+                for (size_t i = 0; i < num_contexts; i++) {
                     _used.push_back(false);
-                    _gl_contexts.emplace_back(Magnum::Platform::WindowlessGLContext{{}});
+                    _gl_contexts.emplace_back(Magnum::Platform::WindowlessGLContext{configuration});
                 }
             }
 
@@ -119,6 +290,16 @@ namespace robot_dart {
                 _cubemap_color_shader.reset(new gs::CubeMapColor());
                 _cubemap_texture_color_shader.reset(new gs::CubeMapColor(gs::CubeMapColor::Flag::DiffuseTexture));
 
+                /* Instanced shaders (for the repeated shapes) */
+                if (configuration.instancing && Magnum::GL::Context::current().isExtensionSupported<Magnum::GL::Extensions::ARB::instanced_arrays>()) {
+                    _instanced_color_shader.reset(new gs::PhongMultiLight{{gs::PhongMultiLight::Flag::InstancedTransformation}, _max_lights});
+                    _instanced_shadow_shader.reset(new gs::ShadowMap(gs::ShadowMap::Flag::InstancedTransformation));
+                    _instanced_cubemap_shader.reset(new gs::CubeMap(gs::CubeMap::Flag::InstancedTransformation));
+                }
+
+                /* Cached shadows of the static casters (the depth layers are copied with glCopyImageSubData) */
+                _shadow_cache = configuration.cache_static_shadows && Magnum::GL::Context::current().isExtensionSupported<Magnum::GL::Extensions::ARB::copy_image>();
+
                 /* Add default lights (2 directional lights) */
                 gs::Material mat;
                 mat.diffuse_color() = {1.f, 1.f, 1.f, 1.f};
@@ -212,6 +393,9 @@ namespace robot_dart {
                     _color_shader->set_light(i, light);
                 for (int i = 0; i < _texture_shader->max_lights(); i++)
                     _texture_shader->set_light(i, light);
+                if (_instanced_color_shader)
+                    for (int i = 0; i < _instanced_color_shader->max_lights(); i++)
+                        _instanced_color_shader->set_light(i, light);
             }
 
             void BaseApplication::add_light(const gs::Light& light)
@@ -262,107 +446,81 @@ namespace robot_dart {
                     Magnum::Vector3{ux, uy, uz});
             }
 
-            void BaseApplication::update_lights(const gs::Camera& camera)
+            void BaseApplication::update_lights(const gs::Camera& camera, bool render_shadows)
             {
                 /* Update lights transformations */
                 camera.transform_lights(_lights);
 
-                if (_shadowed)
+                if (_shadowed && render_shadows) {
                     _prepare_shadows();
-
-                if (_shadowed)
-                    render_shadows();
-
-                /* Set the shader information */
-                for (size_t i = 0; i < _lights.size(); i++) {
-                    _color_shader->set_light(i, _lights[i]);
-                    _texture_shader->set_light(i, _lights[i]);
-                }
-
-                if (_shadow_texture) {
-                    _color_shader->bind_shadow_texture(*_shadow_texture);
-                    _texture_shader->bind_shadow_texture(*_shadow_texture);
+                    this->render_shadows();
                 }
 
-                if (_shadow_color_texture) {
-                    _color_shader->bind_shadow_color_texture(*_shadow_color_texture);
-                    _texture_shader->bind_shadow_color_texture(*_shadow_color_texture);
-                }
-
-                if (_shadow_cube_map) {
-                    _color_shader->bind_cube_map_texture(*_shadow_cube_map);
-                    _texture_shader->bind_cube_map_texture(*_shadow_cube_map);
-                }
+                /* Set the shader information */
+                for (gs::PhongMultiLight* shader : {_color_shader.get(), _texture_shader.get(), _instanced_color_shader.get()}) {
+                    if (!shader)
+                        continue;
 
-                if (_shadow_color_cube_map) {
-                    _color_shader->bind_cube_map_color_texture(*_shadow_color_cube_map);
-                    _texture_shader->bind_cube_map_color_texture(*_shadow_color_cube_map);
+                    for (size_t i = 0; i < _lights.size(); i++)
+                        shader->set_light(i, _lights[i]);
+
+                    if (_shadow_texture)
+                        shader->bind_shadow_texture(*_shadow_texture);
+                    if (_shadow_color_texture)
+                        shader->bind_shadow_color_texture(*_shadow_color_texture);
+                    if (_shadow_cube_map)
+                        shader->bind_cube_map_texture(*_shadow_cube_map);
+                    if (_shadow_color_cube_map)
+                        shader->bind_cube_map_color_texture(*_shadow_color_cube_map);
+
+                    shader->set_is_shadowed(_shadowed);
+                    shader->set_transparent_shadows(_transparent_shadows && _transparentSize > 0);
+                    shader->set_specular_strength(_configuration.specular_strength);
                 }
-
-                _color_shader->set_is_shadowed(_shadowed);
-                _texture_shader->set_is_shadowed(_shadowed);
-                _color_shader->set_transparent_shadows(_transparent_shadows && _transparentSize > 0);
-                _texture_shader->set_transparent_shadows(_transparent_shadows && _transparentSize > 0);
-
-                _color_shader->set_specular_strength(_configuration.specular_strength);
-                _texture_shader->set_specular_strength(_configuration.specular_strength);
             }
 
             void BaseApplication::update_graphics()
             {
                 /* Refresh the graphical models */
                 _dart_world->refresh();
+                _frame++;
 
                 /* Remove unused/deleted objects */
                 auto& unused = _dart_world->unusedObjects();
                 for (auto& p : unused) {
-                    auto obj = &p->object();
-                    auto it = _drawable_objects.begin();
-                    while (it != _drawable_objects.end()) {
-                        auto obj2 = (it->second->drawable->object().parent());
-                        if (obj == obj2) {
-                            // Update variables
-                            if (_transparent_shadows) {
-                                /* Check if it was transparent */
-                                auto& mats = it->second->drawable->materials();
-                                bool any = false;
-                                for (size_t j = 0; j < mats.size(); j++) {
-                                    // Assume textures are transparent objects so that everything gets drawn better
-                                    // TO-DO: Check if this is okay to do?
-                                    bool isTextured = mats[j].has_diffuse_texture();
-                                    if (isTextured || mats[j].diffuse_color().a() != 1.f) {
-                                        any = true;
-                                        break;
-                                    }
-                                }
-
-                                if (any)
-                                    _transparentSize--;
-                            }
-                            // Remove it from the drawable lists
-                            _drawables.remove(*it->second->drawable);
-                            _shadowed_drawables.remove(*it->second->shadowed);
-                            _shadowed_color_drawables.remove(*it->second->shadowed_color);
-                            _cubemap_drawables.remove(*it->second->cubemapped);
-                            _cubemap_color_drawables.remove(*it->second->cubemapped_color);
-                            // Delete it completely
-                            delete it->second;
-                            _drawable_objects.erase(it);
-                            break;
-                        }
-                        it++;
-                    }
+                    auto it = _drawable_objects.find(p.get());
+                    if (it == _drawable_objects.end())
+                        continue;
+                    // Update variables
+                    if (_transparent_shadows && it->second->drawable->transparent())
+                        _transparentSize--;
+                    // Remove it from the drawable lists
+                    _drawables.remove(*it->second->drawable);
+                    // the shadow casters are either in the static or in the moving groups
+                    it->second->shadowed->drawables()->remove(*it->second->shadowed);
+                    _shadowed_color_drawables.remove(*it->second->shadowed_color);
+                    it->second->cubemapped->drawables()->remove(*it->second->cubemapped);
+                    _cubemap_color_drawables.remove(*it->second->cubemapped_color);
+                    // Delete it completely
+                    delete it->second;
+                    _drawable_objects.erase(it);
+                    _drawables_version++;
                 }
 
-                /* For each update object */
+                /* For each update object (the vectors are reused from one object to the next) */
+                std::vector<gs::Material> materials;
+                std::vector<std::reference_wrapper<Magnum::GL::Mesh>> meshes;
+                std::vector<bool> isSoftBody;
+                // std::vector<Containers::Optional<GL::Texture2D>> textures;
+                std::vector<Magnum::Vector3> scalings;
                 for (Magnum::DartIntegration::Object& object : _dart_world->updatedShapeObjects()) {
                     /* Get material information */
-                    std::vector<gs::Material> materials;
-                    std::vector<std::reference_wrapper<Magnum::GL::Mesh>> meshes;
-                    std::vector<bool> isSoftBody;
-                    // std::vector<Containers::Optional<GL::Texture2D>> textures;
-                    std::vector<Magnum::Vector3> scalings;
+                    materials.clear();
+                    meshes.clear();
+                    isSoftBody.clear();
+                    scalings.clear();
                     bool transparent = false;
+                    bool isSoft = (object.shapeNode()->getShape()->getType() == dart::dynamics::SoftMeshShape::getStaticType());
 
                     for (size_t i = 0; i < object.drawData().meshes.size(); i++) {
                         bool isColor = true;
@@ -375,6 +533,8 @@ namespace robot_dart {
                         mat.ambient_color() = object.drawData().materials[i].ambientColor();
                         if (isColor)
                             mat.diffuse_color() = object.drawData().materials[i].diffuseColor();
+                        // Assume textures are transparent objects so that everything gets drawn better
+                        // TO-DO: Check if this is okay to do?
                         if (!isColor || mat.diffuse_color().a() != 1.f)
                             transparent = true;
                         mat.specular_color() = object.drawData().materials[i].specularColor();
@@ -389,10 +549,7 @@ namespace robot_dart {
 
                         meshes.push_back(mesh);
                         materials.push_back(mat);
-                        if (object.shapeNode()->getShape()->getType() == dart::dynamics::SoftMeshShape::getStaticType())
-                            isSoftBody.push_back(true);
-                        else
-                            isSoftBody.push_back(false);
+                        isSoftBody.push_back(isSoft);
                     }
 
                     /* Check if we already have it */
@@ -425,31 +582,23 @@ namespace robot_dart {
                         it.first->second = obj;
                         if (transparent)
                             _transparentSize++;
+                        _drawables_version++;
                     }
                     else {
                         /* Otherwise, update the mesh and the material data */
                         auto obj = it.first->second;
 
-                        if (_transparent_shadows) {
-                            /* Check if it was transparent before */
-                            auto& mats = obj->drawable->materials();
-                            bool any = false;
-                            for (size_t j = 0; j < mats.size(); j++) {
-                                // Assume textures are transparent objects so that everything gets drawn better
-                                // TO-DO: Check if this is okay to do?
-                                bool isTextured = mats[j].has_diffuse_texture();
-                                if (isTextured || mats[j].diffuse_color().a() != 1.f) {
-                                    any = true;
-                                    break;
-                                }
-                            }
-                            /* if it wasn't transparent and now it is, increase number */
-                            if (!any && transparent)
+                        if (_transparent_shadows && obj->drawable->transparent() != transparent) {
+                            /* if it wasn't transparent and now it is, increase number, else decrease it */
+                            if (transparent)
                                 _transparentSize++;
-                            /* else if it was transparent and now it isn't, decrease number */
-                            else if (any && !transparent)
+                            else
                                 _transparentSize--;
                         }
+                        /* it can change bucket or instances (the meshes and materials are shared by the instances);
+                           the dynamic and soft shapes are updated at every frame, most of the time with the same data */
+                        if (obj->drawable->changed(meshes, materials, isSoftBody, scalings, transparent))
+                            _drawables_version++;
 
                         obj->drawable->set_meshes(meshes).set_materials(materials).set_soft_bodies(isSoftBody).set_scalings(scalings).set_transparent(transparent).set_color_shader(*_color_shader).set_texture_shader(*_texture_shader);
                         obj->shadowed->set_meshes(meshes).set_materials(materials).set_scalings(scalings);
@@ -460,6 +609,157 @@ namespace robot_dart {
                 }
 
                 _dart_world->clearUpdatedShapeObjects();
+
+                _update_instances();
+                if (_shadowed)
+                    _update_shadow_casters();
+            }
+
+            void BaseApplication::_update_instances()
+            {
+                if (!_instanced_color_shader)
+                    return;
+
+                size_t gui_version = _simu->gui_data()->version();
+                if (_instanced_version != _drawables_version || _instanced_gui_version != gui_version) {
+                    _instanced_version = _drawables_version;
+                    _instanced_gui_version = gui_version;
+
+                    /* Group the drawables that share their shape and materials */
+                    _instanced.clear();
+                    std::vector<std::unique_ptr<InstancedDrawables>> groups;
+                    for (auto& it : _drawable_objects) {
+                        ObjectStruct* obj = it.second;
+                        obj->drawable->set_instanced(false);
+                        obj->shadowed->set_instanced(false);
+                        obj->cubemapped->set_instanced(false);
+                        if (!InstancedDrawables::instanceable(*obj->drawable))
+                            continue;
+
+                        bool ghost = _simu->gui_data()->ghost(obj->drawable->shape());
+                        bool cast = _simu->gui_data()->cast_shadows(obj->drawable->shape());
+                        auto group = std::find_if(groups.begin(), groups.end(), [&](const std::unique_ptr<InstancedDrawables>& g) { return g->accepts(*obj->drawable, ghost, cast); });
+                        if (group != groups.end())
+                            (*group)->add(obj);
+                        else
+                            groups.emplace_back(new InstancedDrawables(obj, ghost, cast, *_instanced_color_shader, *_instanced_shadow_shader, *_instanced_cubemap_shader));
+                    }
+
+                    /* Instancing a single drawable is not worth it */
+                    for (auto& group : groups) {
+                        if (group->size() > 1) {
+                            _instanced.emplace_back(std::move(group));
+                            continue;
+                        }
+                        ObjectStruct* obj = group->objects()[0];
+                        obj->drawable->set_instanced(false);
+                        obj->shadowed->set_instanced(false);
+                        obj->cubemapped->set_instanced(false);
+                    }
+                }
+
+                /* Per-instance transformations */
+                for (auto& instances : _instanced)
+                    instances->update();
+            }
+
+            void BaseApplication::_update_shadow_casters()
+            {
+                size_t gui_version = _simu->gui_data()->version();
+                if (_casters_dirty || _casters_drawables_version != _drawables_version || _casters_gui_version != gui_version) {
+                    _casters_dirty = false;
+                    _casters_drawables_version = _drawables_version;
+                    _casters_gui_version = gui_version;
+
+                    /* All the casters are moving until they stay still for a while */
+                    _casters.clear();
+                    _caster_objects.clear();
+                    for (auto& it : _drawable_objects) {
+                        ObjectStruct* obj = it.second;
+                        _set_static_caster(obj, false);
+                        if (!_simu->gui_data()->cast_shadows(obj->drawable->shape()))
+                            continue;
+                        _casters.push_back({obj, {}, 0, false});
+                        _caster_objects.push_back(*obj->drawable);
+                    }
+                    for (auto& instances : _instanced)
+                        instances->set_static_caster(false);
+
+                    _casters_version++;
+                    _static_casters_version++;
+                }
+
+                /* One traversal of the scene for all the casters */
+                std::vector<Magnum::Matrix4> transformations;
+                if (!_caster_objects.empty())
+                    transformations = _caster_objects[0].get().scene()->transformationMatrices(_caster_objects);
+
+                bool moved = false, static_changed = false;
+                for (size_t i = 0; i < _casters.size(); i++) {
+                    ShadowCaster& caster = _casters[i];
+                    if (caster.still_frames > 0 && transformations[i] == caster.transformation) {
+                        caster.still_frames++;
+                        if (!caster.is_static && caster.still_frames > _static_caster_frames) {
+                            caster.is_static = true;
+                            _set_static_caster(caster.object, true);
+                            static_changed = true;
+                        }
+                        continue;
+                    }
+
+                    moved = true;
+                    caster.transformation = transformations[i];
+                    caster.still_frames = 1;
+                    if (caster.is_static) {
+                        caster.is_static = false;
+                        _set_static_caster(caster.object, false);
+                        static_changed = true;
+                    }
+                }
+
+                /* The batches of instances move as a whole */
+                for (auto& instances : _instanced) {
+                    if (!instances->cast_shadows())
+                        continue;
+                    moved = moved || instances->moved();
+                    bool is_static = instances->still_updates() >= _static_caster_frames;
+                    if (is_static != instances->static_caster()) {
+                        instances->set_static_caster(is_static);
+                        static_changed = true;
+                    }
+                }
+
+                if (moved || static_changed)
+                    _casters_version++;
+                if (static_changed)
+                    _static_casters_version++;
+            }
+
+            void BaseApplication::_set_static_caster(ObjectStruct* object, bool is_static)
+            {
+                /* Moving a drawable to another group removes it from its current one */
+                if (is_static) {
+                    _static_shadowed_drawables.add(*object->shadowed);
+                    _static_cubemap_drawables.add(*object->cubemapped);
+                }
+                else {
+                    _shadowed_drawables.add(*object->shadowed);
+                    _cubemap_drawables.add(*object->cubemapped);
+                }
+            }
+
+            const gs::DrawList& BaseApplication::draw_list(bool draw_debug)
+            {
+                size_t i = draw_debug ? 1 : 0;
+                if (_draw_list_frames[i] != _frame) {
+                    _draw_lists[i].update(_drawables, _simu, draw_debug, _drawables_version);
+                    _draw_lists[i].instanced.clear();
+                    for (auto& instances : _instanced)
+                        if (draw_debug || !instances->ghost())
+                            _draw_lists[i].instanced.push_back(instances.get());
+                    _draw_list_frames[i] = _frame;
+                }
+                return _draw_lists[i];
             }
 
             void BaseApplication::render_shadows()
@@ -521,6 +821,13 @@ namespace robot_dart {
                         _cubemap_texture_shader->set_far_plane(far_plane);
                         _cubemap_texture_shader->set_light_index(i);
 
+                        if (_instanced_cubemap_shader) {
+                            _instanced_cubemap_shader->set_shadow_matrices(matrices);
+                            _instanced_cubemap_shader->set_light_position(lightPos);
+                            _instanced_cubemap_shader->set_far_plane(far_plane);
+                            _instanced_cubemap_shader->set_light_index(i);
+                        }
+
                         if (_transparent_shadows) {
                             _cubemap_color_shader->set_shadow_matrices(matrices);
                             _cubemap_color_shader->set_light_position(lightPos);
@@ -540,6 +847,8 @@ namespace robot_dart {
 
                         _color_shader->set_far_plane(far_plane);
                         _texture_shader->set_far_plane(far_plane);
+                        if (_instanced_color_shader)
+                            _instanced_color_shader->set_far_plane(far_plane);
 
                         // cameraMatrix = Magnum::Matrix4::lookAt(lightPos, lightPos + Magnum::Vector3::xAxis(), -Magnum::Vector3::yAxis()); // No effect
                     }
@@ -551,27 +860,64 @@ namespace robot_dart {
                         {0.5f, 0.5f, 0.5f, 1.0f}};
                     _lights[i].set_shadow_matrix(bias * _shadow_camera->projectionMatrix() * cameraMatrix.invertedRigid());
 
+                    /* The shadow map is kept if the light did not move and if it is not due or nothing moved since it was rendered
+                       (the period counts the graphics updates, not the calls: all the cameras of a frame see the same maps) */
+                    ShadowData& data = _shadow_data[i];
+                    Magnum::Matrix4 light_view = isPointLight ? Magnum::Matrix4::translation(_lights[i].position().xyz()) : cameraMatrix;
+                    bool light_moved = !data.rendered || light_view != data.light_view || _shadow_camera->projectionMatrix() != data.light_projection;
+                    if (!light_moved && (_frame % _shadow_update_period(i) != 0 || data.casters_version == _casters_version))
+                        continue;
+                    data.rendered = true;
+                    data.light_view = light_view;
+                    data.light_projection = _shadow_camera->projectionMatrix();
+                    data.casters_version = _casters_version;
+
+                    auto draw_casters = [&](bool static_casters) {
+                        if (!isPointLight) {
+                            _shadow_camera->draw(static_casters ? _static_shadowed_drawables : _shadowed_drawables);
+                            for (auto& instances : _instanced)
+                                if (instances->static_caster() == static_casters)
+                                    instances->draw_shadows(*_shadow_camera);
+                        }
+                        else {
+                            _shadow_camera->draw(static_casters ? _static_cubemap_drawables : _cubemap_drawables);
+                            for (auto& instances : _instanced)
+                                if (instances->static_caster() == static_casters)
+                                    instances->draw_cube_map();
+                        }
+                    };
+
                     Magnum::GL::Renderer::setDepthMask(true);
                     Magnum::GL::Renderer::enable(Magnum::GL::Renderer::Feature::DepthTest);
                     if (cullFront)
                         Magnum::GL::Renderer::setFaceCullingMode(Magnum::GL::Renderer::PolygonFacing::Front);
-                    _shadow_data[i].shadow_framebuffer.bind();
-                    if (isPointLight) {
-                        /* Clear layer-by-layer of the cube-map texture array */
-                        for (size_t k = 0; k < 6; k++) {
-                            _shadow_data[i].shadow_framebuffer.attachTextureLayer(Magnum::GL::Framebuffer::BufferAttachment::Depth, *_shadow_cube_map, 0, i * 6 + k);
-                            _shadow_data[i].shadow_framebuffer.clear(Magnum::GL::FramebufferClear::Depth);
+                    data.shadow_framebuffer.bind();
+
+                    /* Static casters: copied from the cache if they did not change (and the light did not move) */
+                    if (_shadow_cache && !light_moved && data.static_version == _static_casters_version)
+                        _copy_static_shadows(i, isPointLight, false);
+                    else {
+                        if (isPointLight) {
+                            /* Clear layer-by-layer of the cube-map texture array */
+                            for (size_t k = 0; k < 6; k++) {
+                                data.shadow_framebuffer.attachTextureLayer(Magnum::GL::Framebuffer::BufferAttachment::Depth, *_shadow_cube_map, 0, i * 6 + k);
+                                data.shadow_framebuffer.clear(Magnum::GL::FramebufferClear::Depth);
+                            }
+                            /* Attach again the full texture */
+                            data.shadow_framebuffer.attachLayeredTexture(Magnum::GL::Framebuffer::BufferAttachment::Depth, *_shadow_cube_map, 0);
+                        }
+                        else
+                            data.shadow_framebuffer.clear(Magnum::GL::FramebufferClear::Depth);
+
+                        draw_casters(true);
+                        if (_shadow_cache) {
+                            _copy_static_shadows(i, isPointLight, true);
+                            data.static_version = _static_casters_version;
                         }
-                        /* Attach again the full texture */
-                        _shadow_data[i].shadow_framebuffer.attachLayeredTexture(Magnum::GL::Framebuffer::BufferAttachment::Depth, *_shadow_cube_map, 0);
                     }
-                    else
-                        _shadow_data[i].shadow_framebuffer.clear(Magnum::GL::FramebufferClear::Depth);
 
-                    if (!isPointLight)
-                        _shadow_camera->draw(_shadowed_drawables);
-                    else
-                        _shadow_camera->draw(_cubemap_drawables);
+                    /* Moving casters: drawn on top of the static ones */
+                    draw_casters(false);
                     if (cullFront)
                         Magnum::GL::Renderer::setFaceCullingMode(Magnum::GL::Renderer::PolygonFacing::Back);
 
@@ -641,6 +987,28 @@ namespace robot_dart {
                 }
             }
 
+            void BaseApplication::_copy_static_shadows(size_t light, bool point_light, bool to_cache)
+            {
+                /* The layers of the light (the 6 faces of the cube map for point lights) */
+                GLenum target = point_light ? GL_TEXTURE_CUBE_MAP_ARRAY : GL_TEXTURE_2D_ARRAY;
+                GLuint shadows = point_light ? _shadow_cube_map->id() : _shadow_texture->id();
+                GLuint cache = point_light ? _static_shadow_cube_map->id() : _static_shadow_texture->id();
+                GLint layer = static_cast<GLint>(point_light ? light * 6 : light);
+                GLsizei layers = point_light ? 6 : 1;
+
+                GLuint src = to_cache ? shadows : cache;
+                GLuint dst = to_cache ? cache : shadows;
+                glCopyImageSubData(src, target, 0, 0, 0, layer, dst, target, 0, 0, 0, layer, _shadow_map_size, _shadow_map_size, layers);
+            }
+
+            size_t BaseApplication::_shadow_update_period(size_t light) const
+            {
+                size_t period = _configuration.shadow_update_period;
+                if (light < _configuration.light_shadow_update_periods.size() && _configuration.light_shadow_update_periods[light] > 0)
+                    period = _configuration.light_shadow_update_periods[light];
+                return std::max<size_t>(1, period);
+            }
+
             bool BaseApplication::attach_camera(gs::Camera& camera, dart::dynamics::BodyNode* body)
             {
                 for (Magnum::DartIntegration::Object& object : _dart_world->objects()) {
@@ -661,6 +1029,9 @@ namespace robot_dart {
             {
                 _shadowed = enable;
                 _transparent_shadows = drawTransparentShadows;
+                _casters_dirty = true;
+                for (auto& data : _shadow_data)
+                    data.rendered = false;
 #ifdef MAGNUM_MAC_OSX
                 ROBOT_DART_WARNING(_shadowed, "Shadows are not working properly on Mac! Disable them if you experience unexpected behavior..");
 #endif
@@ -693,23 +1064,36 @@ namespace robot_dart {
                 return gs::depth_array_from_image(&*depth_image, _camera->near_plane(), _camera->far_plane());
             }
 
+            DepthView BaseApplication::depth_view()
+            {
+                return _camera->depth_view();
+            }
+
             void BaseApplication::_gl_clean_up()
             {
                 /* Clean up GL because of destructor order */
+                if (_camera)
+                    _camera->release();
+                _instanced.clear();
                 _color_shader.reset();
                 _texture_shader.reset();
+                _instanced_color_shader.reset();
                 _shadow_shader.reset();
                 _shadow_texture_shader.reset();
+                _instanced_shadow_shader.reset();
                 _shadow_color_shader.reset();
                 _shadow_texture_color_shader.reset();
                 _cubemap_shader.reset();
                 _cubemap_texture_shader.reset();
+                _instanced_cubemap_shader.reset();
                 _cubemap_color_shader.reset();
                 _cubemap_texture_color_shader.reset();
                 _shadow_texture.reset();
                 _shadow_color_texture.reset();
                 _shadow_cube_map.reset();
                 _shadow_color_cube_map.reset();
+                _static_shadow_texture.reset();
+                _static_shadow_cube_map.reset();
                 _3D_axis_shader.reset();
                 _3D_axis_mesh.reset();
                 _background_mesh.reset();
@@ -765,6 +1149,17 @@ namespace robot_dart {
                         .setDepthStencilMode(Magnum::GL::SamplerDepthStencilMode::DepthComponent);
                 }
 
+                /* Cache of the shadows of the static casters (same layout as the shadow maps) */
+                if (_shadow_cache && !_static_shadow_texture) {
+                    _static_shadow_texture.reset(new Magnum::GL::Texture2DArray{});
+                    _static_shadow_texture->setStorage(1, Magnum::GL::TextureFormat::DepthComponent24, {_shadow_map_size, _shadow_map_size, _max_lights});
+                }
+
+                if (_shadow_cache && !_static_shadow_cube_map) {
+                    _static_shadow_cube_map.reset(new Magnum::GL::CubeMapTextureArray{});
+                    _static_shadow_cube_map->setStorage(1, Magnum::GL::TextureFormat::DepthComponent24, {_shadow_map_size, _shadow_map_size, _max_lights * 6});
+                }
+
                 if (_transparent_shadows && !_shadow_color_cube_map) {
                     _shadow_color_cube_map.reset(new Magnum::GL::CubeMapTextureArray{});
                     _shadow_color_cube_map->setStorage(1, Magnum::GL::TextureFormat::RGBA32F, {_shadow_map_size, _shadow_map_size, _max_lights * 6})
@@ -1,6 +1,7 @@
 #ifndef ROBOT_DART_GUI_MAGNUM_BASE_APPLICATION_HPP
 #define ROBOT_DART_GUI_MAGNUM_BASE_APPLICATION_HPP
 
+#include <condition_variable>
 #include <mutex>
 #include <unistd.h>
 #include <unordered_map>
@@ -14,6 +15,7 @@
 #include <robot_dart/gui/magnum/gs/shadow_map.hpp>
 #include <robot_dart/gui/magnum/gs/shadow_map_color.hpp>
 #include <robot_dart/gui/magnum/types.hpp>
+#include <robot_dart/utils.hpp>
 
 #include <robot_dart/utils_headers_external_gui.hpp>
 
@@ -22,7 +24,9 @@
 #include <Magnum/GL/Mesh.h>
 #include <Magnum/GL/TextureArray.h>
 #include <Magnum/Platform/GLContext.h>
-#ifndef MAGNUM_MAC_OSX
+#if defined(ROBOT_DART_MAGNUM_EGL)
+#include <Magnum/Platform/WindowlessEglApplication.h>
+#elif !defined(MAGNUM_MAC_OSX)
 #include <Magnum/Platform/WindowlessGlxApplication.h>
 #else
 #include <Magnum/Platform/WindowlessCglApplication.h>
@@ -53,11 +57,33 @@
 
 #define get_gl_context(name) get_gl_context_with_sleep(name, 0)
 
+#define get_gl_context_with_timeout(name, timeout_ms)                                                                           \
+    /* Wait (at most timeout_ms) for a GLContext */                                                                             \
+    Corrade::Utility::Debug name##_magnum_silence_output{nullptr};                                                              \
+    Magnum::Platform::WindowlessGLContext* name = robot_dart::gui::magnum::GlobalData::instance()->wait_gl_context(timeout_ms); \
+    ROBOT_DART_EXCEPTION_ASSERT(name, "No GL context available after " + std::to_string(timeout_ms) + "ms!");                   \
+    while (!name->makeCurrent()) {                                                                                              \
+        usleep(1000);                                                                                                           \
+    }                                                                                                                           \
+                                                                                                                                \
+    Magnum::Platform::GLContext name##_magnum_context;
+
 #define release_gl_context(name) robot_dart::gui::magnum::GlobalData::instance()->free_gl_context(name);
 
 namespace robot_dart {
     namespace gui {
         namespace magnum {
+            /// Where the windowless contexts are rendered:
+            /// - Auto: ROBOT_DART_GL_BACKEND (hardware or software) if set, otherwise the GPU if there is one and the software renderer if not
+            /// - Hardware: the GPU (the default EGL device or the X server)
+            /// - Software: Mesa's llvmpipe (the software EGL device on headless builds), for nodes without GPU
+            /// The windowing system is chosen when compiling (GLX, or EGL with `--magnum-egl` for machines without an X server).
+            enum class GLBackend {
+                Auto,
+                Hardware,
+                Software
+            };
+
             struct GlobalData {
             public:
                 static GlobalData* instance()
@@ -69,22 +95,43 @@ namespace robot_dart {
                 GlobalData(const GlobalData&) = delete;
                 void operator=(const GlobalData&) = delete;
 
+                /* nullptr if all the contexts are used */
                 Magnum::Platform::WindowlessGLContext* gl_context();
+                /* Waits at most timeout_ms for a free context (nullptr afterwards) */
+                Magnum::Platform::WindowlessGLContext* wait_gl_context(size_t timeout_ms);
                 void free_gl_context(Magnum::Platform::WindowlessGLContext* context);
 
-                /* You should call this before starting to draw or after finished */
+                /* You should call this before starting to draw or after finished (0 = one context per core with the software backend, 4 otherwise) */
                 void set_max_contexts(size_t N);
+                size_t max_contexts();
+
+                /* You should call this before creating any context (the drivers read their options once) */
+                void set_backend(GLBackend backend);
+                /* The backend that is used (Auto is resolved) */
+                GLBackend backend();
+
+                /* Configuration of the windowless contexts for the backend (device, etc.) */
+                Magnum::Platform::WindowlessGLContext::Configuration context_configuration();
 
             private:
                 GlobalData() = default;
                 ~GlobalData() = default;
 
                 void _create_contexts();
+                void _resolve_backend();
+                Magnum::Platform::WindowlessGLContext::Configuration _context_configuration();
+                size_t _num_contexts() const;
 
                 std::vector<Magnum::Platform::WindowlessGLContext> _gl_contexts;
                 std::vector<bool> _used;
                 std::mutex _context_mutex;
-                size_t _max_contexts = 4;
+                std::condition_variable _context_freed;
+                size_t _max_contexts = 0;
+
+                GLBackend _backend = GLBackend::Auto;
+                bool _backend_resolved = false;
+                // EGL device of the backend (-1 = default)
+                int _device = -1;
             };
 
             struct GraphicsConfiguration {
@@ -109,6 +156,16 @@ namespace robot_dart {
 
                 // Background (default = black)
                 Eigen::Vector4d bg_color{0.0, 0.0, 0.0, 1.0};
+
+                // Draw the shapes that are repeated (e.g., clones of a robot) with instanced draw calls
+                bool instancing = true;
+
+                // Shadow updates
+                // the shadow maps are rendered every N frames (per-light periods override it, 0 = default)
+                size_t shadow_update_period = 1;
+                std::vector<size_t> light_shadow_update_periods;
+                // the shadows of the objects that do not move are cached (only the moving ones are rendered again)
+                bool cache_static_shadows = true;
             };
 
             struct DebugDrawData {
@@ -138,6 +195,9 @@ namespace robot_dart {
                 size_t num_lights() const;
 
                 Magnum::SceneGraph::DrawableGroup3D& drawables() { return _drawables; }
+                /// drawables of the current frame (with or without the ghosts), shared by all the cameras;
+                /// the scene is traversed once per call of update_graphics()
+                const gs::DrawList& draw_list(bool draw_debug);
                 Scene3D& scene() { return _scene; }
                 gs::Camera& camera() { return *_camera; }
                 const gs::Camera& camera() const { return *_camera; }
@@ -150,7 +210,8 @@ namespace robot_dart {
 
                 virtual void render() {}
 
-                void update_lights(const gs::Camera& camera);
+                /// render_shadows = false reuses the shadow maps of the previous call (the shadows do not depend on the camera)
+                void update_lights(const gs::Camera& camera, bool render_shadows = true);
                 void update_graphics();
                 void render_shadows();
 
@@ -164,6 +225,8 @@ namespace robot_dart {
                 void enable_shadows(bool enable = true, bool drawTransparentShadows = false);
 
                 Corrade::Containers::Optional<Magnum::Image2D>& image() { return _camera->image(); }
+                // Image that is not copied
+                ImageView image_view() { return _camera->image_view(); }
 
                 // This is for visualization purposes
                 GrayscaleImage depth_image();
@@ -174,6 +237,9 @@ namespace robot_dart {
                 // "Image" filled with depth buffer values (this returns an array of doubles)
                 DepthImage depth_array();
 
+                // Raw depth buffer (not copied)
+                DepthView depth_view();
+
                 // Access to debug data
                 DebugDrawData debug_draw_data()
                 {
@@ -195,7 +261,9 @@ namespace robot_dart {
                 /* Magnum */
                 Scene3D _scene;
                 Magnum::SceneGraph::DrawableGroup3D _drawables, _shadowed_drawables, _shadowed_color_drawables, _cubemap_drawables, _cubemap_color_drawables;
-                std::unique_ptr<gs::PhongMultiLight> _color_shader, _texture_shader;
+                // shadow casters that did not move for a while (their shadows are cached)
+                Magnum::SceneGraph::DrawableGroup3D _static_shadowed_drawables, _static_cubemap_drawables;
+                std::unique_ptr<gs::PhongMultiLight> _color_shader, _texture_shader, _instanced_color_shader;
 
                 std::unique_ptr<gs::Camera> _camera;
 
@@ -209,17 +277,43 @@ namespace robot_dart {
                 std::unique_ptr<Magnum::DartIntegration::World> _dart_world;
                 std::unordered_map<Magnum::DartIntegration::Object*, ObjectStruct*> _drawable_objects;
                 std::vector<gs::Light> _lights;
+                // incremented when drawables are added/removed or change transparency
+                size_t _drawables_version = 0;
+                // incremented by update_graphics(): the draw lists are updated at most once per frame
+                size_t _frame = 1;
+                gs::DrawList _draw_lists[2]; // without/with the debug (ghost) drawables
+                size_t _draw_list_frames[2] = {0, 0};
+                // drawables of the same shape and materials, grouped again when the drawables change
+                std::vector<std::unique_ptr<InstancedDrawables>> _instanced;
+                size_t _instanced_version = 0, _instanced_gui_version = 0;
 
                 /* Shadows */
                 bool _shadowed = true, _transparent_shadows = false;
                 int _transparentSize = 0;
-                std::unique_ptr<gs::ShadowMap> _shadow_shader, _shadow_texture_shader;
+                std::unique_ptr<gs::ShadowMap> _shadow_shader, _shadow_texture_shader, _instanced_shadow_shader;
                 std::unique_ptr<gs::ShadowMapColor> _shadow_color_shader, _shadow_texture_color_shader;
-                std::unique_ptr<gs::CubeMap> _cubemap_shader, _cubemap_texture_shader;
+                std::unique_ptr<gs::CubeMap> _cubemap_shader, _cubemap_texture_shader, _instanced_cubemap_shader;
                 std::unique_ptr<gs::CubeMapColor> _cubemap_color_shader, _cubemap_texture_color_shader;
                 std::vector<ShadowData> _shadow_data;
-                std::unique_ptr<Magnum::GL::Texture2DArray> _shadow_texture, _shadow_color_texture;
-                std::unique_ptr<Magnum::GL::CubeMapTextureArray> _shadow_cube_map, _shadow_color_cube_map;
+                std::unique_ptr<Magnum::GL::Texture2DArray> _shadow_texture, _shadow_color_texture, _static_shadow_texture;
+                std::unique_ptr<Magnum::GL::CubeMapTextureArray> _shadow_cube_map, _shadow_color_cube_map, _static_shadow_cube_map;
+                bool _shadow_cache = false;
+
+                /* Shadow casters (moving or static) */
+                struct ShadowCaster {
+                    ObjectStruct* object;
+                    Magnum::Matrix4 transformation;
+                    size_t still_frames;
+                    bool is_static;
+                };
+                std::vector<ShadowCaster> _casters;
+                std::vector<std::reference_wrapper<Magnum::SceneGraph::AbstractObject3D>> _caster_objects;
+                bool _casters_dirty = true;
+                size_t _casters_drawables_version = 0, _casters_gui_version = 0;
+                // incremented when a caster moved (or the casters changed) / when the static casters changed
+                size_t _casters_version = 0, _static_casters_version = 0;
+                // a caster becomes static when it did not move for this number of frames
+                size_t _static_caster_frames = 30;
                 int _max_lights = 5;
                 int _shadow_map_size = 512;
                 std::unique_ptr<Camera3D> _shadow_camera;
@@ -244,6 +338,11 @@ namespace robot_dart {
 
                 void _gl_clean_up();
                 void _prepare_shadows();
+                void _update_instances();
+                void _update_shadow_casters();
+                void _set_static_caster(ObjectStruct* object, bool is_static);
+                void _copy_static_shadows(size_t light, bool point_light, bool to_cache);
+                size_t _shadow_update_period(size_t light) const;
             };
 
             template <typename T>
@@ -151,6 +151,12 @@ namespace robot_dart {
                     return Image();
                 }
 
+                ImageView image_view() override
+                {
+                    ROBOT_DART_EXCEPTION_ASSERT(_magnum_app, "MagnumApp pointer is null!");
+                    return _magnum_app->image_view();
+                }
+
                 GrayscaleImage depth_image() override
                 {
                     ROBOT_DART_EXCEPTION_ASSERT(_magnum_app, "MagnumApp pointer is null!");
@@ -169,6 +175,12 @@ namespace robot_dart {
                     return _magnum_app->depth_array();
                 }
 
+                DepthView depth_view() override
+                {
+                    ROBOT_DART_EXCEPTION_ASSERT(_magnum_app, "MagnumApp pointer is null!");
+                    return _magnum_app->depth_view();
+                }
+
                 gs::Camera& camera()
                 {
                     ROBOT_DART_EXCEPTION_ASSERT(_magnum_app, "MagnumApp pointer is null!");
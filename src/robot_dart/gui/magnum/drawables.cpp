@@ -2,6 +2,7 @@
 #include <robot_dart/gui_data.hpp>
 #include <robot_dart/robot_dart_simu.hpp>
 #include <robot_dart/utils.hpp>
+#include <robot_dart/utils_headers_dart_dynamics.hpp>
 
 #include <Magnum/GL/CubeMapTexture.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
@@ -11,6 +12,8 @@
 #include <Magnum/GL/AbstractFramebuffer.h>
 #include <Magnum/GL/GL.h>
 
+#include <algorithm>
+
 namespace robot_dart {
     namespace gui {
         namespace magnum {
@@ -39,6 +42,11 @@ namespace robot_dart {
             DrawableObject& DrawableObject::set_meshes(const std::vector<std::reference_wrapper<Magnum::GL::Mesh>>& meshes)
             {
                 _meshes = meshes;
+                // the instance buffers of the meshes that were replaced are not used anymore (and their address can be reused)
+                _instance_buffers.erase(std::remove_if(_instance_buffers.begin(), _instance_buffers.end(), [&](const std::pair<Magnum::GL::Mesh*, Magnum::GL::Buffer>& b) {
+                    return std::find_if(_meshes.begin(), _meshes.end(), [&](const std::reference_wrapper<Magnum::GL::Mesh>& m) { return &m.get() == b.first; }) == _meshes.end();
+                }),
+                    _instance_buffers.end());
                 return *this;
             }
 
@@ -77,6 +85,32 @@ namespace robot_dart {
                 return *this;
             }
 
+            bool DrawableObject::changed(const std::vector<std::reference_wrapper<Magnum::GL::Mesh>>& meshes, const std::vector<gs::Material>& materials,
+                const std::vector<bool>& softBody, const std::vector<Magnum::Vector3>& scalings, bool transparent) const
+            {
+                if (transparent != _isTransparent || softBody != _is_soft_body || scalings != _scalings)
+                    return true;
+                if (meshes.size() != _meshes.size() || materials.size() != _materials.size())
+                    return true;
+                for (size_t i = 0; i < meshes.size(); i++)
+                    if (&meshes[i].get() != &_meshes[i].get())
+                        return true;
+                // the textures are read at every draw: only their presence matters
+                for (size_t i = 0; i < materials.size(); i++) {
+                    const gs::Material& a = materials[i];
+                    const gs::Material& b = _materials[i];
+                    if (a.has_diffuse_texture() != b.has_diffuse_texture() || a.ambient_color() != b.ambient_color() || a.diffuse_color() != b.diffuse_color() || a.specular_color() != b.specular_color() || a.shininess() != b.shininess())
+                        return true;
+                }
+                return false;
+            }
+
+            DrawableObject& DrawableObject::set_instanced(bool instanced)
+            {
+                _instanced = instanced;
+                return *this;
+            }
+
             DrawableObject& DrawableObject::set_color_shader(std::reference_wrapper<gs::PhongMultiLight> shader)
             {
                 _color_shader = shader;
@@ -160,9 +194,15 @@ namespace robot_dart {
                 return *this;
             }
 
+            ShadowedObject& ShadowedObject::set_instanced(bool instanced)
+            {
+                _instanced = instanced;
+                return *this;
+            }
+
             void ShadowedObject::draw(const Magnum::Matrix4& transformationMatrix, Magnum::SceneGraph::Camera3D& camera)
             {
-                if (!_simu->gui_data()->cast_shadows(_shape))
+                if (_instanced || !_simu->gui_data()->cast_shadows(_shape))
                     return;
                 for (size_t i = 0; i < _meshes.size(); i++) {
                     Magnum::GL::Mesh& mesh = _meshes[i];
@@ -280,8 +320,16 @@ namespace robot_dart {
                 return *this;
             }
 
+            CubeMapShadowedObject& CubeMapShadowedObject::set_instanced(bool instanced)
+            {
+                _instanced = instanced;
+                return *this;
+            }
+
             void CubeMapShadowedObject::draw(const Magnum::Matrix4&, Magnum::SceneGraph::Camera3D&)
             {
+                if (_instanced)
+                    return;
                 for (size_t i = 0; i < _meshes.size(); i++) {
                     Magnum::GL::Mesh& mesh = _meshes[i];
                     Magnum::Matrix4 scalingMatrix = Magnum::Matrix4::scaling(_scalings[i]);
@@ -358,6 +406,173 @@ namespace robot_dart {
                     }
                 }
             }
+
+            // InstancedDrawables
+            InstancedDrawables::InstancedDrawables(ObjectStruct* first, bool ghost, bool cast_shadows,
+                gs::PhongMultiLight& color_shader, gs::ShadowMap& shadow_shader, gs::CubeMap& cube_map_shader)
+                : _ghost(ghost),
+                  _cast_shadows(cast_shadows),
+                  _color_shader{color_shader},
+                  _shadow_shader{shadow_shader},
+                  _cube_map_shader{cube_map_shader}
+            {
+                add(first);
+            }
+
+            bool InstancedDrawables::same_geometry(const dart::dynamics::Shape& a, const dart::dynamics::Shape& b)
+            {
+                if (&a == &b)
+                    return true;
+                // the clones of a robot do not always share their shapes (deep copies with recent versions of DART)
+                if (a.getType() != b.getType())
+                    return false;
+                if (a.getType() == dart::dynamics::MeshShape::getStaticType()) {
+                    auto& mesh_a = static_cast<const dart::dynamics::MeshShape&>(a);
+                    auto& mesh_b = static_cast<const dart::dynamics::MeshShape&>(b);
+                    return !mesh_a.getMeshUri().empty() && mesh_a.getMeshUri() == mesh_b.getMeshUri() && mesh_a.getScale() == mesh_b.getScale();
+                }
+                // these primitives are defined by their bounding box
+                if (a.getType() == dart::dynamics::BoxShape::getStaticType()
+                    || a.getType() == dart::dynamics::SphereShape::getStaticType()
+                    || a.getType() == dart::dynamics::CylinderShape::getStaticType()
+                    || a.getType() == dart::dynamics::CapsuleShape::getStaticType()
+                    || a.getType() == dart::dynamics::EllipsoidShape::getStaticType()) {
+                    auto& box_a = a.getBoundingBox();
+                    auto& box_b = b.getBoundingBox();
+                    return box_a.getMin() == box_b.getMin() && box_a.getMax() == box_b.getMax();
+                }
+                return false;
+            }
+
+            bool InstancedDrawables::instanceable(const DrawableObject& drawable)
+            {
+                if (drawable._isTransparent || drawable._meshes.empty())
+                    return false;
+                if (drawable._materials.size() != drawable._meshes.size() || drawable._scalings.size() != drawable._meshes.size())
+                    return false;
+                for (size_t i = 0; i < drawable._meshes.size(); i++)
+                    if (drawable._materials[i].has_diffuse_texture() || drawable._is_soft_body[i])
+                        return false;
+                return true;
+            }
+
+            bool InstancedDrawables::accepts(const DrawableObject& drawable, bool ghost, bool cast_shadows) const
+            {
+                const DrawableObject& first = *_objects[0]->drawable;
+                if (ghost != _ghost || cast_shadows != _cast_shadows)
+                    return false;
+                if (drawable._meshes.size() != first._meshes.size() || !same_geometry(*drawable._shape->getShape(), *first._shape->getShape()))
+                    return false;
+                if (drawable._has_negative_scaling != first._has_negative_scaling)
+                    return false;
+                for (size_t i = 0; i < first._materials.size(); i++) {
+                    const gs::Material& a = drawable._materials[i];
+                    const gs::Material& b = first._materials[i];
+                    if (a.ambient_color() != b.ambient_color() || a.diffuse_color() != b.diffuse_color() || a.specular_color() != b.specular_color() || a.shininess() != b.shininess())
+                        return false;
+                }
+                return true;
+            }
+
+            void InstancedDrawables::add(ObjectStruct* object)
+            {
+                object->drawable->set_instanced(true);
+                object->shadowed->set_instanced(true);
+                object->cubemapped->set_instanced(true);
+                _objects.push_back(object);
+                _scene_objects.push_back(*object->drawable);
+                _uploaded = false;
+            }
+
+            void InstancedDrawables::update()
+            {
+                // one traversal of the scene graph for all the instances
+                std::vector<Magnum::Matrix4> transformations = _scene_objects[0].get().scene()->transformationMatrices(_scene_objects);
+                _moved = !_uploaded || transformations != _transformations;
+                _still_updates = _moved ? 0 : _still_updates + 1;
+                if (!_moved)
+                    return;
+                _transformations = std::move(transformations);
+
+                DrawableObject& first = *_objects[0]->drawable;
+                if (_buffers.empty()) {
+                    // the instanced attribute is added to the meshes of the first drawable (it is ignored by the other shaders);
+                    // its buffers are kept by the drawable, so that they are reused when the instances are grouped again
+                    for (size_t i = 0; i < first._meshes.size(); i++) {
+                        Magnum::GL::Mesh* mesh = &first._meshes[i].get();
+                        auto it = std::find_if(first._instance_buffers.begin(), first._instance_buffers.end(), [&](const std::pair<Magnum::GL::Mesh*, Magnum::GL::Buffer>& b) { return b.first == mesh; });
+                        if (it == first._instance_buffers.end()) {
+                            first._instance_buffers.emplace_back(mesh, Magnum::GL::Buffer{});
+                            mesh->addVertexBufferInstanced(first._instance_buffers.back().second, 1, 0, gs::PhongMultiLight::TransformationMatrix{});
+                        }
+                    }
+                    // the pointers are taken once all the buffers are created
+                    for (size_t i = 0; i < first._meshes.size(); i++) {
+                        Magnum::GL::Mesh* mesh = &first._meshes[i].get();
+                        auto it = std::find_if(first._instance_buffers.begin(), first._instance_buffers.end(), [&](const std::pair<Magnum::GL::Mesh*, Magnum::GL::Buffer>& b) { return b.first == mesh; });
+                        _buffers.push_back(&it->second);
+                    }
+                }
+
+                _instances.resize(_objects.size());
+                for (size_t i = 0; i < _buffers.size(); i++) {
+                    for (size_t k = 0; k < _objects.size(); k++)
+                        _instances[k] = _transformations[k] * Magnum::Matrix4::scaling(_objects[k]->drawable->_scalings[i]);
+                    _buffers[i]->setData(Corrade::Containers::ArrayView<const void>{_instances.data(), _instances.size() * sizeof(Magnum::Matrix4)}, Magnum::GL::BufferUsage::DynamicDraw);
+                }
+                _uploaded = true;
+            }
+
+            void InstancedDrawables::draw(Magnum::SceneGraph::Camera3D& camera)
+            {
+                DrawableObject& first = *_objects[0]->drawable;
+                for (size_t i = 0; i < first._meshes.size(); i++) {
+                    if (first._has_negative_scaling[i])
+                        Magnum::GL::Renderer::setFaceCullingMode(Magnum::GL::Renderer::PolygonFacing::Front);
+                    // the per-instance transformations are world transformations
+                    _color_shader.get()
+                        .set_material(first._materials[i])
+                        .set_transformation_matrix(Magnum::Matrix4{})
+                        .set_camera_matrix(camera.cameraMatrix())
+                        .set_projection_matrix(camera.projectionMatrix());
+                    _draw_instances(first._meshes[i], _color_shader.get());
+                    if (first._has_negative_scaling[i])
+                        Magnum::GL::Renderer::setFaceCullingMode(Magnum::GL::Renderer::PolygonFacing::Back);
+                }
+            }
+
+            void InstancedDrawables::draw_shadows(Magnum::SceneGraph::Camera3D& camera)
+            {
+                if (!_cast_shadows)
+                    return;
+                DrawableObject& first = *_objects[0]->drawable;
+                for (size_t i = 0; i < first._meshes.size(); i++) {
+                    _shadow_shader.get()
+                        .set_transformation_matrix(camera.cameraMatrix())
+                        .set_projection_matrix(camera.projectionMatrix())
+                        .set_material(first._materials[i]);
+                    _draw_instances(first._meshes[i], _shadow_shader.get());
+                }
+            }
+
+            void InstancedDrawables::draw_cube_map()
+            {
+                DrawableObject& first = *_objects[0]->drawable;
+                for (size_t i = 0; i < first._meshes.size(); i++) {
+                    _cube_map_shader.get()
+                        .set_transformation_matrix(Magnum::Matrix4{})
+                        .set_material(first._materials[i]);
+                    _draw_instances(first._meshes[i], _cube_map_shader.get());
+                }
+            }
+
+            void InstancedDrawables::_draw_instances(Magnum::GL::Mesh& mesh, Magnum::GL::AbstractShaderProgram& shader)
+            {
+                mesh.setInstanceCount(static_cast<Magnum::Int>(_objects.size()));
+                shader.draw(mesh);
+                // the mesh is also the one of the first drawable
+                mesh.setInstanceCount(1);
+            }
         } // namespace magnum
     } // namespace gui
 } // namespace robot_dart
\ No newline at end of file
@@ -9,12 +9,14 @@
 #include <robot_dart/gui/magnum/gs/shadow_map_color.hpp>
 #include <robot_dart/gui/magnum/types.hpp>
 
+#include <Magnum/GL/Buffer.h>
 #include <Magnum/GL/Framebuffer.h>
 
 #include <Magnum/SceneGraph/Drawable.h>
 
 namespace dart {
     namespace dynamics {
+        class Shape;
         class ShapeNode;
     }
 } // namespace dart
@@ -41,17 +43,27 @@ namespace robot_dart {
                 DrawableObject& set_soft_bodies(const std::vector<bool>& softBody);
                 DrawableObject& set_scalings(const std::vector<Magnum::Vector3>& scalings);
                 DrawableObject& set_transparent(bool transparent = true);
+                /// instanced drawables are drawn by their InstancedDrawables (not in the per-object lists)
+                DrawableObject& set_instanced(bool instanced = true);
 
                 DrawableObject& set_color_shader(std::reference_wrapper<gs::PhongMultiLight> shader);
                 DrawableObject& set_texture_shader(std::reference_wrapper<gs::PhongMultiLight> shader);
 
                 const std::vector<gs::Material>& materials() const { return _materials; }
                 bool transparent() const { return _isTransparent; }
+                bool instanced() const { return _instanced; }
+
+                /// whether new data would change the meshes, the materials, the scalings or the transparency
+                /// (the instances are grouped again only then: the dynamic shapes are updated at every frame)
+                bool changed(const std::vector<std::reference_wrapper<Magnum::GL::Mesh>>& meshes, const std::vector<gs::Material>& materials,
+                    const std::vector<bool>& softBody, const std::vector<Magnum::Vector3>& scalings, bool transparent) const;
 
                 RobotDARTSimu* simu() const { return _simu; }
                 dart::dynamics::ShapeNode* shape() const { return _shape; }
 
             private:
+                friend class InstancedDrawables;
+
                 void draw(const Magnum::Matrix4& transformationMatrix, Magnum::SceneGraph::Camera3D& camera) override;
 
                 RobotDARTSimu* _simu;
@@ -64,6 +76,10 @@ namespace robot_dart {
                 std::vector<bool> _has_negative_scaling;
                 std::vector<bool> _is_soft_body;
                 bool _isTransparent;
+                bool _instanced = false;
+                // per-instance transformations, used when this drawable is the first one of an InstancedDrawables:
+                // they are attached to its meshes (a mesh cannot detach a buffer), so they live as long as the drawable
+                std::vector<std::pair<Magnum::GL::Mesh*, Magnum::GL::Buffer>> _instance_buffers;
             };
 
             class ShadowedObject : public Object3D, public Magnum::SceneGraph::Drawable3D {
@@ -80,6 +96,7 @@ namespace robot_dart {
                 ShadowedObject& set_meshes(const std::vector<std::reference_wrapper<Magnum::GL::Mesh>>& meshes);
                 ShadowedObject& set_materials(const std::vector<gs::Material>& materials);
                 ShadowedObject& set_scalings(const std::vector<Magnum::Vector3>& scalings);
+                ShadowedObject& set_instanced(bool instanced = true);
 
                 RobotDARTSimu* simu() const { return _simu; }
                 dart::dynamics::ShapeNode* shape() const { return _shape; }
@@ -93,6 +110,7 @@ namespace robot_dart {
                 std::reference_wrapper<gs::ShadowMap> _shader, _texture_shader;
                 std::vector<gs::Material> _materials;
                 std::vector<Magnum::Vector3> _scalings;
+                bool _instanced = false;
             };
 
             class ShadowedColorObject : public Object3D, public Magnum::SceneGraph::Drawable3D {
@@ -138,6 +156,7 @@ namespace robot_dart {
                 CubeMapShadowedObject& set_meshes(const std::vector<std::reference_wrapper<Magnum::GL::Mesh>>& meshes);
                 CubeMapShadowedObject& set_materials(const std::vector<gs::Material>& materials);
                 CubeMapShadowedObject& set_scalings(const std::vector<Magnum::Vector3>& scalings);
+                CubeMapShadowedObject& set_instanced(bool instanced = true);
 
                 RobotDARTSimu* simu() const { return _simu; }
                 dart::dynamics::ShapeNode* shape() const { return _shape; }
@@ -151,6 +170,7 @@ namespace robot_dart {
                 std::reference_wrapper<gs::CubeMap> _shader, _texture_shader;
                 std::vector<gs::Material> _materials;
                 std::vector<Magnum::Vector3> _scalings;
+                bool _instanced = false;
             };
 
             class CubeMapShadowedColorObject : public Object3D, public Magnum::SceneGraph::Drawable3D {
@@ -185,6 +205,11 @@ namespace robot_dart {
             struct ShadowData {
                 Magnum::GL::Framebuffer shadow_framebuffer{Magnum::NoCreate};
                 Magnum::GL::Framebuffer shadow_color_framebuffer{Magnum::NoCreate};
+
+                // state of the last rendering of the shadow map (it is kept until the light or the casters move)
+                bool rendered = false;
+                Magnum::Matrix4 light_view, light_projection;
+                size_t casters_version = 0, static_version = 0;
             };
 
             struct ObjectStruct {
@@ -194,6 +219,63 @@ namespace robot_dart {
                 CubeMapShadowedObject* cubemapped;
                 CubeMapShadowedColorObject* cubemapped_color;
             };
+
+            /// Opaque, untextured drawables of the same shape with the same materials (e.g., the clones of a robot):
+            /// each of their meshes is drawn with one instanced draw call in the main pass and in the shadow passes.
+            /// The meshes of the first drawable are used for all the instances; the transformations are per-instance attributes.
+            class InstancedDrawables {
+            public:
+                InstancedDrawables(ObjectStruct* first, bool ghost, bool cast_shadows,
+                    gs::PhongMultiLight& color_shader, gs::ShadowMap& shadow_shader, gs::CubeMap& cube_map_shader);
+
+                InstancedDrawables(const InstancedDrawables&) = delete;
+                void operator=(const InstancedDrawables&) = delete;
+
+                /// same mesh file and scale, or same primitive
+                static bool same_geometry(const dart::dynamics::Shape& a, const dart::dynamics::Shape& b);
+                /// opaque, untextured and not soft
+                static bool instanceable(const DrawableObject& drawable);
+                /// same shape, same materials, same flags
+                bool accepts(const DrawableObject& drawable, bool ghost, bool cast_shadows) const;
+                /// the object is drawn by this batch from now on
+                void add(ObjectStruct* object);
+
+                size_t size() const { return _objects.size(); }
+                const std::vector<ObjectStruct*>& objects() const { return _objects; }
+                bool ghost() const { return _ghost; }
+                bool cast_shadows() const { return _cast_shadows; }
+
+                /// whether an instance moved at the last update() / for how many updates nothing moved
+                bool moved() const { return _moved; }
+                size_t still_updates() const { return _still_updates; }
+                /// static casters are drawn in the cached part of the shadow maps
+                bool static_caster() const { return _static_caster; }
+                void set_static_caster(bool is_static = true) { _static_caster = is_static; }
+
+                /// uploads the per-instance transformations (only if something moved)
+                void update();
+
+                void draw(Magnum::SceneGraph::Camera3D& camera);
+                void draw_shadows(Magnum::SceneGraph::Camera3D& camera);
+                void draw_cube_map();
+
+            protected:
+                std::vector<ObjectStruct*> _objects;
+                std::vector<std::reference_wrapper<Magnum::SceneGraph::AbstractObject3D>> _scene_objects;
+                bool _ghost, _cast_shadows;
+
+                std::reference_wrapper<gs::PhongMultiLight> _color_shader;
+                std::reference_wrapper<gs::ShadowMap> _shadow_shader;
+                std::reference_wrapper<gs::CubeMap> _cube_map_shader;
+
+                // one buffer of transformations per mesh (the instances of a mesh have their own scaling), owned by the first drawable
+                std::vector<Magnum::GL::Buffer*> _buffers;
+                std::vector<Magnum::Matrix4> _transformations, _instances;
+                bool _uploaded = false, _moved = true, _static_caster = false;
+                size_t _still_updates = 0;
+
+                void _draw_instances(Magnum::GL::Mesh& mesh, Magnum::GL::AbstractShaderProgram& shader);
+            };
         } // namespace magnum
     } // namespace gui
 } // namespace robot_dart
@@ -88,7 +88,8 @@ namespace robot_dart {
                     _camera->strafe(_speed_strafe);
 
                     /* Draw with main camera */
-                    _camera->draw(_drawables, Magnum::GL::defaultFramebuffer, Magnum::PixelFormat::RGB8Unorm, _simu, debug_draw_data(), _draw_debug);
+                    _camera->draw(draw_list(_draw_debug), _simu, debug_draw_data(), _draw_debug);
+                    _camera->read(Magnum::GL::defaultFramebuffer, Magnum::PixelFormat::RGB8Unorm);
 
                     swapBuffers();
                 }
@@ -1,20 +1,19 @@
-#include <sys/errno.h>
-
 #include "camera.hpp"
+#include "helper.hpp"
 #include "robot_dart/gui/magnum/base_application.hpp"
 #include "robot_dart/gui_data.hpp"
 #include "robot_dart/robot_dart_simu.hpp"
 #include "robot_dart/utils.hpp"
 
 #include <algorithm>
-#include <signal.h>
-
-#include <Corrade/Containers/ArrayViewStl.h>
-#include <Corrade/Containers/StridedArrayView.h>
-#include <Corrade/Utility/Algorithms.h>
 
 #include <Magnum/GL/AbstractFramebuffer.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/BufferImage.h>
+#include <Magnum/GL/Context.h>
+#include <Magnum/GL/Framebuffer.h>
 #include <Magnum/GL/GL.h>
+#include <Magnum/GL/OpenGL.h>
 #include <Magnum/GL/PixelFormat.h>
 #include <Magnum/GL/Renderer.h>
 #include <Magnum/ImageView.h>
@@ -26,6 +25,15 @@ namespace robot_dart {
     namespace gui {
         namespace magnum {
             namespace gs {
+                // one frame of the asynchronous readback: the transfers are done in pixel buffers, and the fence tells when they are finished
+                struct Camera::Readback {
+                    Corrade::Containers::Optional<Magnum::GL::BufferImage2D> color, depth, video;
+                    Magnum::PixelFormat color_format, depth_format;
+                    bool linear_depth = false;
+                    bool color_pending = false, depth_pending = false, video_pending = false;
+                    GLsync fence = nullptr;
+                };
+
                 Camera::Camera(Object3D& object, Magnum::Int width, Magnum::Int height) : Object3D{&object}
                 {
                     _yaw_object = new Object3D{this};
@@ -50,6 +58,9 @@ namespace robot_dart {
                     _width = width;
                     _height = height;
 
+                    _image = std::make_shared<Corrade::Containers::Optional<Magnum::Image2D>>();
+                    _depth_image = std::make_shared<Corrade::Containers::Optional<Magnum::Image2D>>();
+
                     _camera = new Camera3D{*_camera_object};
                     _camera->setAspectRatioPolicy(Magnum::SceneGraph::AspectRatioPolicy::Extend)
                         .setProjectionMatrix(Magnum::Matrix4::perspectiveProjection(_fov, _aspect_ratio, _near_plane, _far_plane))
@@ -58,17 +69,27 @@ namespace robot_dart {
 
                 Camera::~Camera()
                 {
-#ifdef ROBOT_DART_HAS_BOOST_PROCESS
-                    if (_ffmpeg_process.id() > 0) {
-                        // we let ffmpeg finish nicely by detaching it and sending the signal
-                        // terminates() send a violent SIGTERM...
-                        _ffmpeg_process.detach();
-                        kill(_ffmpeg_process.id(), SIGINT);
+                    if (_readbacks.empty())
+                        return;
+                    if (Magnum::GL::Context::hasCurrent()) {
+                        // the fences and the pixel buffers are deleted with the frames still in transfer
+                        release();
+                        return;
                     }
-#else
-                    if (_video_pid != 0)
-                        kill(_video_pid, SIGINT);
-#endif
+                    // no GL call without context: the ids are dropped instead of deleted (the context is probably already gone with them)
+                    ROBOT_DART_WARNING(true, "The camera is destroyed without release() and without GL context: the frames still in transfer are lost");
+                    for (auto& readback : _readbacks)
+                        for (auto image : {&readback->color, &readback->depth, &readback->video})
+                            if (*image)
+                                (*image)->release().release();
+                }
+
+                void Camera::release()
+                {
+                    // the last frames are still written to the video (the writer finishes the queue when it is destroyed)
+                    _flush_readbacks();
+                    _readbacks.clear();
+                    _readback_index = 0;
                 }
 
                 Camera3D& Camera::camera() const
@@ -217,90 +238,157 @@ namespace robot_dart {
 
                 void Camera::record_video(const std::string& video_fname, int fps)
                 {
-                    // we use boost process: https://www.boost.org/doc/libs/1_73_0/doc/html/boost_process/tutorial.html
-#ifdef ROBOT_DART_HAS_BOOST_PROCESS
-                    namespace bp = boost::process;
-                    // search for ffmpeg
-                    boost::filesystem::path ffmpeg = bp::search_path("ffmpeg");
-                    if (ffmpeg.empty()) {
-                        ROBOT_DART_WARNING(ffmpeg.empty(), "ffmpeg not found in the PATH. RobotDART will not be able to record videos!");
+                    record_video(video_fname, fps, gui::make_video_sink(video_fname));
+                }
+
+                void Camera::record_video(const std::string& video_fname, int fps, std::unique_ptr<gui::VideoSink> sink)
+                {
+                    // the frames of the previous video are written before it is closed
+                    _flush_readbacks();
+                    _video.reset();
+
+                    std::unique_ptr<gui::VideoWriter> video(new gui::VideoWriter(std::move(sink), _video_policy, _video_queue_size));
+                    if (!video->open(video_fname, width(), height(), fps)) {
+                        ROBOT_DART_WARNING(true, "Cannot record the video " << video_fname);
                         return;
                     }
-#endif
-                    // std::cout << "Found FFMPEG:" << ffmpeg << std::endl;
-                    _recording_video = true;
-                    // list our options
-                    std::vector<std::string> args = {"-y",
-                        "-f", "rawvideo",
-                        "-vcodec", "rawvideo",
-                        "-s", std::to_string(width()) + 'x' + std::to_string(height()),
-                        "-pix_fmt", "rgb24",
-                        "-r", std::to_string(fps),
-                        "-i", "-",
-                        "-an",
-                        "-vcodec", "mpeg4",
-                        "-vb", "20M",
-                        video_fname};
-#ifdef ROBOT_DART_HAS_BOOST_PROCESS
-                    // clang-format off
-                    _ffmpeg_process = bp::child(ffmpeg, bp::args(args), bp::std_in < _video_pipe, bp::std_out > "/dev/null", bp::std_err > "/dev/null");
-                    // clang-format on
-
-#else
-                    // we do it the old way
-                    // this could should be removed in the future once boost.process is on every computer...
-                    pipe(_video_fd);
-                    //  Data written to fd[1] appears on (i.e., can be read from) fd[0].
-                    _video_pid = fork();
-                    if (_video_pid != 0) { // main process
-                        close(_video_fd[0]); // we close the input on this side
+                    _video = std::move(video);
+                }
+
+                void Camera::set_video_policy(gui::VideoPolicy policy, size_t queue_size)
+                {
+                    // applies to the next video
+                    _video_policy = policy;
+                    _video_queue_size = queue_size;
+                }
+
+                void DrawList::update(Magnum::SceneGraph::DrawableGroup3D& drawables, RobotDARTSimu* simu, bool draw_debug, size_t drawables_version)
+                {
+                    size_t gui_version = simu->gui_data()->version();
+                    bool rebuild = !_built || drawables_version != _drawables_version || gui_version != _gui_version || draw_debug != _draw_debug;
+
+                    if (rebuild) {
+                        opaque.clear();
+                        transparent.clear();
+                        for (size_t i = 0; i < drawables.size(); i++) {
+                            auto& obj = static_cast<DrawableObject&>(drawables[i].object());
+                            if (obj.instanced() || (!draw_debug && simu->gui_data()->ghost(obj.shape())))
+                                continue;
+                            if (obj.transparent())
+                                transparent.emplace_back(drawables[i], Magnum::Matrix4{});
+                            else
+                                opaque.emplace_back(drawables[i], Magnum::Matrix4{});
+                        }
+
+                        _objects.clear();
+                        for (auto& d : opaque)
+                            _objects.push_back(d.first.get().object());
+                        for (auto& d : transparent)
+                            _objects.push_back(d.first.get().object());
+
+                        _built = true;
+                        _draw_debug = draw_debug;
+                        _drawables_version = drawables_version;
+                        _gui_version = gui_version;
+                        opaque_version++;
+                        transparent_version++;
+                    }
+
+                    if (_objects.empty())
+                        return;
+
+                    // one traversal of the scene graph for all the cameras; only the buckets where something moved get a new version
+                    std::vector<Magnum::Matrix4> transformations = _objects[0].get().scene()->transformationMatrices(_objects);
+                    bool opaque_moved = false, transparent_moved = false;
+                    for (size_t i = 0; i < opaque.size(); i++) {
+                        if (opaque[i].second != transformations[i]) {
+                            opaque[i].second = transformations[i];
+                            opaque_moved = true;
+                        }
                     }
-                    else { // ffmpeg process
-                        args.push_back("-loglevel");
-                        args.push_back("quiet");
-                        close(_video_fd[1]); // ffmpeg does not write here
-                        dup2(_video_fd[0], STDIN_FILENO); // ffmpeg will read the fd[0] as stdin
-                        char** argv = (char**)calloc(args.size() + 2, sizeof(char*)); // we need the 0 at the end AND the ffffmpeg at the beginning
-                        argv[0] = (char*)"ffmpeg";
-                        for (size_t i = 0; i < args.size(); ++i)
-                            argv[i + 1] = (char*)args[i].c_str();
-                        int ret = execvp("ffmpeg", argv);
-                        if (ret == -1) {
-                            std::cerr << "Video recording: cannot execute ffmpeg! [" << strerror(errno) << "]" << std::endl;
-                            exit(0); // we are in the fork
+                    for (size_t i = 0; i < transparent.size(); i++) {
+                        const Magnum::Matrix4& tf = transformations[opaque.size() + i];
+                        if (transparent[i].second != tf) {
+                            transparent[i].second = tf;
+                            transparent_moved = true;
                         }
                     }
-#endif
+
+                    if (opaque_moved && !rebuild)
+                        opaque_version++;
+                    if (transparent_moved && !rebuild)
+                        transparent_version++;
                 }
 
                 void Camera::draw(Magnum::SceneGraph::DrawableGroup3D& drawables, Magnum::GL::AbstractFramebuffer& framebuffer, Magnum::PixelFormat format, RobotDARTSimu* simu, const DebugDrawData& debug_data, bool draw_debug)
                 {
-                    // TO-DO: Maybe check if world moved?
-                    std::vector<std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>, Magnum::Matrix4>>
-                        drawableTransformations = _camera->drawableTransformations(drawables);
+                    DrawableTransformations drawableTransformations = _camera->drawableTransformations(drawables);
 
-                    std::vector<std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>, Magnum::Matrix4>> opaque, transparent;
+                    _opaque.clear();
+                    _transparent.clear();
                     for (size_t i = 0; i < drawableTransformations.size(); i++) {
                         auto& obj = static_cast<DrawableObject&>(drawableTransformations[i].first.get().object());
                         if (!draw_debug && simu->gui_data()->ghost(obj.shape()))
                             continue;
                         if (obj.transparent())
-                            transparent.emplace_back(drawableTransformations[i]);
+                            _transparent.emplace_back(drawableTransformations[i]);
                         else
-                            opaque.emplace_back(drawableTransformations[i]);
+                            _opaque.emplace_back(drawableTransformations[i]);
                     }
 
-                    _camera->draw(opaque);
-                    if (transparent.size() > 0) {
-                        std::sort(transparent.begin(), transparent.end(),
-                            [](const std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>, Magnum::Matrix4>& a,
-                                const std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>, Magnum::Matrix4>& b) {
-                                return a.second.translation().z() < b.second.translation().z();
-                            });
+                    _sort_transparent();
+                    // these lists are not the ones of a shared list anymore
+                    _last_list = nullptr;
+
+                    _draw(nullptr, simu, debug_data, draw_debug);
+                    read(framebuffer, format);
+                }
+
+                void Camera::draw(const DrawList& list, RobotDARTSimu* simu, const DebugDrawData& debug_data, bool draw_debug)
+                {
+                    const Magnum::Matrix4& camera_matrix = _camera->cameraMatrix();
+                    bool same_list = (&list == _last_list) && (camera_matrix == _last_camera_matrix);
+
+                    if (!same_list || list.opaque_version != _last_opaque_version) {
+                        _opaque.clear();
+                        for (auto& d : list.opaque)
+                            _opaque.emplace_back(d.first, camera_matrix * d.second);
+                    }
 
-                        _camera->draw(transparent);
+                    /* The transparent drawables are sorted again only when the camera or one of them moved */
+                    if (!same_list || list.transparent_version != _last_transparent_version) {
+                        _transparent.clear();
+                        for (auto& d : list.transparent)
+                            _transparent.emplace_back(d.first, camera_matrix * d.second);
+                        _sort_transparent();
                     }
 
+                    _last_list = &list;
+                    _last_camera_matrix = camera_matrix;
+                    _last_opaque_version = list.opaque_version;
+                    _last_transparent_version = list.transparent_version;
+
+                    _draw(&list, simu, debug_data, draw_debug);
+                }
+
+                void Camera::_sort_transparent()
+                {
+                    std::sort(_transparent.begin(), _transparent.end(),
+                        [](const std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>, Magnum::Matrix4>& a,
+                            const std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>, Magnum::Matrix4>& b) {
+                            return a.second.translation().z() < b.second.translation().z();
+                        });
+                }
+
+                void Camera::_draw(const DrawList* list, RobotDARTSimu* simu, const DebugDrawData& debug_data, bool draw_debug)
+                {
+                    _camera->draw(_opaque);
+                    if (list)
+                        for (auto instances : list->instanced)
+                            instances->draw(*_camera);
+                    if (_transparent.size() > 0)
+                        _camera->draw(_transparent);
+
                     /* Draw debug */
                     if (draw_debug) {
                         /* Draw axes */
@@ -364,29 +452,222 @@ namespace robot_dart {
                             Magnum::GL::Renderer::enable(Magnum::GL::Renderer::Feature::FaceCulling);
                         }
                     }
+                }
+
+                namespace {
+                    // the float format of the linear depth attachment
+                    Magnum::PixelFormat linear_depth_format(DepthMode mode)
+                    {
+                        return (mode == DepthMode::LinearXYZ) ? Magnum::PixelFormat::RGBA32F : Magnum::PixelFormat::R32F;
+                    }
+
+                    using SharedImage = std::shared_ptr<Corrade::Containers::Optional<Magnum::Image2D>>;
+
+                    // the image of the next frame: the previous one is left to the views that still hold it
+                    Corrade::Containers::Optional<Magnum::Image2D>& next_image(SharedImage& image)
+                    {
+                        if (image.use_count() > 1)
+                            image = std::make_shared<Corrade::Containers::Optional<Magnum::Image2D>>();
+                        return *image;
+                    }
+
+                    // the image sharing the ownership of its holder (nullptr without image)
+                    std::shared_ptr<Magnum::Image2D> shared_image(const SharedImage& image)
+                    {
+                        if (!*image)
+                            return nullptr;
+                        return std::shared_ptr<Magnum::Image2D>(image, &**image);
+                    }
+                } // namespace
 
+                void Camera::set_image(Magnum::Image2D&& image)
+                {
+                    next_image(_image) = std::move(image);
+                }
+
+                void Camera::set_depth_image(Magnum::Image2D&& depth_image)
+                {
+                    next_image(_depth_image) = std::move(depth_image);
+                }
+
+                ImageView Camera::image_view() const
+                {
+                    return rgb_view_from_image(shared_image(_image));
+                }
+
+                DepthView Camera::depth_view() const
+                {
+                    return depth_view_from_image(shared_image(_depth_image), _near_plane, _far_plane);
+                }
+
+                void Camera::read(Magnum::GL::AbstractFramebuffer& framebuffer, Magnum::PixelFormat format, Magnum::GL::Framebuffer* depth_framebuffer)
+                {
+                    if (_depth_mode == DepthMode::Raw)
+                        depth_framebuffer = nullptr;
+
+                    if (_readback_mode != ReadbackMode::Sync) {
+                        _read_async(framebuffer, format, depth_framebuffer);
+                        return;
+                    }
+
+                    if (_recording) {
+                        next_image(_image) = framebuffer.read(framebuffer.viewport(), {format});
+                    }
+
+                    if (_recording_depth && depth_framebuffer) {
+                        depth_framebuffer->mapForRead(Magnum::GL::Framebuffer::ColorAttachment(1));
+                        next_image(_depth_image) = depth_framebuffer->read(depth_framebuffer->viewport(), {linear_depth_format(_depth_mode)});
+                        depth_framebuffer->mapForRead(Magnum::GL::Framebuffer::ColorAttachment(0));
+                    }
+                    else if (_recording_depth) {
+                        next_image(_depth_image) = framebuffer.read(framebuffer.viewport(), {Magnum::GL::PixelFormat::DepthComponent, Magnum::GL::PixelType::Float});
+                    }
+
+                    if (_video) {
+                        _write_video_frame(framebuffer.read(framebuffer.viewport(), {Magnum::PixelFormat::RGB8Unorm}));
+                    }
+                }
+
+                void Camera::set_readback_mode(ReadbackMode mode, size_t ring_size)
+                {
+                    release();
+                    _readback_mode = mode;
+                    // LatestButOne needs at least the previous and the current frames
+                    _readback_ring_size = std::max<size_t>(2, ring_size);
+                }
+
+                void Camera::_read_async(Magnum::GL::AbstractFramebuffer& framebuffer, Magnum::PixelFormat format, Magnum::GL::Framebuffer* depth_framebuffer)
+                {
+                    // the ring is (re)allocated at the first frame after set_readback_mode() or release()
+                    if (_readbacks.empty()) {
+                        for (size_t i = 0; i < _readback_ring_size; i++)
+                            _readbacks.emplace_back(new Readback);
+                    }
+
+                    size_t size = _readbacks.size();
+                    Readback& readback = *_readbacks[_readback_index];
+                    // the oldest frame is overwritten: this only waits if the ring is too small
+                    _collect(readback, true);
+
+                    Magnum::Range2Di viewport = framebuffer.viewport();
                     if (_recording) {
-                        _image = framebuffer.read(framebuffer.viewport(), {format});
+                        if (!readback.color)
+                            readback.color.emplace(Magnum::GL::pixelFormat(format), Magnum::GL::pixelType(format));
+                        framebuffer.read(viewport, *readback.color, Magnum::GL::BufferUsage::StreamRead);
+                        readback.color_format = format;
+                        readback.color_pending = true;
                     }
 
                     if (_recording_depth) {
-                        _depth_image = framebuffer.read(framebuffer.viewport(), {Magnum::GL::PixelFormat::DepthComponent, Magnum::GL::PixelType::Float});
+                        bool linear = (depth_framebuffer != nullptr);
+                        Magnum::PixelFormat depth_format = linear_depth_format(_depth_mode);
+                        // the pixel buffer is re-created when the depth mode changed
+                        if (readback.depth && (linear != readback.linear_depth || (linear && depth_format != readback.depth_format)))
+                            readback.depth = Corrade::Containers::NullOpt;
+                        if (!readback.depth) {
+                            if (linear)
+                                readback.depth.emplace(Magnum::GL::pixelFormat(depth_format), Magnum::GL::pixelType(depth_format));
+                            else
+                                readback.depth.emplace(Magnum::GL::PixelFormat::DepthComponent, Magnum::GL::PixelType::Float);
+                        }
+                        readback.linear_depth = linear;
+                        readback.depth_format = depth_format;
+
+                        if (linear) {
+                            depth_framebuffer->mapForRead(Magnum::GL::Framebuffer::ColorAttachment(1));
+                            depth_framebuffer->read(viewport, *readback.depth, Magnum::GL::BufferUsage::StreamRead);
+                            depth_framebuffer->mapForRead(Magnum::GL::Framebuffer::ColorAttachment(0));
+                        }
+                        else
+                            framebuffer.read(viewport, *readback.depth, Magnum::GL::BufferUsage::StreamRead);
+                        readback.depth_pending = true;
                     }
 
-                    if (_recording_video) {
-                        auto image = framebuffer.read(framebuffer.viewport(), {Magnum::PixelFormat::RGB8Unorm});
-
-                        std::vector<uint8_t> data(image.size().product() * sizeof(Magnum::Color3ub));
-                        Corrade::Containers::StridedArrayView2D<const Magnum::Color3ub> src = image.pixels<Magnum::Color3ub>().flipped<0>();
-                        Corrade::Containers::StridedArrayView2D<Magnum::Color3ub> dst{Corrade::Containers::arrayCast<Magnum::Color3ub>(Corrade::Containers::arrayView(data)), {std::size_t(image.size().y()), std::size_t(image.size().x())}};
-                        Corrade::Utility::copy(src, dst);
-#ifdef ROBOT_DART_HAS_BOOST_PROCESS
-                        _video_pipe.write(reinterpret_cast<char*>(data.data()), data.size());
-                        _video_pipe.flush();
-#else
-                        write(_video_fd[1], reinterpret_cast<char*>(data.data()), data.size());
-#endif
+                    if (_video) {
+                        if (!readback.video)
+                            readback.video.emplace(Magnum::GL::PixelFormat::RGB, Magnum::GL::PixelType::UnsignedByte);
+                        framebuffer.read(viewport, *readback.video, Magnum::GL::BufferUsage::StreamRead);
+                        readback.video_pending = true;
+                    }
+
+                    if (readback.color_pending || readback.depth_pending || readback.video_pending)
+                        readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+                    size_t current = _readback_index;
+                    _readback_index = (_readback_index + 1) % size;
+
+                    if (_readback_mode == ReadbackMode::LatestButOne) {
+                        // all the frames before the previous one were already collected
+                        _collect(*_readbacks[(current + size - 1) % size], true);
                     }
+                    else {
+                        // from the oldest to the newest, without waiting (the fences are signaled in order)
+                        for (size_t i = 0; i < size; i++) {
+                            Readback& r = *_readbacks[(_readback_index + i) % size];
+                            if (!r.fence)
+                                continue;
+                            _collect(r, false);
+                            if (r.fence)
+                                break;
+                        }
+                    }
+                }
+
+                void Camera::_collect(Readback& readback, bool wait)
+                {
+                    if (!readback.fence)
+                        return;
+
+                    if (wait) {
+                        while (glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+                        }
+                    }
+                    else if (glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED)
+                        return;
+
+                    glDeleteSync(readback.fence);
+                    readback.fence = nullptr;
+
+                    // the transfers are finished: reading the buffers does not stall
+                    if (readback.color_pending) {
+                        next_image(_image) = Magnum::Image2D{readback.color->storage(), readback.color_format, readback.color->size(), readback.color->buffer().data()};
+                        readback.color_pending = false;
+                    }
+
+                    if (readback.depth_pending) {
+                        if (readback.linear_depth)
+                            next_image(_depth_image) = Magnum::Image2D{readback.depth->storage(), readback.depth_format, readback.depth->size(), readback.depth->buffer().data()};
+                        else
+                            next_image(_depth_image) = Magnum::Image2D{readback.depth->storage(), Magnum::GL::PixelFormat::DepthComponent, Magnum::GL::PixelType::Float, readback.depth->size(), readback.depth->buffer().data()};
+                        readback.depth_pending = false;
+                    }
+
+                    if (readback.video_pending) {
+                        _write_video_frame(Magnum::Image2D{readback.video->storage(), Magnum::PixelFormat::RGB8Unorm, readback.video->size(), readback.video->buffer().data()});
+                        readback.video_pending = false;
+                    }
+                }
+
+                void Camera::_flush_readbacks()
+                {
+                    size_t size = _readbacks.size();
+                    for (size_t i = 0; i < size; i++)
+                        _collect(*_readbacks[(_readback_index + i) % size], true);
+                }
+
+                void Camera::_write_video_frame(Magnum::Image2D&& image)
+                {
+                    if (!_video)
+                        return;
+
+                    // the view reads the image bottom to top and keeps it alive until the writer thread is done with it
+                    push_video_frame(rgb_view_from_image(std::make_shared<Magnum::Image2D>(std::move(image))));
+                }
+
+                void Camera::push_video_frame(const ImageView& frame)
+                {
+                    if (_video)
+                        _video->push(frame);
                 }
             } // namespace gs
         } // namespace magnum
@@ -3,13 +3,12 @@
 
 #include <robot_dart/gui/magnum/gs/light.hpp>
 #include <robot_dart/gui/magnum/types.hpp>
+#include <robot_dart/gui/video_sink.hpp>
 #include <robot_dart/robot_dart_simu.hpp>
 
-#include <boost/version.hpp>
-#if ((BOOST_VERSION / 100000) > 1) || ((BOOST_VERSION / 100000) == 1 && ((BOOST_VERSION / 100 % 1000) >= 64))
-#include <boost/process.hpp> // for launching ffmpeg
-#define ROBOT_DART_HAS_BOOST_PROCESS
-#endif
+#include <functional>
+#include <memory>
+#include <vector>
 
 #include <Corrade/Containers/Optional.h>
 #include <Magnum/GL/Mesh.h>
@@ -22,8 +21,53 @@ namespace robot_dart {
     namespace gui {
         namespace magnum {
             struct DebugDrawData;
+            class InstancedDrawables;
 
             namespace gs {
+                /// How the images (color, depth, video) are read back from the GPU:
+                /// - Sync: at every draw, waiting for the GPU (images of the frame that was just drawn)
+                /// - Latest: asynchronously (pixel buffers + fences), image() gives the most recent frame whose transfer is finished; never waits
+                /// - LatestButOne: asynchronously, image() always gives the previous frame (one frame of latency, waits if needed)
+                enum class ReadbackMode {
+                    Sync,
+                    Latest,
+                    LatestButOne
+                };
+
+                /// What the depth images contain:
+                /// - Raw: the values of the depth buffer (non-linear, in [0, 1])
+                /// - Linear: the metric depth along the axis of the camera (one float per pixel, far plane where nothing is drawn)
+                /// - LinearXYZ: the position in the camera frame and the metric depth (four floats per pixel)
+                /// The linear modes are written by the shaders in a float color attachment of the framebuffer (see sensor::Camera::set_depth_mode()).
+                enum class DepthMode {
+                    Raw,
+                    Linear,
+                    LinearXYZ
+                };
+
+                using DrawableTransformations = std::vector<std::pair<std::reference_wrapper<Magnum::SceneGraph::Drawable3D>, Magnum::Matrix4>>;
+
+                /// Drawables of a frame with their world transformations, already filtered and split in opaque/transparent.
+                /// The buckets persist between frames: they are rebuilt only when drawables are added, removed or change
+                /// (transparency, ghosts); the versions tell the cameras which transformations changed since they last drew.
+                /// The cameras that render the same frame share this traversal of the scene (see BaseApplication::draw_list()).
+                struct DrawList {
+                    DrawableTransformations opaque, transparent;
+                    // the instanced drawables are not in the opaque bucket (see BaseApplication::draw_list())
+                    std::vector<InstancedDrawables*> instanced;
+                    // incremented when the bucket or one of its transformations changed
+                    size_t opaque_version = 0, transparent_version = 0;
+
+                    /// drawables_version has to change when drawables are added/removed or when their transparency changes
+                    void update(Magnum::SceneGraph::DrawableGroup3D& drawables, RobotDARTSimu* simu, bool draw_debug, size_t drawables_version);
+
+                protected:
+                    bool _built = false, _draw_debug = false;
+                    size_t _drawables_version = 0, _gui_version = 0;
+                    // objects of the buckets (opaque then transparent) for the traversal
+                    std::vector<std::reference_wrapper<Magnum::SceneGraph::AbstractObject3D>> _objects;
+                };
+
                 // This is partly code from the ThirdPersonCameraController of https://github.com/alexesDev/magnum-tips
                 class Camera : public Object3D {
                 public:
@@ -66,16 +110,50 @@ namespace robot_dart {
                     }
 
                     // FPS is mandatory here (compared to Graphics and CameraOSR)
+                    // the sink is chosen from the extension of the file (see gui::make_video_sink)
                     void record_video(const std::string& video_fname, int fps);
+                    void record_video(const std::string& video_fname, int fps, std::unique_ptr<gui::VideoSink> sink);
+                    /// the frames are written by a background thread; the policy tells what to do when it falls behind
+                    void set_video_policy(gui::VideoPolicy policy, size_t queue_size = 8);
+                    /// nullptr when no video is recorded
+                    const gui::VideoWriter* video_writer() const { return _video.get(); }
+                    /// frame of a camera that does not read its own images (e.g., rendered in an atlas)
+                    void push_video_frame(const ImageView& frame);
                     bool recording() { return _recording; }
                     bool recording_depth() { return _recording_depth; }
 
-                    Corrade::Containers::Optional<Magnum::Image2D>& image() { return _image; }
-                    Corrade::Containers::Optional<Magnum::Image2D>& depth_image() { return _depth_image; }
+                    /// ring_size is the number of frames that can be in transfer at the same time (asynchronous modes)
+                    void set_readback_mode(ReadbackMode mode, size_t ring_size = 3);
+                    ReadbackMode readback_mode() const { return _readback_mode; }
+
+                    /// the framebuffer given to read() has to have the linear depth in its color attachment 1 (the depth buffer is read otherwise)
+                    void set_depth_mode(DepthMode mode) { _depth_mode = mode; }
+                    DepthMode depth_mode() const { return _depth_mode; }
+
+                    Corrade::Containers::Optional<Magnum::Image2D>& image() { return *_image; }
+                    Corrade::Containers::Optional<Magnum::Image2D>& depth_image() { return *_depth_image; }
+                    /// images of a camera that does not read them itself (e.g., rendered in an atlas)
+                    void set_image(Magnum::Image2D&& image);
+                    void set_depth_image(Magnum::Image2D&& depth_image);
+                    /// views of the images (not copied) that stay valid after the next frame: a new image is allocated when a view still holds the previous one
+                    ImageView image_view() const;
+                    DepthView depth_view() const;
+
+                    /// collects the frames still in transfer and frees the pixel buffers of the asynchronous readback;
+                    /// this has to be called while the GL context is current (the destructor calls it if a context is current,
+                    /// otherwise the GL objects are not deleted)
+                    void release();
 
                     void draw(Magnum::SceneGraph::DrawableGroup3D& drawables, Magnum::GL::AbstractFramebuffer& framebuffer, Magnum::PixelFormat format, RobotDARTSimu* simu, const DebugDrawData& debug_data, bool draw_debug = true);
+                    /// draws a shared list in the current viewport, without reading the images back
+                    void draw(const DrawList& list, RobotDARTSimu* simu, const DebugDrawData& debug_data, bool draw_debug = true);
+                    /// reads the images (color, depth, video) that are recorded from the viewport of the framebuffer;
+                    /// with a linear depth mode, the depth image is read from the color attachment 1 of depth_framebuffer (if given)
+                    void read(Magnum::GL::AbstractFramebuffer& framebuffer, Magnum::PixelFormat format, Magnum::GL::Framebuffer* depth_framebuffer = nullptr);
 
                 private:
+                    struct Readback;
+
                     Object3D* _yaw_object;
                     Object3D* _pitch_object;
                     Object3D* _camera_object;
@@ -89,17 +167,32 @@ namespace robot_dart {
                     Magnum::Int _width, _height;
 
                     bool _recording = false, _recording_depth = false;
-                    bool _recording_video = false;
-                    Corrade::Containers::Optional<Magnum::Image2D> _image, _depth_image;
-
-#ifdef ROBOT_DART_HAS_BOOST_PROCESS
-                    // pipe to write a video
-                    boost::process::opstream _video_pipe;
-                    boost::process::child _ffmpeg_process;
-#else
-                    pid_t _video_pid = 0;
-                    int _video_fd[2];
-#endif
+                    std::unique_ptr<gui::VideoWriter> _video;
+                    gui::VideoPolicy _video_policy = gui::VideoPolicy::Block;
+                    size_t _video_queue_size = 8;
+                    // the views share the ownership of the images
+                    std::shared_ptr<Corrade::Containers::Optional<Magnum::Image2D>> _image, _depth_image;
+
+                    // ring of pixel buffers for the asynchronous readback (defined in the .cpp to keep GL out of this header)
+                    ReadbackMode _readback_mode = ReadbackMode::Sync;
+                    std::vector<std::unique_ptr<Readback>> _readbacks;
+                    size_t _readback_index = 0, _readback_ring_size = 3;
+                    DepthMode _depth_mode = DepthMode::Raw;
+
+                    // drawables of the current frame in camera coordinates (kept between frames: with a shared list,
+                    // they are only transformed again, and the transparent ones sorted again, when the camera or the drawables moved)
+                    DrawableTransformations _opaque, _transparent;
+                    const DrawList* _last_list = nullptr;
+                    size_t _last_opaque_version = 0, _last_transparent_version = 0;
+                    Magnum::Matrix4 _last_camera_matrix;
+
+                    void _sort_transparent();
+
+                    void _draw(const DrawList* list, RobotDARTSimu* simu, const DebugDrawData& debug_data, bool draw_debug);
+                    void _read_async(Magnum::GL::AbstractFramebuffer& framebuffer, Magnum::PixelFormat format, Magnum::GL::Framebuffer* depth_framebuffer);
+                    void _collect(Readback& readback, bool wait);
+                    void _flush_readbacks();
+                    void _write_video_frame(Magnum::Image2D&& image);
                 };
             } // namespace gs
         } // namespace magnum
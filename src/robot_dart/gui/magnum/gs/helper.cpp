@@ -6,11 +6,38 @@
 
 #include <Magnum/Math/Color.h>
 #include <Magnum/Math/PackingBatch.h>
+#include <Magnum/PixelFormat.h>
 
 namespace robot_dart {
     namespace gui {
         namespace magnum {
             namespace gs {
+                namespace {
+                    // the linear depth images (see DepthMode) have a generic float format, the depth buffers an implementation-specific one
+                    bool linear_depth(const Magnum::Image2D& image)
+                    {
+                        return image.format() == Magnum::PixelFormat::R32F || image.format() == Magnum::PixelFormat::RGBA32F;
+                    }
+
+                    // the linear depth of the pixels (top to bottom), or the values of the depth buffer
+                    std::vector<Magnum::Float> depth_values(const Magnum::Image2D& image)
+                    {
+                        std::vector<Magnum::Float> data = std::vector<Magnum::Float>(image.size().product());
+                        Corrade::Containers::StridedArrayView2D<Magnum::Float> dst{Corrade::Containers::arrayCast<Magnum::Float>(Corrade::Containers::arrayView(data)), {std::size_t(image.size().y()), std::size_t(image.size().x())}};
+                        if (image.format() == Magnum::PixelFormat::RGBA32F) {
+                            // camera frame positions: the linear depth is in the w component
+                            Corrade::Containers::StridedArrayView2D<const Magnum::Vector4> pixels = image.pixels<Magnum::Vector4>().flipped<0>();
+                            for (std::size_t y = 0; y < pixels.size()[0]; y++)
+                                for (std::size_t x = 0; x < pixels.size()[1]; x++)
+                                    dst[y][x] = pixels[y][x].w();
+                        }
+                        else
+                            Corrade::Utility::copy(image.pixels<Magnum::Float>().flipped<0>(), dst);
+
+                        return data;
+                    }
+                } // namespace
+
                 Image rgb_from_image(Magnum::Image2D* image)
                 {
                     Image img;
@@ -26,6 +53,53 @@ namespace robot_dart {
                     return img;
                 }
 
+                ImageView rgb_view_from_image(const std::shared_ptr<Magnum::Image2D>& image)
+                {
+                    ImageView view;
+                    if (!image)
+                        return view;
+
+                    // the OpenGL images are stored from bottom to top: the view starts at the last row and goes backwards
+                    Corrade::Containers::StridedArrayView2D<const Magnum::Color3ub> pixels = image->pixels<Magnum::Color3ub>().flipped<0>();
+                    view.data = reinterpret_cast<const uint8_t*>(pixels.data());
+                    view.width = image->size().x();
+                    view.height = image->size().y();
+                    view.channels = 3;
+                    view.row_stride = pixels.stride()[0];
+                    view.owner = image;
+
+                    return view;
+                }
+
+                DepthView depth_view_from_image(const std::shared_ptr<Magnum::Image2D>& image, Magnum::Float near_plane, Magnum::Float far_plane)
+                {
+                    DepthView view;
+                    if (!image)
+                        return view;
+
+                    // same layout as rgb_view_from_image()
+                    if (image->format() == Magnum::PixelFormat::RGBA32F) {
+                        // the depth is the w component of the camera frame positions
+                        Corrade::Containers::StridedArrayView2D<const Magnum::Vector4> pixels = image->pixels<Magnum::Vector4>().flipped<0>();
+                        view.data = static_cast<const Magnum::Vector4*>(pixels.data())->data() + 3;
+                        view.row_stride = pixels.stride()[0];
+                        view.pixel_stride = 4;
+                    }
+                    else {
+                        Corrade::Containers::StridedArrayView2D<const Magnum::Float> pixels = image->pixels<Magnum::Float>().flipped<0>();
+                        view.data = static_cast<const float*>(pixels.data());
+                        view.row_stride = pixels.stride()[0];
+                    }
+                    view.width = image->size().x();
+                    view.height = image->size().y();
+                    view.near_plane = near_plane;
+                    view.far_plane = far_plane;
+                    view.linear = linear_depth(*image);
+                    view.owner = image;
+
+                    return view;
+                }
+
                 GrayscaleImage depth_from_image(Magnum::Image2D* image, bool linearize, Magnum::Float near_plane, Magnum::Float far_plane)
                 {
                     GrayscaleImage img;
@@ -34,12 +108,19 @@ namespace robot_dart {
                     img.height = image->size().y();
                     img.data.resize(image->size().product() * sizeof(uint8_t));
 
-                    std::vector<Magnum::Float> data = std::vector<Magnum::Float>(image->size().product());
-                    Corrade::Containers::StridedArrayView2D<const Magnum::Float> src = image->pixels<Magnum::Float>().flipped<0>();
+                    std::vector<Magnum::Float> data = depth_values(*image);
                     Corrade::Containers::StridedArrayView2D<Magnum::Float> dst{Corrade::Containers::arrayCast<Magnum::Float>(Corrade::Containers::arrayView(data)), {std::size_t(image->size().y()), std::size_t(image->size().x())}};
-                    Corrade::Utility::copy(src, dst);
 
-                    if (linearize) {
+                    if (linear_depth(*image)) {
+                        // z / far_plane for the visualization, back to the values of the depth buffer otherwise
+                        for (auto& depth : data) {
+                            if (linearize)
+                                depth = depth / far_plane;
+                            else
+                                depth = (far_plane * (depth - near_plane)) / (depth * (far_plane - near_plane));
+                        }
+                    }
+                    else if (linearize) {
                         for (auto& depth : data)
                             depth = (2.f * near_plane) / (far_plane + near_plane - depth * (far_plane - near_plane));
                     }
@@ -57,12 +138,11 @@ namespace robot_dart {
                     img.width = image->size().x();
                     img.height = image->size().y();
 
-                    std::vector<Magnum::Float> data = std::vector<Magnum::Float>(image->size().product());
-                    Corrade::Containers::StridedArrayView2D<const Magnum::Float> src = image->pixels<Magnum::Float>().flipped<0>();
-                    Corrade::Containers::StridedArrayView2D<Magnum::Float> dst{Corrade::Containers::arrayCast<Magnum::Float>(Corrade::Containers::arrayView(data)), {std::size_t(image->size().y()), std::size_t(image->size().x())}};
-                    Corrade::Utility::copy(src, dst);
-
+                    std::vector<Magnum::Float> data = depth_values(*image);
                     img.data = std::vector<double>(data.begin(), data.end());
+                    // already linear (see DepthMode)
+                    if (linear_depth(*image))
+                        return img;
 
                     double zNear = static_cast<double>(near_plane);
                     double zFar = static_cast<double>(far_plane);
@@ -3,6 +3,7 @@
 
 #include <robot_dart/gui/helper.hpp>
 
+#include <memory>
 #include <vector>
 
 #include <Magnum/Image.h>
@@ -12,8 +13,10 @@ namespace robot_dart {
         namespace magnum {
             namespace gs {
                 Image rgb_from_image(Magnum::Image2D* image);
+                ImageView rgb_view_from_image(const std::shared_ptr<Magnum::Image2D>& image);
                 GrayscaleImage depth_from_image(Magnum::Image2D* image, bool linearize = false, Magnum::Float near_plane = 0.f, Magnum::Float far_plane = 100.f);
                 DepthImage depth_array_from_image(Magnum::Image2D* image, Magnum::Float near_plane = 0.f, Magnum::Float far_plane = 100.f);
+                DepthView depth_view_from_image(const std::shared_ptr<Magnum::Image2D>& image, Magnum::Float near_plane, Magnum::Float far_plane);
             } // namespace gs
         } // namespace magnum
     } // namespace gui
@@ -24,8 +24,14 @@ namespace robot_dart {
                     defines += "#define POSITION_ATTRIBUTE_LOCATION " + std::to_string(Position::Location) + "\n";
                     defines += "#define NORMAL_ATTRIBUTE_LOCATION " + std::to_string(Normal::Location) + "\n";
                     defines += "#define TEXTURECOORDINATES_ATTRIBUTE_LOCATION " + std::to_string(TextureCoordinates::Location) + "\n";
-
-                    vert.addSource(flags ? "#define TEXTURED\n" : "")
+                    defines += "#define TRANSFORMATION_MATRIX_ATTRIBUTE_LOCATION " + std::to_string(TransformationMatrix::Location) + "\n";
+                    defines += "#define COLOR_OUTPUT_LOCATION " + std::to_string(ColorOutput) + "\n";
+                    defines += "#define LINEAR_DEPTH_OUTPUT_LOCATION " + std::to_string(LinearDepthOutput) + "\n";
+                    defines += "#define CAMERA_POSITION_OUTPUT_LOCATION " + std::to_string(CameraPositionOutput) + "\n";
+
+                    bool textured(flags & (Flag::AmbientTexture | Flag::DiffuseTexture | Flag::SpecularTexture));
+                    vert.addSource(textured ? "#define TEXTURED\n" : "")
+                        .addSource(flags & Flag::InstancedTransformation ? "#define INSTANCED_TRANSFORMATION\n" : "")
                         .addSource(defines)
                         .addSource(rs_shaders.get("PhongMultiLight.vert"));
                     frag.addSource(flags & Flag::AmbientTexture ? "#define AMBIENT_TEXTURE\n" : "")
@@ -41,8 +47,13 @@ namespace robot_dart {
                     if (!Magnum::GL::Context::current().isExtensionSupported<Magnum::GL::Extensions::ARB::explicit_attrib_location>(version)) {
                         bindAttributeLocation(Position::Location, "position");
                         bindAttributeLocation(Normal::Location, "normal");
-                        if (flags)
+                        if (textured)
                             bindAttributeLocation(TextureCoordinates::Location, "textureCoords");
+                        if (flags & Flag::InstancedTransformation)
+                            bindAttributeLocation(TransformationMatrix::Location, "instancedTransformationMatrix");
+                        bindFragmentDataLocation(ColorOutput, "color");
+                        bindFragmentDataLocation(LinearDepthOutput, "linearDepth");
+                        bindFragmentDataLocation(CameraPositionOutput, "cameraPosition");
                     }
 
                     CORRADE_INTERNAL_ASSERT_OUTPUT(link());
@@ -73,7 +84,7 @@ namespace robot_dart {
                         setUniform(uniformLocation("cubeMapTextures"), _cube_map_textures_location);
                         setUniform(uniformLocation("shadowColorTextures"), _shadow_color_textures_location);
                         setUniform(uniformLocation("cubeMapColorTextures"), _cube_map_color_textures_location);
-                        if (flags) {
+                        if (textured) {
                             if (flags & Flag::AmbientTexture)
                                 setUniform(uniformLocation("ambientTexture"), AmbientTextureLayer);
                             if (flags & Flag::DiffuseTexture)
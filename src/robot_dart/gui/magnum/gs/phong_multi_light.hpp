@@ -21,11 +21,22 @@ namespace robot_dart {
                     using Position = Magnum::Shaders::Generic3D::Position;
                     using Normal = Magnum::Shaders::Generic3D::Normal;
                     using TextureCoordinates = Magnum::Shaders::Generic3D::TextureCoordinates;
+                    /// per-instance transformation (used with Flag::InstancedTransformation)
+                    using TransformationMatrix = Magnum::Shaders::Generic3D::TransformationMatrix;
+
+                    /// fragment outputs: the color and, for the depth cameras, the linear depth (float) or the camera frame position
+                    /// and linear depth (vec4); the outputs that are not mapped to an attachment are discarded
+                    enum : Magnum::UnsignedInt {
+                        ColorOutput = 0,
+                        LinearDepthOutput = 1,
+                        CameraPositionOutput = 2
+                    };
 
                     enum class Flag : Magnum::UnsignedByte {
                         AmbientTexture = 1 << 0, /**< The shader uses ambient texture instead of color */
                         DiffuseTexture = 1 << 1, /**< The shader uses diffuse texture instead of color */
-                        SpecularTexture = 1 << 2 /**< The shader uses specular texture instead of color */
+                        SpecularTexture = 1 << 2, /**< The shader uses specular texture instead of color */
+                        InstancedTransformation = 1 << 3 /**< The transformation is given per instance (the normal matrix is computed in the shader) */
                     };
 
                     using Flags = Magnum::Containers::EnumSet<Flag>;
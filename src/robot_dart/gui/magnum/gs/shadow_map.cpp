@@ -20,11 +20,15 @@ namespace robot_dart {
 
                     std::string defines = "#define POSITION_ATTRIBUTE_LOCATION " + std::to_string(Position::Location) + "\n";
                     defines += "#define TEXTURECOORDINATES_ATTRIBUTE_LOCATION " + std::to_string(TextureCoordinates::Location) + "\n";
+                    defines += "#define TRANSFORMATION_MATRIX_ATTRIBUTE_LOCATION " + std::to_string(TransformationMatrix::Location) + "\n";
 
-                    vert.addSource(flags ? "#define TEXTURED\n" : "")
+                    bool textured(flags & Flag::DiffuseTexture);
+
+                    vert.addSource(textured ? "#define TEXTURED\n" : "")
+                        .addSource(flags & Flag::InstancedTransformation ? "#define INSTANCED_TRANSFORMATION\n" : "")
                         .addSource(defines)
                         .addSource(rs_shaders.get("ShadowMap.vert"));
-                    frag.addSource(flags ? "#define TEXTURED\n" : "")
+                    frag.addSource(textured ? "#define TEXTURED\n" : "")
                         .addSource(rs_shaders.get("ShadowMap.frag"));
 
                     CORRADE_INTERNAL_ASSERT_OUTPUT(Magnum::GL::Shader::compile({vert, frag}));
@@ -33,8 +37,10 @@ namespace robot_dart {
 
                     if (!Magnum::GL::Context::current().isExtensionSupported<Magnum::GL::Extensions::ARB::explicit_attrib_location>(version)) {
                         bindAttributeLocation(Position::Location, "position");
-                        if (flags)
+                        if (textured)
                             bindAttributeLocation(TextureCoordinates::Location, "textureCoords");
+                        if (flags & Flag::InstancedTransformation)
+                            bindAttributeLocation(TransformationMatrix::Location, "instancedTransformationMatrix");
                     }
 
                     CORRADE_INTERNAL_ASSERT_OUTPUT(link());
@@ -47,7 +53,7 @@ namespace robot_dart {
 
                     if (!Magnum::GL::Context::current()
                              .isExtensionSupported<Magnum::GL::Extensions::ARB::shading_language_420pack>(version)
-                        && flags) {
+                        && textured) {
                         setUniform(uniformLocation("diffuseTexture"), DiffuseTextureLayer);
                     }
                 }
@@ -20,9 +20,12 @@ namespace robot_dart {
                 public:
                     using Position = Magnum::Shaders::Generic3D::Position;
                     using TextureCoordinates = Magnum::Shaders::Generic3D::TextureCoordinates;
+                    /// per-instance transformation (used with Flag::InstancedTransformation)
+                    using TransformationMatrix = Magnum::Shaders::Generic3D::TransformationMatrix;
 
                     enum class Flag : Magnum::UnsignedByte {
                         DiffuseTexture = 1 << 0, /**< The shader uses diffuse texture instead of color */
+                        InstancedTransformation = 1 << 1 /**< The transformation is given per instance (multiplied by the transformation matrix) */
                     };
 
                     using Flags = Magnum::Containers::EnumSet<Flag>;
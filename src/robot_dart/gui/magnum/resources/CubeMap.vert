@@ -8,6 +8,13 @@ layout(location = POSITION_ATTRIBUTE_LOCATION)
 #endif
 in highp vec4 position;
 
+#ifdef INSTANCED_TRANSFORMATION
+#ifdef EXPLICIT_ATTRIB_LOCATION
+layout(location = TRANSFORMATION_MATRIX_ATTRIBUTE_LOCATION)
+#endif
+in highp mat4 instancedTransformationMatrix;
+#endif
+
 #ifdef TEXTURED
 #ifdef EXPLICIT_ATTRIB_LOCATION
 layout(location = TEXTURECOORDINATES_ATTRIBUTE_LOCATION)
@@ -19,7 +26,11 @@ out mediump vec2 interTextureCoords;
 
 void main() {
     /* Transform the position */
+    #ifdef INSTANCED_TRANSFORMATION
+    gl_Position = transformationMatrix * instancedTransformationMatrix * position;
+    #else
     gl_Position = transformationMatrix * position;
+    #endif
 
     #ifdef TEXTURED
     /* Texture coordinates, if needed */
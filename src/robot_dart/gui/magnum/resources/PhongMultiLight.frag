@@ -135,7 +135,20 @@ in mediump vec2 interpolatedTextureCoords;
 #endif
 
 #ifdef NEW_GLSL
+#ifdef EXPLICIT_ATTRIB_LOCATION
+layout(location = COLOR_OUTPUT_LOCATION)
+#endif
 out lowp vec4 color;
+
+/* Optional outputs for the depth cameras (discarded if they are not mapped to an attachment) */
+#ifdef EXPLICIT_ATTRIB_LOCATION
+layout(location = LINEAR_DEPTH_OUTPUT_LOCATION)
+#endif
+out highp float linearDepth;
+#ifdef EXPLICIT_ATTRIB_LOCATION
+layout(location = CAMERA_POSITION_OUTPUT_LOCATION)
+#endif
+out highp vec4 cameraPosition;
 #endif
 
 float visibilityCalculation(int index, float bias)
@@ -343,4 +356,10 @@ void main() {
     }
 
     color.a = finalDiffuseColor.a;
+
+    #ifdef NEW_GLSL
+    /* Camera frame position (the camera looks towards -Z) and distance along the axis of the camera */
+    linearDepth = cameraDirection.z;
+    cameraPosition = vec4(-cameraDirection, cameraDirection.z);
+    #endif
 }
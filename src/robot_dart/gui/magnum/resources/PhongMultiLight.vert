@@ -31,6 +31,13 @@ layout(location = NORMAL_ATTRIBUTE_LOCATION)
 #endif
 in mediump vec3 normal;
 
+#ifdef INSTANCED_TRANSFORMATION
+#ifdef EXPLICIT_ATTRIB_LOCATION
+layout(location = TRANSFORMATION_MATRIX_ATTRIBUTE_LOCATION)
+#endif
+in highp mat4 instancedTransformationMatrix;
+#endif
+
 #ifdef TEXTURED
 #ifdef EXPLICIT_ATTRIB_LOCATION
 layout(location = TEXTURECOORDINATES_ATTRIBUTE_LOCATION)
@@ -47,13 +54,23 @@ out highp vec4 lightSpacePositions[LIGHT_COUNT];
 
 void main() {
     /* Transformed vertex position */
+    #ifdef INSTANCED_TRANSFORMATION
+    /* One transformation per instance (transformationMatrix is applied on top of it) */
+    highp mat4 instanceTransformation = transformationMatrix*instancedTransformationMatrix;
+    highp vec4 transformedPosition4 = instanceTransformation*position;
+    #else
     highp vec4 transformedPosition4 = transformationMatrix*position;
+    #endif
     worldPosition = transformedPosition4.xyz;
     highp vec4 modelViewPosition = cameraMatrix*transformedPosition4;
     highp vec3 transformedPosition = modelViewPosition.xyz/modelViewPosition.w;
 
     /* Transformed normal vector */
+    #ifdef INSTANCED_TRANSFORMATION
+    transformedNormal = mat3(cameraMatrix*instanceTransformation)*normal;
+    #else
     transformedNormal = normalMatrix*normal;
+    #endif
 
     /* Direction to the camera */
     cameraDirection = -transformedPosition;
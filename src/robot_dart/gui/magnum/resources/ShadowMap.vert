@@ -13,6 +13,13 @@ layout(location = POSITION_ATTRIBUTE_LOCATION)
 #endif
 in highp vec4 position;
 
+#ifdef INSTANCED_TRANSFORMATION
+#ifdef EXPLICIT_ATTRIB_LOCATION
+layout(location = TRANSFORMATION_MATRIX_ATTRIBUTE_LOCATION)
+#endif
+in highp mat4 instancedTransformationMatrix;
+#endif
+
 #ifdef TEXTURED
 #ifdef EXPLICIT_ATTRIB_LOCATION
 layout(location = TEXTURECOORDINATES_ATTRIBUTE_LOCATION)
@@ -24,7 +31,11 @@ out mediump vec2 interpolatedTextureCoords;
 
 void main() {
     /* Transformed vertex position */
+    #ifdef INSTANCED_TRANSFORMATION
+    highp vec4 transformedPosition4 = transformationMatrix*instancedTransformationMatrix*position;
+    #else
     highp vec4 transformedPosition4 = transformationMatrix*position;
+    #endif
     /* Transform the position */
     gl_Position = projectionMatrix*transformedPosition4;
 
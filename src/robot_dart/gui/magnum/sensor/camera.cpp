@@ -1,5 +1,7 @@
 #include "camera.hpp"
 
+#include <robot_dart/gui/magnum/gs/phong_multi_light.hpp>
+
 #include <Corrade/Containers/ArrayViewStl.h>
 #include <Corrade/Containers/StridedArrayView.h>
 #include <Corrade/Utility/Algorithms.h>
@@ -9,7 +11,9 @@
 #include <Magnum/GL/Renderer.h>
 #include <Magnum/GL/TextureFormat.h>
 #include <Magnum/ImageView.h>
+#include <Magnum/Math/Color.h>
 #include <Magnum/PixelFormat.h>
+#include <Magnum/PixelStorage.h>
 
 #include <robot_dart/gui/magnum/utils_headers_eigen.hpp>
 
@@ -58,6 +62,12 @@ namespace robot_dart {
                 void Camera::calculate(double)
                 {
                     ROBOT_DART_EXCEPTION_ASSERT(_simu, "Simulation pointer is null!");
+                    /* The atlas draws all its due cameras at once */
+                    if (_atlas) {
+                        _atlas_due = true;
+                        return;
+                    }
+
                     /* Update graphic meshes/materials and render */
                     _magnum_app->update_graphics();
                     /* Update lights transformations --- this also draws the shadows if enabled */
@@ -77,12 +87,40 @@ namespace robot_dart {
                     /* Clear framebuffer */
                     _framebuffer.clear(Magnum::GL::FramebufferClear::Color | Magnum::GL::FramebufferClear::Depth);
 
+                    bool linear_depth = (_camera->depth_mode() != gs::DepthMode::Raw);
+                    if (linear_depth) {
+                        /* Nothing drawn: far plane (and no position) */
+                        float far_plane = _camera->far_plane();
+                        _framebuffer.clearColor(1, (_camera->depth_mode() == gs::DepthMode::Linear) ? Magnum::Vector4{far_plane} : Magnum::Vector4{0.f, 0.f, 0.f, far_plane});
+                        /* The depth values must not be blended with the background */
+                        Magnum::GL::Renderer::disable(Magnum::GL::Renderer::Feature::Blending, 1);
+                    }
+
                     /* Draw with this camera */
-                    _camera->draw(_magnum_app->drawables(), _framebuffer, _format, _simu, _magnum_app->debug_draw_data(), _draw_debug);
+                    _camera->draw(_magnum_app->draw_list(_draw_debug), _simu, _magnum_app->debug_draw_data(), _draw_debug);
+                    _camera->read(_framebuffer, _format, &_framebuffer);
+
+                    if (linear_depth)
+                        Magnum::GL::Renderer::enable(Magnum::GL::Renderer::Feature::Blending, 1);
                 }
 
                 std::string Camera::type() const { return "rgb_camera"; }
 
+                bool Camera::write_blob(std::vector<uint8_t>& blob)
+                {
+                    ImageView view = image_view();
+                    if (view.empty())
+                        return false;
+
+                    uint32_t dims[3] = {static_cast<uint32_t>(view.width), static_cast<uint32_t>(view.height), static_cast<uint32_t>(view.channels)};
+                    const uint8_t* header = reinterpret_cast<const uint8_t*>(dims);
+                    blob.insert(blob.end(), header, header + sizeof(dims));
+                    size_t row_size = view.width * view.channels;
+                    for (size_t y = 0; y < view.height; y++)
+                        blob.insert(blob.end(), view.row(y), view.row(y) + row_size);
+                    return true;
+                }
+
                 void Camera::attach_to_body(dart::dynamics::BodyNode* body, const Eigen::Isometry3d& tf)
                 {
                     robot_dart::sensor::Sensor::attach_to_body(body, tf);
@@ -156,8 +194,81 @@ namespace robot_dart {
                     }
                 }
 
+                ImageView Camera::image_view()
+                {
+                    if (!_atlas || !_atlas_color)
+                        return _camera->image_view();
+
+                    // the region of the camera in the (bottom-up) atlas, seen from the top-left corner
+                    size_t y = static_cast<size_t>(_atlas_color->size().y() - _atlas_offset.y()) - _height;
+                    return gs::rgb_view_from_image(_atlas_color).region(static_cast<size_t>(_atlas_offset.x()), y, _width, _height);
+                }
+
+                DepthView Camera::depth_view()
+                {
+                    if (!_atlas || !_atlas_depth)
+                        return _camera->depth_view();
+
+                    // the region of the camera in the (bottom-up) atlas, seen from the top-left corner
+                    DepthView view = gs::depth_view_from_image(_atlas_depth, _camera->near_plane(), _camera->far_plane());
+                    size_t y = static_cast<size_t>(_atlas_depth->size().y() - _atlas_offset.y()) - _height;
+                    view.data = view.row(y) + _atlas_offset.x() * view.pixel_stride;
+                    view.width = _width;
+                    view.height = _height;
+                    return view;
+                }
+
+                void Camera::set_depth_mode(gs::DepthMode mode)
+                {
+                    ROBOT_DART_WARNING(_atlas && mode != gs::DepthMode::Raw, "The linear depth modes are not supported for cameras rendered in an atlas: using the depth buffer.");
+                    if (_atlas || !_framebuffer.id())
+                        mode = gs::DepthMode::Raw;
+
+                    _camera->set_depth_mode(mode);
+                    if (!_framebuffer.id())
+                        return;
+
+                    if (mode == gs::DepthMode::Raw) {
+                        _framebuffer.detach(Magnum::GL::Framebuffer::ColorAttachment(1));
+                        _framebuffer.mapForDraw({{gs::PhongMultiLight::ColorOutput, Magnum::GL::Framebuffer::ColorAttachment(0)}});
+                        _linear_depth = Magnum::GL::Renderbuffer{Magnum::NoCreate};
+                        return;
+                    }
+
+                    /* Float attachment written by the PhongMultiLight shaders */
+                    int w = _width, h = _height;
+                    bool xyz = (mode == gs::DepthMode::LinearXYZ);
+                    _linear_depth = Magnum::GL::Renderbuffer{};
+                    _linear_depth.setStorage(xyz ? Magnum::GL::RenderbufferFormat::RGBA32F : Magnum::GL::RenderbufferFormat::R32F, {w, h});
+                    _framebuffer.attachRenderbuffer(Magnum::GL::Framebuffer::ColorAttachment(1), _linear_depth);
+                    _framebuffer.mapForDraw({{gs::PhongMultiLight::ColorOutput, Magnum::GL::Framebuffer::ColorAttachment(0)},
+                        {xyz ? gs::PhongMultiLight::CameraPositionOutput : gs::PhongMultiLight::LinearDepthOutput, Magnum::GL::Framebuffer::ColorAttachment(1)}});
+                }
+
+                void Camera::_copy_from_atlas()
+                {
+                    if (!_atlas_copy_pending)
+                        return;
+                    _atlas_copy_pending = false;
+
+                    Magnum::Vector2i size{static_cast<int>(_width), static_cast<int>(_height)};
+                    std::size_t x = static_cast<std::size_t>(_atlas_offset.x()), y = static_cast<std::size_t>(_atlas_offset.y());
+                    if (_atlas_color && _camera->recording()) {
+                        Magnum::Image2D image{Magnum::PixelStorage{}.setAlignment(1), Magnum::PixelFormat::RGB8Unorm, size, Corrade::Containers::Array<char>{Corrade::Containers::ValueInit, _width * _height * sizeof(Magnum::Color3ub)}};
+                        Corrade::Utility::copy(_atlas_color->pixels<Magnum::Color3ub>().slice({y, x}, {y + _height, x + _width}), image.pixels<Magnum::Color3ub>());
+                        _camera->set_image(std::move(image));
+                    }
+
+                    if (_atlas_depth && _camera->recording_depth()) {
+                        Magnum::Image2D image{Magnum::PixelStorage{}.setAlignment(1), Magnum::GL::PixelFormat::DepthComponent, Magnum::GL::PixelType::Float, size, Corrade::Containers::Array<char>{Corrade::Containers::ValueInit, _width * _height * sizeof(Magnum::Float)}};
+                        Corrade::Utility::copy(_atlas_depth->pixels<Magnum::Float>().slice({y, x}, {y + _height, x + _width}), image.pixels<Magnum::Float>());
+                        _camera->set_depth_image(std::move(image));
+                    }
+                }
+
                 GrayscaleImage Camera::depth_image()
                 {
+                    _copy_from_atlas();
                     auto& depth_image = _camera->depth_image();
                     if (!depth_image)
                         return GrayscaleImage();
@@ -167,6 +278,7 @@ namespace robot_dart {
 
                 GrayscaleImage Camera::raw_depth_image()
                 {
+                    _copy_from_atlas();
                     auto& depth_image = _camera->depth_image();
                     if (!depth_image)
                         return GrayscaleImage();
@@ -176,6 +288,7 @@ namespace robot_dart {
 
                 DepthImage Camera::depth_array()
                 {
+                    _copy_from_atlas();
                     auto& depth_image = _camera->depth_image();
                     if (!depth_image)
                         return DepthImage();
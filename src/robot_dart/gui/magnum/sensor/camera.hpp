@@ -13,10 +13,13 @@ namespace robot_dart {
     namespace gui {
         namespace magnum {
             namespace sensor {
+                class CameraAtlas;
+
                 class Camera : public robot_dart::sensor::Sensor {
                 public:
                     Camera(BaseApplication* app, size_t width, size_t height, size_t freq = 30, bool draw_debug = false);
-                    ~Camera() {}
+                    // the framebuffers of the camera are GL objects: the context of the application has to be current
+                    ~Camera() { _camera->release(); }
 
                     void init() override;
 
@@ -24,6 +27,10 @@ namespace robot_dart {
 
                     std::string type() const override;
 
+                    // blob: width, height and channels (3 uint32_t) followed by the RGB image (top-down rows)
+                    bool write_blob(std::vector<uint8_t>& blob) override;
+                    size_t blob_size() const override { return 3 * sizeof(uint32_t) + _width * _height * 3; }
+
                     void attach_to_body(dart::dynamics::BodyNode* body, const Eigen::Isometry3d& tf = Eigen::Isometry3d::Identity()) override;
 
                     void attach_to_joint(dart::dynamics::Joint*, const Eigen::Isometry3d&) override
@@ -50,6 +57,7 @@ namespace robot_dart {
 
                     Magnum::Image2D* magnum_image()
                     {
+                        _copy_from_atlas();
                         if (_camera->image())
                             return &(*_camera->image());
                         return nullptr;
@@ -63,8 +71,11 @@ namespace robot_dart {
                         return Image();
                     }
 
+                    ImageView image_view();
+
                     Magnum::Image2D* magnum_depth_image()
                     {
+                        _copy_from_atlas();
                         if (_camera->depth_image())
                             return &(*_camera->depth_image());
                         return nullptr;
@@ -79,10 +90,24 @@ namespace robot_dart {
                     // "Image" filled with depth buffer values (this returns an array of doubles)
                     DepthImage depth_array();
 
+                    // Raw depth buffer (not copied, e.g., for PointCloudGenerator)
+                    DepthView depth_view();
+
+                    // The linear modes make the shaders write the metric depth (and the camera frame positions with LinearXYZ)
+                    // in a float attachment that is read instead of the depth buffer (not supported in an atlas)
+                    void set_depth_mode(gs::DepthMode mode);
+                    gs::DepthMode depth_mode() const { return _camera->depth_mode(); }
+
+                    /// the atlas that renders this camera (nullptr if the camera renders itself)
+                    CameraAtlas* atlas() const { return _atlas; }
+
                 protected:
+                    friend class CameraAtlas;
+
                     Magnum::GL::Framebuffer _framebuffer{Magnum::NoCreate};
                     Magnum::PixelFormat _format;
                     Magnum::GL::Renderbuffer _color, _depth;
+                    Magnum::GL::Renderbuffer _linear_depth{Magnum::NoCreate};
 
                     BaseApplication* _magnum_app;
                     size_t _width, _height;
@@ -90,6 +115,15 @@ namespace robot_dart {
                     std::unique_ptr<gs::Camera> _camera;
 
                     bool _draw_debug;
+
+                    // rendered in an atlas: the images are regions of the images of the atlas
+                    CameraAtlas* _atlas = nullptr;
+                    Magnum::Vector2i _atlas_offset;
+                    bool _atlas_due = false, _atlas_copy_pending = false;
+                    std::shared_ptr<Magnum::Image2D> _atlas_color, _atlas_depth;
+
+                    // copies the regions of the atlas to the images of the camera (only when they are needed)
+                    void _copy_from_atlas();
                 };
             } // namespace sensor
         } // namespace magnum
@@ -0,0 +1,240 @@
+#include "camera_atlas.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include <Magnum/GL/PixelFormat.h>
+#include <Magnum/GL/RenderbufferFormat.h>
+#include <Magnum/GL/Renderer.h>
+#include <Magnum/ImageView.h>
+#include <Magnum/PixelFormat.h>
+
+namespace robot_dart {
+    namespace gui {
+        namespace magnum {
+            namespace sensor {
+                CameraAtlas::CameraAtlas(BaseApplication* app, size_t freq, bool draw_debug) : robot_dart::sensor::Sensor(freq), _magnum_app(app), _draw_debug(draw_debug), _scheduler(1. / std::max<size_t>(1, freq))
+                {
+                    /* Assume context is given externally, if not, we cannot have cameras */
+                    if (!Magnum::GL::Context::hasCurrent()) {
+                        Corrade::Utility::Error{} << "GL::Context not provided.. Cannot use this camera atlas!";
+                        _active = false;
+                    }
+                }
+
+                CameraAtlas::~CameraAtlas()
+                {
+                    // the cameras cannot render without the atlas (they do not have a framebuffer)
+                    for (auto& camera : _cameras) {
+                        camera->_atlas = nullptr;
+                        camera->_active = false;
+                    }
+                }
+
+                void CameraAtlas::init()
+                {
+                    if (!_simu || !Magnum::GL::Context::hasCurrent())
+                        return;
+                    _active = true;
+                    for (auto& camera : _cameras) {
+                        camera->set_simu(_simu);
+                        camera->init();
+                    }
+                }
+
+                std::shared_ptr<Camera> CameraAtlas::add_camera(size_t width, size_t height, size_t freq)
+                {
+                    auto camera = std::make_shared<Camera>(_magnum_app, width, height, (freq == 0) ? _frequency : freq, _draw_debug);
+                    // the atlas draws in its own framebuffer
+                    camera->_framebuffer = Magnum::GL::Framebuffer{Magnum::NoCreate};
+                    camera->_color = Magnum::GL::Renderbuffer{Magnum::NoCreate};
+                    camera->_depth = Magnum::GL::Renderbuffer{Magnum::NoCreate};
+                    camera->_atlas = this;
+                    camera->_driven = true;
+                    if (_simu) {
+                        camera->set_simu(_simu);
+                        camera->init();
+                    }
+
+                    _update_tasks();
+                    _camera_tasks.push_back(_scheduler.add_task(_camera_frequency(*camera)));
+                    _cameras.push_back(camera);
+                    _layout_dirty = true;
+                    return camera;
+                }
+
+                void CameraAtlas::remove_camera(const std::shared_ptr<Camera>& camera)
+                {
+                    auto it = std::find(_cameras.begin(), _cameras.end(), camera);
+                    if (it == _cameras.end())
+                        return;
+                    camera->_atlas = nullptr;
+                    camera->_active = false;
+                    size_t index = static_cast<size_t>(it - _cameras.begin());
+                    _scheduler.remove_task(_camera_tasks[index]);
+                    _camera_tasks.erase(_camera_tasks.begin() + index);
+                    _cameras.erase(it);
+                    _layout_dirty = true;
+                }
+
+                void CameraAtlas::calculate(double t)
+                {
+                    ROBOT_DART_EXCEPTION_ASSERT(_simu, "Simulation pointer is null!");
+
+                    /* The cameras that are due: refresh() updates their pose and marks them (see Camera::calculate()) */
+                    _update_tasks();
+                    bool any_due = false;
+                    for (size_t i = 0; i < _cameras.size(); i++) {
+                        if (_scheduler.due(_camera_tasks[i])) {
+                            _cameras[i]->refresh(t);
+                            any_due = any_due || _cameras[i]->_atlas_due;
+                        }
+                    }
+                    _scheduler.step();
+                    if (!any_due)
+                        return;
+
+                    if (_layout_dirty)
+                        _layout();
+
+                    /* Update graphic meshes/materials */
+                    _magnum_app->update_graphics();
+
+                    Magnum::GL::Renderer::enable(Magnum::GL::Renderer::Feature::DepthTest);
+                    Magnum::GL::Renderer::enable(Magnum::GL::Renderer::Feature::FaceCulling);
+                    Magnum::GL::Renderer::enable(Magnum::GL::Renderer::Feature::Blending);
+                    Magnum::GL::Renderer::setBlendFunction(Magnum::GL::Renderer::BlendFunction::SourceAlpha, Magnum::GL::Renderer::BlendFunction::OneMinusSourceAlpha);
+                    Magnum::GL::Renderer::setBlendEquation(Magnum::GL::Renderer::BlendEquation::Add);
+
+                    /* Change clear color to black */
+                    Magnum::GL::Renderer::setClearColor(Magnum::Vector4{0.f, 0.f, 0.f, 1.f});
+
+                    /* Clear the whole atlas once */
+                    Magnum::Range2Di full{{}, _size};
+                    _framebuffer.setViewport(full).bind();
+                    _framebuffer.clear(Magnum::GL::FramebufferClear::Color | Magnum::GL::FramebufferClear::Depth);
+
+                    /* One traversal of the scene for all the cameras */
+                    const gs::DrawList& draw_list = _magnum_app->draw_list(_draw_debug);
+
+                    bool render_shadows = true, read_color = false, read_depth = false;
+                    for (auto& camera : _cameras) {
+                        if (!camera->_atlas_due)
+                            continue;
+                        gs::Camera& cam = *camera->_camera;
+                        if (cam.readback_mode() != gs::ReadbackMode::Sync) {
+                            ROBOT_DART_WARNING(true, "The cameras of an atlas are read back synchronously with the atlas: ignoring their asynchronous readback mode.");
+                            cam.set_readback_mode(gs::ReadbackMode::Sync);
+                        }
+
+                        /* The lights are transformed for each camera, but the shadow maps are rendered only once */
+                        _magnum_app->update_lights(cam, render_shadows);
+                        render_shadows = false;
+
+                        /* The shadow pass binds its own framebuffers */
+                        _framebuffer.setViewport(Magnum::Range2Di::fromSize(camera->_atlas_offset, {static_cast<int>(camera->_width), static_cast<int>(camera->_height)})).bind();
+                        cam.draw(draw_list, _simu, _magnum_app->debug_draw_data(), _draw_debug);
+
+                        read_color = read_color || cam.recording() || cam.video_writer();
+                        read_depth = read_depth || cam.recording_depth();
+                    }
+
+                    /* Single readback for all the cameras */
+                    _framebuffer.setViewport(full);
+                    _image = read_color ? std::make_shared<Magnum::Image2D>(_framebuffer.read(full, {Magnum::PixelFormat::RGB8Unorm})) : nullptr;
+                    _depth_image = read_depth ? std::make_shared<Magnum::Image2D>(_framebuffer.read(full, {Magnum::GL::PixelFormat::DepthComponent, Magnum::GL::PixelType::Float})) : nullptr;
+
+                    for (auto& camera : _cameras) {
+                        if (!camera->_atlas_due)
+                            continue;
+                        camera->_atlas_due = false;
+                        camera->_atlas_color = _image;
+                        camera->_atlas_depth = _depth_image;
+                        // the images of the camera are copied from the atlas only if they are asked for
+                        camera->_atlas_copy_pending = true;
+
+                        if (_image && camera->_camera->video_writer())
+                            camera->_camera->push_video_frame(camera->image_view());
+                        // the cameras of the atlas are not refreshed by the simulation
+                        camera->_record(t);
+                    }
+                }
+
+                std::string CameraAtlas::type() const { return "camera_atlas"; }
+
+                double CameraAtlas::_camera_frequency(const Camera& camera) const
+                {
+                    // a camera cannot be faster than its atlas
+                    return static_cast<double>(std::max<size_t>(1, std::min(camera.frequency(), _frequency)));
+                }
+
+                void CameraAtlas::_update_tasks()
+                {
+                    double dt = 1. / std::max<size_t>(1, _frequency);
+                    if (_scheduler.dt() != dt) {
+                        // the periods of the cameras are checked with the new dt
+                        std::vector<std::pair<size_t, double>> frequencies;
+                        for (size_t i = 0; i < _cameras.size(); i++)
+                            frequencies.emplace_back(_camera_tasks[i], _camera_frequency(*_cameras[i]));
+                        _scheduler.set_dt(dt, frequencies);
+                        return;
+                    }
+                    // no-op if the frequency of the camera did not change
+                    for (size_t i = 0; i < _cameras.size(); i++)
+                        _scheduler.set_task_frequency(_camera_tasks[i], _camera_frequency(*_cameras[i]));
+                }
+
+                void CameraAtlas::_layout()
+                {
+                    _layout_dirty = false;
+                    if (_cameras.empty())
+                        return;
+
+                    /* Shelf packing: the tallest cameras first, rows of (roughly) the width of a square atlas */
+                    std::vector<size_t> order(_cameras.size());
+                    std::iota(order.begin(), order.end(), 0);
+                    std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) { return _cameras[a]->_height > _cameras[b]->_height; });
+
+                    size_t area = 0, max_width = 0;
+                    for (auto& camera : _cameras) {
+                        area += camera->_width * camera->_height;
+                        max_width = std::max(max_width, camera->_width);
+                    }
+                    int atlas_width = static_cast<int>(std::max(max_width, static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(area))))));
+
+                    int x = 0, y = 0, row_height = 0, width = 0;
+                    for (size_t i : order) {
+                        auto& camera = _cameras[i];
+                        int w = static_cast<int>(camera->_width), h = static_cast<int>(camera->_height);
+                        if (x + w > atlas_width) {
+                            x = 0;
+                            y += row_height;
+                            row_height = 0;
+                        }
+                        camera->_atlas_offset = {x, y};
+                        x += w;
+                        row_height = std::max(row_height, h);
+                        width = std::max(width, x);
+                    }
+                    Magnum::Vector2i size{width, y + row_height};
+
+                    ROBOT_DART_WARNING(size.max() > Magnum::GL::Renderbuffer::maxSize(), "The camera atlas (" << size.x() << "x" << size.y() << ") is bigger than the maximum size of a renderbuffer!");
+                    if (size == _size)
+                        return;
+
+                    /* Create the framebuffer of the atlas */
+                    _size = size;
+                    _color = Magnum::GL::Renderbuffer{};
+                    _color.setStorage(Magnum::GL::RenderbufferFormat::RGBA8, _size);
+                    _depth = Magnum::GL::Renderbuffer{};
+                    _depth.setStorage(Magnum::GL::RenderbufferFormat::DepthComponent, _size);
+
+                    _framebuffer = Magnum::GL::Framebuffer({{}, _size});
+                    _framebuffer.attachRenderbuffer(Magnum::GL::Framebuffer::ColorAttachment(0), _color);
+                    _framebuffer.attachRenderbuffer(Magnum::GL::Framebuffer::BufferAttachment::Depth, _depth);
+                }
+            } // namespace sensor
+        } // namespace magnum
+    } // namespace gui
+} // namespace robot_dart
@@ -0,0 +1,84 @@
+#ifndef ROBOT_DART_GUI_MAGNUM_SENSOR_CAMERA_ATLAS_HPP
+#define ROBOT_DART_GUI_MAGNUM_SENSOR_CAMERA_ATLAS_HPP
+
+#include <robot_dart/gui/magnum/sensor/camera.hpp>
+#include <robot_dart/scheduler.hpp>
+
+namespace robot_dart {
+    namespace gui {
+        namespace magnum {
+            namespace sensor {
+                /// Renders many cameras into one framebuffer (each camera has its own region of the atlas).
+                /// The scene is traversed once, the shadow maps are rendered once and the images are read back once per frame
+                /// (synchronously: the asynchronous readback modes of the cameras are not supported);
+                /// the images of the cameras are views of regions of the atlas (see Camera::image_view()).
+                /// The atlas is the sensor that is added to the simulation: its cameras are updated when it is refreshed,
+                /// each one at its own frequency (at most the one of the atlas): a camera is due at the refreshes of the atlas
+                /// closest to its activations, without accumulating rounding errors (same as the tasks of the simulation).
+                class CameraAtlas : public robot_dart::sensor::Sensor {
+                public:
+                    CameraAtlas(BaseApplication* app, size_t freq = 30, bool draw_debug = false);
+                    ~CameraAtlas();
+
+                    void init() override;
+
+                    void calculate(double t) override;
+
+                    std::string type() const override;
+
+                    void attach_to_body(dart::dynamics::BodyNode*, const Eigen::Isometry3d&) override
+                    {
+                        ROBOT_DART_WARNING(true, "You cannot attach a camera atlas to a body! Attach its cameras instead.");
+                    }
+
+                    void attach_to_joint(dart::dynamics::Joint*, const Eigen::Isometry3d&) override
+                    {
+                        ROBOT_DART_WARNING(true, "You cannot attach a camera atlas to a joint!");
+                    }
+
+                    /// creates a camera that is rendered in the atlas (do not add it to the simulation);
+                    /// freq = 0 uses the frequency of the atlas
+                    std::shared_ptr<Camera> add_camera(size_t width, size_t height, size_t freq = 0);
+                    void remove_camera(const std::shared_ptr<Camera>& camera);
+                    const std::vector<std::shared_ptr<Camera>>& cameras() const { return _cameras; }
+
+                    bool drawing_debug() const { return _draw_debug; }
+                    void draw_debug(bool draw = true) { _draw_debug = draw; }
+
+                    /// size of the atlas (0x0 before the first frame)
+                    Magnum::Vector2i size() const { return _size; }
+                    /// images of the whole atlas (of the last frame)
+                    std::shared_ptr<Magnum::Image2D>& image() { return _image; }
+                    std::shared_ptr<Magnum::Image2D>& depth_image() { return _depth_image; }
+
+                protected:
+                    BaseApplication* _magnum_app;
+                    bool _draw_debug;
+
+                    std::vector<std::shared_ptr<Camera>> _cameras;
+                    // one task per camera (same order as _cameras), stepped at each refresh of the atlas
+                    Scheduler _scheduler;
+                    std::vector<size_t> _camera_tasks;
+
+                    Magnum::GL::Framebuffer _framebuffer{Magnum::NoCreate};
+                    Magnum::GL::Renderbuffer _color{Magnum::NoCreate}, _depth{Magnum::NoCreate};
+                    Magnum::Vector2i _size;
+                    bool _layout_dirty = true;
+
+                    std::shared_ptr<Magnum::Image2D> _image, _depth_image;
+
+                    void _layout();
+                    double _camera_frequency(const Camera& camera) const;
+                    // follows the changes of the frequencies of the atlas and of the cameras
+                    void _update_tasks();
+                };
+            } // namespace sensor
+        } // namespace magnum
+    } // namespace gui
+
+    namespace sensor {
+        using gui::magnum::sensor::CameraAtlas;
+    }
+} // namespace robot_dart
+
+#endif
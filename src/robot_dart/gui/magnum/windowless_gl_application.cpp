@@ -21,7 +21,7 @@ namespace robot_dart {
                 /* Assume context is given externally, if not create it */
                 if (!Magnum::GL::Context::hasCurrent()) {
                     Corrade::Utility::Debug{} << "GL::Context not provided. Creating...";
-                    if (!tryCreateContext(Configuration())) {
+                    if (!tryCreateContext(GlobalData::instance()->context_configuration())) {
                         Corrade::Utility::Error{} << "Could not create context!";
                         return;
                     }
@@ -78,7 +78,8 @@ namespace robot_dart {
                     _framebuffer.clear(Magnum::GL::FramebufferClear::Color | Magnum::GL::FramebufferClear::Depth);
 
                     /* Draw with main camera */
-                    _camera->draw(_drawables, _framebuffer, _format, _simu, debug_draw_data(), _draw_debug);
+                    _camera->draw(draw_list(_draw_debug), _simu, debug_draw_data(), _draw_debug);
+                    _camera->read(_framebuffer, _format);
 
                     // if (_index % 10 == 0) {
                     //     intptr_t tt = (intptr_t)_glx_context;
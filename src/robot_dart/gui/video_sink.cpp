@@ -0,0 +1,510 @@
+#include "video_sink.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <boost/version.hpp>
+#if ((BOOST_VERSION / 100000) > 1) || ((BOOST_VERSION / 100000) == 1 && ((BOOST_VERSION / 100 % 1000) >= 64))
+#include <boost/process.hpp> // for launching ffmpeg
+#define ROBOT_DART_HAS_BOOST_PROCESS
+#endif
+
+#ifdef ROBOT_DART_HAS_LIBAV
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+#endif
+
+namespace robot_dart {
+    namespace gui {
+        namespace {
+            bool check_frame(const ImageView& frame, size_t width, size_t height)
+            {
+                ROBOT_DART_ASSERT(!frame.empty(), "VideoSink: Empty frame", false);
+                ROBOT_DART_ASSERT(frame.channels == 3, "VideoSink: Only RGB frames can be written", false);
+                ROBOT_DART_ASSERT(frame.width == width && frame.height == height, "VideoSink: The size of the frame is not the size of the video", false);
+                return true;
+            }
+        } // namespace
+
+        bool RawVideoSink::open(const std::string& filename, size_t width, size_t height, int)
+        {
+            close();
+            _file.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+            ROBOT_DART_ASSERT(_file.is_open(), "RawVideoSink: Cannot open " << filename, false);
+            _width = width;
+            _height = height;
+            return true;
+        }
+
+        bool RawVideoSink::write_frame(const ImageView& frame)
+        {
+            if (!_file.is_open() || !check_frame(frame, _width, _height))
+                return false;
+
+            // the rows are written from top to bottom, whatever the orientation of the view
+            for (size_t y = 0; y < _height; y++)
+                _file.write(reinterpret_cast<const char*>(frame.row(y)), _width * 3);
+            return static_cast<bool>(_file);
+        }
+
+        void RawVideoSink::close()
+        {
+            if (_file.is_open())
+                _file.close();
+        }
+
+        bool Y4MVideoSink::open(const std::string& filename, size_t width, size_t height, int fps)
+        {
+            close();
+            _file.open(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+            ROBOT_DART_ASSERT(_file.is_open(), "Y4MVideoSink: Cannot open " << filename, false);
+            _width = width;
+            _height = height;
+            _planes.resize(3 * width * height);
+
+            _file << "YUV4MPEG2 W" << width << " H" << height << " F" << fps << ":1 Ip A1:1 C444\n";
+            return static_cast<bool>(_file);
+        }
+
+        bool Y4MVideoSink::write_frame(const ImageView& frame)
+        {
+            if (!_file.is_open() || !check_frame(frame, _width, _height))
+                return false;
+
+            // BT.601, studio range (integer approximation)
+            size_t size = _width * _height;
+            uint8_t* Y = _planes.data();
+            uint8_t* U = Y + size;
+            uint8_t* V = U + size;
+            for (size_t y = 0; y < _height; y++) {
+                const uint8_t* rgb = frame.row(y);
+                for (size_t x = 0; x < _width; x++, rgb += 3) {
+                    int r = rgb[0], g = rgb[1], b = rgb[2];
+                    size_t i = y * _width + x;
+                    Y[i] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+                    U[i] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                    V[i] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+                }
+            }
+
+            _file << "FRAME\n";
+            _file.write(reinterpret_cast<const char*>(_planes.data()), _planes.size());
+            return static_cast<bool>(_file);
+        }
+
+        void Y4MVideoSink::close()
+        {
+            if (_file.is_open())
+                _file.close();
+        }
+
+        struct FFmpegVideoSink::Process {
+#ifdef ROBOT_DART_HAS_BOOST_PROCESS
+            boost::process::opstream pipe;
+            boost::process::child child;
+#else
+            pid_t pid = 0;
+            FILE* pipe = nullptr;
+#endif
+        };
+
+        FFmpegVideoSink::FFmpegVideoSink() {}
+
+        FFmpegVideoSink::~FFmpegVideoSink() { close(); }
+
+        bool FFmpegVideoSink::open(const std::string& filename, size_t width, size_t height, int fps)
+        {
+            close();
+            _width = width;
+            _height = height;
+
+            // we use boost process: https://www.boost.org/doc/libs/1_73_0/doc/html/boost_process/tutorial.html
+#ifdef ROBOT_DART_HAS_BOOST_PROCESS
+            namespace bp = boost::process;
+            // search for ffmpeg
+            boost::filesystem::path ffmpeg = bp::search_path("ffmpeg");
+            if (ffmpeg.empty()) {
+                ROBOT_DART_WARNING(ffmpeg.empty(), "ffmpeg not found in the PATH. RobotDART will not be able to record videos!");
+                return false;
+            }
+#endif
+            // list our options
+            std::vector<std::string> args = {"-y",
+                "-f", "rawvideo",
+                "-vcodec", "rawvideo",
+                "-s", std::to_string(width) + 'x' + std::to_string(height),
+                "-pix_fmt", "rgb24",
+                "-r", std::to_string(fps),
+                "-i", "-",
+                "-an",
+                "-vcodec", "mpeg4",
+                "-vb", "20M",
+                filename};
+
+            _process.reset(new Process);
+#ifdef ROBOT_DART_HAS_BOOST_PROCESS
+            // clang-format off
+            _process->child = bp::child(ffmpeg, bp::args(args), bp::std_in < _process->pipe, bp::std_out > "/dev/null", bp::std_err > "/dev/null");
+            // clang-format on
+#else
+            // we do it the old way
+            // this could should be removed in the future once boost.process is on every computer...
+            int fd[2];
+            if (pipe(fd) != 0) {
+                _process.reset();
+                return false;
+            }
+            //  Data written to fd[1] appears on (i.e., can be read from) fd[0].
+            _process->pid = fork();
+            if (_process->pid != 0) { // main process
+                ::close(fd[0]); // we close the input on this side
+                _process->pipe = fdopen(fd[1], "wb");
+            }
+            else { // ffmpeg process
+                args.push_back("-loglevel");
+                args.push_back("quiet");
+                ::close(fd[1]); // ffmpeg does not write here
+                dup2(fd[0], STDIN_FILENO); // ffmpeg will read the fd[0] as stdin
+                char** argv = (char**)calloc(args.size() + 2, sizeof(char*)); // we need the 0 at the end AND the ffffmpeg at the beginning
+                argv[0] = (char*)"ffmpeg";
+                for (size_t i = 0; i < args.size(); ++i)
+                    argv[i + 1] = (char*)args[i].c_str();
+                int ret = execvp("ffmpeg", argv);
+                if (ret == -1) {
+                    std::cerr << "Video recording: cannot execute ffmpeg! [" << strerror(errno) << "]" << std::endl;
+                    exit(0); // we are in the fork
+                }
+            }
+#endif
+            return true;
+        }
+
+        bool FFmpegVideoSink::write_frame(const ImageView& frame)
+        {
+            if (!_process || !check_frame(frame, _width, _height))
+                return false;
+
+            // the pipe is buffered: the rows are not written one by one
+            for (size_t y = 0; y < _height; y++) {
+#ifdef ROBOT_DART_HAS_BOOST_PROCESS
+                _process->pipe.write(reinterpret_cast<const char*>(frame.row(y)), _width * 3);
+#else
+                fwrite(frame.row(y), 1, _width * 3, _process->pipe);
+#endif
+            }
+#ifdef ROBOT_DART_HAS_BOOST_PROCESS
+            return static_cast<bool>(_process->pipe);
+#else
+            return !ferror(_process->pipe);
+#endif
+        }
+
+        void FFmpegVideoSink::close()
+        {
+            if (!_process)
+                return;
+
+            // ffmpeg finishes the video when its input is closed
+#ifdef ROBOT_DART_HAS_BOOST_PROCESS
+            if (_process->child.valid()) {
+                _process->pipe.flush();
+                _process->pipe.pipe().close();
+                _process->child.wait();
+            }
+#else
+            if (_process->pipe)
+                fclose(_process->pipe);
+            if (_process->pid > 0)
+                waitpid(_process->pid, nullptr, 0);
+#endif
+            _process.reset();
+        }
+
+#ifdef ROBOT_DART_HAS_LIBAV
+        struct LibavVideoSink::Encoder {
+            AVFormatContext* format = nullptr;
+            AVCodecContext* codec = nullptr;
+            AVStream* stream = nullptr;
+            AVFrame* frame = nullptr;
+            AVPacket* packet = nullptr;
+            SwsContext* sws = nullptr;
+            size_t width = 0, height = 0;
+            int64_t pts = 0;
+
+            ~Encoder()
+            {
+                sws_freeContext(sws);
+                av_packet_free(&packet);
+                av_frame_free(&frame);
+                avcodec_free_context(&codec);
+                if (format) {
+                    if (!(format->oformat->flags & AVFMT_NOFILE))
+                        avio_closep(&format->pb);
+                    avformat_free_context(format);
+                }
+            }
+
+            // sends a frame (nullptr to flush the encoder) and writes the packets that are ready
+            bool encode(AVFrame* f)
+            {
+                if (avcodec_send_frame(codec, f) < 0)
+                    return false;
+                while (true) {
+                    int ret = avcodec_receive_packet(codec, packet);
+                    if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF)
+                        return true;
+                    if (ret < 0)
+                        return false;
+                    av_packet_rescale_ts(packet, codec->time_base, stream->time_base);
+                    packet->stream_index = stream->index;
+                    if (av_interleaved_write_frame(format, packet) < 0)
+                        return false;
+                }
+            }
+        };
+
+        LibavVideoSink::LibavVideoSink() {}
+
+        LibavVideoSink::~LibavVideoSink() { close(); }
+
+        bool LibavVideoSink::available() { return true; }
+
+        bool LibavVideoSink::open(const std::string& filename, size_t width, size_t height, int fps)
+        {
+            close();
+            std::unique_ptr<Encoder> encoder(new Encoder);
+            encoder->width = width;
+            encoder->height = height;
+
+            avformat_alloc_output_context2(&encoder->format, nullptr, nullptr, filename.c_str());
+            ROBOT_DART_ASSERT(encoder->format, "LibavVideoSink: Unknown container for " << filename, false);
+
+            const AVCodec* codec = avcodec_find_encoder(encoder->format->oformat->video_codec);
+            if (!codec)
+                codec = avcodec_find_encoder(AV_CODEC_ID_MPEG4);
+            ROBOT_DART_ASSERT(codec, "LibavVideoSink: No video encoder for " << filename, false);
+
+            encoder->stream = avformat_new_stream(encoder->format, nullptr);
+            encoder->codec = avcodec_alloc_context3(codec);
+            ROBOT_DART_ASSERT(encoder->stream && encoder->codec, "LibavVideoSink: Cannot allocate the encoder", false);
+
+            // the chroma planes are subsampled: the size of the video has to be even
+            AVCodecContext* ctx = encoder->codec;
+            ctx->width = static_cast<int>(width & ~size_t(1));
+            ctx->height = static_cast<int>(height & ~size_t(1));
+            ctx->time_base = AVRational{1, fps};
+            ctx->framerate = AVRational{fps, 1};
+            ctx->pix_fmt = AV_PIX_FMT_YUV420P;
+            ctx->bit_rate = 20000000;
+            ctx->gop_size = 12;
+            if (encoder->format->oformat->flags & AVFMT_GLOBALHEADER)
+                ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+            ROBOT_DART_ASSERT(avcodec_open2(ctx, codec, nullptr) >= 0, "LibavVideoSink: Cannot open the encoder", false);
+            ROBOT_DART_ASSERT(avcodec_parameters_from_context(encoder->stream->codecpar, ctx) >= 0, "LibavVideoSink: Cannot set the stream parameters", false);
+            encoder->stream->time_base = ctx->time_base;
+
+            if (!(encoder->format->oformat->flags & AVFMT_NOFILE))
+                ROBOT_DART_ASSERT(avio_open(&encoder->format->pb, filename.c_str(), AVIO_FLAG_WRITE) >= 0, "LibavVideoSink: Cannot open " << filename, false);
+            ROBOT_DART_ASSERT(avformat_write_header(encoder->format, nullptr) >= 0, "LibavVideoSink: Cannot write the header of " << filename, false);
+
+            encoder->frame = av_frame_alloc();
+            encoder->packet = av_packet_alloc();
+            ROBOT_DART_ASSERT(encoder->frame && encoder->packet, "LibavVideoSink: Cannot allocate the frames", false);
+            encoder->frame->format = ctx->pix_fmt;
+            encoder->frame->width = ctx->width;
+            encoder->frame->height = ctx->height;
+            ROBOT_DART_ASSERT(av_frame_get_buffer(encoder->frame, 0) >= 0, "LibavVideoSink: Cannot allocate the frames", false);
+
+            // odd frames are cropped (last column/row), not rescaled: the conversion reads the even size from the frames
+            encoder->sws = sws_getContext(ctx->width, ctx->height, AV_PIX_FMT_RGB24, ctx->width, ctx->height, AV_PIX_FMT_YUV420P, SWS_BILINEAR, nullptr, nullptr, nullptr);
+            ROBOT_DART_ASSERT(encoder->sws, "LibavVideoSink: Cannot create the color conversion", false);
+
+            _encoder = std::move(encoder);
+            return true;
+        }
+
+        bool LibavVideoSink::write_frame(const ImageView& frame)
+        {
+            if (!_encoder || !check_frame(frame, _encoder->width, _encoder->height))
+                return false;
+
+            AVFrame* f = _encoder->frame;
+            if (av_frame_make_writable(f) < 0)
+                return false;
+
+            // swscale accepts negative strides: the bottom-up views are flipped by the conversion itself
+            const uint8_t* src[1] = {frame.data};
+            int src_stride[1] = {static_cast<int>(frame.row_stride)};
+            sws_scale(_encoder->sws, src, src_stride, 0, f->height, f->data, f->linesize);
+            f->pts = _encoder->pts++;
+
+            return _encoder->encode(f);
+        }
+
+        void LibavVideoSink::close()
+        {
+            if (!_encoder)
+                return;
+            _encoder->encode(nullptr);
+            av_write_trailer(_encoder->format);
+            _encoder.reset();
+        }
+#else
+        struct LibavVideoSink::Encoder {
+        };
+
+        LibavVideoSink::LibavVideoSink() {}
+
+        LibavVideoSink::~LibavVideoSink() {}
+
+        bool LibavVideoSink::available() { return false; }
+
+        bool LibavVideoSink::open(const std::string&, size_t, size_t, int)
+        {
+            ROBOT_DART_WARNING(true, "RobotDART was compiled without libav*: LibavVideoSink cannot record videos!");
+            return false;
+        }
+
+        bool LibavVideoSink::write_frame(const ImageView&) { return false; }
+
+        void LibavVideoSink::close() {}
+#endif
+
+        std::unique_ptr<VideoSink> make_video_sink(const std::string& filename)
+        {
+            std::string extension;
+            size_t dot = filename.find_last_of('.');
+            if (dot != std::string::npos)
+                extension = filename.substr(dot + 1);
+            std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+
+            if (extension == "y4m")
+                return std::unique_ptr<VideoSink>(new Y4MVideoSink);
+            if (extension == "rgb" || extension == "raw")
+                return std::unique_ptr<VideoSink>(new RawVideoSink);
+            if (LibavVideoSink::available())
+                return std::unique_ptr<VideoSink>(new LibavVideoSink);
+            return std::unique_ptr<VideoSink>(new FFmpegVideoSink);
+        }
+
+        VideoWriter::VideoWriter(std::unique_ptr<VideoSink> sink, VideoPolicy policy, size_t queue_size) : _sink(std::move(sink)), _policy(policy), _queue(std::max<size_t>(1, queue_size))
+        {
+            ROBOT_DART_EXCEPTION_ASSERT(_sink, "VideoWriter: The sink is null!");
+        }
+
+        VideoWriter::~VideoWriter()
+        {
+            close();
+        }
+
+        bool VideoWriter::open(const std::string& filename, size_t width, size_t height, int fps)
+        {
+            close();
+            if (!_sink->open(filename, width, height, fps))
+                return false;
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            _head = _count = 0;
+            _written = _dropped = 0;
+            _stop = _failed = false;
+            _thread = std::thread(&VideoWriter::_run, this);
+            return true;
+        }
+
+        bool VideoWriter::push(const ImageView& frame)
+        {
+            ImageView dropped; // released outside of the lock
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (!_thread.joinable() || _stop || _failed)
+                return false;
+
+            if (_count == _queue.size()) {
+                if (_policy == VideoPolicy::DropNewest) {
+                    _dropped++;
+                    return false;
+                }
+                else if (_policy == VideoPolicy::DropOldest) {
+                    dropped = std::move(_queue[_head]);
+                    _head = (_head + 1) % _queue.size();
+                    _count--;
+                    _dropped++;
+                }
+                else {
+                    _not_full.wait(lock, [this] { return _count < _queue.size() || _failed; });
+                    if (_failed)
+                        return false;
+                }
+            }
+
+            _queue[(_head + _count) % _queue.size()] = frame;
+            _count++;
+            lock.unlock();
+            _not_empty.notify_one();
+            return true;
+        }
+
+        void VideoWriter::close()
+        {
+            if (!_thread.joinable())
+                return;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stop = true;
+            }
+            _not_empty.notify_one();
+            _thread.join();
+            _sink->close();
+        }
+
+        size_t VideoWriter::frames_written() const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _written;
+        }
+
+        size_t VideoWriter::frames_dropped() const
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _dropped;
+        }
+
+        void VideoWriter::_run()
+        {
+            while (true) {
+                ImageView frame;
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _not_empty.wait(lock, [this] { return _count > 0 || _stop; });
+                    // the queued frames are written before stopping
+                    if (_count == 0)
+                        return;
+                    frame = std::move(_queue[_head]);
+                    _head = (_head + 1) % _queue.size();
+                    _count--;
+                }
+                _not_full.notify_one();
+
+                bool ok = _sink->write_frame(frame);
+
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (ok)
+                    _written++;
+                else if (!_failed) {
+                    // e.g. the encoder died: the next frames are refused instead of blocking the simulation
+                    _failed = true;
+                    _not_full.notify_all();
+                }
+            }
+        }
+    } // namespace gui
+} // namespace robot_dart
@@ -0,0 +1,148 @@
+#ifndef ROBOT_DART_GUI_VIDEO_SINK_HPP
+#define ROBOT_DART_GUI_VIDEO_SINK_HPP
+
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <robot_dart/gui/helper.hpp>
+
+namespace robot_dart {
+    namespace gui {
+        /// Destination of the frames of a video (RGB, 3 channels). The frames are given as views:
+        /// the sinks read the rows directly (whatever the orientation), the frames are never flipped into a temporary copy.
+        class VideoSink {
+        public:
+            virtual ~VideoSink() {}
+
+            virtual bool open(const std::string& filename, size_t width, size_t height, int fps) = 0;
+            virtual bool write_frame(const ImageView& frame) = 0;
+            virtual void close() = 0;
+        };
+
+        /// raw rgb24 frames, one after the other (e.g., `ffplay -f rawvideo -pixel_format rgb24 -video_size WxH file.rgb`)
+        class RawVideoSink : public VideoSink {
+        public:
+            ~RawVideoSink() { close(); }
+
+            bool open(const std::string& filename, size_t width, size_t height, int fps) override;
+            bool write_frame(const ImageView& frame) override;
+            void close() override;
+
+        protected:
+            std::ofstream _file;
+            size_t _width = 0, _height = 0;
+        };
+
+        /// YUV4MPEG2 stream (4:4:4, BT.601), readable by most players and encoders
+        class Y4MVideoSink : public VideoSink {
+        public:
+            ~Y4MVideoSink() { close(); }
+
+            bool open(const std::string& filename, size_t width, size_t height, int fps) override;
+            bool write_frame(const ImageView& frame) override;
+            void close() override;
+
+        protected:
+            std::ofstream _file;
+            size_t _width = 0, _height = 0;
+            // Y, U and V planes of one frame (allocated once)
+            std::vector<uint8_t> _planes;
+        };
+
+        /// frames piped to an external ffmpeg process (mpeg4 encoding)
+        class FFmpegVideoSink : public VideoSink {
+        public:
+            FFmpegVideoSink();
+            ~FFmpegVideoSink();
+
+            bool open(const std::string& filename, size_t width, size_t height, int fps) override;
+            bool write_frame(const ImageView& frame) override;
+            void close() override;
+
+        protected:
+            struct Process;
+            std::unique_ptr<Process> _process;
+            size_t _width = 0, _height = 0;
+        };
+
+        /// in-process encoding with the libav* libraries (libavformat, libavcodec, libswscale);
+        /// the codec is the default one of the container (from the extension of the file)
+        class LibavVideoSink : public VideoSink {
+        public:
+            LibavVideoSink();
+            ~LibavVideoSink();
+
+            /// false when RobotDART was compiled without the libav* libraries
+            static bool available();
+
+            bool open(const std::string& filename, size_t width, size_t height, int fps) override;
+            bool write_frame(const ImageView& frame) override;
+            void close() override;
+
+        protected:
+            struct Encoder;
+            std::unique_ptr<Encoder> _encoder;
+        };
+
+        /// .y4m: Y4MVideoSink, .rgb/.raw: RawVideoSink, otherwise LibavVideoSink if available and FFmpegVideoSink if not
+        std::unique_ptr<VideoSink> make_video_sink(const std::string& filename);
+
+        /// What VideoWriter::push() does when the queue is full:
+        /// - Block: waits for the writer thread (no frame is lost, the simulation slows down to the speed of the encoder)
+        /// - DropNewest: the new frame is dropped
+        /// - DropOldest: the oldest queued frame is dropped to make room for the new one
+        enum class VideoPolicy {
+            Block,
+            DropNewest,
+            DropOldest
+        };
+
+        /// Writes the frames to a sink in a background thread. The queue is bounded and only holds views:
+        /// the frames are not copied, the views keep the images alive until they are written.
+        class VideoWriter {
+        public:
+            VideoWriter(std::unique_ptr<VideoSink> sink, VideoPolicy policy = VideoPolicy::Block, size_t queue_size = 8);
+            ~VideoWriter();
+
+            VideoWriter(const VideoWriter&) = delete;
+            void operator=(const VideoWriter&) = delete;
+
+            /// opens the sink (in the calling thread) and starts the writer thread
+            bool open(const std::string& filename, size_t width, size_t height, int fps);
+            /// false if the frame was dropped (or if the writer is not open)
+            bool push(const ImageView& frame);
+            /// writes the queued frames and closes the sink
+            void close();
+
+            bool is_open() const { return _thread.joinable(); }
+            VideoPolicy policy() const { return _policy; }
+            size_t queue_size() const { return _queue.size(); }
+
+            size_t frames_written() const;
+            size_t frames_dropped() const;
+
+        protected:
+            std::unique_ptr<VideoSink> _sink;
+            VideoPolicy _policy;
+
+            // ring of views
+            std::vector<ImageView> _queue;
+            size_t _head = 0, _count = 0;
+            size_t _written = 0, _dropped = 0;
+            bool _stop = false, _failed = false;
+
+            mutable std::mutex _mutex;
+            std::condition_variable _not_empty, _not_full;
+            std::thread _thread;
+
+            void _run();
+        };
+    } // namespace gui
+} // namespace robot_dart
+
+#endif
@@ -19,6 +19,8 @@ namespace robot_dart {
             std::unordered_map<dart::dynamics::ShapeNode*, RobotData> robot_data;
             std::unordered_map<Robot*, std::vector<std::pair<dart::dynamics::BodyNode*, double>>> robot_axes;
             std::vector<std::shared_ptr<simu::TextData>> text_drawings;
+            // incremented when the data of a shape changes (the renderers rebuild their lists of drawables)
+            size_t data_version = 0;
 
         public:
             std::shared_ptr<simu::TextData> add_text(const std::string& text, const Eigen::Affine2d& tf = Eigen::Affine2d::Identity(), Eigen::Vector4d color = Eigen::Vector4d(1, 1, 1, 1), std::uint8_t alignment = (1 | 3 << 3), bool draw_bg = false, Eigen::Vector4d bg_color = Eigen::Vector4d(0, 0, 0, 0.75), double font_size = 28)
@@ -56,7 +58,11 @@ namespace robot_dart {
                     auto bd = skel->getBodyNode(i);
                     auto& shapes = bd->getShapeNodesWith<dart::dynamics::VisualAspect>();
                     for (size_t j = 0; j < shapes.size(); j++) {
-                        robot_data[shapes[j]] = {cast, ghost};
+                        auto iter = robot_data.find(shapes[j]);
+                        if (iter == robot_data.end() || iter->second.casting_shadows != cast || iter->second.is_ghost != ghost) {
+                            robot_data[shapes[j]] = {cast, ghost};
+                            data_version++;
+                        }
                     }
                 }
 
@@ -72,8 +78,10 @@ namespace robot_dart {
                 for (size_t i = 0; i < skel->getNumShapeNodes(); ++i) {
                     auto shape = skel->getShapeNode(i);
                     auto shape_iter = robot_data.find(shape);
-                    if (shape_iter != robot_data.end())
+                    if (shape_iter != robot_data.end()) {
                         robot_data.erase(shape_iter);
+                        data_version++;
+                    }
                 }
 
                 auto iter = robot_axes.find(robot_ptr);
@@ -81,6 +89,8 @@ namespace robot_dart {
                     robot_axes.erase(iter);
             }
 
+            size_t version() const { return data_version; }
+
             bool cast_shadows(dart::dynamics::ShapeNode* shape) const
             {
                 auto shape_iter = robot_data.find(shape);
@@ -0,0 +1,160 @@
+#include <robot_dart/model_cache.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+
+namespace robot_dart {
+    ModelCache& ModelCache::instance()
+    {
+        static ModelCache cache;
+        return cache;
+    }
+
+    bool ModelCache::enabled() const
+    {
+#if DART_VERSION_AT_LEAST(6, 13, 0)
+        return _enabled;
+#else
+        return false;
+#endif
+    }
+
+    dart::dynamics::SkeletonPtr ModelCache::get(const std::string& model_file, const packages_t& packages, const std::string& variant)
+    {
+        if (!enabled())
+            return nullptr;
+
+        std::string key = _key(model_file, packages, variant);
+        std::time_t mtime = _mtime(model_file);
+
+        dart::dynamics::SkeletonPtr prototype;
+        std::shared_ptr<const mtimes_t> meshes;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = _entries.find(key);
+            if (it != _entries.end()) {
+                if (it->second.mtime == mtime) {
+                    prototype = it->second.prototype;
+                    meshes = it->second.meshes;
+                }
+                else // the file has changed
+                    _entries.erase(it);
+            }
+        }
+
+        // the meshes are checked outside of the lock (one stat per mesh file)
+        if (prototype && _meshes_changed(*meshes)) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = _entries.find(key);
+            if (it != _entries.end() && it->second.prototype == prototype)
+                _entries.erase(it);
+            prototype = nullptr;
+        }
+
+        if (!prototype) {
+            _misses++;
+            return nullptr;
+        }
+
+        _hits++;
+        // the copy is done outside of the cache lock so that different threads can build robots concurrently
+        return clone_skeleton(prototype);
+    }
+
+    void ModelCache::add(const std::string& model_file, const packages_t& packages, const dart::dynamics::SkeletonPtr& skeleton, const std::string& variant)
+    {
+        if (!enabled() || !skeleton)
+            return;
+
+        Entry entry;
+        entry.prototype = clone_skeleton(skeleton);
+        entry.mtime = _mtime(model_file);
+        entry.meshes = _mesh_mtimes(entry.prototype);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        // if two threads parsed the same model, the first one wins
+        _entries.insert(std::make_pair(_key(model_file, packages, variant), entry));
+    }
+
+    void ModelCache::clear()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _entries.clear();
+    }
+
+    size_t ModelCache::size() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _entries.size();
+    }
+
+    dart::dynamics::SkeletonPtr ModelCache::clone_skeleton(const dart::dynamics::SkeletonPtr& skeleton)
+    {
+        dart::dynamics::SkeletonPtr tmp_skel;
+        {
+            // safely clone the skeleton
+            std::lock_guard<std::mutex> lock(skeleton->getMutex());
+#if DART_VERSION_AT_LEAST(6, 7, 2)
+            tmp_skel = skeleton->cloneSkeleton();
+#else
+            tmp_skel = skeleton->clone();
+#endif
+        }
+
+#if DART_VERSION_AT_LEAST(6, 13, 0)
+        // Deep copy everything
+        for (auto& bd : tmp_skel->getBodyNodes()) {
+            auto& visual_shapes = bd->getShapeNodesWith<dart::dynamics::VisualAspect>();
+            for (auto& shape : visual_shapes) {
+                if (shape->getShape()->getType() != dart::dynamics::SoftMeshShape::getStaticType())
+                    shape->setShape(shape->getShape()->clone());
+            }
+        }
+#endif
+        return tmp_skel;
+    }
+
+    std::string ModelCache::_key(const std::string& model_file, const packages_t& packages, const std::string& variant)
+    {
+        std::string key = model_file;
+        for (auto& p : packages)
+            key += '\n' + p.first + '=' + p.second;
+        if (!variant.empty())
+            key += "\n#" + variant;
+        return key;
+    }
+
+    std::time_t ModelCache::_mtime(const std::string& model_file)
+    {
+        boost::system::error_code ec;
+        std::time_t mtime = boost::filesystem::last_write_time(model_file, ec);
+        return ec ? 0 : mtime;
+    }
+
+    std::shared_ptr<const ModelCache::mtimes_t> ModelCache::_mesh_mtimes(const dart::dynamics::SkeletonPtr& skeleton)
+    {
+        auto meshes = std::make_shared<mtimes_t>();
+        for (auto& bd : skeleton->getBodyNodes()) {
+            for (size_t i = 0; i < bd->getNumShapeNodes(); i++) {
+                auto shape = bd->getShapeNode(i)->getShape();
+                if (!shape || shape->getType() != dart::dynamics::MeshShape::getStaticType())
+                    continue;
+                // meshes that are not local files (e.g., retrieved from other URIs) are not checked
+                const std::string& path = static_cast<const dart::dynamics::MeshShape*>(shape.get())->getMeshPath();
+                if (path.empty() || std::find_if(meshes->begin(), meshes->end(), [&](const std::pair<std::string, std::time_t>& m) { return m.first == path; }) != meshes->end())
+                    continue;
+                meshes->push_back({path, _mtime(path)});
+            }
+        }
+        return meshes;
+    }
+
+    bool ModelCache::_meshes_changed(const mtimes_t& meshes)
+    {
+        for (auto& m : meshes)
+            if (_mtime(m.first) != m.second)
+                return true;
+        return false;
+    }
+} // namespace robot_dart
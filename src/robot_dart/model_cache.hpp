@@ -0,0 +1,75 @@
+#ifndef ROBOT_DART_MODEL_CACHE_HPP
+#define ROBOT_DART_MODEL_CACHE_HPP
+
+#include <atomic>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <robot_dart/utils.hpp>
+#include <robot_dart/utils_headers_dart_dynamics.hpp>
+
+namespace robot_dart {
+    /// Process-wide cache of the skeletons loaded from model files (URDF/SDF/SKEL).
+    /// Models are keyed by their resolved path and package directories; once a model
+    /// has been parsed, the next robots built from the same file get a copy of a cached
+    /// prototype skeleton instead of parsing the file (and its meshes) again.
+    /// An entry is dropped when the modification time of the model file or of one of
+    /// its (local) mesh files changes.
+    /// The cache is only used with DART >= 6.13 (older versions share the meshes between copies).
+    class ModelCache {
+    public:
+        using packages_t = std::vector<std::pair<std::string, std::string>>;
+
+        static ModelCache& instance();
+
+        ModelCache(const ModelCache&) = delete;
+        void operator=(const ModelCache&) = delete;
+
+        void set_enabled(bool enable) { _enabled = enable; }
+        bool enabled() const;
+
+        /// copy of the cached skeleton or nullptr if the model is not in the cache
+        /// (`variant` distinguishes models that depend on more than the file, e.g. the robot name for .skel worlds)
+        dart::dynamics::SkeletonPtr get(const std::string& model_file, const packages_t& packages, const std::string& variant = "");
+        /// stores a copy of `skeleton` (so that it can be modified afterwards)
+        void add(const std::string& model_file, const packages_t& packages, const dart::dynamics::SkeletonPtr& skeleton, const std::string& variant = "");
+
+        void clear();
+        size_t size() const;
+
+        size_t hits() const { return _hits.load(); }
+        size_t misses() const { return _misses.load(); }
+
+        /// deep copy of a skeleton (visual shapes included)
+        static dart::dynamics::SkeletonPtr clone_skeleton(const dart::dynamics::SkeletonPtr& skeleton);
+
+    protected:
+        using mtimes_t = std::vector<std::pair<std::string, std::time_t>>;
+
+        struct Entry {
+            dart::dynamics::SkeletonPtr prototype;
+            std::time_t mtime;
+            // mesh files of the model (shared so that they are checked outside of the cache lock)
+            std::shared_ptr<const mtimes_t> meshes;
+        };
+
+        ModelCache() {}
+
+        static std::string _key(const std::string& model_file, const packages_t& packages, const std::string& variant);
+        static std::time_t _mtime(const std::string& model_file);
+        static std::shared_ptr<const mtimes_t> _mesh_mtimes(const dart::dynamics::SkeletonPtr& skeleton);
+        static bool _meshes_changed(const mtimes_t& meshes);
+
+        std::atomic<bool> _enabled{true};
+        std::atomic<size_t> _hits{0}, _misses{0};
+        mutable std::mutex _mutex;
+        std::unordered_map<std::string, Entry> _entries;
+    };
+} // namespace robot_dart
+
+#endif
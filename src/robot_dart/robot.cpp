@@ -3,7 +3,9 @@
 #include <boost/filesystem.hpp>
 #include <unistd.h>
 
+#include <robot_dart/model_cache.hpp>
 #include <robot_dart/robot.hpp>
+#include <robot_dart/robot_dart_simu.hpp>
 #include <robot_dart/utils.hpp>
 #include <robot_dart/utils_headers_dart_dynamics.hpp>
 #include <robot_dart/utils_headers_dart_io.hpp>
@@ -13,166 +15,269 @@
 namespace robot_dart {
     namespace detail {
         template <int content>
-        Eigen::VectorXd dof_data(dart::dynamics::SkeletonPtr skeleton, const std::vector<std::string>& dof_names, const std::unordered_map<std::string, size_t>& dof_map)
+        Eigen::VectorXd all_dof_data(const dart::dynamics::SkeletonPtr& skeleton)
         {
-            // Return all values
-            if (dof_names.empty()) {
-                if (content == 0)
-                    return skeleton->getPositions();
-                else if (content == 1)
-                    return skeleton->getVelocities();
-                else if (content == 2)
-                    return skeleton->getAccelerations();
-                else if (content == 3)
-                    return skeleton->getForces();
-                else if (content == 4)
-                    return skeleton->getCommands();
-                else if (content == 5)
-                    return skeleton->getPositionLowerLimits();
-                else if (content == 6)
-                    return skeleton->getPositionUpperLimits();
-                else if (content == 7)
-                    return skeleton->getVelocityLowerLimits();
-                else if (content == 8)
-                    return skeleton->getVelocityUpperLimits();
-                else if (content == 9)
-                    return skeleton->getAccelerationLowerLimits();
-                else if (content == 10)
-                    return skeleton->getAccelerationUpperLimits();
-                else if (content == 11)
-                    return skeleton->getForceLowerLimits();
-                else if (content == 12)
-                    return skeleton->getForceUpperLimits();
-                else if (content == 13)
-                    return skeleton->getCoriolisForces();
-                else if (content == 14)
-                    return skeleton->getGravityForces();
-                else if (content == 15)
-                    return skeleton->getCoriolisAndGravityForces();
-                else if (content == 16)
-                    return skeleton->getConstraintForces();
-                ROBOT_DART_EXCEPTION_ASSERT(false, "Unknown type of data!");
-            }
+            if (content == 0)
+                return skeleton->getPositions();
+            else if (content == 1)
+                return skeleton->getVelocities();
+            else if (content == 2)
+                return skeleton->getAccelerations();
+            else if (content == 3)
+                return skeleton->getForces();
+            else if (content == 4)
+                return skeleton->getCommands();
+            else if (content == 5)
+                return skeleton->getPositionLowerLimits();
+            else if (content == 6)
+                return skeleton->getPositionUpperLimits();
+            else if (content == 7)
+                return skeleton->getVelocityLowerLimits();
+            else if (content == 8)
+                return skeleton->getVelocityUpperLimits();
+            else if (content == 9)
+                return skeleton->getAccelerationLowerLimits();
+            else if (content == 10)
+                return skeleton->getAccelerationUpperLimits();
+            else if (content == 11)
+                return skeleton->getForceLowerLimits();
+            else if (content == 12)
+                return skeleton->getForceUpperLimits();
+            else if (content == 13)
+                return skeleton->getCoriolisForces();
+            else if (content == 14)
+                return skeleton->getGravityForces();
+            else if (content == 15)
+                return skeleton->getCoriolisAndGravityForces();
+            else if (content == 16)
+                return skeleton->getConstraintForces();
+            ROBOT_DART_EXCEPTION_ASSERT(false, "Unknown type of data!");
+            return Eigen::VectorXd();
+        }
 
-            Eigen::VectorXd data(dof_names.size());
-            Eigen::VectorXd tmp;
+        template <int content>
+        void set_all_dof_data(const Eigen::VectorXd& data, const dart::dynamics::SkeletonPtr& skeleton)
+        {
+            if (content == 0)
+                return skeleton->setPositions(data);
+            else if (content == 1)
+                return skeleton->setVelocities(data);
+            else if (content == 2)
+                return skeleton->setAccelerations(data);
+            else if (content == 3)
+                return skeleton->setForces(data);
+            else if (content == 4)
+                return skeleton->setCommands(data);
+            else if (content == 5)
+                return skeleton->setPositionLowerLimits(data);
+            else if (content == 6)
+                return skeleton->setPositionUpperLimits(data);
+            else if (content == 7)
+                return skeleton->setVelocityLowerLimits(data);
+            else if (content == 8)
+                return skeleton->setVelocityUpperLimits(data);
+            else if (content == 9)
+                return skeleton->setAccelerationLowerLimits(data);
+            else if (content == 10)
+                return skeleton->setAccelerationUpperLimits(data);
+            else if (content == 11)
+                return skeleton->setForceLowerLimits(data);
+            else if (content == 12)
+                return skeleton->setForceUpperLimits(data);
+            ROBOT_DART_EXCEPTION_ASSERT(false, "Unknown type of data!");
+        }
+
+        // value of one DoF (only for the per-DoF data, i.e. content < 13)
+        template <int content>
+        double single_dof_data(const dart::dynamics::DegreeOfFreedom* dof)
+        {
+            if (content == 0)
+                return dof->getPosition();
+            else if (content == 1)
+                return dof->getVelocity();
+            else if (content == 2)
+                return dof->getAcceleration();
+            else if (content == 3)
+                return dof->getForce();
+            else if (content == 4)
+                return dof->getCommand();
+            else if (content == 5)
+                return dof->getPositionLowerLimit();
+            else if (content == 6)
+                return dof->getPositionUpperLimit();
+            else if (content == 7)
+                return dof->getVelocityLowerLimit();
+            else if (content == 8)
+                return dof->getVelocityUpperLimit();
+            else if (content == 9)
+                return dof->getAccelerationLowerLimit();
+            else if (content == 10)
+                return dof->getAccelerationUpperLimit();
+            else if (content == 11)
+                return dof->getForceLowerLimit();
+            else if (content == 12)
+                return dof->getForceUpperLimit();
+            ROBOT_DART_EXCEPTION_ASSERT(false, "Unknown type of data!");
+            return 0.;
+        }
+
+        template <int content>
+        void set_single_dof_data(double value, dart::dynamics::DegreeOfFreedom* dof)
+        {
+            if (content == 0)
+                dof->setPosition(value);
+            else if (content == 1)
+                dof->setVelocity(value);
+            else if (content == 2)
+                dof->setAcceleration(value);
+            else if (content == 3)
+                dof->setForce(value);
+            else if (content == 4)
+                dof->setCommand(value);
+            else if (content == 5)
+                dof->setPositionLowerLimit(value);
+            else if (content == 6)
+                dof->setPositionUpperLimit(value);
+            else if (content == 7)
+                dof->setVelocityLowerLimit(value);
+            else if (content == 8)
+                dof->setVelocityUpperLimit(value);
+            else if (content == 9)
+                dof->setAccelerationLowerLimit(value);
+            else if (content == 10)
+                dof->setAccelerationUpperLimit(value);
+            else if (content == 11)
+                dof->setForceLowerLimit(value);
+            else if (content == 12)
+                dof->setForceUpperLimit(value);
+            else
+                ROBOT_DART_EXCEPTION_ASSERT(false, "Unknown type of data!");
+        }
 
+        // the data that DART computes for the whole skeleton (content >= 13)
+        template <int content>
+        const Eigen::VectorXd& skeleton_dof_data(const dart::dynamics::SkeletonPtr& skeleton)
+        {
             if (content == 13)
-                tmp = skeleton->getCoriolisForces();
+                return skeleton->getCoriolisForces();
             else if (content == 14)
-                tmp = skeleton->getGravityForces();
+                return skeleton->getGravityForces();
             else if (content == 15)
-                tmp = skeleton->getCoriolisAndGravityForces();
-            else if (content == 16)
-                tmp = skeleton->getConstraintForces();
+                return skeleton->getCoriolisAndGravityForces();
+            ROBOT_DART_EXCEPTION_ASSERT(content == 16, "Unknown type of data!");
+            return skeleton->getConstraintForces();
+        }
+
+        template <int content>
+        Eigen::VectorXd dof_data(dart::dynamics::SkeletonPtr skeleton, const std::vector<std::string>& dof_names, const std::unordered_map<std::string, size_t>& dof_map)
+        {
+            // Return all values
+            if (dof_names.empty())
+                return all_dof_data<content>(skeleton);
 
+            Eigen::VectorXd data(dof_names.size());
             for (size_t i = 0; i < dof_names.size(); i++) {
                 auto it = dof_map.find(dof_names[i]);
                 ROBOT_DART_ASSERT(it != dof_map.end(), "dof_data: " + dof_names[i] + " is not in dof_map", Eigen::VectorXd());
-                auto dof = skeleton->getDof(it->second);
-                if (content == 0)
-                    data(i) = dof->getPosition();
-                else if (content == 1)
-                    data(i) = dof->getVelocity();
-                else if (content == 2)
-                    data(i) = dof->getAcceleration();
-                else if (content == 3)
-                    data(i) = dof->getForce();
-                else if (content == 4)
-                    data(i) = dof->getCommand();
-                else if (content == 5)
-                    data(i) = dof->getPositionLowerLimit();
-                else if (content == 6)
-                    data(i) = dof->getPositionUpperLimit();
-                else if (content == 7)
-                    data(i) = dof->getVelocityLowerLimit();
-                else if (content == 8)
-                    data(i) = dof->getVelocityUpperLimit();
-                else if (content == 9)
-                    data(i) = dof->getAccelerationLowerLimit();
-                else if (content == 10)
-                    data(i) = dof->getAccelerationUpperLimit();
-                else if (content == 11)
-                    data(i) = dof->getForceLowerLimit();
-                else if (content == 12)
-                    data(i) = dof->getForceUpperLimit();
-                else if (content == 13 || content == 14 || content == 15 || content == 16)
-                    data(i) = tmp(it->second);
+                if (content >= 13)
+                    data(i) = skeleton_dof_data<content>(skeleton)(it->second);
                 else
-                    ROBOT_DART_EXCEPTION_ASSERT(false, "Unknown type of data!");
+                    data(i) = single_dof_data<content>(skeleton->getDof(it->second));
+            }
+            return data;
+        }
+
+        template <int content>
+        Eigen::VectorXd dof_data(dart::dynamics::SkeletonPtr skeleton, const DofSelection& dofs, const std::unordered_map<std::string, size_t>& dof_map)
+        {
+            if (dofs.all())
+                return all_dof_data<content>(skeleton);
+            if (!dofs.valid(skeleton.get()))
+                return dof_data<content>(skeleton, dofs.names(), dof_map);
+
+            const std::vector<size_t>& indices = dofs.indices();
+            Eigen::VectorXd data(indices.size());
+            if (content >= 13) {
+                const Eigen::VectorXd& tmp = skeleton_dof_data<content>(skeleton);
+                for (size_t i = 0; i < indices.size(); i++)
+                    data(i) = tmp(indices[i]);
+            }
+            else {
+                for (size_t i = 0; i < indices.size(); i++)
+                    data(i) = single_dof_data<content>(skeleton->getDof(indices[i]));
             }
             return data;
         }
 
+        // number of DoFs of a selection
+        inline size_t selection_size(const DofSelection& dofs, bool valid, const dart::dynamics::SkeletonPtr& skeleton)
+        {
+            if (dofs.all())
+                return skeleton->getNumDofs();
+            return valid ? dofs.indices().size() : dofs.names().size();
+        }
+
+        // index in the skeleton of the i-th DoF of a selection (the names are used if the selection is outdated)
+        inline size_t selected_dof_index(const DofSelection& dofs, bool valid, size_t i, const std::unordered_map<std::string, size_t>& dof_map)
+        {
+            if (dofs.all())
+                return i;
+            if (valid)
+                return dofs.indices()[i];
+            auto it = dof_map.find(dofs.names()[i]);
+            ROBOT_DART_EXCEPTION_ASSERT(it != dof_map.end(), "dof_data: " + dofs.names()[i] + " is not in dof_map");
+            return it->second;
+        }
+
+        template <int content>
+        void dof_data(Eigen::Ref<Eigen::VectorXd> out, dart::dynamics::SkeletonPtr skeleton, const DofSelection& dofs, const std::unordered_map<std::string, size_t>& dof_map)
+        {
+            bool valid = dofs.valid(skeleton.get());
+            size_t n = selection_size(dofs, valid, skeleton);
+            ROBOT_DART_ASSERT(static_cast<size_t>(out.size()) == n, "dof_data: size of the output is not the same as the DoF selection size", );
+
+            // the data that DART computes for the whole skeleton is returned by reference: no copy
+            const Eigen::VectorXd* full_data = (content >= 13) ? &skeleton_dof_data<content>(skeleton) : nullptr;
+            for (size_t i = 0; i < n; i++) {
+                size_t index = selected_dof_index(dofs, valid, i, dof_map);
+                if (full_data)
+                    out(i) = (*full_data)(index);
+                else
+                    out(i) = single_dof_data<content>(skeleton->getDof(index));
+            }
+        }
+
         template <int content>
         void set_dof_data(const Eigen::VectorXd& data, dart::dynamics::SkeletonPtr skeleton, const std::vector<std::string>& dof_names, const std::unordered_map<std::string, size_t>& dof_map)
         {
             // Set all values
             if (dof_names.empty()) {
                 ROBOT_DART_ASSERT(static_cast<size_t>(data.size()) == skeleton->getNumDofs(), "set_dof_data: size of data is not the same as the DoFs", );
-                if (content == 0)
-                    return skeleton->setPositions(data);
-                else if (content == 1)
-                    return skeleton->setVelocities(data);
-                else if (content == 2)
-                    return skeleton->setAccelerations(data);
-                else if (content == 3)
-                    return skeleton->setForces(data);
-                else if (content == 4)
-                    return skeleton->setCommands(data);
-                else if (content == 5)
-                    return skeleton->setPositionLowerLimits(data);
-                else if (content == 6)
-                    return skeleton->setPositionUpperLimits(data);
-                else if (content == 7)
-                    return skeleton->setVelocityLowerLimits(data);
-                else if (content == 8)
-                    return skeleton->setVelocityUpperLimits(data);
-                else if (content == 9)
-                    return skeleton->setAccelerationLowerLimits(data);
-                else if (content == 10)
-                    return skeleton->setAccelerationUpperLimits(data);
-                else if (content == 11)
-                    return skeleton->setForceLowerLimits(data);
-                else if (content == 12)
-                    return skeleton->setForceUpperLimits(data);
-                ROBOT_DART_EXCEPTION_ASSERT(false, "Unknown type of data!");
+                return set_all_dof_data<content>(data, skeleton);
             }
 
             ROBOT_DART_ASSERT(static_cast<size_t>(data.size()) == dof_names.size(), "set_dof_data: size of data is not the same as the dof_names size", );
             for (size_t i = 0; i < dof_names.size(); i++) {
                 auto it = dof_map.find(dof_names[i]);
                 ROBOT_DART_ASSERT(it != dof_map.end(), "dof_data: " + dof_names[i] + " is not in dof_map", );
-                auto dof = skeleton->getDof(it->second);
-                if (content == 0)
-                    dof->setPosition(data(i));
-                else if (content == 1)
-                    dof->setVelocity(data(i));
-                else if (content == 2)
-                    dof->setAcceleration(data(i));
-                else if (content == 3)
-                    dof->setForce(data(i));
-                else if (content == 4)
-                    dof->setCommand(data(i));
-                else if (content == 5)
-                    dof->setPositionLowerLimit(data(i));
-                else if (content == 6)
-                    dof->setPositionUpperLimit(data(i));
-                else if (content == 7)
-                    dof->setVelocityLowerLimit(data(i));
-                else if (content == 8)
-                    dof->setVelocityUpperLimit(data(i));
-                else if (content == 9)
-                    dof->setAccelerationLowerLimit(data(i));
-                else if (content == 10)
-                    dof->setAccelerationUpperLimit(data(i));
-                else if (content == 11)
-                    dof->setForceLowerLimit(data(i));
-                else if (content == 12)
-                    dof->setForceUpperLimit(data(i));
-                else
-                    ROBOT_DART_EXCEPTION_ASSERT(false, "Unknown type of data!");
+                set_single_dof_data<content>(data(i), skeleton->getDof(it->second));
+            }
+        }
+
+        template <int content>
+        void set_dof_data(const Eigen::VectorXd& data, dart::dynamics::SkeletonPtr skeleton, const DofSelection& dofs, const std::unordered_map<std::string, size_t>& dof_map)
+        {
+            if (dofs.all()) {
+                ROBOT_DART_ASSERT(static_cast<size_t>(data.size()) == skeleton->getNumDofs(), "set_dof_data: size of data is not the same as the DoFs", );
+                return set_all_dof_data<content>(data, skeleton);
             }
+            if (!dofs.valid(skeleton.get()))
+                return set_dof_data<content>(data, skeleton, dofs.names(), dof_map);
+
+            const std::vector<size_t>& indices = dofs.indices();
+            ROBOT_DART_ASSERT(static_cast<size_t>(data.size()) == indices.size(), "set_dof_data: size of data is not the same as the DoF selection size", );
+            for (size_t i = 0; i < indices.size(); i++)
+                set_single_dof_data<content>(data(i), skeleton->getDof(indices[i]));
         }
 
         template <int content>
@@ -181,33 +286,7 @@ namespace robot_dart {
             // Set all values
             if (dof_names.empty()) {
                 ROBOT_DART_ASSERT(static_cast<size_t>(data.size()) == skeleton->getNumDofs(), "set_dof_data: size of data is not the same as the DoFs", );
-                if (content == 0)
-                    return skeleton->setPositions(skeleton->getPositions() + data);
-                else if (content == 1)
-                    return skeleton->setVelocities(skeleton->getVelocities() + data);
-                else if (content == 2)
-                    return skeleton->setAccelerations(skeleton->getAccelerations() + data);
-                else if (content == 3)
-                    return skeleton->setForces(skeleton->getForces() + data);
-                else if (content == 4)
-                    return skeleton->setCommands(skeleton->getCommands() + data);
-                else if (content == 5)
-                    return skeleton->setPositionLowerLimits(skeleton->getPositionLowerLimits() + data);
-                else if (content == 6)
-                    return skeleton->setPositionUpperLimits(skeleton->getPositionUpperLimits() + data);
-                else if (content == 7)
-                    return skeleton->setVelocityLowerLimits(skeleton->getVelocityLowerLimits() + data);
-                else if (content == 8)
-                    return skeleton->setVelocityUpperLimits(skeleton->getVelocityUpperLimits() + data);
-                else if (content == 9)
-                    return skeleton->setAccelerationLowerLimits(skeleton->getAccelerationLowerLimits() + data);
-                else if (content == 10)
-                    return skeleton->setAccelerationUpperLimits(skeleton->getAccelerationUpperLimits() + data);
-                else if (content == 11)
-                    return skeleton->setForceLowerLimits(skeleton->getForceLowerLimits() + data);
-                else if (content == 12)
-                    return skeleton->setForceUpperLimits(skeleton->getForceUpperLimits() + data);
-                ROBOT_DART_EXCEPTION_ASSERT(false, "Unknown type of data!");
+                return set_all_dof_data<content>(all_dof_data<content>(skeleton) + data, skeleton);
             }
 
             ROBOT_DART_ASSERT(static_cast<size_t>(data.size()) == dof_names.size(), "add_dof_data: size of data is not the same as the dof_names size", );
@@ -215,38 +294,34 @@ namespace robot_dart {
                 auto it = dof_map.find(dof_names[i]);
                 ROBOT_DART_ASSERT(it != dof_map.end(), "dof_data: " + dof_names[i] + " is not in dof_map", );
                 auto dof = skeleton->getDof(it->second);
-                if (content == 0)
-                    dof->setPosition(dof->getPosition() + data(i));
-                else if (content == 1)
-                    dof->setVelocity(dof->getVelocity() + data(i));
-                else if (content == 2)
-                    dof->setAcceleration(dof->getAcceleration() + data(i));
-                else if (content == 3)
-                    dof->setForce(dof->getForce() + data(i));
-                else if (content == 4)
-                    dof->setCommand(dof->getCommand() + data(i));
-                else if (content == 5)
-                    dof->setPositionLowerLimit(dof->getPositionLowerLimit() + data(i));
-                else if (content == 6)
-                    dof->setPositionUpperLimit(dof->getPositionUpperLimit() + data(i));
-                else if (content == 7)
-                    dof->setVelocityLowerLimit(dof->getVelocityLowerLimit() + data(i));
-                else if (content == 8)
-                    dof->setVelocityUpperLimit(dof->getVelocityUpperLimit() + data(i));
-                else if (content == 9)
-                    dof->setAccelerationLowerLimit(dof->getAccelerationLowerLimit() + data(i));
-                else if (content == 10)
-                    dof->setAccelerationUpperLimit(dof->getAccelerationUpperLimit() + data(i));
-                else if (content == 11)
-                    dof->setForceLowerLimit(dof->getForceLowerLimit() + data(i));
-                else if (content == 12)
-                    dof->setForceUpperLimit(dof->getForceUpperLimit() + data(i));
-                else
-                    ROBOT_DART_EXCEPTION_ASSERT(false, "Unknown type of data!");
+                set_single_dof_data<content>(single_dof_data<content>(dof) + data(i), dof);
+            }
+        }
+
+        template <int content>
+        void add_dof_data(const Eigen::VectorXd& data, dart::dynamics::SkeletonPtr skeleton, const DofSelection& dofs, const std::unordered_map<std::string, size_t>& dof_map)
+        {
+            if (dofs.all()) {
+                ROBOT_DART_ASSERT(static_cast<size_t>(data.size()) == skeleton->getNumDofs(), "set_dof_data: size of data is not the same as the DoFs", );
+                return set_all_dof_data<content>(all_dof_data<content>(skeleton) + data, skeleton);
+            }
+            if (!dofs.valid(skeleton.get()))
+                return add_dof_data<content>(data, skeleton, dofs.names(), dof_map);
+
+            const std::vector<size_t>& indices = dofs.indices();
+            ROBOT_DART_ASSERT(static_cast<size_t>(data.size()) == indices.size(), "add_dof_data: size of data is not the same as the DoF selection size", );
+            for (size_t i = 0; i < indices.size(); i++) {
+                auto dof = skeleton->getDof(indices[i]);
+                set_single_dof_data<content>(single_dof_data<content>(dof) + data(i), dof);
             }
         }
     } // namespace detail
 
+    bool DofSelection::valid(const dart::dynamics::Skeleton* skeleton) const
+    {
+        return _skeleton && _skeleton == skeleton && _num_skeleton_dofs == skeleton->getNumDofs();
+    }
+
     Robot::Robot(const std::string& model_file, const std::vector<std::pair<std::string, std::string>>& packages, const std::string& robot_name, bool is_urdf_string, bool cast_shadows)
         : _robot_name(robot_name), _skeleton(_load_model(model_file, packages, is_urdf_string)), _cast_shadows(cast_shadows), _is_ghost(false)
     {
@@ -270,26 +345,8 @@ namespace robot_dart {
 
     std::shared_ptr<Robot> Robot::clone() const
     {
-        // safely clone the skeleton
-        _skeleton->getMutex().lock();
-#if DART_VERSION_AT_LEAST(6, 7, 2)
-        auto tmp_skel = _skeleton->cloneSkeleton();
-#else
-        auto tmp_skel = _skeleton->clone();
-#endif
-        _skeleton->getMutex().unlock();
-        auto robot = std::make_shared<Robot>(tmp_skel, _robot_name);
-
-#if DART_VERSION_AT_LEAST(6, 13, 0)
-        // Deep copy everything
-        for (auto& bd : robot->skeleton()->getBodyNodes()) {
-            auto& visual_shapes = bd->getShapeNodesWith<dart::dynamics::VisualAspect>();
-            for (auto& shape : visual_shapes) {
-                if (shape->getShape()->getType() != dart::dynamics::SoftMeshShape::getStaticType())
-                    shape->setShape(shape->getShape()->clone());
-            }
-        }
-#endif
+        // safely clone the skeleton (deep copy of the visual shapes)
+        auto robot = std::make_shared<Robot>(ModelCache::clone_skeleton(_skeleton), _robot_name);
 
         robot->set_positions(this->positions());
 
@@ -303,15 +360,8 @@ namespace robot_dart {
 
     std::shared_ptr<Robot> Robot::clone_ghost(const std::string& ghost_name, const Eigen::Vector4d& ghost_color) const
     {
-        // safely clone the skeleton
-        _skeleton->getMutex().lock();
-#if DART_VERSION_AT_LEAST(6, 7, 2)
-        auto tmp_skel = _skeleton->cloneSkeleton();
-#else
-        auto tmp_skel = _skeleton->clone();
-#endif
-        _skeleton->getMutex().unlock();
-        auto robot = std::make_shared<Robot>(tmp_skel, ghost_name + "_" + _robot_name);
+        // safely clone the skeleton (deep copy of the visual shapes: their color is changed below)
+        auto robot = std::make_shared<Robot>(ModelCache::clone_skeleton(_skeleton), ghost_name + "_" + _robot_name);
         robot->_model_filename = _model_filename;
 
         // ghost robots have no controllers
@@ -333,13 +383,8 @@ namespace robot_dart {
 
             // ghost robots have a different color (same for all bodies)
             auto& visual_shapes = bd->getShapeNodesWith<dart::dynamics::VisualAspect>();
-            for (auto& shape : visual_shapes) {
-#if DART_VERSION_AT_LEAST(6, 13, 0)
-                if (shape->getShape()->getType() != dart::dynamics::SoftMeshShape::getStaticType())
-                    shape->setShape(shape->getShape()->clone());
-#endif
+            for (auto& shape : visual_shapes)
                 shape->getVisualAspect()->setRGBA(ghost_color);
-            }
         }
 
         // set positions
@@ -386,13 +431,34 @@ namespace robot_dart {
 
     void Robot::update(double t)
     {
-        _skeleton->setCommands(Eigen::VectorXd::Zero(_skeleton->getNumDofs()));
+        // the buffers are only (re)allocated when the number of DoFs changes
+        size_t num_dofs = _skeleton->getNumDofs();
+        if (static_cast<size_t>(_commands.size()) != num_dofs)
+            _commands.resize(num_dofs);
+        _commands.setZero();
 
+        // every controller writes in the same scratch buffer, which is added (weighted) to the commands
         for (auto& ctrl : _controllers) {
-            if (ctrl->active())
-                detail::add_dof_data<4>(ctrl->weight() * ctrl->calculate(t), _skeleton,
-                    ctrl->controllable_dofs(), _dof_map);
+            if (!ctrl->active())
+                continue;
+
+            const DofSelection& dofs = ctrl->dof_selection();
+            bool valid = dofs.valid(_skeleton.get());
+            size_t n = detail::selection_size(dofs, valid, _skeleton);
+            if (static_cast<size_t>(_controller_commands.size()) < n)
+                _controller_commands.resize(n);
+
+            // a controller that fails (e.g., wrong size) returns without writing: it must not add the commands of the previous one
+            auto commands = _controller_commands.head(n);
+            commands.setZero();
+            ctrl->calculate_into(t, commands);
+
+            double weight = ctrl->weight();
+            for (size_t i = 0; i < n; i++)
+                _commands(detail::selected_dof_index(dofs, valid, i, _dof_map)) += weight * commands(i);
         }
+
+        _skeleton->setCommands(_commands);
     }
 
     void Robot::reinit_controllers()
@@ -429,6 +495,7 @@ namespace robot_dart {
         const std::shared_ptr<control::RobotControl>& controller, double weight)
     {
         _controllers.push_back(controller);
+        _controllers_version++;
         controller->set_robot(this->shared_from_this());
         controller->set_weight(weight);
         controller->init();
@@ -437,17 +504,24 @@ namespace robot_dart {
     void Robot::remove_controller(const std::shared_ptr<control::RobotControl>& controller)
     {
         auto it = std::find(_controllers.begin(), _controllers.end(), controller);
-        if (it != _controllers.end())
+        if (it != _controllers.end()) {
             _controllers.erase(it);
+            _controllers_version++;
+        }
     }
 
     void Robot::remove_controller(size_t index)
     {
         ROBOT_DART_ASSERT(index < _controllers.size(), "Controller index out of bounds", );
         _controllers.erase(_controllers.begin() + index);
+        _controllers_version++;
     }
 
-    void Robot::clear_controllers() { _controllers.clear(); }
+    void Robot::clear_controllers()
+    {
+        _controllers.clear();
+        _controllers_version++;
+    }
 
     void Robot::fix_to_world()
     {
@@ -464,8 +538,8 @@ namespace robot_dart {
         _skeleton->getRootBodyNode()->changeParentJointType<dart::dynamics::WeldJoint>(properties);
         _skeleton->getRootBodyNode()->getParentJoint()->setTransformFromParentBodyNode(tf);
 
-        reinit_controllers();
         update_joint_dof_maps();
+        reinit_controllers();
     }
 
     // pose: Orientation-Position
@@ -488,8 +562,8 @@ namespace robot_dart {
         _skeleton->getRootBodyNode()->changeParentJointType<dart::dynamics::FreeJoint>(properties);
         _skeleton->getRootBodyNode()->getParentJoint()->setTransformFromParentBodyNode(tf);
 
-        reinit_controllers();
         update_joint_dof_maps();
+        reinit_controllers();
     }
 
     bool Robot::fixed() const
@@ -1214,131 +1288,326 @@ namespace robot_dart {
         return detail::dof_data<0>(_skeleton, dof_names, _dof_map);
     }
 
+    Eigen::VectorXd Robot::positions(const DofSelection& dofs) const
+    {
+        return detail::dof_data<0>(_skeleton, dofs, _dof_map);
+    }
+
+    void Robot::positions(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const
+    {
+        detail::dof_data<0>(out, _skeleton, dofs, _dof_map);
+    }
+
     void Robot::set_positions(const Eigen::VectorXd& positions, const std::vector<std::string>& dof_names)
     {
         detail::set_dof_data<0>(positions, _skeleton, dof_names, _dof_map);
     }
 
+    void Robot::set_positions(const Eigen::VectorXd& positions, const DofSelection& dofs)
+    {
+        detail::set_dof_data<0>(positions, _skeleton, dofs, _dof_map);
+    }
+
     Eigen::VectorXd Robot::position_lower_limits(const std::vector<std::string>& dof_names) const
     {
         return detail::dof_data<5>(_skeleton, dof_names, _dof_map);
     }
 
+    Eigen::VectorXd Robot::position_lower_limits(const DofSelection& dofs) const
+    {
+        return detail::dof_data<5>(_skeleton, dofs, _dof_map);
+    }
+
+    void Robot::position_lower_limits(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const
+    {
+        detail::dof_data<5>(out, _skeleton, dofs, _dof_map);
+    }
+
     void Robot::set_position_lower_limits(const Eigen::VectorXd& positions, const std::vector<std::string>& dof_names)
     {
         detail::set_dof_data<5>(positions, _skeleton, dof_names, _dof_map);
     }
 
+    void Robot::set_position_lower_limits(const Eigen::VectorXd& positions, const DofSelection& dofs)
+    {
+        detail::set_dof_data<5>(positions, _skeleton, dofs, _dof_map);
+    }
+
     Eigen::VectorXd Robot::position_upper_limits(const std::vector<std::string>& dof_names) const
     {
         return detail::dof_data<6>(_skeleton, dof_names, _dof_map);
     }
 
+    Eigen::VectorXd Robot::position_upper_limits(const DofSelection& dofs) const
+    {
+        return detail::dof_data<6>(_skeleton, dofs, _dof_map);
+    }
+
+    void Robot::position_upper_limits(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const
+    {
+        detail::dof_data<6>(out, _skeleton, dofs, _dof_map);
+    }
+
     void Robot::set_position_upper_limits(const Eigen::VectorXd& positions, const std::vector<std::string>& dof_names)
     {
         detail::set_dof_data<6>(positions, _skeleton, dof_names, _dof_map);
     }
 
+    void Robot::set_position_upper_limits(const Eigen::VectorXd& positions, const DofSelection& dofs)
+    {
+        detail::set_dof_data<6>(positions, _skeleton, dofs, _dof_map);
+    }
+
     Eigen::VectorXd Robot::velocities(const std::vector<std::string>& dof_names) const
     {
         return detail::dof_data<1>(_skeleton, dof_names, _dof_map);
     }
 
+    Eigen::VectorXd Robot::velocities(const DofSelection& dofs) const
+    {
+        return detail::dof_data<1>(_skeleton, dofs, _dof_map);
+    }
+
+    void Robot::velocities(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const
+    {
+        detail::dof_data<1>(out, _skeleton, dofs, _dof_map);
+    }
+
     void Robot::set_velocities(const Eigen::VectorXd& velocities, const std::vector<std::string>& dof_names)
     {
         detail::set_dof_data<1>(velocities, _skeleton, dof_names, _dof_map);
     }
 
+    void Robot::set_velocities(const Eigen::VectorXd& velocities, const DofSelection& dofs)
+    {
+        detail::set_dof_data<1>(velocities, _skeleton, dofs, _dof_map);
+    }
+
     Eigen::VectorXd Robot::velocity_lower_limits(const std::vector<std::string>& dof_names) const
     {
         return detail::dof_data<7>(_skeleton, dof_names, _dof_map);
     }
 
+    Eigen::VectorXd Robot::velocity_lower_limits(const DofSelection& dofs) const
+    {
+        return detail::dof_data<7>(_skeleton, dofs, _dof_map);
+    }
+
+    void Robot::velocity_lower_limits(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const
+    {
+        detail::dof_data<7>(out, _skeleton, dofs, _dof_map);
+    }
+
     void Robot::set_velocity_lower_limits(const Eigen::VectorXd& velocities, const std::vector<std::string>& dof_names)
     {
         detail::set_dof_data<7>(velocities, _skeleton, dof_names, _dof_map);
     }
 
+    void Robot::set_velocity_lower_limits(const Eigen::VectorXd& velocities, const DofSelection& dofs)
+    {
+        detail::set_dof_data<7>(velocities, _skeleton, dofs, _dof_map);
+    }
+
     Eigen::VectorXd Robot::velocity_upper_limits(const std::vector<std::string>& dof_names) const
     {
         return detail::dof_data<8>(_skeleton, dof_names, _dof_map);
     }
 
+    Eigen::VectorXd Robot::velocity_upper_limits(const DofSelection& dofs) const
+    {
+        return detail::dof_data<8>(_skeleton, dofs, _dof_map);
+    }
+
+    void Robot::velocity_upper_limits(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const
+    {
+        detail::dof_data<8>(out, _skeleton, dofs, _dof_map);
+    }
+
     void Robot::set_velocity_upper_limits(const Eigen::VectorXd& velocities, const std::vector<std::string>& dof_names)
     {
         detail::set_dof_data<8>(velocities, _skeleton, dof_names, _dof_map);
     }
 
+    void Robot::set_velocity_upper_limits(const Eigen::VectorXd& velocities, const DofSelection& dofs)
+    {
+        detail::set_dof_data<8>(velocities, _skeleton, dofs, _dof_map);
+    }
+
     Eigen::VectorXd Robot::accelerations(const std::vector<std::string>& dof_names) const
     {
         return detail::dof_data<2>(_skeleton, dof_names, _dof_map);
     }
 
+    Eigen::VectorXd Robot::accelerations(const DofSelection& dofs) const
+    {
+        return detail::dof_data<2>(_skeleton, dofs, _dof_map);
+    }
+
+    void Robot::accelerations(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const
+    {
+        detail::dof_data<2>(out, _skeleton, dofs, _dof_map);
+    }
+
     void Robot::set_accelerations(const Eigen::VectorXd& accelerations, const std::vector<std::string>& dof_names)
     {
         detail::set_dof_data<2>(accelerations, _skeleton, dof_names, _dof_map);
     }
 
+    void Robot::set_accelerations(const Eigen::VectorXd& accelerations, const DofSelection& dofs)
+    {
+        detail::set_dof_data<2>(accelerations, _skeleton, dofs, _dof_map);
+    }
+
     Eigen::VectorXd Robot::acceleration_lower_limits(const std::vector<std::string>& dof_names) const
     {
         return detail::dof_data<9>(_skeleton, dof_names, _dof_map);
     }
 
+    Eigen::VectorXd Robot::acceleration_lower_limits(const DofSelection& dofs) const
+    {
+        return detail::dof_data<9>(_skeleton, dofs, _dof_map);
+    }
+
+    void Robot::acceleration_lower_limits(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const
+    {
+        detail::dof_data<9>(out, _skeleton, dofs, _dof_map);
+    }
+
     void Robot::set_acceleration_lower_limits(const Eigen::VectorXd& accelerations, const std::vector<std::string>& dof_names)
     {
         detail::set_dof_data<9>(accelerations, _skeleton, dof_names, _dof_map);
     }
 
+    void Robot::set_acceleration_lower_limits(const Eigen::VectorXd& accelerations, const DofSelection& dofs)
+    {
+        detail::set_dof_data<9>(accelerations, _skeleton, dofs, _dof_map);
+    }
+
     Eigen::VectorXd Robot::acceleration_upper_limits(const std::vector<std::string>& dof_names) const
     {
         return detail::dof_data<10>(_skeleton, dof_names, _dof_map);
     }
 
+    Eigen::VectorXd Robot::acceleration_upper_limits(const DofSelection& dofs) const
+    {
+        return detail::dof_data<10>(_skeleton, dofs, _dof_map);
+    }
+
+    void Robot::acceleration_upper_limits(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const
+    {
+        detail::dof_data<10>(out, _skeleton, dofs, _dof_map);
+    }
+
     void Robot::set_acceleration_upper_limits(const Eigen::VectorXd& accelerations, const std::vector<std::string>& dof_names)
     {
         detail::set_dof_data<10>(accelerations, _skeleton, dof_names, _dof_map);
     }
 
+    void Robot::set_acceleration_upper_limits(const Eigen::VectorXd& accelerations, const DofSelection& dofs)
+    {
+        detail::set_dof_data<10>(accelerations, _skeleton, dofs, _dof_map);
+    }
+
     Eigen::VectorXd Robot::forces(const std::vector<std::string>& dof_names) const
     {
         return detail::dof_data<3>(_skeleton, dof_names, _dof_map);
     }
 
+    Eigen::VectorXd Robot::forces(const DofSelection& dofs) const
+    {
+        return detail::dof_data<3>(_skeleton, dofs, _dof_map);
+    }
+
+    void Robot::forces(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const
+    {
+        detail::dof_data<3>(out, _skeleton, dofs, _dof_map);
+    }
+
     void Robot::set_forces(const Eigen::VectorXd& forces, const std::vector<std::string>& dof_names)
     {
         detail::set_dof_data<3>(forces, _skeleton, dof_names, _dof_map);
     }
 
+    void Robot::set_forces(const Eigen::VectorXd& forces, const DofSelection& dofs)
+    {
+        detail::set_dof_data<3>(forces, _skeleton, dofs, _dof_map);
+    }
+
     Eigen::VectorXd Robot::force_lower_limits(const std::vector<std::string>& dof_names) const
     {
         return detail::dof_data<11>(_skeleton, dof_names, _dof_map);
     }
 
+    Eigen::VectorXd Robot::force_lower_limits(const DofSelection& dofs) const
+    {
+        return detail::dof_data<11>(_skeleton, dofs, _dof_map);
+    }
+
+    void Robot::force_lower_limits(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const
+    {
+        detail::dof_data<11>(out, _skeleton, dofs, _dof_map);
+    }
+
     void Robot::set_force_lower_limits(const Eigen::VectorXd& forces, const std::vector<std::string>& dof_names)
     {
         detail::set_dof_data<11>(forces, _skeleton, dof_names, _dof_map);
     }
 
+    void Robot::set_force_lower_limits(const Eigen::VectorXd& forces, const DofSelection& dofs)
+    {
+        detail::set_dof_data<11>(forces, _skeleton, dofs, _dof_map);
+    }
+
     Eigen::VectorXd Robot::force_upper_limits(const std::vector<std::string>& dof_names) const
     {
         return detail::dof_data<12>(_skeleton, dof_names, _dof_map);
     }
 
+    Eigen::VectorXd Robot::force_upper_limits(const DofSelection& dofs) const
+    {
+        return detail::dof_data<12>(_skeleton, dofs, _dof_map);
+    }
+
+    void Robot::force_upper_limits(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const
+    {
+        detail::dof_data<12>(out, _skeleton, dofs, _dof_map);
+    }
+
     void Robot::set_force_upper_limits(const Eigen::VectorXd& forces, const std::vector<std::string>& dof_names)
     {
         detail::set_dof_data<12>(forces, _skeleton, dof_names, _dof_map);
     }
 
+    void Robot::set_force_upper_limits(const Eigen::VectorXd& forces, const DofSelection& dofs)
+    {
+        detail::set_dof_data<12>(forces, _skeleton, dofs, _dof_map);
+    }
+
     Eigen::VectorXd Robot::commands(const std::vector<std::string>& dof_names) const
     {
         return detail::dof_data<4>(_skeleton, dof_names, _dof_map);
     }
 
+    Eigen::VectorXd Robot::commands(const DofSelection& dofs) const
+    {
+        return detail::dof_data<4>(_skeleton, dofs, _dof_map);
+    }
+
+    void Robot::commands(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const
+    {
+        detail::dof_data<4>(out, _skeleton, dofs, _dof_map);
+    }
+
     void Robot::set_commands(const Eigen::VectorXd& commands, const std::vector<std::string>& dof_names)
     {
         detail::set_dof_data<4>(commands, _skeleton, dof_names, _dof_map);
     }
 
+    void Robot::set_commands(const Eigen::VectorXd& commands, const DofSelection& dofs)
+    {
+        detail::set_dof_data<4>(commands, _skeleton, dofs, _dof_map);
+    }
+
     std::pair<Eigen::Vector6d, Eigen::Vector6d> Robot::force_torque(size_t joint_index) const
     {
         ROBOT_DART_ASSERT(joint_index < _skeleton->getNumJoints(), "Joint index out of bounds", {});
@@ -1584,6 +1853,16 @@ namespace robot_dart {
         return _jacobian(jac, dof_names);
     }
 
+    Eigen::MatrixXd Robot::jacobian(const std::string& body_name, const DofSelection& dofs) const
+    {
+        auto bd = _skeleton->getBodyNode(body_name);
+        ROBOT_DART_ASSERT(bd != nullptr, "BodyNode does not exist in skeleton!", Eigen::MatrixXd());
+
+        Eigen::MatrixXd jac = _skeleton->getWorldJacobian(bd);
+
+        return _jacobian(jac, dofs);
+    }
+
     Eigen::MatrixXd Robot::jacobian_deriv(const std::string& body_name, const std::vector<std::string>& dof_names) const
     {
         auto bd = _skeleton->getBodyNode(body_name);
@@ -1594,6 +1873,32 @@ namespace robot_dart {
         return _jacobian(jac, dof_names);
     }
 
+    Eigen::MatrixXd Robot::jacobian_deriv(const std::string& body_name, const DofSelection& dofs) const
+    {
+        auto bd = _skeleton->getBodyNode(body_name);
+        ROBOT_DART_ASSERT(bd != nullptr, "BodyNode does not exist in skeleton!", Eigen::MatrixXd());
+
+        Eigen::MatrixXd jac = _skeleton->getJacobianSpatialDeriv(bd, dart::dynamics::Frame::World());
+
+        return _jacobian(jac, dofs);
+    }
+
+    void Robot::jacobian(Eigen::Ref<Eigen::MatrixXd> out, const std::string& body_name, const DofSelection& dofs) const
+    {
+        auto bd = _skeleton->getBodyNode(body_name);
+        ROBOT_DART_ASSERT(bd != nullptr, "BodyNode does not exist in skeleton!", );
+
+        _world_jacobian(out, bd, bd->getJacobian(), dofs);
+    }
+
+    void Robot::jacobian_deriv(Eigen::Ref<Eigen::MatrixXd> out, const std::string& body_name, const DofSelection& dofs) const
+    {
+        auto bd = _skeleton->getBodyNode(body_name);
+        ROBOT_DART_ASSERT(bd != nullptr, "BodyNode does not exist in skeleton!", );
+
+        _world_jacobian(out, bd, bd->getJacobianSpatialDeriv(), dofs);
+    }
+
     Eigen::MatrixXd Robot::com_jacobian(const std::vector<std::string>& dof_names) const
     {
         Eigen::MatrixXd jac = _skeleton->getCOMJacobian();
@@ -1601,6 +1906,13 @@ namespace robot_dart {
         return _jacobian(jac, dof_names);
     }
 
+    Eigen::MatrixXd Robot::com_jacobian(const DofSelection& dofs) const
+    {
+        Eigen::MatrixXd jac = _skeleton->getCOMJacobian();
+
+        return _jacobian(jac, dofs);
+    }
+
     Eigen::MatrixXd Robot::com_jacobian_deriv(const std::vector<std::string>& dof_names) const
     {
         Eigen::MatrixXd jac = _skeleton->getCOMJacobianSpatialDeriv();
@@ -1608,6 +1920,13 @@ namespace robot_dart {
         return _jacobian(jac, dof_names);
     }
 
+    Eigen::MatrixXd Robot::com_jacobian_deriv(const DofSelection& dofs) const
+    {
+        Eigen::MatrixXd jac = _skeleton->getCOMJacobianSpatialDeriv();
+
+        return _jacobian(jac, dofs);
+    }
+
     Eigen::MatrixXd Robot::mass_matrix(const std::vector<std::string>& dof_names) const
     {
         Eigen::MatrixXd M = _skeleton->getMassMatrix();
@@ -1615,6 +1934,13 @@ namespace robot_dart {
         return _mass_matrix(M, dof_names);
     }
 
+    Eigen::MatrixXd Robot::mass_matrix(const DofSelection& dofs) const
+    {
+        Eigen::MatrixXd M = _skeleton->getMassMatrix();
+
+        return _mass_matrix(M, dofs);
+    }
+
     Eigen::MatrixXd Robot::aug_mass_matrix(const std::vector<std::string>& dof_names) const
     {
         Eigen::MatrixXd M = _skeleton->getAugMassMatrix();
@@ -1622,6 +1948,13 @@ namespace robot_dart {
         return _mass_matrix(M, dof_names);
     }
 
+    Eigen::MatrixXd Robot::aug_mass_matrix(const DofSelection& dofs) const
+    {
+        Eigen::MatrixXd M = _skeleton->getAugMassMatrix();
+
+        return _mass_matrix(M, dofs);
+    }
+
     Eigen::MatrixXd Robot::inv_mass_matrix(const std::vector<std::string>& dof_names) const
     {
         Eigen::MatrixXd M = _skeleton->getInvMassMatrix();
@@ -1629,6 +1962,13 @@ namespace robot_dart {
         return _mass_matrix(M, dof_names);
     }
 
+    Eigen::MatrixXd Robot::inv_mass_matrix(const DofSelection& dofs) const
+    {
+        Eigen::MatrixXd M = _skeleton->getInvMassMatrix();
+
+        return _mass_matrix(M, dofs);
+    }
+
     Eigen::MatrixXd Robot::inv_aug_mass_matrix(const std::vector<std::string>& dof_names) const
     {
         Eigen::MatrixXd M = _skeleton->getInvAugMassMatrix();
@@ -1636,26 +1976,93 @@ namespace robot_dart {
         return _mass_matrix(M, dof_names);
     }
 
+    Eigen::MatrixXd Robot::inv_aug_mass_matrix(const DofSelection& dofs) const
+    {
+        Eigen::MatrixXd M = _skeleton->getInvAugMassMatrix();
+
+        return _mass_matrix(M, dofs);
+    }
+
+    void Robot::mass_matrix(Eigen::Ref<Eigen::MatrixXd> out, const DofSelection& dofs) const
+    {
+        _mass_matrix(out, _skeleton->getMassMatrix(), dofs);
+    }
+
+    void Robot::aug_mass_matrix(Eigen::Ref<Eigen::MatrixXd> out, const DofSelection& dofs) const
+    {
+        _mass_matrix(out, _skeleton->getAugMassMatrix(), dofs);
+    }
+
+    void Robot::inv_mass_matrix(Eigen::Ref<Eigen::MatrixXd> out, const DofSelection& dofs) const
+    {
+        _mass_matrix(out, _skeleton->getInvMassMatrix(), dofs);
+    }
+
+    void Robot::inv_aug_mass_matrix(Eigen::Ref<Eigen::MatrixXd> out, const DofSelection& dofs) const
+    {
+        _mass_matrix(out, _skeleton->getInvAugMassMatrix(), dofs);
+    }
+
     Eigen::VectorXd Robot::coriolis_forces(const std::vector<std::string>& dof_names) const
     {
         return detail::dof_data<13>(_skeleton, dof_names, _dof_map);
     }
 
+    Eigen::VectorXd Robot::coriolis_forces(const DofSelection& dofs) const
+    {
+        return detail::dof_data<13>(_skeleton, dofs, _dof_map);
+    }
+
+    void Robot::coriolis_forces(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const
+    {
+        detail::dof_data<13>(out, _skeleton, dofs, _dof_map);
+    }
+
     Eigen::VectorXd Robot::gravity_forces(const std::vector<std::string>& dof_names) const
     {
         return detail::dof_data<14>(_skeleton, dof_names, _dof_map);
     }
 
+    Eigen::VectorXd Robot::gravity_forces(const DofSelection& dofs) const
+    {
+        return detail::dof_data<14>(_skeleton, dofs, _dof_map);
+    }
+
+    void Robot::gravity_forces(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const
+    {
+        detail::dof_data<14>(out, _skeleton, dofs, _dof_map);
+    }
+
     Eigen::VectorXd Robot::coriolis_gravity_forces(const std::vector<std::string>& dof_names) const
     {
         return detail::dof_data<15>(_skeleton, dof_names, _dof_map);
     }
 
+    Eigen::VectorXd Robot::coriolis_gravity_forces(const DofSelection& dofs) const
+    {
+        return detail::dof_data<15>(_skeleton, dofs, _dof_map);
+    }
+
+    void Robot::coriolis_gravity_forces(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const
+    {
+        detail::dof_data<15>(out, _skeleton, dofs, _dof_map);
+    }
+
     Eigen::VectorXd Robot::constraint_forces(const std::vector<std::string>& dof_names) const
     {
         return detail::dof_data<16>(_skeleton, dof_names, _dof_map);
     }
 
+    Eigen::VectorXd Robot::constraint_forces(const DofSelection& dofs) const
+    {
+        return detail::dof_data<16>(_skeleton, dofs, _dof_map);
+    }
+
+    void Robot::constraint_forces(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const
+    {
+        detail::dof_data<16>(out, _skeleton, dofs, _dof_map);
+    }
+
     Eigen::VectorXd Robot::vec_dof(const Eigen::VectorXd& vec, const std::vector<std::string>& dof_names) const
     {
         assert(vec.size() == static_cast<int>(_skeleton->getNumDofs()));
@@ -1671,6 +2078,45 @@ namespace robot_dart {
         return ret;
     }
 
+    Eigen::VectorXd Robot::vec_dof(const Eigen::VectorXd& vec, const DofSelection& dofs) const
+    {
+        assert(vec.size() == static_cast<int>(_skeleton->getNumDofs()));
+
+        if (dofs.all())
+            return vec;
+        if (!dofs.valid(_skeleton.get()))
+            return vec_dof(vec, dofs.names());
+
+        const std::vector<size_t>& indices = dofs.indices();
+        Eigen::VectorXd ret(indices.size());
+        for (size_t i = 0; i < indices.size(); i++)
+            ret(i) = vec[indices[i]];
+
+        return ret;
+    }
+
+    DofSelection Robot::dof_selection(const std::vector<std::string>& dof_names) const
+    {
+        DofSelection dofs(_skeleton.get());
+        dofs._num_skeleton_dofs = _skeleton->getNumDofs();
+        dofs._all = dof_names.empty();
+        dofs._names = dof_names;
+
+        if (dofs._all) {
+            for (size_t i = 0; i < _skeleton->getNumDofs(); i++)
+                dofs._indices.push_back(i);
+        }
+        else {
+            for (auto& name : dof_names) {
+                auto it = _dof_map.find(name);
+                ROBOT_DART_EXCEPTION_ASSERT(it != _dof_map.end(), "dof_selection: " + name + " is not in dof_map");
+                dofs._indices.push_back(it->second);
+            }
+        }
+
+        return dofs;
+    }
+
     void Robot::update_joint_dof_maps()
     {
         // DoFs
@@ -1926,6 +2372,23 @@ namespace robot_dart {
             // in C++17 we would use std::filesystem!
             boost::filesystem::path path(model_file);
             std::string extension = path.extension().string();
+
+            std::vector<std::pair<std::string, std::string>> package_dirs;
+            if (extension == ".urdf") {
+                for (size_t i = 0; i < packages.size(); i++) {
+                    std::string package = std::get<1>(packages[i]);
+                    std::string package_path = _get_path(package);
+                    package_dirs.push_back({std::get<0>(packages[i]), package_path + "/" + package});
+                }
+            }
+            // a .skel world gives the skeleton named after the robot
+            std::string variant = (extension == ".skel") ? _robot_name : "";
+
+            // do not parse the same model twice
+            tmp_skel = ModelCache::instance().get(model_file, package_dirs, variant);
+            if (tmp_skel)
+                return _post_load_model(tmp_skel);
+
             if (extension == ".urdf") {
 #if DART_VERSION_AT_LEAST(6, 12, 0)
                 dart::io::DartLoader::Options options;
@@ -1935,12 +2398,8 @@ namespace robot_dart {
 #else
                 dart::io::DartLoader loader;
 #endif
-                for (size_t i = 0; i < packages.size(); i++) {
-                    std::string package = std::get<1>(packages[i]);
-                    std::string package_path = _get_path(package);
-                    loader.addPackageDirectory(
-                        std::get<0>(packages[i]), package_path + "/" + package);
-                }
+                for (auto& p : package_dirs)
+                    loader.addPackageDirectory(p.first, p.second);
                 tmp_skel = loader.parseSkeleton(model_file);
             }
             else if (extension == ".sdf")
@@ -1956,6 +2415,13 @@ namespace robot_dart {
             }
             else
                 return nullptr;
+
+            if (tmp_skel == nullptr)
+                return nullptr;
+
+            _post_load_model(tmp_skel);
+            ModelCache::instance().add(model_file, package_dirs, tmp_skel, variant);
+            return tmp_skel;
         }
         else {
             // Load from URDF string
@@ -1971,6 +2437,11 @@ namespace robot_dart {
         if (tmp_skel == nullptr)
             return nullptr;
 
+        return _post_load_model(tmp_skel);
+    }
+
+    dart::dynamics::SkeletonPtr Robot::_post_load_model(const dart::dynamics::SkeletonPtr& tmp_skel)
+    {
         tmp_skel->setName(_robot_name);
         // Set joint limits
         for (size_t i = 0; i < tmp_skel->getNumJoints(); ++i) {
@@ -2086,6 +2557,21 @@ namespace robot_dart {
         return jac_ret;
     }
 
+    Eigen::MatrixXd Robot::_jacobian(const Eigen::MatrixXd& full_jacobian, const DofSelection& dofs) const
+    {
+        if (dofs.all())
+            return full_jacobian;
+        if (!dofs.valid(_skeleton.get()))
+            return _jacobian(full_jacobian, dofs.names());
+
+        const std::vector<size_t>& indices = dofs.indices();
+        Eigen::MatrixXd jac_ret(6, indices.size());
+        for (size_t i = 0; i < indices.size(); i++)
+            jac_ret.col(i) = full_jacobian.col(indices[i]);
+
+        return jac_ret;
+    }
+
     Eigen::MatrixXd Robot::_mass_matrix(const Eigen::MatrixXd& full_mass_matrix, const std::vector<std::string>& dof_names) const
     {
         if (dof_names.empty())
@@ -2111,6 +2597,71 @@ namespace robot_dart {
         return M_ret;
     }
 
+    Eigen::MatrixXd Robot::_mass_matrix(const Eigen::MatrixXd& full_mass_matrix, const DofSelection& dofs) const
+    {
+        if (dofs.all())
+            return full_mass_matrix;
+        if (!dofs.valid(_skeleton.get()))
+            return _mass_matrix(full_mass_matrix, dofs.names());
+
+        const std::vector<size_t>& indices = dofs.indices();
+        Eigen::MatrixXd M_ret(indices.size(), indices.size());
+        for (size_t i = 0; i < indices.size(); i++)
+            for (size_t j = 0; j < indices.size(); j++)
+                M_ret(i, j) = full_mass_matrix(indices[i], indices[j]);
+
+        return M_ret;
+    }
+
+    void Robot::_world_jacobian(Eigen::Ref<Eigen::MatrixXd> out, const dart::dynamics::BodyNode* body_node, const dart::math::Jacobian& body_jacobian, const DofSelection& dofs) const
+    {
+        bool valid = dofs.valid(_skeleton.get());
+        size_t n = detail::selection_size(dofs, valid, _skeleton);
+        ROBOT_DART_ASSERT(out.rows() == 6 && static_cast<size_t>(out.cols()) == n, "jacobian: size of the output is not 6 x the DoF selection size", );
+
+        // same as Skeleton::getWorldJacobian() but without building the full Jacobian:
+        // the body Jacobian (only the DoFs the body depends on) is rotated in the world frame
+        const Eigen::Matrix3d R = body_node->getWorldTransform().linear();
+        out.setZero();
+        for (size_t j = 0; j < body_node->getNumDependentGenCoords(); j++) {
+            size_t dof_index = body_node->getDependentGenCoordIndex(j);
+            for (size_t i = 0; i < n; i++) {
+                if (detail::selected_dof_index(dofs, valid, i, _dof_map) != dof_index)
+                    continue;
+                out.col(i).head<3>().noalias() = R * body_jacobian.col(j).head<3>();
+                out.col(i).tail<3>().noalias() = R * body_jacobian.col(j).tail<3>();
+            }
+        }
+    }
+
+    void Robot::_mass_matrix(Eigen::Ref<Eigen::MatrixXd> out, const Eigen::MatrixXd& full_mass_matrix, const DofSelection& dofs) const
+    {
+        bool valid = dofs.valid(_skeleton.get());
+        size_t n = detail::selection_size(dofs, valid, _skeleton);
+        ROBOT_DART_ASSERT(static_cast<size_t>(out.rows()) == n && static_cast<size_t>(out.cols()) == n, "mass_matrix: size of the output is not the same as the DoF selection size", );
+
+        if (dofs.all()) {
+            out = full_mass_matrix;
+            return;
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            size_t index_i = detail::selected_dof_index(dofs, valid, i, _dof_map);
+            for (size_t j = 0; j < n; j++)
+                out(i, j) = full_mass_matrix(index_i, detail::selected_dof_index(dofs, valid, j, _dof_map));
+        }
+    }
+
+    void Robot::_add_internal_sensor(RobotDARTSimu* simu, const std::shared_ptr<sensor::Sensor>& sensor)
+    {
+        simu->_add_internal_sensor(sensor);
+    }
+
+    void Robot::_remove_internal_sensor(RobotDARTSimu* simu, const std::shared_ptr<sensor::Sensor>& sensor)
+    {
+        simu->_remove_internal_sensor(sensor);
+    }
+
     std::shared_ptr<Robot> Robot::create_box(const Eigen::Vector3d& dims, const Eigen::Isometry3d& tf, const std::string& type, double mass, const Eigen::Vector4d& color, const std::string& box_name)
     {
         Eigen::Vector6d x;
@@ -10,6 +10,42 @@ namespace robot_dart {
     namespace control {
         class RobotControl;
     }
+    namespace sensor {
+        class Sensor;
+    }
+
+    /// DoF indices of a robot, computed once from their names by Robot::dof_selection().
+    /// The getters/setters of Robot that take a selection instead of a list of names
+    /// do not look up the names at every call.
+    /// If the DoFs of the skeleton change (e.g., with fix_to_world()), the selection
+    /// falls back to its names until it is recomputed.
+    class DofSelection {
+    public:
+        /// a selection that is not attached to any robot (placeholder until Robot::dof_selection() is called)
+        static DofSelection none() { return DofSelection(nullptr); }
+
+        /// names of the selected DoFs (empty if all() is true)
+        const std::vector<std::string>& names() const { return _names; }
+        /// indices of the selected DoFs in the skeleton
+        const std::vector<size_t>& indices() const { return _indices; }
+        size_t size() const { return _indices.size(); }
+        /// true if the selection is all the DoFs of the robot (in skeleton order)
+        bool all() const { return _all; }
+
+        /// true if the indices are valid for this skeleton
+        bool valid(const dart::dynamics::Skeleton* skeleton) const;
+
+    protected:
+        friend class Robot;
+
+        explicit DofSelection(const dart::dynamics::Skeleton* skeleton) : _skeleton(skeleton) {}
+
+        const dart::dynamics::Skeleton* _skeleton;
+        size_t _num_skeleton_dofs = 0;
+        bool _all = false;
+        std::vector<std::string> _names;
+        std::vector<size_t> _indices;
+    };
 
     class Robot : public std::enable_shared_from_this<Robot> {
     public:
@@ -51,6 +87,8 @@ namespace robot_dart {
         void remove_controller(const std::shared_ptr<control::RobotControl>& controller);
         void remove_controller(size_t index);
         void clear_controllers();
+        /// changes every time that controllers are added or removed
+        size_t controllers_version() const { return _controllers_version; }
 
         void fix_to_world();
         // pose: Orientation-Position
@@ -132,39 +170,65 @@ namespace robot_dart {
         Eigen::Vector6d com_acceleration() const;
 
         Eigen::VectorXd positions(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::VectorXd positions(const DofSelection& dofs) const;
         void set_positions(const Eigen::VectorXd& positions, const std::vector<std::string>& dof_names = {});
+        void set_positions(const Eigen::VectorXd& positions, const DofSelection& dofs);
 
         Eigen::VectorXd position_lower_limits(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::VectorXd position_lower_limits(const DofSelection& dofs) const;
         void set_position_lower_limits(const Eigen::VectorXd& positions, const std::vector<std::string>& dof_names = {});
+        void set_position_lower_limits(const Eigen::VectorXd& positions, const DofSelection& dofs);
         Eigen::VectorXd position_upper_limits(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::VectorXd position_upper_limits(const DofSelection& dofs) const;
         void set_position_upper_limits(const Eigen::VectorXd& positions, const std::vector<std::string>& dof_names = {});
+        void set_position_upper_limits(const Eigen::VectorXd& positions, const DofSelection& dofs);
 
         Eigen::VectorXd velocities(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::VectorXd velocities(const DofSelection& dofs) const;
         void set_velocities(const Eigen::VectorXd& velocities, const std::vector<std::string>& dof_names = {});
+        void set_velocities(const Eigen::VectorXd& velocities, const DofSelection& dofs);
 
         Eigen::VectorXd velocity_lower_limits(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::VectorXd velocity_lower_limits(const DofSelection& dofs) const;
         void set_velocity_lower_limits(const Eigen::VectorXd& velocities, const std::vector<std::string>& dof_names = {});
+        void set_velocity_lower_limits(const Eigen::VectorXd& velocities, const DofSelection& dofs);
         Eigen::VectorXd velocity_upper_limits(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::VectorXd velocity_upper_limits(const DofSelection& dofs) const;
         void set_velocity_upper_limits(const Eigen::VectorXd& velocities, const std::vector<std::string>& dof_names = {});
+        void set_velocity_upper_limits(const Eigen::VectorXd& velocities, const DofSelection& dofs);
 
         Eigen::VectorXd accelerations(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::VectorXd accelerations(const DofSelection& dofs) const;
         void set_accelerations(const Eigen::VectorXd& accelerations, const std::vector<std::string>& dof_names = {});
+        void set_accelerations(const Eigen::VectorXd& accelerations, const DofSelection& dofs);
 
         Eigen::VectorXd acceleration_lower_limits(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::VectorXd acceleration_lower_limits(const DofSelection& dofs) const;
         void set_acceleration_lower_limits(const Eigen::VectorXd& accelerations, const std::vector<std::string>& dof_names = {});
+        void set_acceleration_lower_limits(const Eigen::VectorXd& accelerations, const DofSelection& dofs);
         Eigen::VectorXd acceleration_upper_limits(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::VectorXd acceleration_upper_limits(const DofSelection& dofs) const;
         void set_acceleration_upper_limits(const Eigen::VectorXd& accelerations, const std::vector<std::string>& dof_names = {});
+        void set_acceleration_upper_limits(const Eigen::VectorXd& accelerations, const DofSelection& dofs);
 
         Eigen::VectorXd forces(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::VectorXd forces(const DofSelection& dofs) const;
         void set_forces(const Eigen::VectorXd& forces, const std::vector<std::string>& dof_names = {});
+        void set_forces(const Eigen::VectorXd& forces, const DofSelection& dofs);
 
         Eigen::VectorXd force_lower_limits(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::VectorXd force_lower_limits(const DofSelection& dofs) const;
         void set_force_lower_limits(const Eigen::VectorXd& forces, const std::vector<std::string>& dof_names = {});
+        void set_force_lower_limits(const Eigen::VectorXd& forces, const DofSelection& dofs);
         Eigen::VectorXd force_upper_limits(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::VectorXd force_upper_limits(const DofSelection& dofs) const;
         void set_force_upper_limits(const Eigen::VectorXd& forces, const std::vector<std::string>& dof_names = {});
+        void set_force_upper_limits(const Eigen::VectorXd& forces, const DofSelection& dofs);
 
         Eigen::VectorXd commands(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::VectorXd commands(const DofSelection& dofs) const;
         void set_commands(const Eigen::VectorXd& commands, const std::vector<std::string>& dof_names = {});
+        void set_commands(const Eigen::VectorXd& commands, const DofSelection& dofs);
 
         std::pair<Eigen::Vector6d, Eigen::Vector6d> force_torque(size_t joint_index) const;
 
@@ -206,23 +270,70 @@ namespace robot_dart {
         void add_body_mass(size_t body_index, double mass);
 
         Eigen::MatrixXd jacobian(const std::string& body_name, const std::vector<std::string>& dof_names = {}) const;
+        Eigen::MatrixXd jacobian(const std::string& body_name, const DofSelection& dofs) const;
         Eigen::MatrixXd jacobian_deriv(const std::string& body_name, const std::vector<std::string>& dof_names = {}) const;
+        Eigen::MatrixXd jacobian_deriv(const std::string& body_name, const DofSelection& dofs) const;
 
         Eigen::MatrixXd com_jacobian(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::MatrixXd com_jacobian(const DofSelection& dofs) const;
         Eigen::MatrixXd com_jacobian_deriv(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::MatrixXd com_jacobian_deriv(const DofSelection& dofs) const;
 
         Eigen::MatrixXd mass_matrix(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::MatrixXd mass_matrix(const DofSelection& dofs) const;
         Eigen::MatrixXd aug_mass_matrix(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::MatrixXd aug_mass_matrix(const DofSelection& dofs) const;
         Eigen::MatrixXd inv_mass_matrix(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::MatrixXd inv_mass_matrix(const DofSelection& dofs) const;
         Eigen::MatrixXd inv_aug_mass_matrix(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::MatrixXd inv_aug_mass_matrix(const DofSelection& dofs) const;
 
         Eigen::VectorXd coriolis_forces(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::VectorXd coriolis_forces(const DofSelection& dofs) const;
         Eigen::VectorXd gravity_forces(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::VectorXd gravity_forces(const DofSelection& dofs) const;
         Eigen::VectorXd coriolis_gravity_forces(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::VectorXd coriolis_gravity_forces(const DofSelection& dofs) const;
         Eigen::VectorXd constraint_forces(const std::vector<std::string>& dof_names = {}) const;
+        Eigen::VectorXd constraint_forces(const DofSelection& dofs) const;
+
+        // Allocation-free versions: `out` needs to have the size of the selection
+        // (nothing is allocated, so they can be used in control loops)
+        void positions(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const;
+        void position_lower_limits(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const;
+        void position_upper_limits(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const;
+        void velocities(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const;
+        void velocity_lower_limits(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const;
+        void velocity_upper_limits(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const;
+        void accelerations(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const;
+        void acceleration_lower_limits(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const;
+        void acceleration_upper_limits(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const;
+        void forces(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const;
+        void force_lower_limits(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const;
+        void force_upper_limits(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const;
+        void commands(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const;
+
+        void coriolis_forces(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const;
+        void gravity_forces(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const;
+        void coriolis_gravity_forces(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const;
+        void constraint_forces(Eigen::Ref<Eigen::VectorXd> out, const DofSelection& dofs) const;
+
+        // `out` is 6 x dofs.size()
+        void jacobian(Eigen::Ref<Eigen::MatrixXd> out, const std::string& body_name, const DofSelection& dofs) const;
+        void jacobian_deriv(Eigen::Ref<Eigen::MatrixXd> out, const std::string& body_name, const DofSelection& dofs) const;
+
+        // `out` is dofs.size() x dofs.size()
+        void mass_matrix(Eigen::Ref<Eigen::MatrixXd> out, const DofSelection& dofs) const;
+        void aug_mass_matrix(Eigen::Ref<Eigen::MatrixXd> out, const DofSelection& dofs) const;
+        void inv_mass_matrix(Eigen::Ref<Eigen::MatrixXd> out, const DofSelection& dofs) const;
+        void inv_aug_mass_matrix(Eigen::Ref<Eigen::MatrixXd> out, const DofSelection& dofs) const;
 
         // Get only the part of vector for DOFs in dof_names
         Eigen::VectorXd vec_dof(const Eigen::VectorXd& vec, const std::vector<std::string>& dof_names) const;
+        Eigen::VectorXd vec_dof(const Eigen::VectorXd& vec, const DofSelection& dofs) const;
+
+        /// precomputes the indices of dof_names (empty means all the DoFs)
+        DofSelection dof_selection(const std::vector<std::string>& dof_names = {}) const;
 
         void update_joint_dof_maps();
         const std::unordered_map<std::string, size_t>& dof_map() const;
@@ -288,6 +399,7 @@ namespace robot_dart {
     protected:
         std::string _get_path(const std::string& filename) const;
         dart::dynamics::SkeletonPtr _load_model(const std::string& filename, const std::vector<std::pair<std::string, std::string>>& packages = std::vector<std::pair<std::string, std::string>>(), bool is_urdf_string = false);
+        dart::dynamics::SkeletonPtr _post_load_model(const dart::dynamics::SkeletonPtr& tmp_skel);
 
         void _set_color_mode(dart::dynamics::MeshShape::ColorMode color_mode, dart::dynamics::SkeletonPtr skel);
         void _set_color_mode(dart::dynamics::MeshShape::ColorMode color_mode, dart::dynamics::ShapeNode* sn);
@@ -299,12 +411,19 @@ namespace robot_dart {
         std::vector<dart::dynamics::Joint::ActuatorType> _actuator_types() const;
 
         Eigen::MatrixXd _jacobian(const Eigen::MatrixXd& full_jacobian, const std::vector<std::string>& dof_names) const;
+        Eigen::MatrixXd _jacobian(const Eigen::MatrixXd& full_jacobian, const DofSelection& dofs) const;
         Eigen::MatrixXd _mass_matrix(const Eigen::MatrixXd& full_mass_matrix, const std::vector<std::string>& dof_names) const;
+        Eigen::MatrixXd _mass_matrix(const Eigen::MatrixXd& full_mass_matrix, const DofSelection& dofs) const;
+        void _world_jacobian(Eigen::Ref<Eigen::MatrixXd> out, const dart::dynamics::BodyNode* body_node, const dart::math::Jacobian& body_jacobian, const DofSelection& dofs) const;
+        void _mass_matrix(Eigen::Ref<Eigen::MatrixXd> out, const Eigen::MatrixXd& full_mass_matrix, const DofSelection& dofs) const;
 
         /// Function called by RobotDARTSimu object when adding the robot to the world
         virtual void _post_addition(RobotDARTSimu*) {}
         /// Function called by RobotDARTSimu object when removing the robot to the world
         virtual void _post_removal(RobotDARTSimu*) {}
+        /// Sensors refreshed by the simulation but not listed in its sensors (e.g., the banks driving the sensors of the robot)
+        void _add_internal_sensor(RobotDARTSimu* simu, const std::shared_ptr<sensor::Sensor>& sensor);
+        void _remove_internal_sensor(RobotDARTSimu* simu, const std::shared_ptr<sensor::Sensor>& sensor);
 
         friend class RobotDARTSimu;
 
@@ -313,7 +432,10 @@ namespace robot_dart {
         std::vector<std::pair<std::string, std::string>> _packages;
         dart::dynamics::SkeletonPtr _skeleton;
         std::vector<std::shared_ptr<control::RobotControl>> _controllers;
+        size_t _controllers_version = 0;
         std::unordered_map<std::string, size_t> _dof_map, _joint_map;
+        // buffers of update()
+        Eigen::VectorXd _commands, _controller_commands;
         bool _cast_shadows;
         bool _is_ghost;
         std::vector<std::pair<dart::dynamics::BodyNode*, double>> _axis_shapes;
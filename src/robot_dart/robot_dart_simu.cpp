@@ -4,6 +4,7 @@
 #include "utils_headers_dart_collision.hpp"
 #include "utils_headers_dart_dynamics.hpp"
 
+#include <algorithm>
 #include <sstream>
 
 namespace robot_dart {
@@ -25,31 +26,31 @@ namespace robot_dart {
             // This function follows DART's coding style as it needs to override a function
             bool ignoresCollision(DartCollisionConstPtr object1, DartCollisionConstPtr object2) const override
             {
-                auto shape_node1 = object1->getShapeFrame()->asShapeNode();
-                auto shape_node2 = object2->getShapeFrame()->asShapeNode();
-
-                if (dart::collision::BodyNodeCollisionFilter::ignoresCollision(object1, object2))
-                    return true;
-
-                auto shape1_iter = _bitmask_map.find(shape_node1);
-                auto shape2_iter = _bitmask_map.find(shape_node2);
-                if (shape1_iter != _bitmask_map.end() && shape2_iter != _bitmask_map.end()) {
-                    auto col_mask1 = shape1_iter->second.collision_mask;
-                    auto cat_mask1 = shape1_iter->second.category_mask;
-
-                    auto col_mask2 = shape2_iter->second.collision_mask;
-                    auto cat_mask2 = shape2_iter->second.category_mask;
-
-                    if ((col_mask1 & cat_mask2) == 0 && (col_mask2 & cat_mask1) == 0)
-                        return true;
+                // the flags and masks are cheaper to test than the adjacency of the body nodes: they are tested first
+                if (!_frames.empty()) {
+                    int index1 = _find(object1->getShapeFrame());
+                    int index2 = (index1 >= 0) ? _find(object2->getShapeFrame()) : -1;
+                    if (index2 >= 0) {
+                        uint8_t flags = _flags[index1] & _flags[index2];
+                        // none of the two bodies can move: the contact would not change anything
+                        if (flags & Static)
+                            return true;
+                        const Masks& masks1 = _masks[index1];
+                        const Masks& masks2 = _masks[index2];
+                        if ((flags & HasMasks) && (masks1.collision_mask & masks2.category_mask) == 0 && (masks2.collision_mask & masks1.category_mask) == 0)
+                            return true;
+                    }
                 }
 
-                return false;
+                return dart::collision::BodyNodeCollisionFilter::ignoresCollision(object1, object2);
             }
 
             void add_to_map(DartShapeConstPtr shape, uint32_t col_mask, uint32_t cat_mask)
             {
-                _bitmask_map[shape] = {col_mask, cat_mask};
+                size_t index = _insert(shape);
+                _masks[index].collision_mask = col_mask;
+                _masks[index].category_mask = cat_mask;
+                _flags[index] |= HasMasks;
             }
 
             void add_to_map(dart::dynamics::SkeletonPtr skel, uint32_t col_mask, uint32_t cat_mask)
@@ -62,9 +63,13 @@ namespace robot_dart {
 
             void remove_from_map(DartShapeConstPtr shape)
             {
-                auto shape_iter = _bitmask_map.find(shape);
-                if (shape_iter != _bitmask_map.end())
-                    _bitmask_map.erase(shape_iter);
+                int index = _find(shape);
+                if (index < 0)
+                    return;
+                _masks[index] = Masks();
+                _flags[index] &= ~HasMasks;
+                if (!_flags[index])
+                    _erase(index);
             }
 
             void remove_from_map(dart::dynamics::SkeletonPtr skel)
@@ -75,20 +80,120 @@ namespace robot_dart {
                 }
             }
 
-            void clear_all() { _bitmask_map.clear(); }
+            void clear_all()
+            {
+                // only the static shapes keep an entry
+                size_t count = 0;
+                for (size_t i = 0; i < _frames.size(); i++) {
+                    if (_flags[i] & Static) {
+                        _frames[count] = _frames[i];
+                        _flags[count++] = Static;
+                    }
+                }
+                _frames.resize(count);
+                _flags.resize(count);
+                _masks.assign(count, Masks());
+                _rehash();
+            }
 
             Masks mask(DartShapeConstPtr shape) const
             {
-                auto shape_iter = _bitmask_map.find(shape);
-                if (shape_iter != _bitmask_map.end())
-                    return shape_iter->second;
+                int index = _frames.empty() ? -1 : _find(shape);
+                if (index >= 0)
+                    return _masks[index];
                 return {0xffffffff, 0xffffffff};
             }
 
+            // the pairs of static shapes (that no joint can move) are ignored
+            void set_static(DartShapeConstPtr shape, bool is_static)
+            {
+                if (is_static) {
+                    _flags[_insert(shape)] |= Static;
+                    return;
+                }
+                int index = _find(shape);
+                if (index < 0)
+                    return;
+                _flags[index] &= ~Static;
+                if (!_flags[index])
+                    _erase(index);
+            }
+
         private:
-            // We need ShapeNodes and not BodyNodes, since in DART collision checking is performed in ShapeNode-level
-            // in RobotDARTSimu, we only allow setting one mask per BodyNode; maybe we can improve the performance of this slightly
-            std::unordered_map<DartShapeConstPtr, Masks> _bitmask_map;
+            enum : uint8_t {
+                HasMasks = 1,
+                Static = 2
+            };
+
+            struct Slot {
+                const dart::dynamics::ShapeFrame* frame = nullptr;
+                uint32_t index = 0;
+            };
+
+            // We need ShapeNodes and not BodyNodes, since in DART collision checking is performed in ShapeNode-level.
+            // The masks are stored in dense arrays indexed by a per-shape id; the id is found from the shape frame of the
+            // collision object in an open-addressing table (power of two size, linear probing), usually with a single probe
+            std::vector<const dart::dynamics::ShapeFrame*> _frames;
+            std::vector<Masks> _masks;
+            std::vector<uint8_t> _flags;
+            std::vector<Slot> _slots = std::vector<Slot>(16);
+
+            // slot of the shape, or the empty slot where it would be inserted
+            size_t _slot(const dart::dynamics::ShapeFrame* frame) const
+            {
+                size_t mask = _slots.size() - 1;
+                // Fibonacci hashing of the address (the low bits are always 0 because of the alignment)
+                size_t slot = static_cast<size_t>((static_cast<uint64_t>(reinterpret_cast<uintptr_t>(frame)) * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+                while (_slots[slot].frame && _slots[slot].frame != frame)
+                    slot = (slot + 1) & mask;
+                return slot;
+            }
+
+            // id of the shape (-1 if it has no entry)
+            int _find(const dart::dynamics::ShapeFrame* frame) const
+            {
+                const Slot& slot = _slots[_slot(frame)];
+                return slot.frame ? static_cast<int>(slot.index) : -1;
+            }
+
+            size_t _insert(const dart::dynamics::ShapeFrame* frame)
+            {
+                size_t slot = _slot(frame);
+                if (_slots[slot].frame)
+                    return _slots[slot].index;
+
+                _frames.push_back(frame);
+                _masks.push_back(Masks());
+                _flags.push_back(0);
+                // at most half of the slots are used (short probe sequences)
+                if (2 * _frames.size() > _slots.size())
+                    _rehash();
+                else
+                    _slots[slot] = {frame, static_cast<uint32_t>(_frames.size() - 1)};
+                return _frames.size() - 1;
+            }
+
+            void _erase(size_t index)
+            {
+                // the last shape takes the id of the removed one (the arrays stay dense); removals are rare: the table is rebuilt
+                _frames[index] = _frames.back();
+                _masks[index] = _masks.back();
+                _flags[index] = _flags.back();
+                _frames.pop_back();
+                _masks.pop_back();
+                _flags.pop_back();
+                _rehash();
+            }
+
+            void _rehash()
+            {
+                size_t size = 16;
+                while (size < 2 * _frames.size())
+                    size *= 2;
+                _slots.assign(size, Slot());
+                for (size_t i = 0; i < _frames.size(); i++)
+                    _slots[_slot(_frames[i])] = {_frames[i], static_cast<uint32_t>(i)};
+            }
         };
     } // namespace collision_filter
 
@@ -106,12 +211,18 @@ namespace robot_dart {
         _graphics = std::make_shared<gui::Base>();
 
         _gui_data.reset(new simu::GUIData());
+
+        _control_task = _scheduler.add_task(_control_freq);
+        _graphics_task = _scheduler.add_task(_graphics_freq);
     }
 
     RobotDARTSimu::~RobotDARTSimu()
     {
         _robots.clear();
-        _sensors.clear();
+        clear_sensors();
+        for (auto& sensor : _internal_sensors)
+            _remove_sensor_task(*sensor);
+        _internal_sensors.clear();
     }
 
     void RobotDARTSimu::run(double max_duration, bool reset_commands)
@@ -128,11 +239,14 @@ namespace robot_dart {
 
     bool RobotDARTSimu::step_world(bool reset_commands)
     {
-        if (_scheduler(_physics_freq))
-            _world->step(reset_commands);
+        // the physics period is one step by construction (physics_freq = round(1 / dt)): no need to ask the scheduler
+        _update_robot_states();
+        _world->step(reset_commands);
+        if (_sleeping)
+            _update_sleeping();
 
         // Update graphics
-        if (_scheduler(_graphics_freq)) {
+        if (_scheduler.due(_graphics_task)) {
             // Update default texts
             if (_text_panel) { // Need to re-transform as the size of the window might have changed
                 Eigen::Affine2d tf = Eigen::Affine2d::Identity();
@@ -154,10 +268,15 @@ namespace robot_dart {
             _graphics->refresh();
         }
 
-        // update sensors
-        for (auto& sensor : _sensors) {
-            if (sensor->active() && _scheduler(sensor->frequency())) {
+        // update sensors (only the ones that are due are visited)
+        const std::vector<size_t>& due_tasks = _scheduler.due_tasks();
+        for (size_t i = 0; i < due_tasks.size(); i++) {
+            size_t task = due_tasks[i];
+            sensor::Sensor* sensor = (task < _task_sensors.size()) ? _task_sensors[task] : nullptr;
+            if (sensor && sensor->active()) {
                 sensor->refresh(_world->getTime());
+                if (_recorder)
+                    _recorder->record(*sensor, _world->getTime());
             }
         }
 
@@ -169,7 +288,7 @@ namespace robot_dart {
 
     bool RobotDARTSimu::step(bool reset_commands)
     {
-        if (_scheduler(_control_freq)) {
+        if (_scheduler.due(_control_task)) {
             for (auto& robot : _robots) {
                 robot->update(_world->getTime());
             }
@@ -197,9 +316,8 @@ namespace robot_dart {
 
     void RobotDARTSimu::add_sensor(const std::shared_ptr<sensor::Sensor>& sensor)
     {
+        _init_sensor(sensor);
         _sensors.push_back(sensor);
-        sensor->set_simu(this);
-        sensor->init();
     }
 
     std::vector<std::shared_ptr<sensor::Sensor>> RobotDARTSimu::sensors() const
@@ -213,10 +331,51 @@ namespace robot_dart {
         return _sensors[index];
     }
 
+    std::vector<std::shared_ptr<sensor::Sensor>> RobotDARTSimu::sensors(const robot_t& robot) const
+    {
+        std::vector<std::shared_ptr<sensor::Sensor>> robot_sensors;
+        for (auto& sensor : _sensors)
+            if (sensor->attached_to_robot(robot))
+                robot_sensors.push_back(sensor);
+        return robot_sensors;
+    }
+
+    std::vector<sensor::Snapshot> RobotDARTSimu::sensor_snapshots(const robot_t& robot) const
+    {
+        std::vector<sensor::Snapshot> snapshots;
+        sensor_snapshots(robot, snapshots);
+        return snapshots;
+    }
+
+    size_t RobotDARTSimu::sensor_snapshots(const robot_t& robot, std::vector<sensor::Snapshot>& snapshots) const
+    {
+        size_t count = 0;
+        for (auto& sensor : _sensors) {
+            if (!sensor->attached_to_robot(robot))
+                continue;
+            if (snapshots.size() <= count)
+                snapshots.resize(count + 1);
+            sensor->snapshot(snapshots[count++]);
+        }
+        snapshots.resize(count);
+        return count;
+    }
+
+    void RobotDARTSimu::set_recorder(const std::shared_ptr<sensor::Recorder>& recorder)
+    {
+        _recorder = recorder;
+    }
+
+    std::shared_ptr<sensor::Recorder> RobotDARTSimu::recorder() const
+    {
+        return _recorder;
+    }
+
     void RobotDARTSimu::remove_sensor(const std::shared_ptr<sensor::Sensor>& sensor)
     {
         auto it = std::find(_sensors.begin(), _sensors.end(), sensor);
         if (it != _sensors.end()) {
+            _remove_sensor_task(**it);
             _sensors.erase(it);
         }
     }
@@ -224,6 +383,7 @@ namespace robot_dart {
     void RobotDARTSimu::remove_sensor(size_t index)
     {
         ROBOT_DART_ASSERT(index < _sensors.size(), "Sensor index out of bounds", );
+        _remove_sensor_task(*_sensors[index]);
         _sensors.erase(_sensors.begin() + index);
     }
 
@@ -232,6 +392,7 @@ namespace robot_dart {
         for (int i = 0; i < static_cast<int>(_sensors.size()); i++) {
             auto& sensor = _sensors[i];
             if (sensor->type() == type) {
+                _remove_sensor_task(*sensor);
                 _sensors.erase(_sensors.begin() + i);
                 i--;
             }
@@ -240,9 +401,60 @@ namespace robot_dart {
 
     void RobotDARTSimu::clear_sensors()
     {
+        for (auto& sensor : _sensors)
+            _remove_sensor_task(*sensor);
         _sensors.clear();
     }
 
+    void RobotDARTSimu::_init_sensor(const std::shared_ptr<sensor::Sensor>& sensor)
+    {
+        // the sensors refreshed by a bank have no task (the simulation only gives access to them);
+        // the task is added first because the frequency might be too high for the time-step
+        size_t task = 0;
+        if (!sensor->_driven)
+            task = _scheduler.add_task(sensor->frequency());
+
+        sensor->set_simu(this);
+        sensor->init();
+        sensor->_init_snapshot();
+
+        if (sensor->_driven)
+            return;
+
+        if (_task_sensors.size() <= task)
+            _task_sensors.resize(task + 1, nullptr);
+        _task_sensors[task] = sensor.get();
+        sensor->_scheduler_task = static_cast<int>(task);
+    }
+
+    void RobotDARTSimu::_remove_sensor_task(sensor::Sensor& sensor)
+    {
+        // a bank does not refresh the sensors that were removed from the simulation
+        if (sensor._driven)
+            sensor._simu = nullptr;
+        if (sensor._scheduler_task < 0)
+            return;
+        size_t task = static_cast<size_t>(sensor._scheduler_task);
+        _scheduler.remove_task(task);
+        _task_sensors[task] = nullptr;
+        sensor._scheduler_task = -1;
+    }
+
+    void RobotDARTSimu::_add_internal_sensor(const std::shared_ptr<sensor::Sensor>& sensor)
+    {
+        _init_sensor(sensor);
+        _internal_sensors.push_back(sensor);
+    }
+
+    void RobotDARTSimu::_remove_internal_sensor(const std::shared_ptr<sensor::Sensor>& sensor)
+    {
+        auto it = std::find(_internal_sensors.begin(), _internal_sensors.end(), sensor);
+        if (it != _internal_sensors.end()) {
+            _remove_sensor_task(**it);
+            _internal_sensors.erase(it);
+        }
+    }
+
     double RobotDARTSimu::timestep() const
     {
         return _world->getTimeStep();
@@ -250,12 +462,16 @@ namespace robot_dart {
 
     void RobotDARTSimu::set_timestep(double timestep, bool update_control_freq)
     {
-        _world->setTimeStep(timestep);
-        _physics_freq = std::round(1. / timestep);
-        if (update_control_freq)
-            _control_freq = _physics_freq;
+        int physics_freq = std::round(1. / timestep);
+        int control_freq = update_control_freq ? physics_freq : _control_freq;
+
+        // the control period is changed with dt (the old one might not be valid with the new dt);
+        // nothing is changed if a task is too fast for the new dt
+        _scheduler.set_dt(timestep, {{_control_task, static_cast<double>(control_freq)}});
 
-        _scheduler.reset(timestep, _scheduler.sync(), _scheduler.current_time(), _scheduler.real_time());
+        _world->setTimeStep(timestep);
+        _physics_freq = physics_freq;
+        _control_freq = control_freq;
     }
 
     Eigen::Vector3d RobotDARTSimu::gravity() const
@@ -347,6 +563,7 @@ namespace robot_dart {
     {
         auto it = std::find(_robots.begin(), _robots.end(), robot);
         if (it != _robots.end()) {
+            _remove_robot_state(robot);
             robot->_post_removal(this);
             _gui_data->remove_robot(robot);
             _world->removeSkeleton(robot->skeleton());
@@ -357,6 +574,7 @@ namespace robot_dart {
     void RobotDARTSimu::remove_robot(size_t index)
     {
         ROBOT_DART_ASSERT(index < _robots.size(), "Robot index out of bounds", );
+        _remove_robot_state(_robots[index]);
         _robots[index]->_post_removal(this);
         _gui_data->remove_robot(_robots[index]);
         _world->removeSkeleton(_robots[index]->skeleton());
@@ -366,6 +584,7 @@ namespace robot_dart {
     void RobotDARTSimu::clear_robots()
     {
         for (auto& robot : _robots) {
+            _remove_robot_state(robot);
             robot->_post_removal(this);
             _gui_data->remove_robot(robot);
             _world->removeSkeleton(robot->skeleton());
@@ -550,7 +769,8 @@ namespace robot_dart {
     void RobotDARTSimu::set_collision_masks(size_t robot_index, uint32_t category_mask, uint32_t collision_mask)
     {
         ROBOT_DART_ASSERT(robot_index < _robots.size(), "Robot index out of bounds", );
-        auto coll_filter = std::static_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        auto coll_filter = std::dynamic_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        ROBOT_DART_ASSERT(coll_filter, "The collision filter is not a BitmaskContactFilter!", );
         coll_filter->add_to_map(_robots[robot_index]->skeleton(), collision_mask, category_mask);
     }
 
@@ -559,7 +779,8 @@ namespace robot_dart {
         ROBOT_DART_ASSERT(robot_index < _robots.size(), "Robot index out of bounds", );
         auto bd = _robots[robot_index]->skeleton()->getBodyNode(body_name);
         ROBOT_DART_ASSERT(bd != nullptr, "BodyNode does not exist in skeleton!", );
-        auto coll_filter = std::static_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        auto coll_filter = std::dynamic_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        ROBOT_DART_ASSERT(coll_filter, "The collision filter is not a BitmaskContactFilter!", );
         for (auto& shape : bd->getShapeNodes())
             coll_filter->add_to_map(shape, collision_mask, category_mask);
     }
@@ -570,7 +791,8 @@ namespace robot_dart {
         auto skel = _robots[robot_index]->skeleton();
         ROBOT_DART_ASSERT(body_index < skel->getNumBodyNodes(), "BodyNode index out of bounds", );
         auto bd = skel->getBodyNode(body_index);
-        auto coll_filter = std::static_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        auto coll_filter = std::dynamic_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        ROBOT_DART_ASSERT(coll_filter, "The collision filter is not a BitmaskContactFilter!", );
         for (auto& shape : bd->getShapeNodes())
             coll_filter->add_to_map(shape, collision_mask, category_mask);
     }
@@ -580,7 +802,8 @@ namespace robot_dart {
         ROBOT_DART_ASSERT(robot_index < _robots.size(), "Robot index out of bounds", 0xffffffff);
         auto bd = _robots[robot_index]->skeleton()->getBodyNode(body_name);
         ROBOT_DART_ASSERT(bd != nullptr, "BodyNode does not exist in skeleton!", 0xffffffff);
-        auto coll_filter = std::static_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        auto coll_filter = std::dynamic_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        ROBOT_DART_ASSERT(coll_filter, "The collision filter is not a BitmaskContactFilter!", 0xffffffff);
 
         uint32_t mask = 0xffffffff;
         for (auto& shape : bd->getShapeNodes())
@@ -595,7 +818,8 @@ namespace robot_dart {
         auto skel = _robots[robot_index]->skeleton();
         ROBOT_DART_ASSERT(body_index < skel->getNumBodyNodes(), "BodyNode index out of bounds", 0xffffffff);
         auto bd = skel->getBodyNode(body_index);
-        auto coll_filter = std::static_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        auto coll_filter = std::dynamic_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        ROBOT_DART_ASSERT(coll_filter, "The collision filter is not a BitmaskContactFilter!", 0xffffffff);
 
         uint32_t mask = 0xffffffff;
         for (auto& shape : bd->getShapeNodes())
@@ -609,7 +833,8 @@ namespace robot_dart {
         ROBOT_DART_ASSERT(robot_index < _robots.size(), "Robot index out of bounds", 0xffffffff);
         auto bd = _robots[robot_index]->skeleton()->getBodyNode(body_name);
         ROBOT_DART_ASSERT(bd != nullptr, "BodyNode does not exist in skeleton!", 0xffffffff);
-        auto coll_filter = std::static_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        auto coll_filter = std::dynamic_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        ROBOT_DART_ASSERT(coll_filter, "The collision filter is not a BitmaskContactFilter!", 0xffffffff);
 
         uint32_t mask = 0xffffffff;
         for (auto& shape : bd->getShapeNodes())
@@ -624,7 +849,8 @@ namespace robot_dart {
         auto skel = _robots[robot_index]->skeleton();
         ROBOT_DART_ASSERT(body_index < skel->getNumBodyNodes(), "BodyNode index out of bounds", 0xffffffff);
         auto bd = skel->getBodyNode(body_index);
-        auto coll_filter = std::static_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        auto coll_filter = std::dynamic_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        ROBOT_DART_ASSERT(coll_filter, "The collision filter is not a BitmaskContactFilter!", 0xffffffff);
 
         uint32_t mask = 0xffffffff;
         for (auto& shape : bd->getShapeNodes())
@@ -639,7 +865,8 @@ namespace robot_dart {
         ROBOT_DART_ASSERT(robot_index < _robots.size(), "Robot index out of bounds", mask);
         auto bd = _robots[robot_index]->skeleton()->getBodyNode(body_name);
         ROBOT_DART_ASSERT(bd != nullptr, "BodyNode does not exist in skeleton!", mask);
-        auto coll_filter = std::static_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        auto coll_filter = std::dynamic_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        ROBOT_DART_ASSERT(coll_filter, "The collision filter is not a BitmaskContactFilter!", mask);
 
         for (auto& shape : bd->getShapeNodes()) {
             mask.first &= coll_filter->mask(shape).collision_mask;
@@ -656,7 +883,8 @@ namespace robot_dart {
         auto skel = _robots[robot_index]->skeleton();
         ROBOT_DART_ASSERT(body_index < skel->getNumBodyNodes(), "BodyNode index out of bounds", mask);
         auto bd = skel->getBodyNode(body_index);
-        auto coll_filter = std::static_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        auto coll_filter = std::dynamic_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        ROBOT_DART_ASSERT(coll_filter, "The collision filter is not a BitmaskContactFilter!", mask);
 
         for (auto& shape : bd->getShapeNodes()) {
             mask.first &= coll_filter->mask(shape).collision_mask;
@@ -669,7 +897,8 @@ namespace robot_dart {
     void RobotDARTSimu::remove_collision_masks(size_t robot_index)
     {
         ROBOT_DART_ASSERT(robot_index < _robots.size(), "Robot index out of bounds", );
-        auto coll_filter = std::static_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        auto coll_filter = std::dynamic_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        ROBOT_DART_ASSERT(coll_filter, "The collision filter is not a BitmaskContactFilter!", );
         coll_filter->remove_from_map(_robots[robot_index]->skeleton());
     }
 
@@ -678,7 +907,8 @@ namespace robot_dart {
         ROBOT_DART_ASSERT(robot_index < _robots.size(), "Robot index out of bounds", );
         auto bd = _robots[robot_index]->skeleton()->getBodyNode(body_name);
         ROBOT_DART_ASSERT(bd != nullptr, "BodyNode does not exist in skeleton!", );
-        auto coll_filter = std::static_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        auto coll_filter = std::dynamic_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        ROBOT_DART_ASSERT(coll_filter, "The collision filter is not a BitmaskContactFilter!", );
         for (auto& shape : bd->getShapeNodes())
             coll_filter->remove_from_map(shape);
     }
@@ -689,14 +919,199 @@ namespace robot_dart {
         auto skel = _robots[robot_index]->skeleton();
         ROBOT_DART_ASSERT(body_index < skel->getNumBodyNodes(), "BodyNode index out of bounds", );
         auto bd = skel->getBodyNode(body_index);
-        auto coll_filter = std::static_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        auto coll_filter = std::dynamic_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        ROBOT_DART_ASSERT(coll_filter, "The collision filter is not a BitmaskContactFilter!", );
         for (auto& shape : bd->getShapeNodes())
             coll_filter->remove_from_map(shape);
     }
 
     void RobotDARTSimu::remove_all_collision_masks()
     {
-        auto coll_filter = std::static_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        auto coll_filter = std::dynamic_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        ROBOT_DART_ASSERT(coll_filter, "The collision filter is not a BitmaskContactFilter!", );
         coll_filter->clear_all();
     }
+
+    void RobotDARTSimu::set_static_pruning(bool enable)
+    {
+        _static_pruning = enable;
+        for (auto& state : _robot_states)
+            state.refresh = true;
+    }
+
+    void RobotDARTSimu::enable_sleeping(bool enable, double velocity_threshold, size_t steps)
+    {
+        if (!enable)
+            wake_up_all();
+        _sleeping = enable;
+        _sleep_velocity = velocity_threshold;
+        _sleep_steps = steps;
+    }
+
+    bool RobotDARTSimu::sleeping(size_t robot_index) const
+    {
+        ROBOT_DART_ASSERT(robot_index < _robots.size(), "Robot index out of bounds", false);
+        auto it = _robot_state_indices.find(_robots[robot_index]->skeleton().get());
+        return it != _robot_state_indices.end() && _robot_states[it->second].sleeping;
+    }
+
+    size_t RobotDARTSimu::num_sleeping_robots() const
+    {
+        return std::count_if(_robot_states.begin(), _robot_states.end(), [](const RobotState& state) { return state.sleeping; });
+    }
+
+    void RobotDARTSimu::wake_up(size_t robot_index)
+    {
+        ROBOT_DART_ASSERT(robot_index < _robots.size(), "Robot index out of bounds", );
+        auto it = _robot_state_indices.find(_robots[robot_index]->skeleton().get());
+        if (it != _robot_state_indices.end())
+            _sleep(it->second, false);
+    }
+
+    void RobotDARTSimu::wake_up_all()
+    {
+        for (auto& index : _robot_state_indices)
+            _sleep(index.second, false);
+    }
+
+    void RobotDARTSimu::_update_robot_states()
+    {
+        // the states follow the robots (rebuilt when robots are added or removed)
+        bool rebuild = (_robot_states.size() != _robots.size());
+        for (size_t i = 0; i < _robots.size() && !rebuild; i++)
+            rebuild = (_robot_states[i].skeleton != _robots[i]->skeleton().get());
+
+        if (rebuild) {
+            std::vector<RobotState> states(_robots.size());
+            for (size_t i = 0; i < _robots.size(); i++) {
+                auto it = _robot_state_indices.find(_robots[i]->skeleton().get());
+                if (it != _robot_state_indices.end())
+                    states[i] = _robot_states[it->second];
+                states[i].skeleton = _robots[i]->skeleton().get();
+                states[i].refresh = true;
+            }
+            _robot_states = std::move(states);
+
+            _robot_state_indices.clear();
+            for (size_t i = 0; i < _robot_states.size(); i++)
+                _robot_state_indices[_robot_states[i].skeleton] = i;
+        }
+
+        // static shapes: the ones of immobile skeletons and of the bodies that no joint moves (e.g., fixed bases)
+        // (the filter is only looked up when a robot changed; a filter set by the user gets no static flags)
+        std::shared_ptr<collision_filter::BitmaskContactFilter> coll_filter;
+        bool filter_checked = false;
+        for (size_t i = 0; i < _robots.size(); i++) {
+            RobotState& state = _robot_states[i];
+            dart::dynamics::Skeleton* skel = state.skeleton;
+            bool mobile = skel->isMobile();
+            size_t num_dofs = skel->getNumDofs(), num_shapes = skel->getNumShapeNodes();
+            if (!state.refresh && state.mobile == mobile && state.num_dofs == num_dofs && state.num_shapes == num_shapes)
+                continue;
+
+            state.refresh = false;
+            state.mobile = mobile;
+            state.num_dofs = num_dofs;
+            state.num_shapes = num_shapes;
+            if (!filter_checked) {
+                coll_filter = std::dynamic_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+                filter_checked = true;
+            }
+            if (!coll_filter)
+                continue;
+            for (size_t s = 0; s < num_shapes; s++) {
+                auto shape = skel->getShapeNode(s);
+                coll_filter->set_static(shape, _static_pruning && (!mobile || shape->getBodyNodePtr()->getNumDependentGenCoords() == 0));
+            }
+        }
+    }
+
+    int RobotDARTSimu::_island_member(const dart::collision::CollisionObject* object) const
+    {
+        auto shape = object->getShapeFrame()->asShapeNode();
+        if (!shape)
+            return -1;
+        auto it = _robot_state_indices.find(shape->getSkeleton().get());
+        if (it == _robot_state_indices.end())
+            return -1;
+
+        // the static robots (and the ones made immobile by the user) are not part of the islands
+        const RobotState& state = _robot_states[it->second];
+        if (state.num_dofs == 0 || (!state.mobile && !state.sleeping))
+            return -1;
+        return static_cast<int>(it->second);
+    }
+
+    void RobotDARTSimu::_update_sleeping()
+    {
+        // the robots in contact form islands that sleep and wake up together
+        size_t n = _robot_states.size();
+        _islands.resize(n);
+        for (size_t i = 0; i < n; i++)
+            _islands[i] = i;
+        auto root = [this](size_t i) {
+            while (_islands[i] != i)
+                i = _islands[i] = _islands[_islands[i]];
+            return i;
+        };
+
+        const dart::collision::CollisionResult& result = _world->getLastCollisionResult();
+        for (size_t c = 0; c < result.getNumContacts(); c++) {
+            const dart::collision::Contact& contact = result.getContact(c);
+            int i1 = _island_member(contact.collisionObject1);
+            int i2 = (i1 >= 0) ? _island_member(contact.collisionObject2) : -1;
+            if (i2 >= 0)
+                _islands[root(i1)] = root(i2);
+        }
+
+        // an island is moving if one of its awake robots moved during the last steps (or has controllers)
+        _island_moving.assign(n, 0);
+        for (size_t i = 0; i < n; i++) {
+            RobotState& state = _robot_states[i];
+            if (state.sleeping || !state.mobile || state.num_dofs == 0)
+                continue;
+
+            bool still = (_robots[i]->num_controllers() == 0);
+            for (size_t d = 0; d < state.num_dofs && still; d++)
+                still = (std::abs(state.skeleton->getVelocity(d)) < _sleep_velocity);
+            state.still_steps = still ? state.still_steps + 1 : 0;
+            if (state.still_steps < _sleep_steps)
+                _island_moving[root(i)] = 1;
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            RobotState& state = _robot_states[i];
+            if (state.num_dofs == 0 || (!state.mobile && !state.sleeping))
+                continue;
+            _sleep(i, !_island_moving[root(i)]);
+        }
+    }
+
+    void RobotDARTSimu::_sleep(size_t index, bool sleep)
+    {
+        RobotState& state = _robot_states[index];
+        if (state.sleeping == sleep)
+            return;
+
+        // the skeleton keeps its state while it sleeps (immobile skeletons are not integrated)
+        if (sleep)
+            state.skeleton->resetVelocities();
+        state.skeleton->setMobile(!sleep);
+        state.sleeping = sleep;
+        state.still_steps = 0;
+    }
+
+    void RobotDARTSimu::_remove_robot_state(const robot_t& robot)
+    {
+        auto it = _robot_state_indices.find(robot->skeleton().get());
+        if (it == _robot_state_indices.end())
+            return;
+
+        // the robot leaves the simulation awake and without static shapes (the filter may see other shapes at these addresses)
+        _sleep(it->second, false);
+        auto coll_filter = std::dynamic_pointer_cast<collision_filter::BitmaskContactFilter>(_world->getConstraintSolver()->getCollisionOption().collisionFilter);
+        for (size_t s = 0; coll_filter && s < robot->skeleton()->getNumShapeNodes(); s++)
+            coll_filter->set_static(robot->skeleton()->getShapeNode(s), false);
+        _robot_state_indices.erase(it);
+    }
 } // namespace robot_dart
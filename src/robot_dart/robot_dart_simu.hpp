@@ -4,8 +4,11 @@
 #include <robot_dart/gui/base.hpp>
 #include <robot_dart/robot.hpp>
 #include <robot_dart/scheduler.hpp>
+#include <robot_dart/sensor/recorder.hpp>
 #include <robot_dart/sensor/sensor.hpp>
 
+#include <unordered_map>
+
 namespace robot_dart {
     namespace simu {
         struct GUIData;
@@ -47,6 +50,7 @@ namespace robot_dart {
             ROBOT_DART_EXCEPTION_INTERNAL_ASSERT(
                 frequency <= _physics_freq && "Control frequency needs to be less than physics frequency");
             _control_freq = frequency;
+            _scheduler.set_task_frequency(_control_task, frequency);
         }
 
         int graphics_freq() const { return _graphics_freq; }
@@ -56,6 +60,7 @@ namespace robot_dart {
             ROBOT_DART_EXCEPTION_INTERNAL_ASSERT(
                 frequency <= _physics_freq && "Graphics frequency needs to be less than physics frequency");
             _graphics_freq = frequency;
+            _scheduler.set_task_frequency(_graphics_task, frequency);
             _graphics->set_fps(_graphics_freq);
         }
 
@@ -71,9 +76,24 @@ namespace robot_dart {
             return std::static_pointer_cast<T>(_sensors.back());
         }
 
+        // the sensors of a bank (sensor::Sensor::driven()) are listed with the others but only refreshed by their bank
+        // (until they are removed from the simulation)
         void add_sensor(const std::shared_ptr<sensor::Sensor>& sensor);
         std::vector<std::shared_ptr<sensor::Sensor>> sensors() const;
         std::shared_ptr<sensor::Sensor> sensor(size_t index) const;
+        // sensors measuring a body or a joint of the robot
+        std::vector<std::shared_ptr<sensor::Sensor>> sensors(const robot_t& robot) const;
+
+        // Snapshots of all the sensors of the robot (in the order of sensors(robot)), safe to call from any thread
+        // while the simulation steps (but not while sensors are added or removed). Each snapshot is consistent and
+        // timestamped; snapshots of sensors with different frequencies can have different times.
+        std::vector<sensor::Snapshot> sensor_snapshots(const robot_t& robot) const;
+        // no allocation when `snapshots` comes from a previous call; returns the number of snapshots
+        size_t sensor_snapshots(const robot_t& robot, std::vector<sensor::Snapshot>& snapshots) const;
+
+        // the recorder gets the readings of its sensors after each of their refreshes (nullptr to detach it)
+        void set_recorder(const std::shared_ptr<sensor::Recorder>& recorder);
+        std::shared_ptr<sensor::Recorder> recorder() const;
 
         void remove_sensor(const std::shared_ptr<sensor::Sensor>& sensor);
         void remove_sensor(size_t index);
@@ -137,14 +157,56 @@ namespace robot_dart {
 
         void remove_all_collision_masks();
 
+        // Static pruning (disabled by default): the pairs of static bodies (that no joint can move, e.g., floors and fixed boxes,
+        // or that sleep) are not tested for collisions: the collision filter rejects them before the narrowphase.
+        // It has no effect if the collision filter of the world is replaced by a user one.
+        void set_static_pruning(bool enable = true);
+        bool static_pruning() const { return _static_pruning; }
+
+        // Sleeping (disabled by default): the islands of robots in contact whose velocities stay under `velocity_threshold`
+        // for `steps` physics steps are not simulated (their skeletons are immobile) until a moving robot touches them.
+        // The robots with controllers never sleep; call wake_up() after moving or pushing a sleeping robot from the code.
+        void enable_sleeping(bool enable = true, double velocity_threshold = 1e-3, size_t steps = 60);
+        bool sleeping_enabled() const { return _sleeping; }
+        bool sleeping(size_t robot_index) const;
+        size_t num_sleeping_robots() const;
+        void wake_up(size_t robot_index);
+        void wake_up_all();
+
     protected:
+        // what is known of each robot for the static pruning and the sleeping (same order as _robots)
+        struct RobotState {
+            dart::dynamics::Skeleton* skeleton = nullptr;
+            // the static flags of the shapes are refreshed when these change
+            bool mobile = true, refresh = true;
+            size_t num_dofs = 0, num_shapes = 0;
+            size_t still_steps = 0;
+            bool sleeping = false;
+        };
+
+        void _update_robot_states();
+        void _update_sleeping();
+        int _island_member(const dart::collision::CollisionObject* object) const;
+        void _sleep(size_t index, bool sleep);
+        void _remove_robot_state(const robot_t& robot);
+
         void _enable(std::shared_ptr<simu::TextData>& text, bool enable, double font_size);
+        // gives the sensor to the simulation and adds its task (if it is not driven by a bank)
+        void _init_sensor(const std::shared_ptr<sensor::Sensor>& sensor);
+        void _remove_sensor_task(sensor::Sensor& sensor);
+
+        // sensors refreshed by the simulation but owned by a robot and not listed in sensors() (e.g., the banks of Talos)
+        friend class Robot;
+        void _add_internal_sensor(const std::shared_ptr<sensor::Sensor>& sensor);
+        void _remove_internal_sensor(const std::shared_ptr<sensor::Sensor>& sensor);
 
         dart::simulation::WorldPtr _world;
         size_t _old_index;
         bool _break;
 
         std::vector<std::shared_ptr<sensor::Sensor>> _sensors;
+        std::vector<std::shared_ptr<sensor::Sensor>> _internal_sensors;
+        std::shared_ptr<sensor::Recorder> _recorder;
         std::vector<robot_t> _robots;
         std::shared_ptr<gui::Base> _graphics;
         std::unique_ptr<simu::GUIData> _gui_data;
@@ -153,6 +215,19 @@ namespace robot_dart {
 
         Scheduler _scheduler;
         int _physics_freq = -1, _control_freq = -1, _graphics_freq = 40;
+        // the control, the graphics and each sensor are tasks of the scheduler
+        size_t _control_task, _graphics_task;
+        std::vector<sensor::Sensor*> _task_sensors; // indexed by task id (nullptr if the task is not a sensor)
+
+        bool _static_pruning = false;
+        bool _sleeping = false;
+        double _sleep_velocity = 1e-3;
+        size_t _sleep_steps = 60;
+        std::vector<RobotState> _robot_states;
+        std::unordered_map<const dart::dynamics::Skeleton*, size_t> _robot_state_indices;
+        // scratch of _update_sleeping() (union-find of the islands)
+        std::vector<size_t> _islands;
+        std::vector<char> _island_moving;
     };
 } // namespace robot_dart
 
@@ -1,56 +1,245 @@
 #include <robot_dart/robot_pool.hpp>
+#include <robot_dart/thread_pool.hpp>
+
+#include <algorithm>
+#include <chrono>
 
 namespace robot_dart {
-    RobotPool::RobotPool(const std::function<std::shared_ptr<Robot>()>& robot_creator, size_t pool_size, bool verbose) : _robot_creator(robot_creator), _pool_size(pool_size), _verbose(verbose)
+    namespace detail {
+        // the robots given by the pool remember where their skeleton lives in the pool
+        class PooledRobot : public Robot {
+        public:
+            PooledRobot(dart::dynamics::SkeletonPtr skeleton, const std::string& robot_name, size_t pool_index) : Robot(skeleton, robot_name), _pool_index(pool_index) {}
+
+            size_t pool_index() const { return _pool_index; }
+
+        protected:
+            size_t _pool_index;
+        };
+    } // namespace detail
+
+    constexpr uint32_t RobotPool::_npos;
+
+    RobotPool::RobotPool(const robot_creator_t& robot_creator, size_t pool_size, bool verbose, size_t num_threads, size_t max_pool_size) : _robot_creator(robot_creator), _pool_size(0), _num_reserved(pool_size), _max_pool_size(std::max(pool_size, max_pool_size)), _verbose(verbose), _num_failed(0), _free_head(_npos), _num_free(0), _waiters(0)
     {
+        ROBOT_DART_EXCEPTION_ASSERT(_max_pool_size < _npos, "RobotPool: pool size is too big!");
+
+        // everything is allocated for the maximum size so that growing never moves memory
+        _skeletons.resize(_max_pool_size);
+        _build_times.resize(_max_pool_size, 0.);
+        _next.reset(new std::atomic<uint32_t>[_max_pool_size]);
+        _free.reset(new std::atomic<bool>[_max_pool_size]);
+        _built.reset(new std::atomic<bool>[_max_pool_size]);
+        for (size_t i = 0; i < _max_pool_size; i++) {
+            _next[i].store(_npos);
+            _free[i].store(false);
+            _built[i].store(false);
+        }
+
         if (_verbose) {
-            std::cout << "Creating a pool of " << pool_size << " robots: ";
+            std::cout << "Creating a pool of " << pool_size << " robots";
+            if (_max_pool_size > pool_size)
+                std::cout << " (up to " << _max_pool_size << ")";
+            std::cout << ": ";
             std::cout.flush();
         }
 
-        for (size_t i = 0; i < _pool_size; ++i) {
-            if (_verbose) {
-                std::cout << "[" << i << "]";
-                std::cout.flush();
-            }
-            auto robot = robot_creator();
-            _model_filename = robot->model_filename();
-            _reset_robot(robot);
-            _skeletons.push_back(robot->skeleton());
+        auto start = std::chrono::steady_clock::now();
+        {
+            if (num_threads == 0)
+                num_threads = std::max(1u, std::thread::hardware_concurrency());
+            ThreadPool threads(std::max<size_t>(1, std::min(num_threads, pool_size)));
+            threads.parallel_for(pool_size, [this](size_t i) { _build_robot(i); });
         }
-        for (size_t i = 0; i < _pool_size; i++)
-            _free.push_back(true);
+        auto end = std::chrono::steady_clock::now();
+
+        // push in reverse order so that the first robot is given first
+        for (size_t i = pool_size; i > 0; i--)
+            _push(static_cast<uint32_t>(i - 1));
 
         if (_verbose)
-            std::cout << std::endl;
+            std::cout << std::endl
+                      << "Pool created in " << std::chrono::duration<double>(end - start).count() << "s" << std::endl;
     }
 
     std::shared_ptr<Robot> RobotPool::get_robot(const std::string& name)
     {
-        while (true) {
-            std::lock_guard<std::mutex> lock(_skeleton_mutex);
-            for (size_t i = 0; i < _pool_size; i++)
-                if (_free[i]) {
-                    _free[i] = false;
-                    return std::make_shared<Robot>(_skeletons[i], name);
-                }
+        uint32_t index;
+        while (!_pop(index) && !_grow(index)) {
+            // the pool is empty and full-size: sleep until a robot is given back
+            // or until a growth failed (its slot can be built again by this thread)
+            std::unique_lock<std::mutex> lock(_wait_mutex);
+            _waiters.fetch_add(1);
+            bool popped = false;
+            _wait_cv.wait(lock, [&] { popped = _pop(index); return popped || _num_failed.load() > 0; });
+            _waiters.fetch_sub(1);
+            if (popped)
+                break;
         }
+
+        return _make_robot(index, name);
+    }
+
+    std::shared_ptr<Robot> RobotPool::try_get_robot(const std::string& name)
+    {
+        uint32_t index;
+        if (!_pop(index))
+            return nullptr;
+        return _make_robot(index, name);
     }
 
     void RobotPool::free_robot(const std::shared_ptr<Robot>& robot)
     {
-        std::lock_guard<std::mutex> lock(_skeleton_mutex);
-        for (size_t i = 0; i < _pool_size; i++) {
-            if (_skeletons[i] == robot->skeleton()) {
-                _reset_robot(robot);
-                _free[i] = true;
-                break;
-            }
+        size_t index = _index_of(robot);
+        ROBOT_DART_ASSERT(index < _max_pool_size && _built[index].load(), "RobotPool: this robot does not belong to the pool", );
+
+        bool was_free = _free[index].exchange(true);
+        ROBOT_DART_ASSERT(!was_free, "RobotPool: this robot is already free", );
+        _reset_robot(robot);
+        _push(static_cast<uint32_t>(index));
+
+        if (_waiters.load() > 0) {
+            // taking the lock makes sure that the waiter is either sleeping or has not checked yet
+            std::lock_guard<std::mutex> lock(_wait_mutex);
+            _wait_cv.notify_one();
         }
     }
 
+    std::vector<double> RobotPool::build_times() const
+    {
+        std::lock_guard<std::mutex> lock(_grow_mutex);
+        std::vector<double> times;
+        for (size_t i = 0; i < _max_pool_size; i++)
+            if (_built[i].load())
+                times.push_back(_build_times[i]);
+        return times;
+    }
+
     void RobotPool::_reset_robot(const std::shared_ptr<Robot>& robot)
     {
         robot->reset();
     }
+
+    void RobotPool::_build_robot(size_t index)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto robot = _robot_creator();
+        _reset_robot(robot);
+        double build_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(_grow_mutex);
+        _skeletons[index] = robot->skeleton();
+        _build_times[index] = build_time;
+        if (_model_filename.empty())
+            _model_filename = robot->model_filename();
+
+        if (_verbose) {
+            std::cout << "[" << index << ": " << build_time << "s]";
+            std::cout.flush();
+        }
+        _built[index].store(true);
+        _pool_size.fetch_add(1);
+    }
+
+    bool RobotPool::_grow(uint32_t& index)
+    {
+        // a slot is reserved (a slot that failed before first), its robot is built without holding any lock
+        // and it goes to this thread
+        uint32_t slot = _npos;
+        {
+            std::lock_guard<std::mutex> lock(_grow_mutex);
+            if (!_failed_slots.empty()) {
+                slot = _failed_slots.back();
+                _failed_slots.pop_back();
+                _num_failed.fetch_sub(1);
+            }
+        }
+        if (slot == _npos) {
+            size_t reserved = _num_reserved.load();
+            do {
+                if (reserved >= _max_pool_size)
+                    return false;
+            } while (!_num_reserved.compare_exchange_weak(reserved, reserved + 1));
+            slot = static_cast<uint32_t>(reserved);
+        }
+
+        if (_verbose)
+            std::cout << "Growing the robot pool: ";
+        try {
+            _build_robot(slot);
+        }
+        catch (...) {
+            // the slot is cleared for the next attempt
+            {
+                std::lock_guard<std::mutex> lock(_grow_mutex);
+                _skeletons[slot] = nullptr;
+                _build_times[slot] = 0.;
+                _failed_slots.push_back(slot);
+                _num_failed.fetch_add(1);
+            }
+            // the threads waiting for a robot can build it again
+            if (_waiters.load() > 0) {
+                std::lock_guard<std::mutex> lock(_wait_mutex);
+                _wait_cv.notify_all();
+            }
+            throw;
+        }
+        if (_verbose)
+            std::cout << std::endl;
+
+        index = slot;
+        return true;
+    }
+
+    bool RobotPool::_pop(uint32_t& index)
+    {
+        uint64_t head = _free_head.load();
+        while (true) {
+            uint32_t top = static_cast<uint32_t>(head & 0xffffffff);
+            if (top == _npos)
+                return false;
+            uint64_t tag = (head >> 32) + 1;
+            uint64_t new_head = (tag << 32) | _next[top].load();
+            if (_free_head.compare_exchange_weak(head, new_head)) {
+                index = top;
+                _free[index].store(false);
+                _num_free.fetch_sub(1);
+                return true;
+            }
+        }
+    }
+
+    void RobotPool::_push(uint32_t index)
+    {
+        _free[index].store(true);
+        _num_free.fetch_add(1);
+        uint64_t head = _free_head.load();
+        while (true) {
+            _next[index].store(static_cast<uint32_t>(head & 0xffffffff));
+            uint64_t tag = (head >> 32) + 1;
+            uint64_t new_head = (tag << 32) | index;
+            if (_free_head.compare_exchange_weak(head, new_head))
+                return;
+        }
+    }
+
+    size_t RobotPool::_index_of(const std::shared_ptr<Robot>& robot) const
+    {
+        // O(1) for robots given by the pool
+        auto pooled = dynamic_cast<const detail::PooledRobot*>(robot.get());
+        if (pooled && pooled->pool_index() < _max_pool_size && _built[pooled->pool_index()].load() && _skeletons[pooled->pool_index()] == robot->skeleton())
+            return pooled->pool_index();
+
+        // the user might have wrapped the skeleton in another Robot (the robots being built are not published yet)
+        std::lock_guard<std::mutex> lock(_grow_mutex);
+        for (size_t i = 0; i < _max_pool_size; i++)
+            if (_skeletons[i] == robot->skeleton())
+                return i;
+        return _npos;
+    }
+
+    std::shared_ptr<Robot> RobotPool::_make_robot(uint32_t index, const std::string& name)
+    {
+        return std::make_shared<detail::PooledRobot>(_skeletons[index], name, index);
+    }
 } // namespace robot_dart
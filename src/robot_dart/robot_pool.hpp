@@ -1,6 +1,8 @@
 #ifndef ROBOT_DART_ROBOT_POOL
 #define ROBOT_DART_ROBOT_POOL
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
 #include <memory>
 #include <mutex>
@@ -13,27 +15,114 @@ namespace robot_dart {
     public:
         using robot_creator_t = std::function<std::shared_ptr<Robot>()>;
 
-        RobotPool(const robot_creator_t& robot_creator, size_t pool_size = 32, bool verbose = true);
+        /// Robot given by the pool that is given back automatically when the handle is destroyed
+        class RobotHandle {
+        public:
+            RobotHandle() {}
+            RobotHandle(RobotPool* pool, const std::shared_ptr<Robot>& robot) : _pool(pool), _robot(robot) {}
+            RobotHandle(RobotHandle&& other) : _pool(other._pool), _robot(std::move(other._robot)) { other._pool = nullptr; }
+            RobotHandle& operator=(RobotHandle&& other)
+            {
+                if (this != &other) {
+                    release();
+                    _pool = other._pool;
+                    _robot = std::move(other._robot);
+                    other._pool = nullptr;
+                }
+                return *this;
+            }
+            ~RobotHandle() { release(); }
+
+            RobotHandle(const RobotHandle&) = delete;
+            void operator=(const RobotHandle&) = delete;
+
+            const std::shared_ptr<Robot>& robot() const { return _robot; }
+            Robot* operator->() const { return _robot.get(); }
+            Robot& operator*() const { return *_robot; }
+            explicit operator bool() const { return _robot != nullptr; }
+
+            /// gives the robot back to the pool (the robot should not be used afterwards)
+            void release()
+            {
+                if (_pool && _robot)
+                    _pool->free_robot(_robot);
+                _pool = nullptr;
+                _robot = nullptr;
+            }
+
+        protected:
+            RobotPool* _pool = nullptr;
+            std::shared_ptr<Robot> _robot;
+        };
+
+        /// pool_size robots are built at construction, using num_threads threads
+        /// (0 = all the hardware threads; robot_creator needs to be thread-safe if this is not 1).
+        /// When the pool is empty, it grows up to max_pool_size robots before blocking (the threads
+        /// that make it grow build their robots concurrently); max_pool_size = 0 means that the pool never grows.
+        RobotPool(const robot_creator_t& robot_creator, size_t pool_size = 32, bool verbose = true, size_t num_threads = 1, size_t max_pool_size = 0);
         virtual ~RobotPool() {}
 
         RobotPool(const RobotPool&) = delete;
         void operator=(const RobotPool&) = delete;
 
+        /// grows the pool if possible, otherwise blocks (without spinning) until a robot is available
         virtual std::shared_ptr<Robot> get_robot(const std::string& name = "robot");
+        /// returns nullptr if no robot is available (the pool does not grow)
+        virtual std::shared_ptr<Robot> try_get_robot(const std::string& name = "robot");
         virtual void free_robot(const std::shared_ptr<Robot>& robot);
 
+        RobotHandle get_robot_handle(const std::string& name = "robot") { return RobotHandle(this, get_robot(name)); }
+
         const std::string& model_filename() const { return _model_filename; }
 
+        /// number of robots built so far
+        size_t pool_size() const { return _pool_size.load(); }
+        size_t max_pool_size() const { return _max_pool_size; }
+        size_t num_free() const { return _num_free.load(); }
+
+        /// time (in seconds) it took to build each robot of the pool
+        std::vector<double> build_times() const;
+
     protected:
+        static constexpr uint32_t _npos = 0xffffffff;
+
         robot_creator_t _robot_creator;
-        size_t _pool_size;
+        // robots built so far (a slot whose robot could not be built is only counted once it is built again)
+        std::atomic<size_t> _pool_size;
+        // slots handed out so far (built or being built)
+        std::atomic<size_t> _num_reserved;
+        size_t _max_pool_size;
         bool _verbose;
+        // preallocated to max_pool_size; only written (under _grow_mutex once constructed) when a robot is built
         std::vector<dart::dynamics::SkeletonPtr> _skeletons;
-        std::vector<bool> _free;
-        std::mutex _skeleton_mutex;
+        std::vector<double> _build_times;
         std::string _model_filename;
+        // reserved slots whose robot could not be built (given to the next growth, under _grow_mutex)
+        std::vector<uint32_t> _failed_slots;
+        std::atomic<size_t> _num_failed;
+        // only held to write the slots, never while a robot is built
+        mutable std::mutex _grow_mutex;
+        std::unique_ptr<std::atomic<bool>[]> _built;
+
+        // lock-free stack of free indices: the head packs an ABA tag (high 32 bits) and an index (low 32 bits)
+        std::atomic<uint64_t> _free_head;
+        std::unique_ptr<std::atomic<uint32_t>[]> _next;
+        std::unique_ptr<std::atomic<bool>[]> _free;
+        std::atomic<size_t> _num_free;
+
+        // only used to sleep when the pool is empty
+        std::atomic<size_t> _waiters;
+        std::mutex _wait_mutex;
+        std::condition_variable _wait_cv;
 
         virtual void _reset_robot(const std::shared_ptr<Robot>& robot);
+
+        void _build_robot(size_t index);
+        bool _grow(uint32_t& index);
+        bool _pop(uint32_t& index);
+        void _push(uint32_t index);
+        size_t _index_of(const std::shared_ptr<Robot>& robot) const;
+        std::shared_ptr<Robot> _make_robot(uint32_t index, const std::string& name);
     };
 } // namespace robot_dart
 
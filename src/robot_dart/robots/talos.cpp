@@ -10,29 +10,14 @@ namespace robot_dart {
               _ft_foot_right(std::make_shared<sensor::ForceTorque>(joint("leg_right_6_joint"), frequency)),
               _ft_wrist_left(std::make_shared<sensor::ForceTorque>(joint("wrist_left_ft_joint"), frequency)),
               _ft_wrist_right(std::make_shared<sensor::ForceTorque>(joint("wrist_right_ft_joint"), frequency)),
+              _ft_bank(std::make_shared<sensor::ForceTorqueBank>(frequency)),
+              _torque_bank(std::make_shared<sensor::TorqueBank>(frequency)),
               _frequency(frequency)
         {
-            // use position/torque limits
-            set_position_enforced(true);
-
-            // set a position abobe the floor
-            skeleton()->setPosition(5, 1.1);
-
-            // rotate the robot
-            skeleton()->setPosition(2, 1.57);
-        }
-
-        void Talos::_post_addition(RobotDARTSimu* simu)
-        {
-            // We do not want to add sensors if we are a ghost robot
-            if (ghost())
-                return;
-            simu->add_sensor(_imu);
-
-            simu->add_sensor(_ft_foot_left);
-            simu->add_sensor(_ft_foot_right);
-            simu->add_sensor(_ft_wrist_left);
-            simu->add_sensor(_ft_wrist_right);
+            _ft_bank->add_sensor(_ft_foot_left);
+            _ft_bank->add_sensor(_ft_foot_right);
+            _ft_bank->add_sensor(_ft_wrist_left);
+            _ft_bank->add_sensor(_ft_wrist_right);
 
             // torques sensors
             std::vector<std::string> joints = {
@@ -53,11 +38,42 @@ namespace robot_dart {
                 "leg_right_4_joint", "leg_right_5_joint", "leg_right_6_joint"
 
             };
+            // the torque sensors are refreshed by the bank (one pass over the joints)
             for (auto& s : joints) {
-                auto t = std::make_shared<sensor::Torque>(joint(s), _frequency);
+                auto t = std::make_shared<sensor::Torque>(joint(s), frequency);
                 _torques[s] = t;
-                simu->add_sensor(t);
+                _torque_names.push_back(s);
+                _torque_bank->add_sensor(t);
             }
+
+            // use position/torque limits
+            set_position_enforced(true);
+
+            // set a position abobe the floor
+            skeleton()->setPosition(5, 1.1);
+
+            // rotate the robot
+            skeleton()->setPosition(2, 1.57);
+        }
+
+        void Talos::_post_addition(RobotDARTSimu* simu)
+        {
+            // We do not want to add sensors if we are a ghost robot
+            if (ghost())
+                return;
+            simu->add_sensor(_imu);
+
+            // the force/torque and torque sensors are reachable from the simulation, but refreshed by the banks
+            // (the banks belong to the robot: they are not listed in the sensors of the simulation)
+            simu->add_sensor(_ft_foot_left);
+            simu->add_sensor(_ft_foot_right);
+            simu->add_sensor(_ft_wrist_left);
+            simu->add_sensor(_ft_wrist_right);
+            for (auto& s : _torque_names)
+                simu->add_sensor(_torques[s]);
+
+            _add_internal_sensor(simu, _ft_bank);
+            _add_internal_sensor(simu, _torque_bank);
         }
 
         void Talos::_post_removal(RobotDARTSimu* simu)
@@ -68,10 +84,11 @@ namespace robot_dart {
             simu->remove_sensor(_ft_foot_right);
             simu->remove_sensor(_ft_wrist_left);
             simu->remove_sensor(_ft_wrist_right);
-
-            for (auto& t : _torques) {
+            for (auto& t : _torques)
                 simu->remove_sensor(t.second);
-            }
+
+            _remove_internal_sensor(simu, _ft_bank);
+            _remove_internal_sensor(simu, _torque_bank);
         }
     } // namespace robots
 } // namespace robot_dart
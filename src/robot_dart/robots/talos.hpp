@@ -22,6 +22,11 @@ namespace robot_dart {
             using torque_map_t = std::unordered_map<std::string, std::shared_ptr<sensor::Torque>>;
             const torque_map_t& torques() const { return _torques; }
 
+            // the force/torque and torque sensors are added to the simulation (after the IMU) but refreshed by these banks (packed readings);
+            // the banks belong to the robot: the simulation refreshes them but does not list them in its sensors
+            const sensor::ForceTorqueBank& ft_bank() const { return *_ft_bank; }
+            const sensor::TorqueBank& torque_bank() const { return *_torque_bank; }
+
         protected:
             std::shared_ptr<sensor::IMU> _imu;
             std::shared_ptr<sensor::ForceTorque> _ft_foot_left;
@@ -29,6 +34,9 @@ namespace robot_dart {
             std::shared_ptr<sensor::ForceTorque> _ft_wrist_left;
             std::shared_ptr<sensor::ForceTorque> _ft_wrist_right;
             torque_map_t _torques;
+            std::vector<std::string> _torque_names; // order of addition to the simulation
+            std::shared_ptr<sensor::ForceTorqueBank> _ft_bank;
+            std::shared_ptr<sensor::TorqueBank> _torque_bank;
             size_t _frequency;
 
             void _post_addition(RobotDARTSimu* simu) override;
@@ -1,28 +1,223 @@
 #include <robot_dart/scheduler.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 namespace robot_dart {
+    constexpr size_t Scheduler::_wheel_size;
+
     bool Scheduler::schedule(int frequency)
+    {
+        _start();
+        _max_frequency = std::max(_max_frequency, frequency);
+
+        // computing the period is cheaper than looking it up; the registered tasks (add_task()) keep theirs
+        double period = std::round((1. / frequency) / _dt);
+        ROBOT_DART_EXCEPTION_INTERNAL_ASSERT(
+            period >= 1. && "Time-step is too big for required frequency.");
+
+        return (_current_step % int(period)) == 0;
+    }
+
+    size_t Scheduler::add_task(double frequency)
+    {
+        size_t id;
+        if (_free_tasks.empty()) {
+            id = _tasks.size();
+            _tasks.push_back(Task());
+            _reserve_wheel();
+        }
+        else {
+            id = _free_tasks.back();
+            _free_tasks.pop_back();
+        }
+
+        Task& task = _tasks[id];
+        task.used = true;
+        task.frequency = frequency;
+        task.due_step = -1;
+        _set_period(task);
+        _insert_task(id);
+
+        return id;
+    }
+
+    void Scheduler::remove_task(size_t id)
+    {
+        ROBOT_DART_ASSERT(id < _tasks.size() && _tasks[id].used, "Scheduler: unknown task", );
+        _tasks[id].used = false;
+        _tasks[id].version++;
+        _free_tasks.push_back(id);
+
+        auto it = std::find(_due.begin(), _due.end(), id);
+        if (it != _due.end())
+            _due.erase(it);
+    }
+
+    void Scheduler::set_task_frequency(size_t id, double frequency)
+    {
+        ROBOT_DART_ASSERT(id < _tasks.size() && _tasks[id].used, "Scheduler: unknown task", );
+        Task& task = _tasks[id];
+        if (task.frequency == frequency)
+            return;
+        task.frequency = frequency;
+        _set_period(task);
+        _insert_task(id);
+    }
+
+    double Scheduler::task_frequency(size_t id) const
+    {
+        ROBOT_DART_ASSERT(id < _tasks.size() && _tasks[id].used, "Scheduler: unknown task", 0.);
+        return _tasks[id].frequency;
+    }
+
+    const std::vector<size_t>& Scheduler::due_tasks()
+    {
+        _compute_due();
+        return _due;
+    }
+
+    bool Scheduler::due(size_t id)
+    {
+        ROBOT_DART_ASSERT(id < _tasks.size() && _tasks[id].used, "Scheduler: unknown task", false);
+        _compute_due();
+        return _tasks[id].due_step == _current_step;
+    }
+
+    void Scheduler::_start()
     {
         if (_max_frequency == -1) {
             _start_time = clock_t::now();
             _last_iteration_time = _start_time;
+            _max_frequency = 0;
         }
+    }
 
-        _max_frequency = std::max(_max_frequency, frequency);
-        double period = std::round((1. / frequency) / _dt);
-
+    void Scheduler::_set_period(Task& task)
+    {
+        task.period = (1. / task.frequency) / _dt;
+        // same tolerance as schedule(): tasks faster than the simulation are due at every step
         ROBOT_DART_EXCEPTION_INTERNAL_ASSERT(
-            period >= 1. && "Time-step is too big for required frequency.");
+            std::round(task.period) >= 1. && "Time-step is too big for required frequency.");
+    }
+
+    void Scheduler::_insert_task(size_t id)
+    {
+        // first activation at or after the current step; the activations are aligned to step 0 like schedule()
+        Task& task = _tasks[id];
+        long long k = static_cast<long long>(std::floor(_current_step / task.period));
+        while (std::llround(k * task.period) < _current_step)
+            k++;
+
+        task.activation = k;
+        task.next_step = std::llround(k * task.period);
+        task.version++;
 
-        if (_current_step % int(period) == 0)
-            return true;
+        // the due tasks of this step were already given
+        if (task.next_step == _processed_step) {
+            if (task.due_step != _current_step) {
+                task.due_step = _current_step;
+                _due.push_back(id);
+            }
+            _schedule_next(id);
+            return;
+        }
 
-        return false;
+        _wheel[task.next_step & (_wheel_size - 1)].push_back({id, task.version});
+    }
+
+    void Scheduler::_schedule_next(size_t id)
+    {
+        // the step is computed from the activation index (and not by adding the period) to avoid any drift
+        Task& task = _tasks[id];
+        task.activation++;
+        task.next_step = std::max(std::llround(task.activation * task.period), task.next_step + 1);
+        _wheel[task.next_step & (_wheel_size - 1)].push_back({id, task.version});
+    }
+
+    void Scheduler::_reserve_wheel()
+    {
+        // a bucket holds at most one (valid) entry per task: the steps do not allocate even in the first turn of the wheel
+        size_t capacity = _tasks.capacity();
+        for (auto& bucket : _wheel)
+            bucket.reserve(capacity);
+        _bucket.reserve(capacity);
+        _due.reserve(capacity);
+    }
+
+    void Scheduler::_rebuild_wheel()
+    {
+        for (auto& bucket : _wheel)
+            bucket.clear();
+        _due.clear();
+        _processed_step = _current_step - 1;
+        for (size_t i = 0; i < _tasks.size(); i++) {
+            if (_tasks[i].used) {
+                _set_period(_tasks[i]);
+                _insert_task(i);
+            }
+        }
+    }
+
+    void Scheduler::_compute_due()
+    {
+        if (_processed_step == _current_step)
+            return;
+        _start();
+
+        // if due_tasks() was not called for a whole turn of the wheel, it is faster to start from scratch
+        if (_current_step - _processed_step > static_cast<int>(_wheel_size))
+            _rebuild_wheel();
+
+        // the steps that were skipped (if any) are processed without giving their due tasks
+        while (_processed_step < _current_step) {
+            _processed_step++;
+            _due.clear();
+
+            auto& bucket = _wheel[_processed_step & (_wheel_size - 1)];
+            _bucket.clear();
+            std::swap(_bucket, bucket);
+            for (auto& entry : _bucket) {
+                Task& task = _tasks[entry.id];
+                if (!task.used || entry.version != task.version)
+                    continue; // stale entry
+                if (task.next_step != _processed_step) {
+                    bucket.push_back(entry); // due in a later turn of the wheel
+                    continue;
+                }
+                task.due_step = _processed_step;
+                _due.push_back(entry.id);
+                _schedule_next(entry.id);
+            }
+        }
     }
 
     void Scheduler::reset(double dt, bool sync, double current_time, double real_time)
+    {
+        _reset(dt, sync, current_time, real_time, {});
+    }
+
+    void Scheduler::set_dt(double dt, const std::vector<std::pair<size_t, double>>& task_frequencies)
+    {
+        _reset(dt, _sync, this->current_time(), this->real_time(), task_frequencies);
+    }
+
+    void Scheduler::_reset(double dt, bool sync, double current_time, double real_time, const std::vector<std::pair<size_t, double>>& task_frequencies)
     {
         ROBOT_DART_EXCEPTION_INTERNAL_ASSERT(dt > 0. && "Time-step needs to be bigger than zero.");
+        for (auto& t : task_frequencies)
+            ROBOT_DART_EXCEPTION_ASSERT(t.first < _tasks.size() && _tasks[t.first].used, "Scheduler: unknown task");
+        // the periods are checked with the new dt and the new frequencies, before anything is changed
+        for (size_t i = 0; i < _tasks.size(); i++) {
+            if (!_tasks[i].used)
+                continue;
+            double frequency = _tasks[i].frequency;
+            for (auto& t : task_frequencies)
+                if (t.first == i)
+                    frequency = t.second;
+            ROBOT_DART_EXCEPTION_INTERNAL_ASSERT(
+                std::round((1. / frequency) / dt) >= 1. && "Time-step is too big for required frequency.");
+        }
 
         _current_time = 0.;
         _real_time = 0.;
@@ -34,6 +229,11 @@ namespace robot_dart {
 
         _dt = dt;
         _sync = sync;
+        for (auto& t : task_frequencies)
+            _tasks[t.first].frequency = t.second;
+
+        // the periods depend on dt
+        _rebuild_wheel();
     }
 
     double Scheduler::step()
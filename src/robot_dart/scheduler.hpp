@@ -5,6 +5,8 @@
 
 #include <chrono>
 #include <thread>
+#include <utility>
+#include <vector>
 
 namespace robot_dart {
     class Scheduler {
@@ -18,8 +20,24 @@ namespace robot_dart {
         }
 
         bool operator()(int frequency) { return schedule(frequency); };
+        /// true if a task at `frequency` is due at the current step
+        /// (the period is rounded to an integer number of steps)
         bool schedule(int frequency);
 
+        /// registers a task that is due `frequency` times per second (of simulation time);
+        /// the period does not need to be a multiple of dt: the due steps are rounded without accumulating errors.
+        /// Returns the id of the task (ids of removed tasks are reused)
+        size_t add_task(double frequency);
+        void remove_task(size_t id);
+        void set_task_frequency(size_t id, double frequency);
+        double task_frequency(size_t id) const;
+
+        /// ids of the registered tasks that are due at the current step (valid until the next call of step());
+        /// the cost only depends on the number of due tasks, not on the number of registered tasks
+        const std::vector<size_t>& due_tasks();
+        /// true if the task is due at the current step
+        bool due(size_t id);
+
         /// call this at the end of the loop (see examples)
         /// this will synchronize with real time if requested
         /// and increase the counter;
@@ -27,6 +45,9 @@ namespace robot_dart {
         double step();
 
         void reset(double dt, bool sync = false, double current_time = 0., double real_time = 0.);
+        /// changes dt (the clocks go on) and the frequencies of some tasks at once:
+        /// the periods of all the tasks are only checked once everything is set
+        void set_dt(double dt, const std::vector<std::pair<size_t, double>>& task_frequencies = {});
 
         /// synchronize the simulation clock with the wall clock
         /// (when possible, i.e. when the simulation is faster than real time)
@@ -49,6 +70,22 @@ namespace robot_dart {
         double last_it_duration() const { return _it_duration * 1e-6; }
 
     protected:
+        struct Task {
+            double frequency = 0.;
+            double period = 0.; // in steps
+            long long activation = 0; // index of the next activation (its step is round(activation * period))
+            long long next_step = 0;
+            long long due_step = -1; // last step at which the task was due
+            unsigned int version = 0; // entries of the wheel that do not have the current version are stale
+            bool used = false;
+        };
+        struct WheelEntry {
+            size_t id;
+            unsigned int version;
+        };
+        // power of two; tasks with longer periods are skipped when their bucket comes back before they are due
+        static constexpr size_t _wheel_size = 256;
+
         double _current_time = 0., _simu_start_time = 0., _real_time = 0., _real_start_time = 0., _it_duration = 0.;
         double _average_it_duration = 0.;
         double _dt;
@@ -57,6 +94,22 @@ namespace robot_dart {
         int _max_frequency = -1;
         clock_t::time_point _start_time;
         clock_t::time_point _last_iteration_time;
+
+        std::vector<Task> _tasks;
+        std::vector<size_t> _free_tasks;
+        std::vector<std::vector<WheelEntry>> _wheel = std::vector<std::vector<WheelEntry>>(_wheel_size);
+        std::vector<WheelEntry> _bucket; // scratch to process a bucket without allocations
+        std::vector<size_t> _due;
+        int _processed_step = -1; // _due is valid for this step
+
+        void _start();
+        void _reset(double dt, bool sync, double current_time, double real_time, const std::vector<std::pair<size_t, double>>& task_frequencies);
+        void _set_period(Task& task);
+        void _insert_task(size_t id);
+        void _schedule_next(size_t id);
+        void _reserve_wheel();
+        void _rebuild_wheel();
+        void _compute_due();
     };
 } // namespace robot_dart
 
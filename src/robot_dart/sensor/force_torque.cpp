@@ -40,6 +40,13 @@ namespace robot_dart {
 
         std::string ForceTorque::type() const { return "ft"; }
 
+        size_t ForceTorque::snapshot_size() const { return 6; }
+
+        void ForceTorque::write_snapshot(Eigen::Ref<Eigen::VectorXd> values) const
+        {
+            values = _wrench;
+        }
+
         Eigen::Vector3d ForceTorque::force() const
         {
             return _wrench.tail(3);
@@ -54,5 +61,113 @@ namespace robot_dart {
         {
             return _wrench;
         }
+
+        ForceTorqueBank::ForceTorqueBank(size_t frequency) : Sensor(frequency) {}
+
+        size_t ForceTorqueBank::add_joint(dart::dynamics::Joint* joint, const std::string& direction)
+        {
+            ROBOT_DART_EXCEPTION_ASSERT(joint, "Joint is nullptr");
+            ROBOT_DART_EXCEPTION_ASSERT(joint->getChildBodyNode(), "Child BodyNode is nullptr");
+
+            _joints.push_back(joint);
+            _child_bodies.push_back(joint->getChildBodyNode());
+            _directions.push_back(direction);
+            _signs.push_back((direction == "parent_to_child") ? -1. : 1.);
+            _sensors.push_back(nullptr);
+
+            // the storage is only resized when joints are added
+            _wrenches.conservativeResize(Eigen::NoChange, _wrenches.cols() + 1);
+            _wrenches.rightCols(1).setZero();
+
+            return _joints.size() - 1;
+        }
+
+        size_t ForceTorqueBank::add_sensor(const std::shared_ptr<ForceTorque>& sensor)
+        {
+            ROBOT_DART_EXCEPTION_ASSERT(sensor && sensor->_attached_to_joint, "The force/torque sensor is not attached to a joint");
+            size_t index = add_joint(sensor->_joint_attached, sensor->_direction);
+            _sensors[index] = sensor;
+            sensor->_driven = true;
+            return index;
+        }
+
+        void ForceTorqueBank::init()
+        {
+            _wrenches.setZero();
+
+            for (size_t i = 0; i < _sensors.size(); i++) {
+                if (_sensors[i]) {
+                    // the direction of the sensor might have changed since its addition
+                    _directions[i] = _sensors[i]->_direction;
+                    _sensors[i]->_simu = _simu;
+                    _sensors[i]->_frequency = _frequency;
+                    _sensors[i]->init();
+                    _sensors[i]->_init_snapshot();
+                }
+                _signs[i] = (_directions[i] == "parent_to_child") ? -1. : 1.;
+            }
+            _active = true;
+        }
+
+        void ForceTorqueBank::calculate(double t)
+        {
+            // same computations as ForceTorque::calculate (in the joint frame)
+            for (size_t i = 0; i < _joints.size(); i++) {
+                _wrenches.col(i) = _signs[i] * dart::math::dAdT(_joints[i]->getTransformFromChildBodyNode(), _child_bodies[i]->getBodyForce());
+                // the sensors removed from the simulation are not refreshed anymore
+                if (_sensors[i] && _sensors[i]->_simu) {
+                    _sensors[i]->_update_pose();
+                    _sensors[i]->_wrench = _wrenches.col(i);
+                    _sensors[i]->_publish_snapshot(t);
+                    _sensors[i]->_record(t);
+                }
+            }
+        }
+
+        std::string ForceTorqueBank::type() const { return "ft_bank"; }
+
+        size_t ForceTorqueBank::snapshot_size() const { return _wrenches.size(); }
+
+        void ForceTorqueBank::write_snapshot(Eigen::Ref<Eigen::VectorXd> values) const
+        {
+            values = Eigen::Map<const Eigen::VectorXd>(_wrenches.data(), _wrenches.size());
+        }
+
+        bool ForceTorqueBank::attached_to_robot(const std::shared_ptr<Robot>& robot) const
+        {
+            for (auto joint : _joints)
+                if (joint->getSkeleton() == robot->skeleton())
+                    return true;
+            return false;
+        }
+
+        size_t ForceTorqueBank::num_joints() const { return _joints.size(); }
+
+        dart::dynamics::Joint* ForceTorqueBank::joint(size_t index) const
+        {
+            ROBOT_DART_ASSERT(index < _joints.size(), "Joint index out of bounds", nullptr);
+            return _joints[index];
+        }
+
+        const Eigen::Matrix<double, 6, Eigen::Dynamic>& ForceTorqueBank::wrenches() const
+        {
+            return _wrenches;
+        }
+
+        Eigen::Vector6d ForceTorqueBank::wrench(size_t index) const
+        {
+            ROBOT_DART_EXCEPTION_ASSERT(index < _joints.size(), "Joint index out of bounds");
+            return _wrenches.col(index);
+        }
+
+        Eigen::Vector3d ForceTorqueBank::force(size_t index) const
+        {
+            return wrench(index).tail(3);
+        }
+
+        Eigen::Vector3d ForceTorqueBank::torque(size_t index) const
+        {
+            return wrench(index).head(3);
+        }
     } // namespace sensor
 } // namespace robot_dart
\ No newline at end of file
@@ -5,6 +5,8 @@
 
 namespace robot_dart {
     namespace sensor {
+        class ForceTorqueBank;
+
         class ForceTorque : public Sensor {
         public:
             ForceTorque(dart::dynamics::Joint* joint, size_t frequency = 1000, const std::string& direction = "child_to_parent");
@@ -16,6 +18,10 @@ namespace robot_dart {
 
             std::string type() const override;
 
+            // snapshot: [torque, force] (the wrench)
+            size_t snapshot_size() const override;
+            void write_snapshot(Eigen::Ref<Eigen::VectorXd> values) const override;
+
             Eigen::Vector3d force() const;
             Eigen::Vector3d torque() const;
             const Eigen::Vector6d& wrench() const;
@@ -26,10 +32,65 @@ namespace robot_dart {
             }
 
         protected:
+            friend class ForceTorqueBank;
+
             std::string _direction;
 
             Eigen::Vector6d _wrench;
         };
+
+        // Force/torque sensors of several joints refreshed in one pass (one scheduler task for all the joints).
+        // The wrenches are packed in a 6xN matrix (one column per joint, in the order of addition).
+        // Force/torque sensors added to the bank are not refreshed by the simulation but updated by the bank.
+        class ForceTorqueBank : public Sensor {
+        public:
+            ForceTorqueBank(size_t frequency = 1000);
+
+            // returns the index of the joint in the bank
+            size_t add_joint(dart::dynamics::Joint* joint, const std::string& direction = "child_to_parent");
+            size_t add_joint(const std::shared_ptr<Robot>& robot, const std::string& joint_name, const std::string& direction = "child_to_parent") { return add_joint(robot->joint(joint_name), direction); }
+            // the wrench of the sensor is updated by the bank (with the direction of the sensor)
+            size_t add_sensor(const std::shared_ptr<ForceTorque>& sensor);
+
+            void init() override;
+
+            void calculate(double) override;
+
+            std::string type() const override;
+
+            // snapshot: the wrenches of the joints, one after the other
+            size_t snapshot_size() const override;
+            void write_snapshot(Eigen::Ref<Eigen::VectorXd> values) const override;
+
+            bool attached_to_robot(const std::shared_ptr<Robot>& robot) const override;
+
+            size_t num_joints() const;
+            dart::dynamics::Joint* joint(size_t index) const;
+
+            const Eigen::Matrix<double, 6, Eigen::Dynamic>& wrenches() const;
+            Eigen::Vector6d wrench(size_t index) const;
+            Eigen::Vector3d force(size_t index) const;
+            Eigen::Vector3d torque(size_t index) const;
+
+            void attach_to_body(dart::dynamics::BodyNode*, const Eigen::Isometry3d&) override
+            {
+                ROBOT_DART_WARNING(true, "You cannot attach a force/torque bank to a body!");
+            }
+
+            void attach_to_joint(dart::dynamics::Joint*, const Eigen::Isometry3d&) override
+            {
+                ROBOT_DART_WARNING(true, "You cannot attach a force/torque bank to a joint! Use add_joint instead.");
+            }
+
+        protected:
+            std::vector<dart::dynamics::Joint*> _joints;
+            std::vector<const dart::dynamics::BodyNode*> _child_bodies;
+            std::vector<std::string> _directions;
+            std::vector<double> _signs; // +1 for "child_to_parent", -1 for "parent_to_child"
+            std::vector<std::shared_ptr<ForceTorque>> _sensors; // nullptr if the joint has no sensor
+
+            Eigen::Matrix<double, 6, Eigen::Dynamic> _wrenches;
+        };
     } // namespace sensor
 } // namespace robot_dart
 
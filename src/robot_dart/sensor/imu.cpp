@@ -38,6 +38,15 @@ namespace robot_dart {
 
         std::string IMU::type() const { return "imu"; }
 
+        size_t IMU::snapshot_size() const { return 9; }
+
+        void IMU::write_snapshot(Eigen::Ref<Eigen::VectorXd> values) const
+        {
+            values.head(3) = _angular_pos.angle() * _angular_pos.axis();
+            values.segment(3, 3) = _angular_vel;
+            values.tail(3) = _linear_accel;
+        }
+
         const Eigen::AngleAxisd& IMU::angular_position() const
         {
             return _angular_pos;
@@ -37,6 +37,10 @@ namespace robot_dart {
 
             std::string type() const override;
 
+            // snapshot: [angular position (angle * axis), angular velocity, linear acceleration]
+            size_t snapshot_size() const override;
+            void write_snapshot(Eigen::Ref<Eigen::VectorXd> values) const override;
+
             const Eigen::AngleAxisd& angular_position() const;
             Eigen::Vector3d angular_position_vec() const;
             const Eigen::Vector3d& angular_velocity() const;
@@ -0,0 +1,449 @@
+#include "recorder.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace robot_dart {
+    namespace sensor {
+        namespace {
+            constexpr char recording_magic[8] = {'R', 'D', 'R', 'E', 'C', 0, 0, 0};
+            constexpr uint64_t recording_version = 1;
+            constexpr uint32_t chunk_magic = 0x4b4e4843; // "CHNK"
+            // the blob chunks are also written when they reach this size
+            constexpr size_t max_blob_chunk_bytes = 64 * 1024 * 1024;
+
+            size_t padding(size_t size) { return (8 - size % 8) % 8; }
+
+            // the size of the payload of a chunk must match its layout (the reader never reads past a chunk)
+            bool valid_chunk(const RecordingChunkHeader& chunk, const uint8_t* payload, size_t num_values)
+            {
+                size_t n = chunk.num_records;
+                if (n > chunk.size / sizeof(double)) // also keeps the products below from overflowing
+                    return false;
+
+                if (!chunk.blobs) {
+                    // times and num_values columns
+                    if (n == 0)
+                        return chunk.size == 0;
+                    return chunk.size % (n * sizeof(double)) == 0 && chunk.size / (n * sizeof(double)) - 1 == num_values;
+                }
+
+                // times, offsets and the padded data
+                size_t header_size = n * sizeof(double) + (n + 1) * sizeof(uint64_t);
+                if (chunk.size < header_size)
+                    return false;
+                auto offsets = reinterpret_cast<const uint64_t*>(payload + n * sizeof(double));
+                for (size_t i = 0; i < n; i++)
+                    if (offsets[i] > offsets[i + 1])
+                        return false;
+                size_t data_size = chunk.size - header_size;
+                return offsets[n] <= data_size && data_size - offsets[n] >= padding(offsets[n]);
+            }
+        } // namespace
+
+        Recorder::Recorder(const std::string& filename, size_t chunk_size) : _filename(filename), _chunk_size(chunk_size)
+        {
+            ROBOT_DART_EXCEPTION_ASSERT(_chunk_size > 0, "The chunks must hold at least one record");
+        }
+
+        Recorder::~Recorder()
+        {
+            stop();
+        }
+
+        size_t Recorder::add_sensor(const std::shared_ptr<Sensor>& sensor, const std::string& name, bool blobs)
+        {
+            ROBOT_DART_EXCEPTION_ASSERT(!_recording, "Sensors cannot be added to a recorder that is recording");
+            ROBOT_DART_EXCEPTION_ASSERT(sensor, "Sensor is nullptr");
+            ROBOT_DART_EXCEPTION_ASSERT(_stream_indices.find(sensor.get()) == _stream_indices.end(), "The sensor is already recorded");
+
+            Stream stream;
+            stream.sensor = sensor;
+            stream.name = name.empty() ? sensor->type() + "_" + std::to_string(_streams.size()) : name;
+            ROBOT_DART_EXCEPTION_ASSERT(stream.name.size() < sizeof(RecordingStreamHeader::name), "Stream name too long: " + stream.name);
+            stream.num_values = sensor->snapshot_size();
+            stream.blobs = blobs;
+            stream.values.resize(stream.num_values);
+
+            _stream_indices[sensor.get()] = _streams.size();
+            _streams.push_back(std::move(stream));
+            return _streams.size() - 1;
+        }
+
+        void Recorder::add_sensors(const std::vector<std::shared_ptr<Sensor>>& sensors)
+        {
+            for (auto& sensor : sensors)
+                add_sensor(sensor);
+        }
+
+        void Recorder::start()
+        {
+            ROBOT_DART_EXCEPTION_ASSERT(!_recording, "The recorder is already recording");
+            _file = std::fopen(_filename.c_str(), "wb");
+            ROBOT_DART_EXCEPTION_ASSERT(_file, "Cannot open the recording file: " + _filename);
+
+            RecordingFileHeader header;
+            std::memset(&header, 0, sizeof(header));
+            std::memcpy(header.magic, recording_magic, sizeof(header.magic));
+            header.version = recording_version;
+            header.num_streams = _streams.size();
+            std::fwrite(&header, sizeof(header), 1, _file);
+
+            for (size_t i = 0; i < _streams.size(); i++) {
+                auto& stream = _streams[i];
+                RecordingStreamHeader stream_header;
+                std::memset(&stream_header, 0, sizeof(stream_header));
+                std::strncpy(stream_header.name, stream.name.c_str(), sizeof(stream_header.name) - 1);
+                std::strncpy(stream_header.type, stream.sensor->type().c_str(), sizeof(stream_header.type) - 1);
+                stream_header.num_values = stream.num_values;
+                stream_header.frequency = stream.sensor->frequency();
+                stream_header.has_blobs = stream.blobs;
+                std::fwrite(&stream_header, sizeof(stream_header), 1, _file);
+
+                // the blobs are appended in preallocated buffers (a chunk is written when it reaches max_blob_chunk_bytes)
+                size_t blob_size = stream.sensor->blob_size();
+                stream.blob_capacity = std::min(_chunk_size * blob_size, max_blob_chunk_bytes + blob_size);
+
+                // one chunk being filled and one being written per stream (more only if the writer is late)
+                if (stream.num_values > 0) {
+                    stream.values_chunk = _new_chunk(i, false);
+                    stream.free_values.push_back(_new_chunk(i, false));
+                }
+                if (stream.blobs) {
+                    stream.blobs_chunk = _new_chunk(i, true);
+                    stream.free_blobs.push_back(_new_chunk(i, true));
+                }
+            }
+
+            _stop = false;
+            _writer = std::thread(&Recorder::_writer_loop, this);
+            _recording = true;
+        }
+
+        void Recorder::stop()
+        {
+            if (!_recording)
+                return;
+
+            // the partial chunks
+            for (auto& stream : _streams) {
+                if (stream.values_chunk && stream.values_chunk->num_records > 0)
+                    _submit(stream, false);
+                if (stream.blobs_chunk && stream.blobs_chunk->num_records > 0)
+                    _submit(stream, true);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stop = true;
+            }
+            _cv.notify_one();
+            _writer.join();
+
+            std::fclose(_file);
+            _file = nullptr;
+            _recording = false;
+        }
+
+        void Recorder::record(Sensor& sensor, double t)
+        {
+            if (!_recording)
+                return;
+            auto it = _stream_indices.find(&sensor);
+            if (it == _stream_indices.end())
+                return;
+            Stream& stream = _streams[it->second];
+
+            // the values are copied in rows: the background thread writes them in columns
+            if (stream.num_values > 0 && sensor.snapshot_size() == stream.num_values) {
+                sensor.write_snapshot(stream.values);
+                Chunk& chunk = *stream.values_chunk;
+                double* row = chunk.rows.data() + chunk.num_records * (1 + stream.num_values);
+                row[0] = t;
+                std::copy(stream.values.data(), stream.values.data() + stream.num_values, row + 1);
+                if (++chunk.num_records == _chunk_size)
+                    _submit(stream, false);
+            }
+
+            if (stream.blobs) {
+                Chunk& chunk = *stream.blobs_chunk;
+                if (sensor.write_blob(chunk.data)) {
+                    chunk.rows[chunk.num_records] = t;
+                    chunk.num_records++;
+                    chunk.offsets[chunk.num_records] = chunk.data.size();
+                    if (chunk.num_records == _chunk_size || chunk.data.size() >= max_blob_chunk_bytes)
+                        _submit(stream, true);
+                }
+                else // nothing appended (or a partial blob)
+                    chunk.data.resize(chunk.offsets[chunk.num_records]);
+            }
+        }
+
+        std::unique_ptr<Recorder::Chunk> Recorder::_new_chunk(size_t stream, bool blobs)
+        {
+            std::unique_ptr<Chunk> chunk(new Chunk);
+            chunk->stream = stream;
+            chunk->blobs = blobs;
+            if (blobs) {
+                chunk->rows.resize(_chunk_size);
+                chunk->offsets.resize(_chunk_size + 1, 0);
+                chunk->data.reserve(_streams[stream].blob_capacity);
+            }
+            else
+                chunk->rows.resize(_chunk_size * (1 + _streams[stream].num_values));
+            return chunk;
+        }
+
+        void Recorder::_submit(Stream& stream, bool blobs)
+        {
+            std::unique_ptr<Chunk>& current = blobs ? stream.blobs_chunk : stream.values_chunk;
+            auto& free_chunks = blobs ? stream.free_blobs : stream.free_values;
+            size_t index = current->stream;
+
+            std::unique_ptr<Chunk> next;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _full.push_back(std::move(current));
+                if (!free_chunks.empty()) {
+                    next = std::move(free_chunks.back());
+                    free_chunks.pop_back();
+                }
+            }
+            _cv.notify_one();
+
+            // we never wait for the background thread
+            if (!next)
+                next = _new_chunk(index, blobs);
+            next->num_records = 0;
+            next->data.clear();
+            current = std::move(next);
+        }
+
+        void Recorder::_writer_loop()
+        {
+            std::vector<double> columns;
+            while (true) {
+                std::unique_ptr<Chunk> chunk;
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _cv.wait(lock, [this] { return _stop || !_full.empty(); });
+                    if (_full.empty())
+                        return; // stopped and everything is written
+                    chunk = std::move(_full.front());
+                    _full.pop_front();
+                }
+
+                _write_chunk(*chunk, columns);
+
+                std::lock_guard<std::mutex> lock(_mutex);
+                auto& stream = _streams[chunk->stream];
+                (chunk->blobs ? stream.free_blobs : stream.free_values).push_back(std::move(chunk));
+            }
+        }
+
+        void Recorder::_write_chunk(const Chunk& chunk, std::vector<double>& columns)
+        {
+            size_t n = chunk.num_records;
+            RecordingChunkHeader header;
+            std::memset(&header, 0, sizeof(header));
+            header.magic = chunk_magic;
+            header.blobs = chunk.blobs;
+            header.stream = chunk.stream;
+            header.num_records = n;
+
+            bool ok = true;
+            if (chunk.blobs) {
+                size_t data_size = chunk.offsets[n];
+                size_t pad = padding(data_size);
+                header.size = n * sizeof(double) + (n + 1) * sizeof(uint64_t) + data_size + pad;
+
+                const uint64_t zeros = 0;
+                ok = ok && std::fwrite(&header, sizeof(header), 1, _file) == 1;
+                ok = ok && std::fwrite(chunk.rows.data(), sizeof(double), n, _file) == n;
+                ok = ok && std::fwrite(chunk.offsets.data(), sizeof(uint64_t), n + 1, _file) == n + 1;
+                ok = ok && std::fwrite(chunk.data.data(), 1, data_size, _file) == data_size;
+                ok = ok && std::fwrite(&zeros, 1, pad, _file) == pad;
+            }
+            else {
+                // time and values of the records in columns
+                size_t row_size = 1 + _streams[chunk.stream].num_values;
+                columns.resize(row_size * n);
+                for (size_t r = 0; r < n; r++)
+                    for (size_t c = 0; c < row_size; c++)
+                        columns[c * n + r] = chunk.rows[r * row_size + c];
+                header.size = columns.size() * sizeof(double);
+
+                ok = ok && std::fwrite(&header, sizeof(header), 1, _file) == 1;
+                ok = ok && std::fwrite(columns.data(), sizeof(double), columns.size(), _file) == columns.size();
+            }
+            ROBOT_DART_WARNING(!ok, "Could not write a chunk to the recording file: " + _filename);
+        }
+
+        RecordingReader::RecordingReader(const std::string& filename)
+        {
+            int fd = ::open(filename.c_str(), O_RDONLY);
+            ROBOT_DART_EXCEPTION_ASSERT(fd >= 0, "Cannot open the recording file: " + filename);
+            struct stat st;
+            if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(RecordingFileHeader)) {
+                ::close(fd);
+                ROBOT_DART_EXCEPTION_ASSERT(false, "Not a recording file: " + filename);
+            }
+            _size = static_cast<size_t>(st.st_size);
+            _mapping = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd); // the mapping stays valid
+            if (_mapping == MAP_FAILED) {
+                _mapping = nullptr;
+                ROBOT_DART_EXCEPTION_ASSERT(false, "Cannot map the recording file: " + filename);
+            }
+
+            const uint8_t* base = static_cast<const uint8_t*>(_mapping);
+            auto header = reinterpret_cast<const RecordingFileHeader*>(base);
+            size_t offset = sizeof(RecordingFileHeader) + header->num_streams * sizeof(RecordingStreamHeader);
+            if (std::memcmp(header->magic, recording_magic, sizeof(header->magic)) != 0 || header->version != recording_version || offset > _size) {
+                ::munmap(_mapping, _size);
+                _mapping = nullptr;
+                ROBOT_DART_EXCEPTION_ASSERT(false, "Not a recording file (or unsupported version): " + filename);
+            }
+
+            auto stream_headers = reinterpret_cast<const RecordingStreamHeader*>(base + sizeof(RecordingFileHeader));
+            for (size_t i = 0; i < header->num_streams; i++) {
+                const auto& h = stream_headers[i];
+                _streams.push_back({std::string(h.name, strnlen(h.name, sizeof(h.name))), std::string(h.type, strnlen(h.type, sizeof(h.type))), h.num_values, h.frequency, h.has_blobs != 0});
+            }
+            _chunks.resize(_streams.size());
+            _blob_chunks.resize(_streams.size());
+            _num_records.resize(_streams.size(), 0);
+            _num_blobs.resize(_streams.size(), 0);
+
+            // only the chunk headers are read; a truncated last chunk (e.g., after a crash) is ignored
+            while (offset + sizeof(RecordingChunkHeader) <= _size) {
+                auto chunk = reinterpret_cast<const RecordingChunkHeader*>(base + offset);
+                offset += sizeof(RecordingChunkHeader);
+                if (chunk->magic != chunk_magic || chunk->stream >= _streams.size() || chunk->size > _size - offset)
+                    break;
+                if (!valid_chunk(*chunk, base + offset, _streams[chunk->stream].num_values)) {
+                    ROBOT_DART_WARNING(true, "Invalid chunk in the recording file (the next records are ignored): " + filename);
+                    break;
+                }
+
+                size_t n = chunk->num_records;
+                auto times = reinterpret_cast<const double*>(base + offset);
+                if (chunk->blobs) {
+                    auto offsets = reinterpret_cast<const uint64_t*>(times + n);
+                    _blob_chunks[chunk->stream].push_back({n, times, offsets, reinterpret_cast<const uint8_t*>(offsets + n + 1)});
+                    _num_blobs[chunk->stream] += n;
+                }
+                else {
+                    ChunkView view;
+                    view.num_records = n;
+                    view.times = times;
+                    view.values = times + n;
+                    _chunks[chunk->stream].push_back(view);
+                    _num_records[chunk->stream] += n;
+                }
+                offset += chunk->size;
+            }
+        }
+
+        RecordingReader::~RecordingReader()
+        {
+            if (_mapping)
+                ::munmap(_mapping, _size);
+        }
+
+        const RecordingReader::StreamInfo& RecordingReader::stream(size_t index) const
+        {
+            ROBOT_DART_EXCEPTION_ASSERT(index < _streams.size(), "Stream index out of bounds");
+            return _streams[index];
+        }
+
+        int RecordingReader::stream_index(const std::string& name) const
+        {
+            for (size_t i = 0; i < _streams.size(); i++)
+                if (_streams[i].name == name)
+                    return static_cast<int>(i);
+            return -1;
+        }
+
+        size_t RecordingReader::num_records(size_t stream) const
+        {
+            ROBOT_DART_EXCEPTION_ASSERT(stream < _streams.size(), "Stream index out of bounds");
+            return _num_records[stream];
+        }
+
+        size_t RecordingReader::num_chunks(size_t stream) const
+        {
+            ROBOT_DART_EXCEPTION_ASSERT(stream < _streams.size(), "Stream index out of bounds");
+            return _chunks[stream].size();
+        }
+
+        const RecordingReader::ChunkView& RecordingReader::chunk(size_t stream, size_t index) const
+        {
+            ROBOT_DART_EXCEPTION_ASSERT(stream < _streams.size() && index < _chunks[stream].size(), "Chunk index out of bounds");
+            return _chunks[stream][index];
+        }
+
+        Eigen::Map<const Eigen::VectorXd> RecordingReader::chunk_times(size_t stream, size_t index) const
+        {
+            const ChunkView& view = chunk(stream, index);
+            return Eigen::Map<const Eigen::VectorXd>(view.times, view.num_records);
+        }
+
+        Eigen::Map<const Eigen::MatrixXd> RecordingReader::chunk_values(size_t stream, size_t index) const
+        {
+            const ChunkView& view = chunk(stream, index);
+            return Eigen::Map<const Eigen::MatrixXd>(view.values, view.num_records, _streams[stream].num_values);
+        }
+
+        Eigen::VectorXd RecordingReader::times(size_t stream) const
+        {
+            Eigen::VectorXd result(num_records(stream));
+            size_t row = 0;
+            for (size_t i = 0; i < _chunks[stream].size(); i++) {
+                auto times = chunk_times(stream, i);
+                result.segment(row, times.size()) = times;
+                row += times.size();
+            }
+            return result;
+        }
+
+        Eigen::MatrixXd RecordingReader::values(size_t stream) const
+        {
+            Eigen::MatrixXd result(num_records(stream), _streams[stream].num_values);
+            size_t row = 0;
+            for (size_t i = 0; i < _chunks[stream].size(); i++) {
+                auto values = chunk_values(stream, i);
+                result.middleRows(row, values.rows()) = values;
+                row += values.rows();
+            }
+            return result;
+        }
+
+        size_t RecordingReader::num_blobs(size_t stream) const
+        {
+            ROBOT_DART_EXCEPTION_ASSERT(stream < _streams.size(), "Stream index out of bounds");
+            return _num_blobs[stream];
+        }
+
+        RecordingReader::BlobView RecordingReader::blob(size_t stream, size_t index) const
+        {
+            ROBOT_DART_EXCEPTION_ASSERT(index < num_blobs(stream), "Blob index out of bounds");
+            for (auto& chunk : _blob_chunks[stream]) {
+                if (index < chunk.num_records) {
+                    BlobView view;
+                    view.time = chunk.times[index];
+                    view.data = chunk.data + chunk.offsets[index];
+                    view.size = chunk.offsets[index + 1] - chunk.offsets[index];
+                    return view;
+                }
+                index -= chunk.num_records;
+            }
+            return BlobView();
+        }
+    } // namespace sensor
+} // namespace robot_dart
\ No newline at end of file
@@ -0,0 +1,182 @@
+#ifndef ROBOT_DART_SENSOR_RECORDER_HPP
+#define ROBOT_DART_SENSOR_RECORDER_HPP
+
+#include <robot_dart/sensor/sensor.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace robot_dart {
+    namespace sensor {
+        // Layout of the recording files (native endianness, every block is 8-byte aligned):
+        //   RecordingFileHeader
+        //   RecordingStreamHeader x num_streams
+        //   chunks until the end of the file: RecordingChunkHeader + payload (`size` bytes)
+        // Values chunk (columnar): double times[n], then double values[n] for each of the num_values columns.
+        // Blobs chunk: double times[n], uint64_t offsets[n + 1] (from the start of the data), the data (padded to 8 bytes).
+        struct RecordingFileHeader {
+            char magic[8]; // "RDREC\0\0\0"
+            uint64_t version;
+            uint64_t num_streams;
+            uint64_t reserved;
+        };
+
+        struct RecordingStreamHeader {
+            char name[64];
+            char type[32]; // type() of the sensor
+            uint64_t num_values;
+            uint64_t frequency;
+            uint64_t has_blobs;
+        };
+
+        struct RecordingChunkHeader {
+            uint32_t magic; // 'CHNK'
+            uint32_t blobs; // 0: values, 1: blobs
+            uint64_t stream;
+            uint64_t num_records;
+            uint64_t size; // bytes of the payload
+        };
+
+        // Records the readings of sensors (their snapshot values and, optionally, their blobs, e.g., camera images)
+        // at their scheduled rates, in a binary file that RecordingReader maps without parsing.
+        // The sensors refreshed by another one (the sensors of a bank, the cameras of an atlas) are recorded when it refreshes them.
+        // The thread stepping the simulation only copies the readings in preallocated chunks (the blob chunks are reused
+        // with their buffers); the full chunks are transposed to columns and written by a background thread.
+        class Recorder {
+        public:
+            // chunk_size: records per chunk of each stream
+            Recorder(const std::string& filename, size_t chunk_size = 1000);
+            ~Recorder();
+
+            Recorder(const Recorder&) = delete;
+            void operator=(const Recorder&) = delete;
+
+            // the sensors are added before start() (the name is the type of the sensor followed by its index if empty);
+            // returns the index of the stream
+            size_t add_sensor(const std::shared_ptr<Sensor>& sensor, const std::string& name = "", bool blobs = false);
+            void add_sensors(const std::vector<std::shared_ptr<Sensor>>& sensors);
+
+            void start();
+            // writes the partial chunks and waits for the background thread
+            void stop();
+            bool recording() const { return _recording; }
+
+            const std::string& filename() const { return _filename; }
+            size_t num_streams() const { return _streams.size(); }
+
+            // called by the simulation after each refresh of a sensor (does nothing if the sensor is not recorded)
+            void record(Sensor& sensor, double t);
+
+        protected:
+            struct Chunk {
+                size_t stream;
+                bool blobs;
+                size_t num_records = 0;
+                std::vector<double> rows; // values: (time, values...) per record; blobs: times
+                std::vector<uint64_t> offsets; // blobs: offsets[i] is the start of blob i
+                std::vector<uint8_t> data; // blobs
+            };
+
+            struct Stream {
+                std::shared_ptr<Sensor> sensor;
+                std::string name;
+                size_t num_values;
+                bool blobs;
+                Eigen::VectorXd values;
+                size_t blob_capacity = 0; // bytes reserved for the data of each blob chunk (from Sensor::blob_size())
+                std::unique_ptr<Chunk> values_chunk, blobs_chunk;
+                std::vector<std::unique_ptr<Chunk>> free_values, free_blobs; // returned by the background thread
+            };
+
+            std::string _filename;
+            size_t _chunk_size;
+            std::vector<Stream> _streams;
+            std::unordered_map<const Sensor*, size_t> _stream_indices;
+            bool _recording = false;
+
+            FILE* _file = nullptr;
+            std::thread _writer;
+            std::mutex _mutex;
+            std::condition_variable _cv;
+            std::deque<std::unique_ptr<Chunk>> _full; // waiting to be written
+            bool _stop = false;
+
+            std::unique_ptr<Chunk> _new_chunk(size_t stream, bool blobs);
+            // hands the current chunk to the background thread and takes a free one
+            void _submit(Stream& stream, bool blobs);
+            void _writer_loop();
+            void _write_chunk(const Chunk& chunk, std::vector<double>& columns);
+        };
+
+        // Maps a recording file (read-only): the values of each chunk are used in place.
+        class RecordingReader {
+        public:
+            struct StreamInfo {
+                std::string name;
+                std::string type;
+                size_t num_values;
+                size_t frequency;
+                bool has_blobs;
+            };
+
+            struct ChunkView {
+                size_t num_records = 0;
+                const double* times = nullptr;
+                const double* values = nullptr; // num_values columns of num_records values
+            };
+
+            struct BlobView {
+                double time = 0.;
+                const uint8_t* data = nullptr;
+                size_t size = 0;
+            };
+
+            RecordingReader(const std::string& filename);
+            ~RecordingReader();
+
+            RecordingReader(const RecordingReader&) = delete;
+            void operator=(const RecordingReader&) = delete;
+
+            size_t num_streams() const { return _streams.size(); }
+            const StreamInfo& stream(size_t index) const;
+            // -1 if there is no stream with this name
+            int stream_index(const std::string& name) const;
+
+            size_t num_records(size_t stream) const;
+            size_t num_chunks(size_t stream) const;
+            const ChunkView& chunk(size_t stream, size_t index) const;
+            // times and values of a chunk (one row per record), without copy
+            Eigen::Map<const Eigen::VectorXd> chunk_times(size_t stream, size_t index) const;
+            Eigen::Map<const Eigen::MatrixXd> chunk_values(size_t stream, size_t index) const;
+
+            // copies of all the records of a stream (one row per record)
+            Eigen::VectorXd times(size_t stream) const;
+            Eigen::MatrixXd values(size_t stream) const;
+
+            size_t num_blobs(size_t stream) const;
+            BlobView blob(size_t stream, size_t index) const;
+
+        protected:
+            struct BlobChunk {
+                size_t num_records;
+                const double* times;
+                const uint64_t* offsets;
+                const uint8_t* data;
+            };
+
+            void* _mapping = nullptr;
+            size_t _size = 0;
+            std::vector<StreamInfo> _streams;
+            std::vector<std::vector<ChunkView>> _chunks;
+            std::vector<std::vector<BlobChunk>> _blob_chunks;
+            std::vector<size_t> _num_records, _num_blobs;
+        };
+    } // namespace sensor
+} // namespace robot_dart
+
+#endif
\ No newline at end of file
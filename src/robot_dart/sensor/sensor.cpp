@@ -12,6 +12,7 @@ namespace robot_dart {
             _active = false;
             if (enable) {
                 init();
+                _init_snapshot();
             }
         }
 
@@ -36,7 +37,12 @@ namespace robot_dart {
         }
 
         size_t Sensor::frequency() const { return _frequency; }
-        void Sensor::set_frequency(size_t freq) { _frequency = freq; }
+        void Sensor::set_frequency(size_t freq)
+        {
+            _frequency = freq;
+            if (_simu && _scheduler_task >= 0)
+                _simu->scheduler().set_task_frequency(_scheduler_task, freq);
+        }
 
         void Sensor::set_pose(const Eigen::Isometry3d& tf) { _world_pose = tf; }
         const Eigen::Isometry3d& Sensor::pose() const { return _world_pose; }
@@ -54,6 +60,13 @@ namespace robot_dart {
         {
             if (!_active)
                 return;
+            _update_pose();
+            calculate(t);
+            _publish_snapshot(t);
+        }
+
+        void Sensor::_update_pose()
+        {
             if (_attaching_to_body && !_attached_to_body) {
                 attach_to_body(_body_attached, _attached_tf);
             }
@@ -80,7 +93,6 @@ namespace robot_dart {
                 if (body)
                     _world_pose = body->getWorldTransform() * tf * _attached_tf;
             }
-            calculate(t);
         }
 
         void Sensor::attach_to_body(dart::dynamics::BodyNode* body, const Eigen::Isometry3d& tf)
@@ -127,5 +139,55 @@ namespace robot_dart {
             // attached to joint
             return _joint_attached->getName();
         }
+
+        bool Sensor::attached_to_robot(const std::shared_ptr<Robot>& robot) const
+        {
+            if (_attached_to_body && _body_attached)
+                return _body_attached->getSkeleton() == robot->skeleton();
+            if (_attached_to_joint && _joint_attached)
+                return _joint_attached->getSkeleton() == robot->skeleton();
+            return false;
+        }
+
+        bool Sensor::snapshot(Snapshot& snapshot) const
+        {
+            if (!_snapshot) {
+                snapshot = Snapshot();
+                return false;
+            }
+            return _snapshot->read(snapshot);
+        }
+
+        Snapshot Sensor::snapshot() const
+        {
+            Snapshot s;
+            snapshot(s);
+            return s;
+        }
+
+        void Sensor::_init_snapshot()
+        {
+            size_t size = snapshot_size();
+            if (size == 0)
+                _snapshot.reset();
+            else if (!_snapshot || _snapshot->size() != size)
+                _snapshot.reset(new SnapshotBuffer(size));
+            _snapshot_values.resize(size);
+        }
+
+        void Sensor::_publish_snapshot(double t)
+        {
+            // the size might have changed since the buffer was allocated (e.g., a joint added to a bank)
+            if (!_snapshot || _snapshot->size() != snapshot_size())
+                return;
+            write_snapshot(_snapshot_values);
+            _snapshot->publish(t, _snapshot_values);
+        }
+
+        void Sensor::_record(double t)
+        {
+            if (_simu && _simu->recorder())
+                _simu->recorder()->record(*this, t);
+        }
     } // namespace sensor
 } // namespace robot_dart
\ No newline at end of file
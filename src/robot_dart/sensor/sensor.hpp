@@ -2,6 +2,7 @@
 #define ROBOT_DART_SENSOR_SENSOR_HPP
 
 #include <robot_dart/robot.hpp>
+#include <robot_dart/sensor/snapshot.hpp>
 #include <robot_dart/utils.hpp>
 
 #include <memory>
@@ -36,6 +37,8 @@ namespace robot_dart {
             const Eigen::Isometry3d& pose() const;
 
             void refresh(double t);
+            // true if the sensor is refreshed by another one (e.g., a TorqueBank) and not by the simulation
+            bool driven() const { return _driven; }
 
             virtual void init() = 0;
             // TO-DO: Maybe make this const?
@@ -51,11 +54,44 @@ namespace robot_dart {
 
             void detach();
             const std::string& attached_to() const;
+            // true if the sensor measures a body or a joint of the robot
+            virtual bool attached_to_robot(const std::shared_ptr<Robot>& robot) const;
+
+            // The readings are published as a flat vector after each refresh (see the layout in each sensor).
+            // Sensors without readings to publish (e.g., cameras) have a snapshot size of 0.
+            virtual size_t snapshot_size() const { return 0; }
+            virtual void write_snapshot(Eigen::Ref<Eigen::VectorXd>) const {}
+            // Appends the binary data of the last refresh (e.g., the image of a camera) for the recorders.
+            // Returns false if the sensor has no such data.
+            virtual bool write_blob(std::vector<uint8_t>&) { return false; }
+            // upper bound of the size of a blob (0 if unknown): the recorders preallocate their buffers with it
+            virtual size_t blob_size() const { return 0; }
+
+            // Copy of the last published readings, safe to call from any thread while the simulation steps
+            // (but not while the sensor is added to a simulation or activated). The thread stepping the
+            // simulation is never blocked. Returns false if nothing was published yet.
+            bool snapshot(Snapshot& snapshot) const;
+            Snapshot snapshot() const;
 
         protected:
+            friend class robot_dart::RobotDARTSimu;
+
+            // computes _world_pose from the body or the joint the sensor is attached to (called by refresh())
+            void _update_pose();
+            // allocates the snapshot buffer (when the snapshot size changed)
+            void _init_snapshot();
+            void _publish_snapshot(double t);
+            // gives the last refresh to the recorder of the simulation (for the sensors refreshed by another one)
+            void _record(double t);
+
+            std::unique_ptr<SnapshotBuffer> _snapshot;
+            Eigen::VectorXd _snapshot_values;
+
             RobotDARTSimu* _simu = nullptr;
             bool _active;
             size_t _frequency;
+            int _scheduler_task = -1; // task of the simulation's scheduler (-1 if not added to a simulation)
+            bool _driven = false;
 
             Eigen::Isometry3d _world_pose;
 
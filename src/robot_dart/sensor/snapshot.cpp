@@ -0,0 +1,63 @@
+#include "snapshot.hpp"
+
+namespace robot_dart {
+    namespace sensor {
+        SnapshotBuffer::SnapshotBuffer(size_t size) : _size(size), _sequence(0), _values(new std::atomic<double>[2 * size])
+        {
+            for (size_t i = 0; i < 2 * _size; i++)
+                _values[i].store(0., std::memory_order_relaxed);
+            _times[0].store(-1., std::memory_order_relaxed);
+            _times[1].store(-1., std::memory_order_relaxed);
+        }
+
+        void SnapshotBuffer::publish(double time, const Eigen::VectorXd& values)
+        {
+            ROBOT_DART_ASSERT(static_cast<size_t>(values.size()) == _size, "Snapshot size mismatch", );
+
+            // there is only one writer: a relaxed load is enough
+            uint64_t sequence = _sequence.load(std::memory_order_relaxed);
+            _sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            // publication k = sequence / 2 + 1 goes in the buffer that is not the last published one
+            size_t buffer = (sequence / 2 + 1) % 2;
+            std::atomic<double>* data = _values.get() + buffer * _size;
+            for (size_t i = 0; i < _size; i++)
+                data[i].store(values[i], std::memory_order_relaxed);
+            _times[buffer].store(time, std::memory_order_relaxed);
+
+            _sequence.store(sequence + 2, std::memory_order_release);
+        }
+
+        bool SnapshotBuffer::read(Snapshot& snapshot) const
+        {
+            if (static_cast<size_t>(snapshot.values.size()) != _size)
+                snapshot.values.resize(_size);
+
+            while (true) {
+                uint64_t begin = _sequence.load(std::memory_order_acquire);
+                uint64_t published = begin / 2;
+                if (published == 0) {
+                    snapshot.time = -1.;
+                    snapshot.sequence = 0;
+                    snapshot.values.setZero();
+                    return false;
+                }
+
+                size_t buffer = published % 2;
+                const std::atomic<double>* data = _values.get() + buffer * _size;
+                for (size_t i = 0; i < _size; i++)
+                    snapshot.values[i] = data[i].load(std::memory_order_relaxed);
+                snapshot.time = _times[buffer].load(std::memory_order_relaxed);
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                // the buffer is only overwritten by publication `published + 2`, which starts at 2 * published + 3
+                uint64_t end = _sequence.load(std::memory_order_relaxed);
+                if (end <= 2 * published + 2) {
+                    snapshot.sequence = published;
+                    return true;
+                }
+            }
+        }
+    } // namespace sensor
+} // namespace robot_dart
\ No newline at end of file
@@ -0,0 +1,42 @@
+#ifndef ROBOT_DART_SENSOR_SNAPSHOT_HPP
+#define ROBOT_DART_SENSOR_SNAPSHOT_HPP
+
+#include <robot_dart/utils.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace robot_dart {
+    namespace sensor {
+        // timestamped copy of the readings of a sensor
+        struct Snapshot {
+            double time = -1.; // simulation time of the readings
+            uint64_t sequence = 0; // number of published readings (0 if the sensor was never refreshed)
+            Eigen::VectorXd values;
+        };
+
+        // Seqlock over two buffers: a single writer (the thread stepping the simulation) publishes the readings
+        // and any number of readers copy the last published ones. The writer never waits for the readers and
+        // a reader only retries when the writer publishes twice while it copies.
+        class SnapshotBuffer {
+        public:
+            SnapshotBuffer(size_t size = 0);
+
+            size_t size() const { return _size; }
+
+            void publish(double time, const Eigen::VectorXd& values);
+
+            // false if nothing was published yet (no allocation if `snapshot.values` has the right size)
+            bool read(Snapshot& snapshot) const;
+
+        protected:
+            size_t _size;
+            std::atomic<uint64_t> _sequence; // 2 * number of publications (+1 while publishing)
+            std::unique_ptr<std::atomic<double>[]> _values; // buffer of publication k at (k % 2) * _size
+            std::atomic<double> _times[2];
+        };
+    } // namespace sensor
+} // namespace robot_dart
+
+#endif
\ No newline at end of file
@@ -5,6 +5,22 @@
 
 namespace robot_dart {
     namespace sensor {
+        namespace {
+            using single_dof_joint_t = dart::dynamics::GenericJoint<dart::math::R1Space>;
+
+            // torques of the degrees of freedom of the joint due to the wrench of its child body
+            // (no allocation for 1-DoF joints: `single_dof` is the joint if it is one, nullptr otherwise)
+            template <typename Derived>
+            void joint_torques(const dart::dynamics::Joint* joint, const single_dof_joint_t* single_dof, const dart::dynamics::BodyNode* child_body, Eigen::MatrixBase<Derived> const& torques)
+            {
+                auto& out = const_cast<Eigen::MatrixBase<Derived>&>(torques);
+                if (single_dof)
+                    out(0) = single_dof->getRelativeJacobianStatic().col(0).dot(child_body->getBodyForce());
+                else
+                    out.noalias() = joint->getRelativeJacobian().transpose() * child_body->getBodyForce();
+            }
+        } // namespace
+
         Torque::Torque(dart::dynamics::Joint* joint, size_t frequency) : Sensor(frequency), _torques(joint->getNumDofs())
         {
             attach_to_joint(joint, Eigen::Isometry3d::Identity());
@@ -23,21 +39,133 @@ namespace robot_dart {
             if (!_attached_to_joint)
                 return; // cannot compute anything if not attached to a joint
 
-            Eigen::Vector6d wrench = Eigen::Vector6d::Zero();
             auto child_body = _joint_attached->getChildBodyNode();
             ROBOT_DART_ASSERT(child_body != nullptr, "Child BodyNode is nullptr", );
 
-            wrench = child_body->getBodyForce();
-
             // get forces for only the only degrees of freedom in this joint
-            _torques = _joint_attached->getRelativeJacobian().transpose() * wrench;
+            joint_torques(_joint_attached, dynamic_cast<const single_dof_joint_t*>(_joint_attached), child_body, _torques);
         }
 
         std::string Torque::type() const { return "t"; }
 
+        size_t Torque::snapshot_size() const { return _torques.size(); }
+
+        void Torque::write_snapshot(Eigen::Ref<Eigen::VectorXd> values) const
+        {
+            values = _torques;
+        }
+
         const Eigen::VectorXd& Torque::torques() const
         {
             return _torques;
         }
+
+        TorqueBank::TorqueBank(size_t frequency) : Sensor(frequency) {}
+
+        TorqueBank::TorqueBank(const std::vector<dart::dynamics::Joint*>& joints, size_t frequency) : Sensor(frequency)
+        {
+            for (auto joint : joints)
+                add_joint(joint);
+        }
+
+        size_t TorqueBank::add_joint(dart::dynamics::Joint* joint)
+        {
+            ROBOT_DART_EXCEPTION_ASSERT(joint, "Joint is nullptr");
+            ROBOT_DART_EXCEPTION_ASSERT(joint->getChildBodyNode(), "Child BodyNode is nullptr");
+
+            _joints.push_back(joint);
+            _child_bodies.push_back(joint->getChildBodyNode());
+            // resolved once: the refreshes do not cast
+            _single_dofs.push_back(dynamic_cast<const single_dof_joint_t*>(joint));
+            _offsets.push_back(_torques.size());
+            _sensors.push_back(nullptr);
+
+            // the storage is only resized when joints are added
+            _torques.conservativeResize(_torques.size() + joint->getNumDofs());
+            _torques.tail(joint->getNumDofs()).setZero();
+
+            return _joints.size() - 1;
+        }
+
+        size_t TorqueBank::add_sensor(const std::shared_ptr<Torque>& sensor)
+        {
+            ROBOT_DART_EXCEPTION_ASSERT(sensor && sensor->_attached_to_joint, "The torque sensor is not attached to a joint");
+            size_t index = add_joint(sensor->_joint_attached);
+            _sensors[index] = sensor;
+            sensor->_driven = true;
+            return index;
+        }
+
+        void TorqueBank::init()
+        {
+            _torques.setZero();
+
+            for (auto& sensor : _sensors) {
+                if (sensor) {
+                    sensor->_simu = _simu;
+                    sensor->_frequency = _frequency;
+                    sensor->init();
+                    sensor->_init_snapshot();
+                }
+            }
+            _active = true;
+        }
+
+        void TorqueBank::calculate(double t)
+        {
+            for (size_t i = 0; i < _joints.size(); i++) {
+                auto torques = _torques.segment(_offsets[i], _joints[i]->getNumDofs());
+                joint_torques(_joints[i], _single_dofs[i], _child_bodies[i], torques);
+                // the sensors removed from the simulation are not refreshed anymore
+                if (_sensors[i] && _sensors[i]->_simu) {
+                    _sensors[i]->_update_pose();
+                    _sensors[i]->_torques = torques; // same size: no allocation
+                    _sensors[i]->_publish_snapshot(t);
+                    _sensors[i]->_record(t);
+                }
+            }
+        }
+
+        std::string TorqueBank::type() const { return "t_bank"; }
+
+        size_t TorqueBank::snapshot_size() const { return _torques.size(); }
+
+        void TorqueBank::write_snapshot(Eigen::Ref<Eigen::VectorXd> values) const
+        {
+            values = _torques;
+        }
+
+        bool TorqueBank::attached_to_robot(const std::shared_ptr<Robot>& robot) const
+        {
+            for (auto joint : _joints)
+                if (joint->getSkeleton() == robot->skeleton())
+                    return true;
+            return false;
+        }
+
+        size_t TorqueBank::num_joints() const { return _joints.size(); }
+
+        dart::dynamics::Joint* TorqueBank::joint(size_t index) const
+        {
+            ROBOT_DART_ASSERT(index < _joints.size(), "Joint index out of bounds", nullptr);
+            return _joints[index];
+        }
+
+        size_t TorqueBank::offset(size_t index) const
+        {
+            ROBOT_DART_ASSERT(index < _offsets.size(), "Joint index out of bounds", 0);
+            return _offsets[index];
+        }
+
+        const Eigen::VectorXd& TorqueBank::torques() const
+        {
+            return _torques;
+        }
+
+        Eigen::VectorBlock<const Eigen::VectorXd> TorqueBank::torques(size_t index) const
+        {
+            ROBOT_DART_EXCEPTION_ASSERT(index < _joints.size(), "Joint index out of bounds");
+            return _torques.segment(_offsets[index], _joints[index]->getNumDofs());
+        }
     } // namespace sensor
 } // namespace robot_dart
\ No newline at end of file
@@ -2,9 +2,12 @@
 #define ROBOT_DART_SENSOR_TORQUE_HPP
 
 #include <robot_dart/sensor/sensor.hpp>
+#include <robot_dart/utils_headers_dart_dynamics.hpp>
 
 namespace robot_dart {
     namespace sensor {
+        class TorqueBank;
+
         class Torque : public Sensor {
         public:
             Torque(dart::dynamics::Joint* joint, size_t frequency = 1000);
@@ -16,6 +19,10 @@ namespace robot_dart {
 
             std::string type() const override;
 
+            // snapshot: the torques of the joint
+            size_t snapshot_size() const override;
+            void write_snapshot(Eigen::Ref<Eigen::VectorXd> values) const override;
+
             const Eigen::VectorXd& torques() const;
 
             void attach_to_body(dart::dynamics::BodyNode*, const Eigen::Isometry3d&) override
@@ -24,6 +31,62 @@ namespace robot_dart {
             }
 
         protected:
+            friend class TorqueBank;
+
+            Eigen::VectorXd _torques;
+        };
+
+        // Torque sensors of several joints refreshed in one pass (one scheduler task for all the joints).
+        // The torques of all the joints are packed in one vector (in the order of addition).
+        // Torque sensors added to the bank are not refreshed by the simulation but updated by the bank.
+        class TorqueBank : public Sensor {
+        public:
+            TorqueBank(size_t frequency = 1000);
+            TorqueBank(const std::vector<dart::dynamics::Joint*>& joints, size_t frequency = 1000);
+
+            // returns the index of the joint in the bank
+            size_t add_joint(dart::dynamics::Joint* joint);
+            size_t add_joint(const std::shared_ptr<Robot>& robot, const std::string& joint_name) { return add_joint(robot->joint(joint_name)); }
+            // the torques of the sensor are updated by the bank
+            size_t add_sensor(const std::shared_ptr<Torque>& sensor);
+
+            void init() override;
+
+            void calculate(double) override;
+
+            std::string type() const override;
+
+            // snapshot: the packed torques
+            size_t snapshot_size() const override;
+            void write_snapshot(Eigen::Ref<Eigen::VectorXd> values) const override;
+
+            bool attached_to_robot(const std::shared_ptr<Robot>& robot) const override;
+
+            size_t num_joints() const;
+            dart::dynamics::Joint* joint(size_t index) const;
+            // index of the first torque of the joint in the packed vector
+            size_t offset(size_t index) const;
+
+            const Eigen::VectorXd& torques() const;
+            Eigen::VectorBlock<const Eigen::VectorXd> torques(size_t index) const;
+
+            void attach_to_body(dart::dynamics::BodyNode*, const Eigen::Isometry3d&) override
+            {
+                ROBOT_DART_WARNING(true, "You cannot attach a torque bank to a body!");
+            }
+
+            void attach_to_joint(dart::dynamics::Joint*, const Eigen::Isometry3d&) override
+            {
+                ROBOT_DART_WARNING(true, "You cannot attach a torque bank to a joint! Use add_joint instead.");
+            }
+
+        protected:
+            std::vector<dart::dynamics::Joint*> _joints;
+            std::vector<const dart::dynamics::BodyNode*> _child_bodies;
+            std::vector<const dart::dynamics::GenericJoint<dart::math::R1Space>*> _single_dofs; // nullptr if not a 1-DoF joint
+            std::vector<size_t> _offsets;
+            std::vector<std::shared_ptr<Torque>> _sensors; // nullptr if the joint has no sensor
+
             Eigen::VectorXd _torques;
         };
     } // namespace sensor
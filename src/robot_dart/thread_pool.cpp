@@ -0,0 +1,115 @@
+#include <robot_dart/thread_pool.hpp>
+
+#include <algorithm>
+
+namespace robot_dart {
+    ThreadPool::ThreadPool(size_t num_threads) : _num_threads(num_threads)
+    {
+        if (_num_threads == 0)
+            _num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+        _chunks.reset(new Chunk[_num_threads]);
+
+        // the calling thread is participant 0
+        for (size_t i = 1; i < _num_threads; i++)
+            _workers.emplace_back(&ThreadPool::_worker_loop, this, i);
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _work_cv.notify_all();
+        for (auto& w : _workers)
+            w.join();
+    }
+
+    void ThreadPool::parallel_for(size_t n, const task_t& task)
+    {
+        if (n == 0)
+            return;
+
+        std::lock_guard<std::mutex> call_lock(_call_mutex);
+
+        // no need to wake up anyone for a single task
+        if (_num_threads == 1 || n == 1) {
+            for (size_t i = 0; i < n; i++)
+                task(i);
+            return;
+        }
+
+        // split [0, n) in contiguous chunks
+        size_t per_chunk = n / _num_threads;
+        size_t remainder = n % _num_threads;
+        size_t begin = 0;
+        for (size_t i = 0; i < _num_threads; i++) {
+            size_t size = per_chunk + (i < remainder ? 1 : 0);
+            _chunks[i].next.store(begin, std::memory_order_relaxed);
+            _chunks[i].end = begin + size;
+            begin += size;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _task = &task;
+            _exception = nullptr;
+            _pending = _workers.size();
+            _generation++;
+        }
+        _work_cv.notify_all();
+
+        _run_chunks(0);
+
+        std::exception_ptr exception;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _done_cv.wait(lock, [this] { return _pending == 0; });
+            _task = nullptr;
+            exception = _exception;
+        }
+
+        if (exception)
+            std::rethrow_exception(exception);
+    }
+
+    void ThreadPool::_worker_loop(size_t id)
+    {
+        size_t seen = 0;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _work_cv.wait(lock, [this, seen] { return _stop || _generation != seen; });
+                if (_stop)
+                    return;
+                seen = _generation;
+            }
+
+            _run_chunks(id);
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_pending == 0)
+                _done_cv.notify_one();
+        }
+    }
+
+    void ThreadPool::_run_chunks(size_t id)
+    {
+        // own chunk first, then steal from the others
+        for (size_t k = 0; k < _num_threads; k++) {
+            Chunk& chunk = _chunks[(id + k) % _num_threads];
+            size_t i;
+            while ((i = chunk.next.fetch_add(1, std::memory_order_relaxed)) < chunk.end) {
+                try {
+                    (*_task)(i);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    if (!_exception)
+                        _exception = std::current_exception();
+                }
+            }
+        }
+    }
+} // namespace robot_dart
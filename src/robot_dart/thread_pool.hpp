@@ -0,0 +1,61 @@
+#ifndef ROBOT_DART_THREAD_POOL_HPP
+#define ROBOT_DART_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace robot_dart {
+    /// Small fixed-size pool of worker threads with a work-stealing parallel_for.
+    /// The index range of each parallel_for is split in one contiguous chunk per participant
+    /// (the workers and the calling thread); a participant that finishes its own chunk
+    /// steals the remaining indices of the others.
+    class ThreadPool {
+    public:
+        using task_t = std::function<void(size_t)>;
+
+        /// num_threads counts the calling thread; 0 means std::thread::hardware_concurrency()
+        ThreadPool(size_t num_threads = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        void operator=(const ThreadPool&) = delete;
+
+        size_t num_threads() const { return _num_threads; }
+
+        /// calls task(i) for every i in [0, n) and blocks until all calls are done
+        /// the first exception thrown by a task is re-thrown here
+        /// it is not possible to call parallel_for from inside a task
+        void parallel_for(size_t n, const task_t& task);
+
+    protected:
+        struct alignas(64) Chunk {
+            std::atomic<size_t> next{0};
+            size_t end = 0;
+        };
+
+        size_t _num_threads;
+        std::vector<std::thread> _workers;
+        std::unique_ptr<Chunk[]> _chunks;
+
+        std::mutex _call_mutex; // only one parallel_for at a time
+        std::mutex _mutex;
+        std::condition_variable _work_cv, _done_cv;
+        size_t _generation = 0;
+        size_t _pending = 0;
+        bool _stop = false;
+
+        const task_t* _task = nullptr;
+        std::exception_ptr _exception;
+
+        void _worker_loop(size_t id);
+        void _run_chunks(size_t id);
+    };
+} // namespace robot_dart
+
+#endif
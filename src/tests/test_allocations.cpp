@@ -0,0 +1,374 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE test_allocations
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#include <boost/test/unit_test.hpp>
+
+#include <robot_dart/control/pd_control.hpp>
+#include <robot_dart/control/simple_control.hpp>
+#include <robot_dart/gui/helper.hpp>
+#include <robot_dart/robot_dart_simu.hpp>
+#include <robot_dart/robots/talos.hpp>
+
+// The C++ allocations (new, std containers) are counted by replacing the global operator new.
+// With glibc, malloc and friends are also replaced, so that the allocations of Eigen (and of C code) are counted too;
+// elsewhere, only the C++ allocations are counted.
+#ifdef __GLIBC__
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t num, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+}
+#endif
+
+namespace {
+    std::atomic<bool> counting(false);
+    std::atomic<size_t> num_allocations(0);
+
+    void count_allocation()
+    {
+        if (counting)
+            num_allocations++;
+    }
+
+    // allocations that are not counted again by the malloc replacements
+    void* raw_malloc(size_t size)
+    {
+#ifdef __GLIBC__
+        return __libc_malloc(size);
+#else
+        return std::malloc(size);
+#endif
+    }
+
+#ifdef __cpp_aligned_new
+    void* raw_aligned_malloc(size_t alignment, size_t size)
+    {
+#ifdef __GLIBC__
+        return __libc_memalign(alignment, size);
+#else
+        void* ptr = nullptr;
+        return (posix_memalign(&ptr, std::max(alignment, sizeof(void*)), size) == 0) ? ptr : nullptr;
+#endif
+    }
+#endif
+} // namespace
+
+#ifdef __GLIBC__
+extern "C" {
+void* malloc(size_t size)
+{
+    count_allocation();
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t num, size_t size)
+{
+    count_allocation();
+    return __libc_calloc(num, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    count_allocation();
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    count_allocation();
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    count_allocation();
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    count_allocation();
+    *ptr = __libc_memalign(alignment, size);
+    return *ptr ? 0 : ENOMEM;
+}
+}
+#endif
+
+void* operator new(size_t size)
+{
+    count_allocation();
+    void* ptr = raw_malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    count_allocation();
+    return raw_malloc(size ? size : 1);
+}
+void* operator new[](size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+
+#ifdef __cpp_aligned_new
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    count_allocation();
+    void* ptr = raw_aligned_malloc(static_cast<size_t>(alignment), size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+void* operator new[](size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+#endif
+
+struct AllocationCounter {
+    AllocationCounter()
+    {
+        num_allocations = 0;
+        counting = true;
+    }
+    ~AllocationCounter() { counting = false; }
+
+    size_t count() const { return num_allocations.load(); }
+};
+
+using namespace robot_dart;
+
+std::shared_ptr<robots::Talos> make_talos()
+{
+    setenv("ROBOT_DART_PATH", (std::string(ROBOT_DART_BUILD_DIR) + "/robots").c_str(), 1);
+    return std::make_shared<robots::Talos>();
+}
+
+BOOST_AUTO_TEST_CASE(test_state_getters)
+{
+    auto robot = make_talos();
+    RobotDARTSimu simu(0.001);
+    simu.add_robot(robot);
+
+    auto all = robot->dof_selection();
+    auto arms = robot->dof_selection({"arm_left_1_joint", "arm_left_2_joint", "arm_left_3_joint", "arm_left_4_joint", "torso_1_joint"});
+
+    Eigen::VectorXd q(all.size()), dq(arms.size()), cg(all.size()), tau(arms.size());
+    Eigen::MatrixXd J(6, arms.size()), J_all(6, all.size()), M(all.size(), all.size()), M_arms(arms.size(), arms.size());
+
+    auto read_state = [&]() {
+        robot->positions(q, all);
+        robot->velocities(dq, arms);
+        robot->commands(tau, arms);
+        robot->coriolis_gravity_forces(cg, all);
+        robot->jacobian(J, "arm_left_7_link", arms);
+        robot->jacobian(J_all, "arm_left_7_link", all);
+        robot->mass_matrix(M, all);
+        robot->mass_matrix(M_arms, arms);
+    };
+
+    for (int i = 0; i < 10; i++)
+        simu.step_world();
+    // DART updates its caches (mass matrix, etc.) when they are first used after a step
+    read_state();
+
+    {
+        AllocationCounter counter;
+        for (int i = 0; i < 10; i++)
+            read_state();
+        BOOST_CHECK_EQUAL(counter.count(), 0u);
+    }
+
+    // same values as the allocating versions
+    BOOST_CHECK(q.isApprox(robot->positions()));
+    BOOST_CHECK(dq.isApprox(robot->velocities(arms.names())));
+    BOOST_CHECK(cg.isApprox(robot->coriolis_gravity_forces()));
+    BOOST_CHECK(J.isApprox(robot->jacobian("arm_left_7_link", arms.names())));
+    BOOST_CHECK(J_all.isApprox(robot->jacobian("arm_left_7_link")));
+    BOOST_CHECK(M.isApprox(robot->mass_matrix()));
+    BOOST_CHECK(M_arms.isApprox(robot->mass_matrix(arms.names())));
+}
+
+BOOST_AUTO_TEST_CASE(test_controller_mixing)
+{
+    auto robot = make_talos();
+    RobotDARTSimu simu(0.001);
+    simu.add_robot(robot);
+
+    std::vector<std::string> arm = {"arm_left_1_joint", "arm_left_2_joint", "arm_left_3_joint"};
+    std::vector<std::string> arm_torso = {"arm_left_2_joint", "torso_1_joint"};
+    auto ctrl1 = std::make_shared<control::SimpleControl>(Eigen::VectorXd::Constant(arm.size(), 1.), arm);
+    auto ctrl2 = std::make_shared<control::SimpleControl>(Eigen::VectorXd::Constant(arm_torso.size(), 2.), arm_torso);
+    robot->add_controller(ctrl1, 1.);
+    robot->add_controller(ctrl2, 0.5);
+
+    robot->update(0.);
+    {
+        AllocationCounter counter;
+        for (int i = 0; i < 10; i++)
+            robot->update(i * 0.001);
+        BOOST_CHECK_EQUAL(counter.count(), 0u);
+    }
+
+    BOOST_CHECK(robot->commands({"arm_left_1_joint"})[0] == 1.);
+    BOOST_CHECK(robot->commands({"arm_left_2_joint"})[0] == 2.);
+    BOOST_CHECK(robot->commands({"torso_1_joint"})[0] == 1.);
+    BOOST_CHECK(robot->commands({"arm_right_1_joint"})[0] == 0.);
+}
+
+BOOST_AUTO_TEST_CASE(test_pd_control)
+{
+    auto robot = make_talos();
+    RobotDARTSimu simu(0.001);
+    simu.add_robot(robot);
+
+    // full control includes the free joint of the floating base
+    auto pd = std::make_shared<control::PDControl>(Eigen::VectorXd::Zero(robot->num_dofs()), true);
+    robot->add_controller(pd);
+
+    robot->update(0.);
+    {
+        AllocationCounter counter;
+        for (int i = 0; i < 10; i++)
+            robot->update(i * 0.001);
+        BOOST_CHECK_EQUAL(counter.count(), 0u);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_sensor_banks)
+{
+    auto robot = make_talos();
+    RobotDARTSimu simu(0.001);
+    simu.add_robot(robot);
+
+    // IMU, 4 force/torque sensors and 22 torque sensors (the banks belong to the robot and are not listed)
+    BOOST_REQUIRE_EQUAL(simu.sensors().size(), 27u);
+    BOOST_CHECK_EQUAL(simu.sensors(robot).size(), 27u);
+    BOOST_CHECK_EQUAL(simu.sensor_snapshots(robot).size(), 27u);
+    // the sensors of the banks are reachable, but refreshed by their bank
+    BOOST_CHECK(simu.sensor(1).get() == &robot->ft_foot_left());
+    for (size_t i = 1; i < 27; i++) {
+        BOOST_CHECK(simu.sensor(i)->type() == ((i < 5) ? "ft" : "t"));
+        BOOST_CHECK(simu.sensor(i)->driven());
+    }
+    BOOST_CHECK(!simu.sensor(0)->driven());
+    const auto& ft_bank = robot->ft_bank();
+    const auto& torque_bank = robot->torque_bank();
+    BOOST_CHECK_EQUAL(ft_bank.num_joints(), 4u);
+    BOOST_CHECK_EQUAL(torque_bank.num_joints(), 22u);
+    BOOST_CHECK_EQUAL(torque_bank.torques().size(), 22);
+
+    for (int i = 0; i < 10; i++)
+        simu.step_world();
+
+    {
+        // same joints as the banks of the robot
+        sensor::ForceTorqueBank ft_copy;
+        for (size_t i = 0; i < ft_bank.num_joints(); i++)
+            ft_copy.add_joint(ft_bank.joint(i));
+        sensor::TorqueBank torque_copy;
+        for (size_t i = 0; i < torque_bank.num_joints(); i++)
+            torque_copy.add_joint(torque_bank.joint(i));
+        ft_copy.set_simu(&simu);
+        ft_copy.init();
+        torque_copy.set_simu(&simu);
+        torque_copy.init();
+
+        AllocationCounter counter;
+        for (int i = 0; i < 10; i++) {
+            ft_copy.refresh(simu.scheduler().current_time());
+            torque_copy.refresh(simu.scheduler().current_time());
+        }
+        BOOST_CHECK_EQUAL(counter.count(), 0u);
+    }
+
+    // same values as the individual sensors
+    for (size_t i = 0; i < torque_bank->num_joints(); i++) {
+        auto joint = torque_bank->joint(i);
+        sensor::Torque single(joint);
+        single.calculate(0.);
+        BOOST_CHECK_SMALL((torque_bank->torques(i) - single.torques()).norm(), 1e-12);
+        BOOST_CHECK_SMALL((robot->torques().at(joint->getName())->torques() - single.torques()).norm(), 1e-12);
+    }
+
+    sensor::ForceTorque single(robot, "leg_left_6_joint");
+    single.calculate(0.);
+    BOOST_CHECK_SMALL((ft_bank.wrench(0) - single.wrench()).norm(), 1e-12);
+    BOOST_CHECK_SMALL((robot->ft_foot_left().wrench() - single.wrench()).norm(), 1e-12);
+
+    // the bank does not refresh the sensors removed from the simulation
+    auto removed = robot->torques().at(torque_bank.joint(0)->getName());
+    double time = removed->snapshot().time;
+    simu.remove_sensors("t");
+    BOOST_CHECK_EQUAL(simu.sensors().size(), 5u);
+    for (int i = 0; i < 10; i++)
+        simu.step_world();
+    BOOST_CHECK_EQUAL(removed->snapshot().time, time);
+    BOOST_CHECK(robot->ft_foot_left().snapshot().time > time);
+}
+
+BOOST_AUTO_TEST_CASE(test_step_world)
+{
+    // fixed and without floor: the contact constraints are allocated by DART at every step
+    auto robot = make_talos();
+    robot->fix_to_world();
+    RobotDARTSimu simu(0.001);
+    simu.add_robot(robot);
+
+    auto pd = std::make_shared<control::PDControl>(Eigen::VectorXd::Zero(robot->num_dofs()));
+    robot->add_controller(pd);
+
+    // warm-up: the buffers of the controllers and of the sensors are sized at the first steps
+    // (more than one turn of the wheel of the scheduler, even if its buckets are reserved)
+    for (int i = 0; i < 300; i++)
+        simu.step();
+
+    {
+        // step() runs the controllers (step_world() does not)
+        AllocationCounter counter;
+        for (int i = 0; i < 300; i++)
+            simu.step();
+        BOOST_CHECK_EQUAL(counter.count(), 0u);
+    }
+
+    // the robot falls under gravity: the PD controller pushes it back to the zero position
+    Eigen::VectorXd commands = robot->commands();
+    BOOST_CHECK(commands.allFinite());
+    BOOST_CHECK(commands.norm() > 0.);
+    BOOST_CHECK(robot->positions().norm() > 0.);
+}
+
+BOOST_AUTO_TEST_CASE(test_point_cloud_generator)
+{
+    // the rows are split between the threads of the pool of the generator
+    gui::PointCloudGenerator generator(3);
+    Eigen::Matrix3d K;
+    K << 50., 0., 32., 0., 50., 24., 0., 0., 1.;
+    generator.set_intrinsics(K, 64, 48);
+
+    gui::DepthImage depth;
+    depth.width = 64;
+    depth.height = 48;
+    depth.data.assign(depth.width * depth.height, 1.);
+    Eigen::Matrix3Xf points;
+    generator.compute(depth, Eigen::Matrix4d::Identity(), 10., points);
+
+    {
+        AllocationCounter counter;
+        for (int i = 0; i < 100; i++)
+            generator.compute(depth, Eigen::Matrix4d::Identity(), 10., points);
+        BOOST_CHECK_EQUAL(counter.count(), 0u);
+    }
+}
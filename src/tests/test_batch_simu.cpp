@@ -0,0 +1,152 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE test_batch_simu
+
+#include <atomic>
+#include <stdexcept>
+
+#include <boost/test/unit_test.hpp>
+
+#include <robot_dart/batch_simu.hpp>
+#include <robot_dart/control/batch_pd_control.hpp>
+#include <robot_dart/control/pd_control.hpp>
+#include <robot_dart/robot.hpp>
+#include <robot_dart/thread_pool.hpp>
+#include <robot_dart/utils.hpp>
+
+using namespace robot_dart;
+
+namespace {
+    std::shared_ptr<Robot> fixed_pendulum()
+    {
+        auto pendulum = std::make_shared<Robot>(std::string(ROBOT_DART_BUILD_DIR) + "/robots/pendulum.urdf");
+        pendulum->fix_to_world();
+        return pendulum;
+    }
+
+    // a controller that fails when it is asked for commands
+    class ThrowingControl : public control::RobotControl {
+    public:
+        ThrowingControl() : RobotControl(Eigen::VectorXd::Zero(1)) {}
+
+        void configure() override { _active = true; }
+        Eigen::VectorXd calculate(double) override { throw std::runtime_error("ThrowingControl"); }
+        std::shared_ptr<control::RobotControl> clone() const override { return std::make_shared<ThrowingControl>(); }
+    };
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_thread_pool)
+{
+    ThreadPool pool(3);
+    BOOST_CHECK(pool.num_threads() == 3);
+
+    // every index is done exactly once
+    std::vector<std::atomic<int>> calls(100);
+    for (auto& c : calls)
+        c = 0;
+    pool.parallel_for(calls.size(), [&](size_t i) { calls[i]++; });
+    for (auto& c : calls)
+        BOOST_CHECK(c == 1);
+
+    // the exception of a task is given back to the caller and the pool can still be used
+    BOOST_CHECK_THROW(pool.parallel_for(100, [](size_t i) { if (i == 57) throw std::runtime_error("task"); }), std::runtime_error);
+    std::atomic<size_t> sum(0);
+    pool.parallel_for(100, [&](size_t i) { sum += i; });
+    BOOST_CHECK(sum == 4950);
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_simu_sequential)
+{
+    const size_t num_worlds = 4;
+    const double dt = 0.001;
+
+    Eigen::VectorXd target(1);
+    target << 1.;
+    auto batch = std::make_shared<control::PDBatch>(target);
+    auto reference_batch = std::make_shared<control::PDBatch>(target);
+    batch->set_pd(20., 1.);
+    reference_batch->set_pd(20., 1.);
+
+    // the same worlds in a BatchSimu and in RobotDARTSimus stepped one after the other:
+    // a pendulum with a PDControl and one with a BatchPDControl
+    auto pd_pendulum = fixed_pendulum();
+    pd_pendulum->add_controller(std::make_shared<control::PDControl>(target));
+    auto batch_pendulum = fixed_pendulum();
+    auto reference_pendulum = fixed_pendulum();
+    batch_pendulum->add_controller(std::make_shared<control::BatchPDControl>(batch));
+    reference_pendulum->add_controller(std::make_shared<control::BatchPDControl>(reference_batch));
+
+    BatchSimu batch_simu(num_worlds, dt, 2);
+    batch_simu.add_robot(pd_pendulum);
+    batch_simu.add_robot(batch_pendulum);
+    BOOST_CHECK(batch_simu.num_worlds() == num_worlds);
+
+    std::vector<std::shared_ptr<RobotDARTSimu>> simus;
+    for (size_t i = 0; i < num_worlds; i++) {
+        auto simu = std::make_shared<RobotDARTSimu>(dt);
+        simu->add_robot(pd_pendulum->clone());
+        simu->add_robot(reference_pendulum->clone());
+        simus.push_back(simu);
+    }
+
+    auto set_state = [](RobotDARTSimu& simu, size_t i) {
+        for (auto& robot : simu.robots())
+            robot->set_positions(Eigen::VectorXd::Constant(1, -1.5 + 0.7 * i));
+    };
+    batch_simu.for_each(set_state, true);
+    for (size_t i = 0; i < num_worlds; i++)
+        set_state(*simus[i], i);
+
+    auto check_same = [&]() {
+        for (size_t i = 0; i < num_worlds; i++) {
+            for (size_t r = 0; r < 2; r++) {
+                double p = batch_simu.robot(i, r)->positions()(0);
+                BOOST_CHECK_SMALL(p - simus[i]->robot(r)->positions()(0), 1e-10);
+            }
+        }
+    };
+
+    for (size_t s = 0; s < 200; s++) {
+        batch_simu.step();
+        for (auto& simu : simus)
+            simu->step();
+    }
+    check_same();
+    BOOST_CHECK(batch_simu.last_steps() == num_worlds);
+
+    // the controllers changed between two steps are taken into account
+    batch_simu.robot(2, 1)->clear_controllers();
+    simus[2]->robot(1)->clear_controllers();
+    for (size_t s = 0; s < 200; s++) {
+        batch_simu.step();
+        for (auto& simu : simus)
+            simu->step();
+    }
+    check_same();
+
+    // run() steps the worlds of a PD batch together, like step()
+    batch_simu.run(0.2);
+    for (size_t s = 0; s < 200; s++) {
+        for (auto& simu : simus)
+            simu->step();
+    }
+    check_same();
+    BOOST_CHECK(batch_simu.last_steps() == 200 * num_worlds);
+}
+
+BOOST_AUTO_TEST_CASE(test_batch_simu_exception)
+{
+    BatchSimu batch_simu(4, 0.001, 2);
+    batch_simu.add_robot(fixed_pendulum());
+    batch_simu.step();
+
+    // a failure in one world (computed by a worker thread) is given back to the caller
+    BOOST_CHECK_THROW(batch_simu.for_each([](RobotDARTSimu&, size_t i) { if (i == 3) throw std::runtime_error("world"); }, true), std::runtime_error);
+
+    batch_simu.robot(3, 0)->add_controller(std::make_shared<ThrowingControl>());
+    BOOST_CHECK_THROW(batch_simu.step(), std::runtime_error);
+    BOOST_CHECK_THROW(batch_simu.run(0.01), std::runtime_error);
+
+    // the other worlds can still be stepped once the failing controller is removed
+    batch_simu.robot(3, 0)->clear_controllers();
+    BOOST_CHECK_NO_THROW(batch_simu.step());
+}
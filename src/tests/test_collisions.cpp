@@ -0,0 +1,134 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE test_collisions
+
+#include <boost/test/unit_test.hpp>
+
+#include <robot_dart/robot_dart_simu.hpp>
+#include <robot_dart/utils_headers_dart_collision.hpp>
+
+using namespace robot_dart;
+
+namespace {
+    // number of contacts of the last step between the two robots
+    size_t num_contacts(RobotDARTSimu& simu, const std::shared_ptr<Robot>& robot1, const std::shared_ptr<Robot>& robot2)
+    {
+        size_t count = 0;
+        const dart::collision::CollisionResult& result = simu.world()->getLastCollisionResult();
+        for (size_t i = 0; i < result.getNumContacts(); i++) {
+            auto skel1 = result.getContact(i).collisionObject1->getShapeFrame()->asShapeNode()->getSkeleton();
+            auto skel2 = result.getContact(i).collisionObject2->getShapeFrame()->asShapeNode()->getSkeleton();
+            if ((skel1 == robot1->skeleton() && skel2 == robot2->skeleton()) || (skel1 == robot2->skeleton() && skel2 == robot1->skeleton()))
+                count++;
+        }
+        return count;
+    }
+
+    Eigen::Vector6d box_pose(double x, double z)
+    {
+        Eigen::Vector6d pose = Eigen::Vector6d::Zero();
+        pose.tail(3) << x, 0., z;
+        return pose;
+    }
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_collision_masks)
+{
+    RobotDARTSimu simu(0.001);
+    simu.add_floor();
+    auto box = Robot::create_box({0.1, 0.1, 0.1}, box_pose(0., 0.5));
+    simu.add_robot(box);
+
+    // the box does not collide with the floor anymore
+    simu.set_collision_masks(0, 0x1, 0x1);
+    simu.set_collision_masks(1, 0x2, 0x2);
+    auto masks = simu.collision_masks(1, size_t(0));
+    BOOST_CHECK_EQUAL(masks.first, 0x2u);
+    BOOST_CHECK_EQUAL(masks.second, 0x2u);
+
+    simu.run(0.5);
+    BOOST_CHECK(box->base_pose().translation()[2] < -0.1);
+
+    // back to the default masks: the box falls on the floor
+    simu.remove_all_collision_masks();
+    BOOST_CHECK_EQUAL(simu.collision_mask(1, size_t(0)), 0xffffffffu);
+    box->set_base_pose(box_pose(0., 0.5));
+    box->set_velocities(Eigen::VectorXd::Zero(6));
+    simu.run(1.);
+    BOOST_CHECK_CLOSE(box->base_pose().translation()[2], 0.05, 5.);
+}
+
+BOOST_AUTO_TEST_CASE(test_static_pruning)
+{
+    RobotDARTSimu simu(0.001);
+    auto floor = simu.add_floor();
+    // a fixed box inside the floor and a free box on the floor
+    auto fixed_box = Robot::create_box({0.1, 0.1, 0.1}, box_pose(1., 0.), "fixed");
+    auto box = Robot::create_box({0.1, 0.1, 0.1}, box_pose(0., 0.05));
+    simu.add_robot(fixed_box);
+    simu.add_robot(box);
+
+    // disabled by default
+    BOOST_CHECK(!simu.static_pruning());
+    simu.step_world();
+    BOOST_CHECK(num_contacts(simu, floor, fixed_box) > 0);
+    BOOST_CHECK(num_contacts(simu, floor, box) > 0);
+
+    simu.set_static_pruning(true);
+    simu.step_world();
+    BOOST_CHECK_EQUAL(num_contacts(simu, floor, fixed_box), 0u);
+    BOOST_CHECK(num_contacts(simu, floor, box) > 0);
+
+    simu.set_static_pruning(false);
+    simu.step_world();
+    BOOST_CHECK(num_contacts(simu, floor, fixed_box) > 0);
+    BOOST_CHECK(num_contacts(simu, floor, box) > 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_sleeping)
+{
+    RobotDARTSimu simu(0.001);
+    auto floor = simu.add_floor();
+    auto box = Robot::create_box({0.1, 0.1, 0.1}, box_pose(0., 0.05));
+    simu.add_robot(box);
+    simu.enable_sleeping(true, 1e-2, 50);
+    simu.set_static_pruning(true);
+
+    // the box rests on the floor: it falls asleep
+    simu.run(0.5);
+    BOOST_REQUIRE(simu.sleeping(1));
+    BOOST_CHECK(!box->skeleton()->isMobile());
+    BOOST_CHECK_EQUAL(simu.num_sleeping_robots(), 1u);
+    // the floor does not take part in the islands
+    BOOST_CHECK(!simu.sleeping(0));
+    // sleeping boxes are static: no contacts with the floor (with the static pruning)
+    BOOST_CHECK_EQUAL(num_contacts(simu, floor, box), 0u);
+    double z = box->base_pose().translation()[2];
+
+    // a second box falls on the first one and wakes it up
+    auto box2 = Robot::create_box({0.1, 0.1, 0.1}, box_pose(0., 0.3));
+    simu.add_robot(box2);
+    bool woken = false;
+    for (size_t i = 0; i < 500 && !woken; i++) {
+        simu.step_world();
+        woken = !simu.sleeping(1);
+    }
+    BOOST_CHECK(woken);
+
+    // both fall asleep, stacked
+    simu.run(2.);
+    BOOST_CHECK(simu.sleeping(1));
+    BOOST_CHECK(simu.sleeping(2));
+    BOOST_CHECK_CLOSE(box->base_pose().translation()[2], z, 5.);
+    BOOST_CHECK_CLOSE(box2->base_pose().translation()[2], z + 0.1, 5.);
+
+    // the robots are awake when the sleeping is disabled (and when they are removed)
+    simu.enable_sleeping(false);
+    BOOST_CHECK(box->skeleton()->isMobile());
+    BOOST_CHECK_EQUAL(simu.num_sleeping_robots(), 0u);
+
+    simu.enable_sleeping(true, 1e-2, 50);
+    simu.run(0.5);
+    BOOST_REQUIRE(simu.sleeping(2));
+    simu.remove_robot(box2);
+    BOOST_CHECK(box2->skeleton()->isMobile());
+}
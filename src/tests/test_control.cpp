@@ -7,9 +7,12 @@
 #include <robot_dart/control/robot_control.hpp>
 #include <robot_dart/robot.hpp>
 
+#include <robot_dart/control/batch_pd_control.hpp>
 #include <robot_dart/control/pd_control.hpp>
+#include <robot_dart/control/policy_control.hpp>
 #include <robot_dart/control/simple_control.hpp>
 #include <robot_dart/utils.hpp>
+#include <robot_dart/utils_headers_dart_dynamics.hpp>
 
 using namespace robot_dart;
 
@@ -68,6 +71,99 @@ BOOST_AUTO_TEST_CASE(test_pd_control)
     BOOST_CHECK(pd_control->weight() == 30.0);
 }
 
+BOOST_AUTO_TEST_CASE(test_batch_pd_control)
+{
+    Eigen::VectorXd ctrl(1);
+    ctrl << 2.;
+    auto batch = std::make_shared<control::PDBatch>(ctrl);
+    batch->set_pd(10., 1.);
+
+    // a few pendulums in different states, each with a PDControl that should give the same commands
+    std::vector<std::shared_ptr<Robot>> pendulums;
+    std::vector<std::shared_ptr<control::PDControl>> pd_controls;
+    for (size_t i = 0; i < 4; i++) {
+        auto pendulum = std::make_shared<Robot>(std::string(ROBOT_DART_BUILD_DIR) + "/robots/pendulum.urdf");
+        BOOST_REQUIRE(pendulum);
+        pendulum->fix_to_world();
+        pendulum->set_positions(Eigen::VectorXd::Constant(1, -3. + 2. * i));
+        pendulum->set_velocities(Eigen::VectorXd::Constant(1, 0.5 * i));
+
+        auto batch_control = std::make_shared<control::BatchPDControl>(batch);
+        pendulum->add_controller(batch_control);
+        BOOST_CHECK(batch_control->active());
+        BOOST_CHECK(batch_control->index() == i);
+
+        auto pd_control = std::make_shared<control::PDControl>(ctrl);
+        pd_control->set_robot(pendulum);
+        pd_control->init();
+        pd_control->set_pd(10., 1.);
+
+        pendulums.push_back(pendulum);
+        pd_controls.push_back(pd_control);
+    }
+    BOOST_CHECK(batch->num_robots() == 4);
+
+    // different target for the last one
+    ctrl << -1.;
+    batch->set_target(3, ctrl);
+    pd_controls[3]->set_parameters(ctrl);
+    pd_controls[3]->set_pd(10., 1.);
+
+    for (size_t i = 0; i < pendulums.size(); i++) {
+        Eigen::VectorXd commands = pendulums[i]->controller(0)->calculate(0.);
+        BOOST_CHECK_CLOSE(commands(0), pd_controls[i]->calculate(0.)(0), 1e-6);
+    }
+
+    // the target is kept when the controller is configured again
+    pendulums[3]->reinit_controllers();
+    BOOST_CHECK(batch->target(3)(0) == -1.);
+
+    // cloned robots are added to the same batch (with the target of the cloned robot)
+    auto clone = pendulums[3]->clone();
+    BOOST_CHECK(batch->num_robots() == 5);
+    BOOST_CHECK(batch->target(4)(0) == -1.);
+
+    // new parameters change the target
+    ctrl << 0.5;
+    pendulums[3]->controller(0)->set_parameters(ctrl);
+    BOOST_CHECK(batch->target(3)(0) == 0.5);
+
+    // removed robots leave a column that is reused
+    pendulums[1]->clear_controllers();
+    clone = pendulums[0]->clone();
+    BOOST_CHECK(batch->num_robots() == 5);
+}
+
+BOOST_AUTO_TEST_CASE(test_pd_control_dof_changes)
+{
+    Eigen::VectorXd ctrl(1);
+    ctrl << 1.;
+    std::vector<std::string> dofs = {"pendulum_joint_1"};
+
+    auto pendulum = std::make_shared<Robot>(std::string(ROBOT_DART_BUILD_DIR) + "/robots/pendulum.urdf");
+    auto pd_control = std::make_shared<control::PDControl>(ctrl, dofs);
+    pendulum->add_controller(pd_control);
+    pd_control->set_pd(10., 1.);
+
+    auto batch = std::make_shared<control::PDBatch>(ctrl, dofs);
+    batch->set_pd(10., 1.);
+    auto batch_pendulum = std::make_shared<Robot>(std::string(ROBOT_DART_BUILD_DIR) + "/robots/pendulum.urdf");
+    batch_pendulum->add_controller(std::make_shared<control::BatchPDControl>(batch));
+
+    // the free base is removed after the controllers are configured (without reinit_controllers())
+    for (auto& robot : {pendulum, batch_pendulum}) {
+        BOOST_REQUIRE(robot->skeleton()->getNumDofs() == 7);
+        robot->skeleton()->getRootBodyNode()->changeParentJointType<dart::dynamics::WeldJoint>();
+        robot->update_joint_dof_maps();
+        robot->set_positions(Eigen::VectorXd::Constant(1, 0.2));
+        robot->set_velocities(Eigen::VectorXd::Zero(1));
+    }
+
+    // the controllers find the index of the DoF again: P gain * (target - position)
+    BOOST_CHECK_CLOSE(pd_control->calculate(0.)(0), 8., 1e-6);
+    BOOST_CHECK_CLOSE(batch_pendulum->controller(0)->calculate(0.)(0), 8., 1e-6);
+}
+
 BOOST_AUTO_TEST_CASE(test_simple_control)
 {
     // default constructor
@@ -178,4 +274,65 @@ BOOST_AUTO_TEST_CASE(test_robot_control)
     for (int i = 0; i < robot_commands.size(); i++) {
         BOOST_CHECK(robot_commands(i) == commands(i));
     }
-}
\ No newline at end of file
+}
+
+// subclasses written before calculate_into(): their calculate() has to be used by Robot::update()
+class DoublePDControl : public control::PDControl {
+public:
+    using control::PDControl::PDControl;
+    Eigen::VectorXd calculate(double t) override { return 2. * control::PDControl::calculate(t); }
+    std::shared_ptr<control::RobotControl> clone() const override { return std::make_shared<DoublePDControl>(*this); }
+};
+
+class DoubleSimpleControl : public control::SimpleControl {
+public:
+    using control::SimpleControl::SimpleControl;
+    Eigen::VectorXd calculate(double t) override { return 2. * control::SimpleControl::calculate(t); }
+    std::shared_ptr<control::RobotControl> clone() const override { return std::make_shared<DoubleSimpleControl>(*this); }
+};
+
+struct ConstantPolicy {
+    void set_params(const Eigen::VectorXd& params) { _params = params; }
+    int output_size() const { return static_cast<int>(_params.size()); }
+    Eigen::VectorXd query(const std::shared_ptr<Robot>&, double) { return _params; }
+    void set_h_params(const Eigen::VectorXd&) {}
+    Eigen::VectorXd h_params() const { return Eigen::VectorXd(); }
+
+    Eigen::VectorXd _params;
+};
+
+class DoublePolicyControl : public control::PolicyControl<ConstantPolicy> {
+public:
+    using control::PolicyControl<ConstantPolicy>::PolicyControl;
+    Eigen::VectorXd calculate(double t) override { return 2. * control::PolicyControl<ConstantPolicy>::calculate(t); }
+    std::shared_ptr<control::RobotControl> clone() const override { return std::make_shared<DoublePolicyControl>(*this); }
+};
+
+BOOST_AUTO_TEST_CASE(test_overridden_calculate)
+{
+    auto pendulum = std::make_shared<Robot>(std::string(ROBOT_DART_BUILD_DIR) + "/robots/pendulum.urdf");
+    BOOST_REQUIRE(pendulum);
+    pendulum->fix_to_world();
+    // the commands stay below the effort limits (2.5)
+    pendulum->set_positions(Eigen::VectorXd::Zero(1));
+
+    Eigen::VectorXd ctrl(1);
+    ctrl << 0.1;
+    auto pd_control = std::make_shared<DoublePDControl>(ctrl);
+    pendulum->add_controller(pd_control);
+    pendulum->update(0.0);
+    Eigen::VectorXd commands = pd_control->control::PDControl::calculate(0.0);
+    BOOST_CHECK_CLOSE(pendulum->commands()(0), 2. * commands(0), 1e-6);
+
+    pendulum->clear_controllers();
+    auto simple_control = std::make_shared<DoubleSimpleControl>(ctrl);
+    pendulum->add_controller(simple_control);
+    pendulum->update(0.0);
+    BOOST_CHECK_CLOSE(pendulum->commands()(0), 0.2, 1e-6);
+
+    pendulum->clear_controllers();
+    auto policy_control = std::make_shared<DoublePolicyControl>(ctrl);
+    pendulum->add_controller(policy_control);
+    pendulum->update(0.0);
+    BOOST_CHECK_CLOSE(pendulum->commands()(0), 0.2, 1e-6);
+}
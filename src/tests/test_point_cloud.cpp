@@ -0,0 +1,157 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE test_point_cloud
+
+#include <boost/test/unit_test.hpp>
+
+#include <robot_dart/gui/helper.hpp>
+
+namespace {
+    struct DepthBuffer {
+        size_t width = 64, height = 48;
+        double near_plane = 0.1, far_plane = 10.;
+        // raw OpenGL depth, stored from bottom to top (the background is at the far plane)
+        std::vector<float> raw;
+
+        DepthBuffer()
+        {
+            raw.resize(width * height);
+            for (size_t i = 0; i < raw.size(); i++)
+                raw[i] = (i % 7 == 0) ? 1.f : 0.5f + 0.4f * static_cast<float>(i % 100) / 100.f;
+        }
+
+        robot_dart::gui::DepthView view() const
+        {
+            robot_dart::gui::DepthView view;
+            view.data = raw.data() + (height - 1) * width;
+            view.width = width;
+            view.height = height;
+            view.row_stride = -static_cast<std::ptrdiff_t>(width * sizeof(float));
+            view.near_plane = near_plane;
+            view.far_plane = far_plane;
+            return view;
+        }
+
+        robot_dart::gui::DepthImage depth_array() const
+        {
+            robot_dart::gui::DepthImage image;
+            image.width = width;
+            image.height = height;
+            image.data.resize(width * height);
+            auto v = view();
+            for (size_t y = 0; y < height; y++)
+                for (size_t x = 0; x < width; x++)
+                    image.data[y * width + x] = (near_plane * far_plane) / (far_plane - v.row(y)[x] * (far_plane - near_plane));
+            return image;
+        }
+    };
+
+    Eigen::Matrix3d intrinsic_matrix()
+    {
+        Eigen::Matrix3d K;
+        K << 50., 0.1, 32., 0., 50., 24., 0., 0., 1.;
+        return K;
+    }
+
+    Eigen::Matrix4d extrinsic_matrix()
+    {
+        Eigen::Matrix4d tf = Eigen::Matrix4d::Identity();
+        tf.topLeftCorner<3, 3>() = Eigen::AngleAxisd(0.3, Eigen::Vector3d(1., 2., 3.).normalized()).toRotationMatrix();
+        tf.topRightCorner<3, 1>() << 1., 2., 3.;
+        return tf;
+    }
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_point_cloud_generator)
+{
+    DepthBuffer buffer;
+    auto depth_array = buffer.depth_array();
+    std::vector<Eigen::Vector3d> expected = robot_dart::gui::point_cloud_from_depth_array(depth_array, intrinsic_matrix(), extrinsic_matrix(), buffer.far_plane);
+
+    for (size_t num_threads : {1, 3}) {
+        robot_dart::gui::PointCloudGenerator generator(num_threads);
+        generator.set_intrinsics(intrinsic_matrix(), buffer.width, buffer.height);
+
+        // from the raw depth buffer and from the (linear) depth array
+        Eigen::Matrix3Xf points;
+        size_t n = generator.compute(buffer.view(), extrinsic_matrix(), points);
+        BOOST_REQUIRE_EQUAL(n, expected.size());
+        BOOST_REQUIRE_EQUAL(static_cast<size_t>(points.cols()), generator.max_points());
+        for (size_t i = 0; i < n; i++)
+            BOOST_CHECK_SMALL((points.col(i).cast<double>() - expected[i]).norm(), 1e-4);
+
+        n = generator.compute(depth_array, extrinsic_matrix(), buffer.far_plane, points);
+        BOOST_REQUIRE_EQUAL(n, expected.size());
+        for (size_t i = 0; i < n; i++)
+            BOOST_CHECK_SMALL((points.col(i).cast<double>() - expected[i]).norm(), 1e-4);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_point_cloud_generator_stride)
+{
+    DepthBuffer buffer;
+    auto depth_array = buffer.depth_array();
+
+    // the reference is computed on the downsampled image (with the scaled intrinsics)
+    size_t stride = 2;
+    robot_dart::gui::DepthImage small;
+    small.width = buffer.width / stride;
+    small.height = buffer.height / stride;
+    for (size_t y = 0; y < small.height; y++)
+        for (size_t x = 0; x < small.width; x++)
+            small.data.push_back(depth_array.data[y * stride * buffer.width + x * stride]);
+    Eigen::Matrix3d K = intrinsic_matrix();
+    K.topRows<2>() /= static_cast<double>(stride);
+    std::vector<Eigen::Vector3d> expected = robot_dart::gui::point_cloud_from_depth_array(small, K, extrinsic_matrix(), buffer.far_plane);
+
+    robot_dart::gui::PointCloudGenerator generator;
+    generator.set_intrinsics(intrinsic_matrix(), buffer.width, buffer.height, stride);
+    BOOST_REQUIRE_EQUAL(generator.max_points(), small.width * small.height);
+
+    Eigen::Matrix3Xf points;
+    size_t n = generator.compute(buffer.view(), extrinsic_matrix(), points);
+    BOOST_REQUIRE_EQUAL(n, expected.size());
+    for (size_t i = 0; i < n; i++)
+        BOOST_CHECK_SMALL((points.col(i).cast<double>() - expected[i]).norm(), 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(test_point_cloud_generator_linear_xyz)
+{
+    DepthBuffer buffer;
+    auto depth_array = buffer.depth_array();
+    std::vector<Eigen::Vector3d> expected = robot_dart::gui::point_cloud_from_depth_array(depth_array, intrinsic_matrix(), extrinsic_matrix(), buffer.far_plane);
+
+    // camera frame positions with the linear depth in w (DepthMode::LinearXYZ), from top to bottom
+    std::vector<float> xyzw(4 * buffer.width * buffer.height, 0.f);
+    for (size_t i = 0; i < depth_array.data.size(); i++)
+        xyzw[4 * i + 3] = static_cast<float>(depth_array.data[i]);
+
+    robot_dart::gui::DepthView view;
+    view.data = xyzw.data() + 3;
+    view.width = buffer.width;
+    view.height = buffer.height;
+    view.row_stride = static_cast<std::ptrdiff_t>(4 * buffer.width * sizeof(float));
+    view.pixel_stride = 4;
+    view.near_plane = buffer.near_plane;
+    view.far_plane = buffer.far_plane;
+    view.linear = true;
+
+    for (size_t stride : {1, 2}) {
+        robot_dart::gui::PointCloudGenerator generator;
+        generator.set_intrinsics(intrinsic_matrix(), buffer.width, buffer.height, stride);
+
+        Eigen::Matrix3Xf points;
+        size_t n = generator.compute(view, extrinsic_matrix(), points);
+        if (stride == 1) {
+            BOOST_REQUIRE_EQUAL(n, expected.size());
+            for (size_t i = 0; i < n; i++)
+                BOOST_CHECK_SMALL((points.col(i).cast<double>() - expected[i]).norm(), 1e-4);
+        }
+        else {
+            // same points as from the depth buffer
+            Eigen::Matrix3Xf raw_points;
+            BOOST_REQUIRE_EQUAL(n, generator.compute(buffer.view(), extrinsic_matrix(), raw_points));
+            for (size_t i = 0; i < n; i++)
+                BOOST_CHECK_SMALL((points.col(i) - raw_points.col(i)).norm(), 1e-4f);
+        }
+    }
+}
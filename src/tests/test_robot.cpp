@@ -4,6 +4,9 @@
 #include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
 
+#include <fstream>
+
+#include <robot_dart/model_cache.hpp>
 #include <robot_dart/robot.hpp>
 #include <robot_dart/utils.hpp>
 #include <robot_dart/utils_headers_dart_dynamics.hpp>
@@ -60,6 +63,37 @@ BOOST_AUTO_TEST_CASE(test_dof_maps)
     BOOST_CHECK(pendulum->positions(name)[0] == 0.1);
 }
 
+BOOST_AUTO_TEST_CASE(test_dof_selection)
+{
+    auto pendulum = std::make_shared<Robot>(std::string(ROBOT_DART_BUILD_DIR) + "/robots/pendulum.urdf");
+    BOOST_REQUIRE(pendulum);
+
+    std::vector<std::string> name = {"pendulum_joint_1"};
+    auto dofs = pendulum->dof_selection(name);
+    BOOST_REQUIRE(dofs.size() == 1);
+    BOOST_CHECK(!dofs.all());
+    BOOST_CHECK(dofs.indices()[0] == pendulum->dof_index(name[0]));
+
+    pendulum->set_positions(make_vector({0.2}), dofs);
+    BOOST_CHECK(pendulum->positions(name)[0] == 0.2);
+    BOOST_CHECK(pendulum->positions(dofs)[0] == 0.2);
+
+    auto all = pendulum->dof_selection();
+    BOOST_CHECK(all.all());
+    BOOST_CHECK(all.size() == pendulum->num_dofs());
+    BOOST_CHECK(pendulum->positions(all) == pendulum->positions());
+
+    // the indices change when the robot is fixed: the selection falls back to the names
+    pendulum->fix_to_world();
+    BOOST_CHECK(!dofs.valid(pendulum->skeleton().get()));
+    pendulum->set_positions(make_vector({0.3}), dofs);
+    BOOST_CHECK(pendulum->positions(name)[0] == 0.3);
+    BOOST_CHECK(pendulum->positions(dofs)[0] == 0.3);
+
+    // unknown names are detected when building the selection
+    BOOST_REQUIRE_EXCEPTION(pendulum->dof_selection({"not_a_dof"}), Assertion, [](const Assertion&) { return true; });
+}
+
 BOOST_AUTO_TEST_CASE(test_fix_free)
 {
     auto pendulum = std::make_shared<Robot>(std::string(ROBOT_DART_BUILD_DIR) + "/robots/pendulum.urdf");
@@ -296,3 +330,58 @@ BOOST_AUTO_TEST_CASE(test_static_creation)
         BOOST_CHECK(ellipsoid2->fixed());
     }
 }
+
+BOOST_AUTO_TEST_CASE(test_model_cache)
+{
+    auto& cache = ModelCache::instance();
+    if (!cache.enabled())
+        return;
+    cache.clear();
+
+    std::string file = std::string(ROBOT_DART_BUILD_DIR) + "/robots/pendulum.urdf";
+    size_t misses = cache.misses();
+    auto pendulum1 = std::make_shared<Robot>(file, "pendulum1");
+    BOOST_CHECK(cache.misses() == misses + 1);
+    BOOST_CHECK(cache.size() == 1);
+
+    size_t hits = cache.hits();
+    auto pendulum2 = std::make_shared<Robot>(file, "pendulum2");
+    BOOST_CHECK(cache.hits() == hits + 1);
+
+    // robots built from the cache are independent copies
+    BOOST_CHECK(pendulum1->skeleton() != pendulum2->skeleton());
+    BOOST_CHECK(pendulum2->name() == "pendulum2");
+    BOOST_CHECK(pendulum2->skeleton()->getName() == "pendulum2");
+    BOOST_CHECK(pendulum1->num_dofs() == pendulum2->num_dofs());
+    BOOST_CHECK(pendulum1->num_bodies() == pendulum2->num_bodies());
+
+    Eigen::VectorXd positions = Eigen::VectorXd::Constant(pendulum2->num_dofs(), 0.5);
+    pendulum2->set_positions(positions);
+    BOOST_CHECK(pendulum1->positions().isZero());
+    auto pendulum3 = std::make_shared<Robot>(file, "pendulum3");
+    BOOST_CHECK(pendulum3->positions().isZero());
+
+    // the cache is refreshed when a mesh file changes
+    namespace fs = boost::filesystem;
+    fs::path dir = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(dir);
+    fs::path mesh = dir / "link_0.stl";
+    fs::copy_file(std::string(ROBOT_DART_BUILD_DIR) + "/robots/iiwa/iiwa_description/meshes/link_0.stl", mesh);
+    std::string mesh_file = (dir / "mesh.urdf").string();
+    {
+        std::ofstream urdf(mesh_file);
+        urdf << "<robot name=\"mesh\"><link name=\"base\"><visual><geometry><mesh filename=\"" << mesh.string() << "\"/></geometry></visual></link></robot>";
+    }
+    misses = cache.misses();
+    std::make_shared<Robot>(mesh_file, "mesh1");
+    hits = cache.hits();
+    std::make_shared<Robot>(mesh_file, "mesh2");
+    BOOST_CHECK(cache.hits() == hits + 1);
+    fs::last_write_time(mesh, fs::last_write_time(mesh) + 10);
+    std::make_shared<Robot>(mesh_file, "mesh3");
+    BOOST_CHECK(cache.misses() == misses + 2);
+    fs::remove_all(dir);
+
+    cache.clear();
+    BOOST_CHECK(cache.size() == 0);
+}
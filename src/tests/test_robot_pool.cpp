@@ -0,0 +1,224 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE test_robot_pool
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <robot_dart/robot.hpp>
+#include <robot_dart/robot_pool.hpp>
+#include <robot_dart/utils.hpp>
+
+using namespace robot_dart;
+
+namespace {
+    std::shared_ptr<Robot> pendulum()
+    {
+        return std::make_shared<Robot>(std::string(ROBOT_DART_BUILD_DIR) + "/robots/pendulum.urdf");
+    }
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_pool_concurrent)
+{
+    const size_t pool_size = 4;
+    RobotPool pool(pendulum, pool_size, false, 2);
+    BOOST_CHECK(pool.pool_size() == pool_size);
+    BOOST_CHECK(pool.num_free() == pool_size);
+    BOOST_CHECK(pool.build_times().size() == pool_size);
+
+    // more threads than robots: no robot is given to two threads at the same time
+    std::mutex mutex;
+    std::set<dart::dynamics::Skeleton*> in_use;
+    std::atomic<size_t> errors(0);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 8; t++) {
+        threads.emplace_back([&]() {
+            for (size_t i = 0; i < 500; i++) {
+                auto robot = pool.get_robot();
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!in_use.insert(robot->skeleton().get()).second)
+                        errors++;
+                }
+                robot->set_positions(Eigen::VectorXd::Constant(1, 0.1 * i));
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    in_use.erase(robot->skeleton().get());
+                }
+                pool.free_robot(robot);
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    BOOST_CHECK(errors.load() == 0);
+    BOOST_CHECK(pool.num_free() == pool_size);
+    // the pool does not grow by default
+    BOOST_CHECK(pool.pool_size() == pool_size);
+}
+
+BOOST_AUTO_TEST_CASE(test_pool_handles)
+{
+    RobotPool pool(pendulum, 2, false);
+    {
+        auto handle = pool.get_robot_handle();
+        BOOST_REQUIRE(handle);
+        BOOST_CHECK(pool.num_free() == 1);
+
+        // the robot moves with the handle
+        auto skeleton = handle->skeleton();
+        auto other = std::move(handle);
+        BOOST_CHECK(!handle);
+        BOOST_CHECK(other->skeleton() == skeleton);
+        BOOST_CHECK(pool.num_free() == 1);
+
+        // the robot of the assigned handle is given back
+        auto last = pool.get_robot_handle();
+        BOOST_CHECK(pool.num_free() == 0);
+        last = std::move(other);
+        BOOST_CHECK(pool.num_free() == 1);
+        BOOST_CHECK(last->skeleton() == skeleton);
+    }
+    // given back when the handles go out of scope
+    BOOST_CHECK(pool.num_free() == 2);
+
+    auto handle = pool.get_robot_handle();
+    handle.release();
+    BOOST_CHECK(!handle);
+    BOOST_CHECK(pool.num_free() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_pool_blocking)
+{
+    RobotPool pool(pendulum, 1, false);
+    auto robot = pool.get_robot();
+    BOOST_CHECK(!pool.try_get_robot());
+
+    // the pool is empty: get_robot() blocks until the robot is given back
+    std::atomic<bool> got(false);
+    std::thread waiter([&]() {
+        auto other = pool.get_robot();
+        got = true;
+        pool.free_robot(other);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    BOOST_CHECK(!got.load());
+
+    pool.free_robot(robot);
+    waiter.join();
+    BOOST_CHECK(got.load());
+    BOOST_CHECK(pool.num_free() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_pool_double_free)
+{
+    RobotPool pool(pendulum, 2, false);
+    auto robot = pool.get_robot();
+    pool.free_robot(robot);
+    BOOST_CHECK(pool.num_free() == 2);
+
+    // the second free is refused (and the robot is not given twice)
+    pool.free_robot(robot);
+    BOOST_CHECK(pool.num_free() == 2);
+    auto first = pool.get_robot();
+    auto second = pool.get_robot();
+    BOOST_CHECK(first->skeleton() != second->skeleton());
+    BOOST_CHECK(!pool.try_get_robot());
+
+    // robots that do not come from the pool are refused
+    pool.free_robot(pendulum());
+    BOOST_CHECK(pool.num_free() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_pool_growth)
+{
+    RobotPool pool(pendulum, 2, false, 1, 4);
+    BOOST_CHECK(pool.pool_size() == 2);
+    BOOST_CHECK(pool.max_pool_size() == 4);
+
+    // the pool grows when it is empty, up to max_pool_size
+    std::vector<std::shared_ptr<Robot>> robots;
+    for (size_t i = 0; i < 4; i++)
+        robots.push_back(pool.get_robot());
+    BOOST_CHECK(pool.pool_size() == 4);
+    BOOST_CHECK(pool.build_times().size() == 4);
+    BOOST_CHECK(pool.num_free() == 0);
+    BOOST_CHECK(!pool.try_get_robot());
+
+    // then it blocks
+    std::atomic<bool> got(false);
+    std::thread waiter([&]() {
+        auto robot = pool.get_robot();
+        got = true;
+        pool.free_robot(robot);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    BOOST_CHECK(!got.load());
+    BOOST_CHECK(pool.pool_size() == 4);
+
+    pool.free_robot(robots.back());
+    waiter.join();
+    BOOST_CHECK(got.load());
+    robots.pop_back();
+    for (auto& robot : robots)
+        pool.free_robot(robot);
+    BOOST_CHECK(pool.num_free() == 4);
+}
+
+BOOST_AUTO_TEST_CASE(test_pool_failed_growth)
+{
+    // the second robot (the first growth) fails once it is released
+    std::atomic<size_t> num_calls(0);
+    std::atomic<bool> building(false), release(false);
+    auto creator = [&]() {
+        if (num_calls.fetch_add(1) == 1) {
+            building = true;
+            while (!release.load())
+                std::this_thread::yield();
+            throw std::runtime_error("creator");
+        }
+        return pendulum();
+    };
+
+    RobotPool pool(creator, 1, false, 1, 2);
+    auto robot = pool.get_robot();
+
+    std::atomic<bool> failed(false);
+    std::thread grower([&]() {
+        try {
+            pool.get_robot();
+        }
+        catch (const std::runtime_error&) {
+            failed = true;
+        }
+    });
+    while (!building.load())
+        std::this_thread::yield();
+
+    // the only slot left is being built: this one waits
+    std::shared_ptr<Robot> waited;
+    std::thread waiter([&]() { waited = pool.get_robot(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // the failure wakes the waiter, which builds the slot again
+    release = true;
+    grower.join();
+    waiter.join();
+    BOOST_CHECK(failed.load());
+    BOOST_REQUIRE(waited);
+    BOOST_CHECK(waited->skeleton() != robot->skeleton());
+    BOOST_CHECK(num_calls.load() == 3);
+    BOOST_CHECK(pool.pool_size() == 2);
+    BOOST_CHECK(pool.build_times().size() == 2);
+
+    pool.free_robot(robot);
+    pool.free_robot(waited);
+    BOOST_CHECK(pool.num_free() == 2);
+}
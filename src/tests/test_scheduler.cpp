@@ -0,0 +1,144 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE test_scheduler
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <robot_dart/scheduler.hpp>
+
+using namespace robot_dart;
+
+namespace {
+    // true if `step` is round(k * period) for some k (the activations of a task are aligned to step 0)
+    bool activation_step(long long step, double period)
+    {
+        long long k = static_cast<long long>(std::floor(step / period));
+        for (long long i = std::max(0ll, k - 1); i <= k + 1; i++)
+            if (std::llround(i * period) == step)
+                return true;
+        return false;
+    }
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_scheduler_no_drift)
+{
+    // 300 Hz is not a multiple of dt: the period is 3.33 steps
+    Scheduler scheduler(1e-3);
+    size_t task = scheduler.add_task(300.);
+    const double period = 1000. / 300.;
+
+    std::vector<size_t> activations(10, 0);
+    long long k = 0;
+    bool aligned = true;
+    for (long long s = 0; s < 10000; s++) {
+        if (scheduler.due(task)) {
+            activations[s / 1000]++;
+            aligned = aligned && (s == std::llround(k * period));
+            k++;
+        }
+        scheduler.step();
+    }
+
+    // exactly 300 activations in every simulated second
+    for (auto n : activations)
+        BOOST_CHECK_EQUAL(n, 300u);
+    BOOST_CHECK(aligned);
+}
+
+BOOST_AUTO_TEST_CASE(test_scheduler_reuse_id)
+{
+    Scheduler scheduler(1e-3);
+    size_t a = scheduler.add_task(100.); // every 10 steps
+    size_t b = scheduler.add_task(50.);
+    for (int s = 0; s < 5; s++) {
+        scheduler.due_tasks();
+        scheduler.step();
+    }
+
+    // the id of a is reused: its entry for step 10 is stale
+    scheduler.remove_task(a);
+    size_t c = scheduler.add_task(250.); // every 4 steps
+    BOOST_CHECK_EQUAL(c, a);
+    BOOST_CHECK_EQUAL(scheduler.task_frequency(c), 250.);
+
+    for (int s = 5; s < 300; s++) {
+        const auto& due = scheduler.due_tasks();
+        BOOST_CHECK_EQUAL(std::count(due.begin(), due.end(), c), (s % 4 == 0) ? 1 : 0);
+        BOOST_CHECK_EQUAL(std::count(due.begin(), due.end(), b), (s % 20 == 0) ? 1 : 0);
+        scheduler.step();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_scheduler_change_frequency)
+{
+    Scheduler scheduler(1e-3);
+    size_t task = scheduler.add_task(100.); // every 10 steps
+    for (int s = 0; s < 15; s++) {
+        BOOST_CHECK_EQUAL(scheduler.due(task), s % 10 == 0);
+        scheduler.step();
+    }
+
+    // the due tasks of step 15 were already given: the task is due now with its new period
+    BOOST_CHECK(!scheduler.due(task));
+    scheduler.set_task_frequency(task, 200.); // every 5 steps
+    BOOST_CHECK(scheduler.due(task));
+    const auto& due = scheduler.due_tasks();
+    BOOST_CHECK_EQUAL(std::count(due.begin(), due.end(), task), 1);
+    scheduler.step();
+
+    for (int s = 16; s < 100; s++) {
+        BOOST_CHECK_EQUAL(scheduler.due(task), s % 5 == 0);
+        scheduler.step();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_scheduler_long_period)
+{
+    // the periods are longer than the wheel (256 steps): the tasks come back to their bucket before being due
+    Scheduler scheduler(1e-3);
+    size_t slow = scheduler.add_task(1.); // every 1000 steps
+    size_t odd = scheduler.add_task(3.); // every 333.33 steps
+    size_t n_slow = 0, n_odd = 0;
+    for (long long s = 0; s < 5000; s++) {
+        bool due = scheduler.due(slow);
+        BOOST_CHECK_EQUAL(due, s % 1000 == 0);
+        n_slow += due;
+
+        due = scheduler.due(odd);
+        BOOST_CHECK_EQUAL(due, activation_step(s, 1000. / 3.));
+        n_odd += due;
+        scheduler.step();
+    }
+    BOOST_CHECK_EQUAL(n_slow, 5u);
+    BOOST_CHECK_EQUAL(n_odd, 15u);
+}
+
+BOOST_AUTO_TEST_CASE(test_scheduler_skipped_steps)
+{
+    Scheduler scheduler(1e-3);
+    size_t fast = scheduler.add_task(100.);
+    size_t odd = scheduler.add_task(300.);
+    BOOST_CHECK(scheduler.due(fast));
+
+    // more than a turn of the wheel without asking for the due tasks
+    for (int s = 0; s < 1000; s++)
+        scheduler.step();
+
+    for (long long s = 1000; s < 1500; s++) {
+        BOOST_CHECK_EQUAL(scheduler.due(fast), s % 10 == 0);
+        BOOST_CHECK_EQUAL(scheduler.due(odd), activation_step(s, 1000. / 300.));
+        scheduler.step();
+    }
+
+    // less than a turn of the wheel
+    for (int s = 0; s < 100; s++)
+        scheduler.step();
+    for (long long s = 1600; s < 1700; s++) {
+        BOOST_CHECK_EQUAL(scheduler.due(fast), s % 10 == 0);
+        BOOST_CHECK_EQUAL(scheduler.due(odd), activation_step(s, 1000. / 300.));
+        scheduler.step();
+    }
+}
@@ -1,6 +1,9 @@
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE test_robot
 
+#include <atomic>
+#include <thread>
+
 #include <boost/filesystem.hpp>
 #include <boost/test/unit_test.hpp>
 
@@ -184,3 +187,186 @@ BOOST_AUTO_TEST_CASE(test_force_torque)
         BOOST_CHECK_SMALL(std::abs(cmd(0) - torque_sensor->torques().norm()), 1e-6);
     }
 }
+
+
+BOOST_AUTO_TEST_CASE(test_sensor_snapshots)
+{
+    Eigen::Vector6d pose = Eigen::Vector6d::Zero();
+    pose(5) = 1.5;
+    auto robot = robot_dart::Robot::create_box(Eigen::Vector3d(0.1, 0.1, 0.1), pose, "free", 1.);
+    auto other = robot_dart::Robot::create_box(Eigen::Vector3d(0.1, 0.1, 0.1), pose, "free", 1., dart::Color::Red(1.), "other");
+
+    robot_dart::RobotDARTSimu simu(0.001);
+    simu.add_robot(robot);
+    simu.add_robot(other);
+
+    auto imu = simu.add_sensor<robot_dart::sensor::IMU>(robot_dart::sensor::IMUConfig(robot->body_node(0), 1000));
+    auto ft = simu.add_sensor<robot_dart::sensor::ForceTorque>(robot->joint(0), 500);
+    simu.add_sensor<robot_dart::sensor::IMU>(robot_dart::sensor::IMUConfig(other->body_node(0), 1000));
+
+    // nothing published yet
+    robot_dart::sensor::Snapshot snapshot;
+    BOOST_CHECK(!imu->snapshot(snapshot));
+    BOOST_CHECK_EQUAL(snapshot.sequence, 0u);
+    BOOST_CHECK_EQUAL(imu->snapshot_size(), 9u);
+
+    for (int i = 0; i < 10; i++)
+        simu.step_world();
+
+    // the snapshots are copies of the last readings
+    BOOST_REQUIRE(imu->snapshot(snapshot));
+    BOOST_CHECK_EQUAL(snapshot.sequence, 10u);
+    BOOST_CHECK_CLOSE(snapshot.time, simu.world()->getTime(), 1e-6);
+    BOOST_CHECK(snapshot.values.head(3).isApprox(imu->angular_position_vec()));
+    BOOST_CHECK(snapshot.values.segment(3, 3).isApprox(imu->angular_velocity()));
+    BOOST_CHECK(snapshot.values.tail(3).isApprox(imu->linear_acceleration()));
+
+    // bulk snapshot of the sensors of the robot (not the ones of the other robot)
+    auto snapshots = simu.sensor_snapshots(robot);
+    BOOST_REQUIRE_EQUAL(snapshots.size(), 2u);
+    BOOST_CHECK_EQUAL(simu.sensors(robot).size(), 2u);
+    BOOST_CHECK(snapshots[0].values.isApprox(snapshot.values));
+    BOOST_CHECK(snapshots[1].sequence > 0);
+    BOOST_CHECK(snapshots[1].values.isApprox(ft->wrench()));
+
+    // a reader thread always gets consistent snapshots while the simulation steps
+    std::atomic<bool> done(false);
+    std::atomic<size_t> inconsistent(0);
+    std::thread reader([&]() {
+        std::vector<robot_dart::sensor::Snapshot> reader_snapshots;
+        uint64_t last = 0;
+        while (!done) {
+            simu.sensor_snapshots(robot, reader_snapshots);
+            auto& s = reader_snapshots[0];
+            // the IMU is refreshed after each step: its time is given by its sequence
+            if (s.sequence < last || std::abs(s.time - s.sequence * 0.001) > 1e-9)
+                inconsistent++;
+            last = s.sequence;
+        }
+    });
+    for (int i = 0; i < 2000; i++)
+        simu.step_world();
+    done = true;
+    reader.join();
+    BOOST_CHECK_EQUAL(inconsistent, 0u);
+    BOOST_CHECK_EQUAL(imu->snapshot().sequence, 2010u);
+}
+
+BOOST_AUTO_TEST_CASE(test_sensor_recorder)
+{
+    Eigen::Vector6d pose = Eigen::Vector6d::Zero();
+    pose(5) = 1.5;
+    auto robot = robot_dart::Robot::create_box(Eigen::Vector3d(0.1, 0.1, 0.1), pose, "free", 1.);
+
+    robot_dart::RobotDARTSimu simu(0.001);
+    simu.add_robot(robot);
+    auto imu = simu.add_sensor<robot_dart::sensor::IMU>(robot_dart::sensor::IMUConfig(robot->body_node(0), 1000));
+    auto ft = simu.add_sensor<robot_dart::sensor::ForceTorque>(robot->joint(0), 250);
+    // refreshed (and recorded) by its bank
+    auto torque = std::make_shared<robot_dart::sensor::Torque>(robot->joint(0));
+    auto bank = std::make_shared<robot_dart::sensor::TorqueBank>(500);
+    bank->add_sensor(torque);
+    simu.add_sensor(torque);
+    simu.add_sensor(bank);
+
+    std::string filename = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%.rdrec")).string();
+    {
+        auto recorder = std::make_shared<robot_dart::sensor::Recorder>(filename, 64);
+        recorder->add_sensor(imu, "imu");
+        recorder->add_sensor(ft);
+        recorder->add_sensor(torque, "torque");
+        recorder->start();
+        simu.set_recorder(recorder);
+
+        for (int i = 0; i < 1000; i++)
+            simu.step_world();
+        recorder->stop();
+        BOOST_CHECK(!recorder->recording());
+    }
+
+    robot_dart::sensor::RecordingReader reader(filename);
+    BOOST_REQUIRE_EQUAL(reader.num_streams(), 3u);
+    BOOST_CHECK_EQUAL(reader.stream_index("imu"), 0);
+    BOOST_CHECK_EQUAL(reader.stream(1).type, "ft");
+    BOOST_CHECK_EQUAL(reader.stream(1).num_values, 6u);
+
+    // all the refreshes, in chunks of 64 records
+    BOOST_CHECK_EQUAL(reader.num_records(0), 1000u);
+    BOOST_CHECK_EQUAL(reader.num_chunks(0), 16u);
+    BOOST_CHECK_EQUAL(reader.num_records(1), 250u);
+    // at the frequency of the bank
+    BOOST_CHECK_EQUAL(reader.stream(2).type, "t");
+    BOOST_CHECK_EQUAL(reader.num_records(2), 500u);
+    BOOST_CHECK(reader.values(2).bottomRows(1).transpose().isApprox(torque->torques()));
+
+    Eigen::VectorXd times = reader.times(0);
+    Eigen::MatrixXd values = reader.values(0);
+    BOOST_CHECK_CLOSE(times[999], simu.world()->getTime(), 1e-6);
+    BOOST_CHECK(values.row(999).transpose().segment(3, 3).isApprox(imu->angular_velocity()));
+    BOOST_CHECK(values.row(999).transpose().tail(3).isApprox(imu->linear_acceleration()));
+    BOOST_CHECK(reader.chunk_values(0, 1).row(0).isApprox(values.row(64)));
+
+    boost::filesystem::remove(filename);
+}
+
+BOOST_AUTO_TEST_CASE(test_sensor_bank_poses)
+{
+    // the sensors refreshed by a bank have the same pose as the ones refreshed by the simulation
+    Eigen::Vector6d pose = Eigen::Vector6d::Zero();
+    pose.head(3) = Eigen::Vector3d(0.3, -0.2, 0.5);
+    pose(5) = 1.5;
+    auto robot = robot_dart::Robot::create_box(Eigen::Vector3d(0.1, 0.1, 0.1), pose, "free", 1.);
+
+    robot_dart::RobotDARTSimu simu(0.001);
+    simu.add_robot(robot);
+    auto ft = simu.add_sensor<robot_dart::sensor::ForceTorque>(robot->joint(0), 1000);
+    auto torque = simu.add_sensor<robot_dart::sensor::Torque>(robot->joint(0), 1000);
+
+    auto ft_driven = std::make_shared<robot_dart::sensor::ForceTorque>(robot->joint(0));
+    auto ft_bank = std::make_shared<robot_dart::sensor::ForceTorqueBank>(1000);
+    ft_bank->add_sensor(ft_driven);
+    simu.add_sensor(ft_driven);
+    simu.add_sensor(ft_bank);
+    auto torque_driven = std::make_shared<robot_dart::sensor::Torque>(robot->joint(0));
+    auto torque_bank = std::make_shared<robot_dart::sensor::TorqueBank>(1000);
+    torque_bank->add_sensor(torque_driven);
+    simu.add_sensor(torque_driven);
+    simu.add_sensor(torque_bank);
+
+    for (int i = 0; i < 10; i++)
+        simu.step_world();
+
+    BOOST_CHECK(!ft->pose().isApprox(Eigen::Isometry3d::Identity()));
+    BOOST_CHECK(ft_driven->pose().isApprox(ft->pose()));
+    BOOST_CHECK(torque_driven->pose().isApprox(torque->pose()));
+}
+
+BOOST_AUTO_TEST_CASE(test_set_timestep)
+{
+    // the control, graphics and sensor tasks are registered in the scheduler when the timestep changes
+    auto robot = robot_dart::Robot::create_box(Eigen::Vector3d(0.1, 0.1, 0.1), Eigen::Vector6d::Zero(), "free", 1.);
+    robot_dart::RobotDARTSimu simu(0.001);
+    simu.add_robot(robot);
+    robot_dart::sensor::IMUConfig imu_config;
+    imu_config.body = robot->body_node("box");
+    imu_config.frequency = 100;
+    simu.add_sensor<robot_dart::sensor::IMU>(imu_config);
+
+    // lower physics rate: the control frequency follows it
+    BOOST_CHECK_NO_THROW(simu.set_timestep(0.005));
+    BOOST_CHECK(simu.control_freq() == 200);
+    for (int i = 0; i < 10; i++)
+        simu.step_world();
+
+    // higher physics rate
+    BOOST_CHECK_NO_THROW(simu.set_timestep(0.0005));
+    BOOST_CHECK(simu.control_freq() == 2000);
+    for (int i = 0; i < 10; i++)
+        simu.step_world();
+
+    // a task that is faster than the new physics rate is rejected and nothing is changed
+    BOOST_CHECK_THROW(simu.set_timestep(0.05), robot_dart::Assertion);
+    BOOST_CHECK(simu.scheduler().dt() == 0.0005);
+    BOOST_CHECK(simu.timestep() == 0.0005);
+    BOOST_CHECK(simu.control_freq() == 2000);
+}
@@ -0,0 +1,232 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE test_video
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <robot_dart/gui/video_sink.hpp>
+
+using namespace robot_dart;
+
+namespace {
+    // bottom-up RGB frame (like the framebuffer of a camera): the row y of the image has the gray level `value + y`
+    gui::ImageView bottom_up_frame(size_t width, size_t height, uint8_t value)
+    {
+        auto buffer = std::make_shared<std::vector<uint8_t>>(width * height * 3);
+        for (size_t y = 0; y < height; y++) {
+            // the last row in memory is the top of the image
+            uint8_t* row = buffer->data() + (height - 1 - y) * width * 3;
+            std::fill(row, row + width * 3, static_cast<uint8_t>(value + y));
+        }
+
+        gui::ImageView frame;
+        frame.width = width;
+        frame.height = height;
+        frame.row_stride = -static_cast<std::ptrdiff_t>(width * 3);
+        frame.data = buffer->data() + (height - 1) * width * 3;
+        frame.owner = buffer;
+        return frame;
+    }
+
+    std::vector<uint8_t> read_file(const std::string& filename)
+    {
+        std::ifstream file(filename, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    std::string temp_file(const std::string& extension)
+    {
+        return (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%." + extension)).string();
+    }
+
+    // sink that only writes a frame when it is allowed to (to fill the queue of a VideoWriter)
+    class GatedSink : public gui::VideoSink {
+    public:
+        GatedSink(bool fail = false) : _fail(fail) {}
+
+        bool open(const std::string&, size_t, size_t, int) override { return true; }
+        bool write_frame(const gui::ImageView& frame) override
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _started++;
+            _cv.notify_all();
+            _cv.wait(lock, [this] { return _open; });
+            if (_fail)
+                return false;
+            _values.push_back(frame.row(0)[0]);
+            return true;
+        }
+        void close() override {}
+
+        void wait_started(size_t n)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait(lock, [&] { return _started >= n; });
+        }
+        void open_gate()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _open = true;
+            _cv.notify_all();
+        }
+        std::vector<uint8_t> values()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _values;
+        }
+
+    protected:
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        size_t _started = 0;
+        bool _open = false, _fail;
+        std::vector<uint8_t> _values;
+    };
+
+    // the writer thread is in the sink with frame 0 and frame 1 is queued (queue of 1)
+    void fill_queue(gui::VideoWriter& writer, GatedSink& sink)
+    {
+        BOOST_REQUIRE(writer.open("", 4, 2, 30));
+        BOOST_CHECK(writer.push(bottom_up_frame(4, 2, 0)));
+        sink.wait_started(1);
+        BOOST_CHECK(writer.push(bottom_up_frame(4, 2, 10)));
+    }
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_raw_sink)
+{
+    const size_t width = 5, height = 3;
+    std::string filename = temp_file("rgb");
+    {
+        gui::VideoWriter writer(gui::make_video_sink(filename));
+        BOOST_REQUIRE(writer.open(filename, width, height, 30));
+        BOOST_CHECK(writer.push(bottom_up_frame(width, height, 0)));
+        BOOST_CHECK(writer.push(bottom_up_frame(width, height, 100)));
+        writer.close();
+        BOOST_CHECK_EQUAL(writer.frames_written(), 2u);
+        BOOST_CHECK_EQUAL(writer.frames_dropped(), 0u);
+    }
+
+    // the rows are written top-down
+    auto data = read_file(filename);
+    BOOST_REQUIRE_EQUAL(data.size(), 2 * width * height * 3);
+    for (size_t f = 0; f < 2; f++)
+        for (size_t y = 0; y < height; y++)
+            for (size_t i = 0; i < width * 3; i++)
+                BOOST_CHECK_EQUAL(data[(f * height + y) * width * 3 + i], f * 100 + y);
+
+    boost::filesystem::remove(filename);
+}
+
+BOOST_AUTO_TEST_CASE(test_y4m_sink)
+{
+    const size_t width = 4, height = 2;
+    std::string filename = temp_file("y4m");
+    {
+        gui::VideoWriter writer(gui::make_video_sink(filename));
+        BOOST_REQUIRE(writer.open(filename, width, height, 25));
+        for (uint8_t f = 0; f < 3; f++)
+            BOOST_CHECK(writer.push(bottom_up_frame(width, height, 50 * f)));
+        writer.close();
+        BOOST_CHECK_EQUAL(writer.frames_written(), 3u);
+    }
+
+    std::string header = "YUV4MPEG2 W4 H2 F25:1 Ip A1:1 C444\n";
+    size_t frame_size = 6 + 3 * width * height;
+    auto data = read_file(filename);
+    BOOST_REQUIRE_EQUAL(data.size(), header.size() + 3 * frame_size);
+    BOOST_CHECK(std::string(data.begin(), data.begin() + header.size()) == header);
+
+    for (size_t f = 0; f < 3; f++) {
+        const uint8_t* frame = data.data() + header.size() + f * frame_size;
+        BOOST_CHECK(std::string(frame, frame + 6) == "FRAME\n");
+        // Y plane, top-down: gray levels give Y = (220 * g + 128) / 256 + 16
+        for (size_t y = 0; y < height; y++) {
+            int gray = static_cast<int>(50 * f + y);
+            BOOST_CHECK_EQUAL(frame[6 + y * width], ((220 * gray + 128) >> 8) + 16);
+        }
+    }
+
+    boost::filesystem::remove(filename);
+}
+
+BOOST_AUTO_TEST_CASE(test_writer_block)
+{
+    auto sink = new GatedSink;
+    gui::VideoWriter writer(std::unique_ptr<gui::VideoSink>(sink), gui::VideoPolicy::Block, 1);
+    fill_queue(writer, *sink);
+
+    // the queue is full: push() waits for the writer thread
+    std::atomic<bool> pushed(false);
+    std::thread pusher([&]() { pushed = writer.push(bottom_up_frame(4, 2, 20)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    BOOST_CHECK(!pushed.load());
+
+    sink->open_gate();
+    pusher.join();
+    BOOST_CHECK(pushed.load());
+    writer.close();
+    BOOST_CHECK_EQUAL(writer.frames_written(), 3u);
+    BOOST_CHECK_EQUAL(writer.frames_dropped(), 0u);
+    BOOST_CHECK(sink->values() == std::vector<uint8_t>({0, 10, 20}));
+}
+
+BOOST_AUTO_TEST_CASE(test_writer_drop_newest)
+{
+    auto sink = new GatedSink;
+    gui::VideoWriter writer(std::unique_ptr<gui::VideoSink>(sink), gui::VideoPolicy::DropNewest, 1);
+    fill_queue(writer, *sink);
+
+    BOOST_CHECK(!writer.push(bottom_up_frame(4, 2, 20)));
+    sink->open_gate();
+    writer.close();
+    BOOST_CHECK_EQUAL(writer.frames_written(), 2u);
+    BOOST_CHECK_EQUAL(writer.frames_dropped(), 1u);
+    BOOST_CHECK(sink->values() == std::vector<uint8_t>({0, 10}));
+}
+
+BOOST_AUTO_TEST_CASE(test_writer_drop_oldest)
+{
+    auto sink = new GatedSink;
+    gui::VideoWriter writer(std::unique_ptr<gui::VideoSink>(sink), gui::VideoPolicy::DropOldest, 1);
+    fill_queue(writer, *sink);
+
+    BOOST_CHECK(writer.push(bottom_up_frame(4, 2, 20)));
+    sink->open_gate();
+    writer.close();
+    BOOST_CHECK_EQUAL(writer.frames_written(), 2u);
+    BOOST_CHECK_EQUAL(writer.frames_dropped(), 1u);
+    BOOST_CHECK(sink->values() == std::vector<uint8_t>({0, 20}));
+}
+
+BOOST_AUTO_TEST_CASE(test_writer_failing_sink)
+{
+    auto sink = new GatedSink(true);
+    gui::VideoWriter writer(std::unique_ptr<gui::VideoSink>(sink), gui::VideoPolicy::Block, 1);
+    fill_queue(writer, *sink);
+
+    // blocked until the sink fails
+    std::atomic<bool> returned(false), pushed(true);
+    std::thread pusher([&]() {
+        pushed = writer.push(bottom_up_frame(4, 2, 20));
+        returned = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    BOOST_CHECK(!returned.load());
+
+    sink->open_gate();
+    pusher.join();
+    BOOST_CHECK(!pushed.load());
+    BOOST_CHECK(!writer.push(bottom_up_frame(4, 2, 30)));
+    writer.close();
+    BOOST_CHECK_EQUAL(writer.frames_written(), 0u);
+}